@@ -52,6 +52,8 @@ $m1="%rbp";
 
 $code=<<___;
 .text
+.extern	OPENSSL_ia32cap_P
+.hidden	OPENSSL_ia32cap_P
 
 .globl	bn_mul_mont_gather5
 .type	bn_mul_mont_gather5,\@function,6
@@ -61,6 +63,13 @@ bn_mul_mont_gather5:
 	jnz	.Lmul_enter
 	cmp	\$8,${num}d
 	jb	.Lmul_enter
+___
+$code.=<<___ if (!$win64);
+	mov	OPENSSL_ia32cap_P+4(%rip),%r11d
+	test	\$IA32CAP_MASK1_ADX,%r11d	# check BMI2 and ADX bits
+	jnz	.Lmulx4x_enter
+___
+$code.=<<___;
 	jmp	.Lmul4x_enter
 
 .align	16
@@ -913,6 +922,57 @@ $code.=<<___;
 ___
 }}}
 
+if (!$win64) {
+######################################################################
+# With BMI2 and ADX, gather bp from the powers table into a temporary
+# vector and hand it to bn_mulx4x_mont from x86_64-mont.pl.
+#
+$code.=<<___;
+.extern	bn_mulx4x_mont
+.hidden	bn_mulx4x_mont
+.type	bn_mulx4x_mont_gather5,\@abi-omnipotent
+.align	16
+bn_mulx4x_mont_gather5:
+.Lmulx4x_enter:
+	push	%rbp
+	mov	%rsp,%rbp
+	push	$rp
+	push	$ap
+	push	$np
+	push	$n0
+	push	$num
+
+	mov	${num}d,${num}d
+	lea	0(,$num,8),%r10
+	sub	%r10,%rsp
+	and	\$-64,%rsp		# b=alloca(8*num)
+
+	mov	%rsp,%rdi		# b
+	mov	$num,%rsi		# num
+	mov	16(%rbp),%ecx		# 7th argument, power
+	call	bn_gather5		# table is already in %rdx
+
+	mov	-8(%rbp),%rdi
+	mov	-16(%rbp),%rsi
+	mov	%rsp,%rdx
+	mov	-24(%rbp),%rcx
+	mov	-32(%rbp),%r8
+	mov	-40(%rbp),%r9
+	call	bn_mulx4x_mont
+
+	mov	-40(%rbp),%rcx
+	mov	%rsp,%rdi
+	xor	%eax,%eax
+	rep	stosq			# zap temporary vector
+
+	mov	\$1,%rax
+	mov	%rbp,%rsp
+	pop	%rbp
+	ret
+.size	bn_mulx4x_mont_gather5,.-bn_mulx4x_mont_gather5
+___
+}
+
 {
 my ($inp,$num,$tbl,$idx)=$win64?("%rcx","%rdx","%r8", "%r9d") : # Win64 order
 				("%rdi","%rsi","%rdx","%ecx"); # Unix order
@@ -20,6 +20,7 @@
 #include <openssl/chacha.h>
 
 #include "chacha-merged.c"
+#include "chacha_local.h"
 
 void
 ChaCha_set_key(ChaCha_ctx *ctx, const unsigned char *key, uint32_t keybits)
@@ -53,6 +54,13 @@ ChaCha(ChaCha_ctx *ctx, unsigned char *out, const unsigned char *in, size_t len)
 		len -= l;
 	}
 
+#ifdef CHACHA_AMD64
+	n = chacha_blocks_amd64(((chacha_ctx *)ctx)->input, out, in, len);
+	in += n;
+	out += n;
+	len -= n;
+#endif
+
 	while (len > 0) {
 		if ((n = len) > UINT32_MAX)
 			n = UINT32_MAX;
@@ -84,6 +92,13 @@ CRYPTO_chacha_20(unsigned char *out, const unsigned char *in, size_t len,
 		ctx.input[13] = (uint32_t)(counter >> 32);
 	}
 
+#ifdef CHACHA_AMD64
+	n = chacha_blocks_amd64(ctx.input, out, in, len);
+	in += n;
+	out += n;
+	len -= n;
+#endif
+
 	while (len > 0) {
 		if ((n = len) > UINT32_MAX)
 			n = UINT32_MAX;
@@ -0,0 +1,305 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Multi-block ChaCha20 for amd64, processing four blocks at a time with
+ * SSSE3 or eight blocks at a time with AVX2.
+ *
+ * Each vector holds the same state word of four (or eight) consecutive
+ * blocks, so that the rounds are the same as in the scalar code, with every
+ * operation applied to all blocks at once. The keystream is transposed back
+ * into block order before being XORed with the input. The functions are
+ * compiled for the respective instruction set extension and are only called
+ * once OPENSSL_cpu_caps() reports support for it.
+ */
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#include <openssl/crypto.h>
+
+#include "chacha_local.h"
+#include "x86_arch.h"
+
+#define CHACHA_BLOCKLEN		64
+
+#define SSSE3_FUNC	__attribute__((__target__("ssse3")))
+#define AVX2_FUNC	__attribute__((__target__("avx2")))
+
+/*
+ * Split the 64-bit block counter for n consecutive blocks into its low and
+ * high words.
+ */
+static void
+chacha_counters(const uint32_t input[16], uint32_t lo[], uint32_t hi[], int n)
+{
+	uint64_t counter;
+	int i;
+
+	counter = (uint64_t)input[13] << 32 | input[12];
+	for (i = 0; i < n; i++) {
+		lo[i] = (uint32_t)(counter + i);
+		hi[i] = (uint32_t)((counter + i) >> 32);
+	}
+}
+
+static void
+chacha_counter_add(uint32_t input[16], uint64_t blocks)
+{
+	uint64_t counter;
+
+	counter = (uint64_t)input[13] << 32 | input[12];
+	counter += blocks;
+	input[12] = (uint32_t)counter;
+	input[13] = (uint32_t)(counter >> 32);
+}
+
+static inline __m128i SSSE3_FUNC
+chacha_rotl_ssse3(__m128i v, int n)
+{
+	return _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - n));
+}
+
+static inline __m128i SSSE3_FUNC
+chacha_rotl16_ssse3(__m128i v)
+{
+	return _mm_shuffle_epi8(v, _mm_set_epi8(13, 12, 15, 14, 9, 8, 11, 10,
+	    5, 4, 7, 6, 1, 0, 3, 2));
+}
+
+static inline __m128i SSSE3_FUNC
+chacha_rotl8_ssse3(__m128i v)
+{
+	return _mm_shuffle_epi8(v, _mm_set_epi8(14, 13, 12, 15, 10, 9, 8, 11,
+	    6, 5, 4, 7, 2, 1, 0, 3));
+}
+
+#define CHACHA_QUARTERROUND_SSSE3(a, b, c, d) do {			\
+	a = _mm_add_epi32(a, b);					\
+	d = chacha_rotl16_ssse3(_mm_xor_si128(d, a));			\
+	c = _mm_add_epi32(c, d);					\
+	b = chacha_rotl_ssse3(_mm_xor_si128(b, c), 12);			\
+	a = _mm_add_epi32(a, b);					\
+	d = chacha_rotl8_ssse3(_mm_xor_si128(d, a));			\
+	c = _mm_add_epi32(c, d);					\
+	b = chacha_rotl_ssse3(_mm_xor_si128(b, c), 7);			\
+} while (0)
+
+static inline void SSSE3_FUNC
+chacha_xor_ssse3(unsigned char *out, const unsigned char *in, __m128i ks)
+{
+	__m128i m;
+
+	m = _mm_loadu_si128((const __m128i *)in);
+	_mm_storeu_si128((__m128i *)out, _mm_xor_si128(m, ks));
+}
+
+static void SSSE3_FUNC
+chacha_4block_ssse3(const uint32_t input[16], unsigned char *out,
+    const unsigned char *in)
+{
+	__m128i j[16], x[16];
+	__m128i t0, t1, t2, t3;
+	uint32_t lo[4], hi[4];
+	int i;
+
+	chacha_counters(input, lo, hi, 4);
+
+	for (i = 0; i < 16; i++)
+		j[i] = _mm_set1_epi32(input[i]);
+	j[12] = _mm_setr_epi32(lo[0], lo[1], lo[2], lo[3]);
+	j[13] = _mm_setr_epi32(hi[0], hi[1], hi[2], hi[3]);
+
+	for (i = 0; i < 16; i++)
+		x[i] = j[i];
+
+	for (i = 20; i > 0; i -= 2) {
+		CHACHA_QUARTERROUND_SSSE3(x[0], x[4], x[8], x[12]);
+		CHACHA_QUARTERROUND_SSSE3(x[1], x[5], x[9], x[13]);
+		CHACHA_QUARTERROUND_SSSE3(x[2], x[6], x[10], x[14]);
+		CHACHA_QUARTERROUND_SSSE3(x[3], x[7], x[11], x[15]);
+		CHACHA_QUARTERROUND_SSSE3(x[0], x[5], x[10], x[15]);
+		CHACHA_QUARTERROUND_SSSE3(x[1], x[6], x[11], x[12]);
+		CHACHA_QUARTERROUND_SSSE3(x[2], x[7], x[8], x[13]);
+		CHACHA_QUARTERROUND_SSSE3(x[3], x[4], x[9], x[14]);
+	}
+
+	for (i = 0; i < 16; i++)
+		x[i] = _mm_add_epi32(x[i], j[i]);
+
+	/* Transpose each group of four words into 16 bytes of each block. */
+	for (i = 0; i < 4; i++) {
+		t0 = _mm_unpacklo_epi32(x[4 * i + 0], x[4 * i + 1]);
+		t1 = _mm_unpacklo_epi32(x[4 * i + 2], x[4 * i + 3]);
+		t2 = _mm_unpackhi_epi32(x[4 * i + 0], x[4 * i + 1]);
+		t3 = _mm_unpackhi_epi32(x[4 * i + 2], x[4 * i + 3]);
+
+		chacha_xor_ssse3(out + 0 * CHACHA_BLOCKLEN + 16 * i,
+		    in + 0 * CHACHA_BLOCKLEN + 16 * i,
+		    _mm_unpacklo_epi64(t0, t1));
+		chacha_xor_ssse3(out + 1 * CHACHA_BLOCKLEN + 16 * i,
+		    in + 1 * CHACHA_BLOCKLEN + 16 * i,
+		    _mm_unpackhi_epi64(t0, t1));
+		chacha_xor_ssse3(out + 2 * CHACHA_BLOCKLEN + 16 * i,
+		    in + 2 * CHACHA_BLOCKLEN + 16 * i,
+		    _mm_unpacklo_epi64(t2, t3));
+		chacha_xor_ssse3(out + 3 * CHACHA_BLOCKLEN + 16 * i,
+		    in + 3 * CHACHA_BLOCKLEN + 16 * i,
+		    _mm_unpackhi_epi64(t2, t3));
+	}
+}
+
+static inline __m256i AVX2_FUNC
+chacha_rotl_avx2(__m256i v, int n)
+{
+	return _mm256_or_si256(_mm256_slli_epi32(v, n),
+	    _mm256_srli_epi32(v, 32 - n));
+}
+
+static inline __m256i AVX2_FUNC
+chacha_rotl16_avx2(__m256i v)
+{
+	return _mm256_shuffle_epi8(v, _mm256_set_epi8(
+	    13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+	    13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2));
+}
+
+static inline __m256i AVX2_FUNC
+chacha_rotl8_avx2(__m256i v)
+{
+	return _mm256_shuffle_epi8(v, _mm256_set_epi8(
+	    14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+	    14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3));
+}
+
+#define CHACHA_QUARTERROUND_AVX2(a, b, c, d) do {			\
+	a = _mm256_add_epi32(a, b);					\
+	d = chacha_rotl16_avx2(_mm256_xor_si256(d, a));			\
+	c = _mm256_add_epi32(c, d);					\
+	b = chacha_rotl_avx2(_mm256_xor_si256(b, c), 12);		\
+	a = _mm256_add_epi32(a, b);					\
+	d = chacha_rotl8_avx2(_mm256_xor_si256(d, a));			\
+	c = _mm256_add_epi32(c, d);					\
+	b = chacha_rotl_avx2(_mm256_xor_si256(b, c), 7);		\
+} while (0)
+
+/*
+ * XOR 16 bytes of block n with the low half of ks and 16 bytes of block
+ * n + 4 with the high half.
+ */
+static inline void AVX2_FUNC
+chacha_xor_avx2(unsigned char *out, const unsigned char *in, __m256i ks)
+{
+	__m128i m;
+
+	m = _mm_loadu_si128((const __m128i *)in);
+	_mm_storeu_si128((__m128i *)out,
+	    _mm_xor_si128(m, _mm256_castsi256_si128(ks)));
+
+	in += 4 * CHACHA_BLOCKLEN;
+	out += 4 * CHACHA_BLOCKLEN;
+
+	m = _mm_loadu_si128((const __m128i *)in);
+	_mm_storeu_si128((__m128i *)out,
+	    _mm_xor_si128(m, _mm256_extracti128_si256(ks, 1)));
+}
+
+static void AVX2_FUNC
+chacha_8block_avx2(const uint32_t input[16], unsigned char *out,
+    const unsigned char *in)
+{
+	__m256i j[16], x[16];
+	__m256i t0, t1, t2, t3;
+	uint32_t lo[8], hi[8];
+	int i;
+
+	chacha_counters(input, lo, hi, 8);
+
+	for (i = 0; i < 16; i++)
+		j[i] = _mm256_set1_epi32(input[i]);
+	j[12] = _mm256_setr_epi32(lo[0], lo[1], lo[2], lo[3],
+	    lo[4], lo[5], lo[6], lo[7]);
+	j[13] = _mm256_setr_epi32(hi[0], hi[1], hi[2], hi[3],
+	    hi[4], hi[5], hi[6], hi[7]);
+
+	for (i = 0; i < 16; i++)
+		x[i] = j[i];
+
+	for (i = 20; i > 0; i -= 2) {
+		CHACHA_QUARTERROUND_AVX2(x[0], x[4], x[8], x[12]);
+		CHACHA_QUARTERROUND_AVX2(x[1], x[5], x[9], x[13]);
+		CHACHA_QUARTERROUND_AVX2(x[2], x[6], x[10], x[14]);
+		CHACHA_QUARTERROUND_AVX2(x[3], x[7], x[11], x[15]);
+		CHACHA_QUARTERROUND_AVX2(x[0], x[5], x[10], x[15]);
+		CHACHA_QUARTERROUND_AVX2(x[1], x[6], x[11], x[12]);
+		CHACHA_QUARTERROUND_AVX2(x[2], x[7], x[8], x[13]);
+		CHACHA_QUARTERROUND_AVX2(x[3], x[4], x[9], x[14]);
+	}
+
+	for (i = 0; i < 16; i++)
+		x[i] = _mm256_add_epi32(x[i], j[i]);
+
+	/*
+	 * The unpack instructions operate on each 128-bit half separately,
+	 * which transposes blocks 0-3 in the low halves and blocks 4-7 in
+	 * the high halves.
+	 */
+	for (i = 0; i < 4; i++) {
+		t0 = _mm256_unpacklo_epi32(x[4 * i + 0], x[4 * i + 1]);
+		t1 = _mm256_unpacklo_epi32(x[4 * i + 2], x[4 * i + 3]);
+		t2 = _mm256_unpackhi_epi32(x[4 * i + 0], x[4 * i + 1]);
+		t3 = _mm256_unpackhi_epi32(x[4 * i + 2], x[4 * i + 3]);
+
+		chacha_xor_avx2(out + 0 * CHACHA_BLOCKLEN + 16 * i,
+		    in + 0 * CHACHA_BLOCKLEN + 16 * i,
+		    _mm256_unpacklo_epi64(t0, t1));
+		chacha_xor_avx2(out + 1 * CHACHA_BLOCKLEN + 16 * i,
+		    in + 1 * CHACHA_BLOCKLEN + 16 * i,
+		    _mm256_unpackhi_epi64(t0, t1));
+		chacha_xor_avx2(out + 2 * CHACHA_BLOCKLEN + 16 * i,
+		    in + 2 * CHACHA_BLOCKLEN + 16 * i,
+		    _mm256_unpacklo_epi64(t2, t3));
+		chacha_xor_avx2(out + 3 * CHACHA_BLOCKLEN + 16 * i,
+		    in + 3 * CHACHA_BLOCKLEN + 16 * i,
+		    _mm256_unpackhi_epi64(t2, t3));
+	}
+}
+
+size_t
+chacha_blocks_amd64(uint32_t input[16], unsigned char *out,
+    const unsigned char *in, size_t len)
+{
+	uint64_t caps = OPENSSL_cpu_caps();
+	size_t done = 0;
+
+	if ((caps & CPUCAP_MASK_AVX2) != 0) {
+		while (len - done >= 8 * CHACHA_BLOCKLEN) {
+			chacha_8block_avx2(input, out + done, in + done);
+			chacha_counter_add(input, 8);
+			done += 8 * CHACHA_BLOCKLEN;
+		}
+	}
+	if ((caps & CPUCAP_MASK_SSSE3) != 0) {
+		while (len - done >= 4 * CHACHA_BLOCKLEN) {
+			chacha_4block_ssse3(input, out + done, in + done);
+			chacha_counter_add(input, 4);
+			done += 4 * CHACHA_BLOCKLEN;
+		}
+	}
+
+	return done;
+}
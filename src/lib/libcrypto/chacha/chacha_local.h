@@ -0,0 +1,38 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef HEADER_CHACHA_LOCAL_H
+#define HEADER_CHACHA_LOCAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+__BEGIN_HIDDEN_DECLS
+
+#ifdef CHACHA_AMD64
+/*
+ * Encrypt as many whole multi-block chunks of in as the CPU supports, using
+ * and advancing the block counter in input[12] and input[13]. Returns the
+ * number of bytes processed, which is zero if no vector unit is available.
+ */
+size_t chacha_blocks_amd64(uint32_t input[16], unsigned char *out,
+    const unsigned char *in, size_t len);
+#endif
+
+__END_HIDDEN_DECLS
+
+#endif /* HEADER_CHACHA_LOCAL_H */
@@ -19,48 +19,48 @@
 
 #include <openssl/crypto.h>
 
-static pthread_mutex_t locks[] = {
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
-	PTHREAD_MUTEX_INITIALIZER,
+static pthread_rwlock_t locks[] = {
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
+	PTHREAD_RWLOCK_INITIALIZER,
 };
 
 #define CTASSERT(x)	extern char  _ctassert[(x) ? 1 : -1 ] \
@@ -68,16 +68,43 @@ static pthread_mutex_t locks[] = {
 
 CTASSERT((sizeof(locks) / sizeof(*locks)) == CRYPTO_NUM_LOCKS);
 
+/*
+ * Read locks are shared, allowing lookups from multiple threads to proceed
+ * in parallel. Anything that is not explicitly a read lock is exclusive.
+ */
 void
 CRYPTO_lock(int mode, int type, const char *file, int line)
 {
 	if (type < 0 || type >= CRYPTO_NUM_LOCKS)
 		return;
 
-	if (mode & CRYPTO_LOCK)
-		(void) pthread_mutex_lock(&locks[type]);
-	else if (mode & CRYPTO_UNLOCK)
-		(void) pthread_mutex_unlock(&locks[type]);
+	if (mode & CRYPTO_LOCK) {
+		if ((mode & (CRYPTO_READ|CRYPTO_WRITE)) == CRYPTO_READ)
+			(void) pthread_rwlock_rdlock(&locks[type]);
+		else
+			(void) pthread_rwlock_wrlock(&locks[type]);
+	} else if (mode & CRYPTO_UNLOCK)
+		(void) pthread_rwlock_unlock(&locks[type]);
+}
+
+/*
+ * Reference counts for these types are updated atomically, rather than
+ * serialising every CRYPTO_add() for the type on a single global lock.
+ * The reference counts must only be modified via CRYPTO_add().
+ */
+static int
+crypto_lock_type_is_atomic(int type)
+{
+	switch (type) {
+	case CRYPTO_LOCK_EVP_PKEY:
+	case CRYPTO_LOCK_SSL_CTX:
+	case CRYPTO_LOCK_SSL_SESSION:
+	case CRYPTO_LOCK_X509:
+	case CRYPTO_LOCK_X509_STORE:
+		return 1;
+	}
+
+	return 0;
 }
 
 int
@@ -86,6 +113,9 @@ CRYPTO_add_lock(int *pointer, int amount, int type, const char *file,
 {
 	int ret;
 
+	if (crypto_lock_type_is_atomic(type))
+		return __atomic_add_fetch(pointer, amount, __ATOMIC_ACQ_REL);
+
 	CRYPTO_lock(CRYPTO_LOCK|CRYPTO_WRITE, type, file, line);
 	ret = *pointer + amount;
 	*pointer = ret;
@@ -33,11 +33,6 @@
 
 #include "curve25519_internal.h"
 
-static const int64_t kBottom25Bits = 0x1ffffffLL;
-static const int64_t kBottom26Bits = 0x3ffffffLL;
-static const int64_t kTop39Bits = 0xfffffffffe000000LL;
-static const int64_t kTop38Bits = 0xfffffffffc000000LL;
-
 static uint64_t load_3(const uint8_t *in) {
   uint64_t result;
   result = (uint64_t)in[0];
@@ -55,6 +50,316 @@ static uint64_t load_4(const uint8_t *in) {
   return result;
 }
 
+#if defined(CURVE25519_64BIT)
+
+/* The 64-bit field implementation below uses five unsigned 51-bit limbs with
+ * 128-bit products. Limbs are kept "tight", i.e. no larger than 2^51 plus a
+ * small carry, after every operation so the bounds of the ten limb
+ * implementation do not have to be tracked through the group operations. */
+
+typedef unsigned __int128 uint128_t;
+
+static const uint64_t kBottom51Bits = 0x7ffffffffffffULL;
+
+static uint64_t load_8(const uint8_t *in) {
+  uint64_t result;
+  result = (uint64_t)in[0];
+  result |= ((uint64_t)in[1]) << 8;
+  result |= ((uint64_t)in[2]) << 16;
+  result |= ((uint64_t)in[3]) << 24;
+  result |= ((uint64_t)in[4]) << 32;
+  result |= ((uint64_t)in[5]) << 40;
+  result |= ((uint64_t)in[6]) << 48;
+  result |= ((uint64_t)in[7]) << 56;
+  return result;
+}
+
+static void store_8(uint8_t *out, uint64_t v) {
+  out[0] = v;
+  out[1] = v >> 8;
+  out[2] = v >> 16;
+  out[3] = v >> 24;
+  out[4] = v >> 32;
+  out[5] = v >> 40;
+  out[6] = v >> 48;
+  out[7] = v >> 56;
+}
+
+/* h = f with each limb reduced to 51 bits, except h[1] which may be up to
+ * 2^51 + 2^13 + 1.
+ *
+ * Preconditions:
+ *    f[i] < 2^63 */
+static void fe_carry(fe h, const fe f) {
+  uint64_t h0 = f[0];
+  uint64_t h1 = f[1];
+  uint64_t h2 = f[2];
+  uint64_t h3 = f[3];
+  uint64_t h4 = f[4];
+
+  h1 += h0 >> 51; h0 &= kBottom51Bits;
+  h2 += h1 >> 51; h1 &= kBottom51Bits;
+  h3 += h2 >> 51; h2 &= kBottom51Bits;
+  h4 += h3 >> 51; h3 &= kBottom51Bits;
+  h0 += (h4 >> 51) * 19; h4 &= kBottom51Bits;
+  h1 += h0 >> 51; h0 &= kBottom51Bits;
+
+  h[0] = h0;
+  h[1] = h1;
+  h[2] = h2;
+  h[3] = h3;
+  h[4] = h4;
+}
+
+/* h = r, where r is given as five 128-bit column sums.
+ *
+ * Preconditions:
+ *    r[i] < 2^115
+ *
+ * Postconditions:
+ *    h[i] bounded by 2^51, except h[1] which may be up to 2^51 + 2^13 + 1. */
+static void fe_carry_wide(fe h, uint128_t r0, uint128_t r1, uint128_t r2,
+                          uint128_t r3, uint128_t r4) {
+  uint64_t h0, h1, h2, h3, h4;
+
+  r1 += (uint64_t)(r0 >> 51); h0 = (uint64_t)r0 & kBottom51Bits;
+  r2 += (uint64_t)(r1 >> 51); h1 = (uint64_t)r1 & kBottom51Bits;
+  r3 += (uint64_t)(r2 >> 51); h2 = (uint64_t)r2 & kBottom51Bits;
+  r4 += (uint64_t)(r3 >> 51); h3 = (uint64_t)r3 & kBottom51Bits;
+  h0 += (uint64_t)(r4 >> 51) * 19; h4 = (uint64_t)r4 & kBottom51Bits;
+  h1 += h0 >> 51; h0 &= kBottom51Bits;
+
+  h[0] = h0;
+  h[1] = h1;
+  h[2] = h2;
+  h[3] = h3;
+  h[4] = h4;
+}
+
+static void fe_frombytes(fe h, const uint8_t *s) {
+  /* Ignores top bit of h. */
+  h[0] = load_8(s) & kBottom51Bits;
+  h[1] = (load_8(s + 6) >> 3) & kBottom51Bits;
+  h[2] = (load_8(s + 12) >> 6) & kBottom51Bits;
+  h[3] = (load_8(s + 19) >> 1) & kBottom51Bits;
+  h[4] = (load_8(s + 24) >> 12) & kBottom51Bits;
+}
+
+/* Preconditions:
+ *    f[i] < 2^63
+ *
+ * Carrying twice leaves every limb below 2^51, so h < 2^255 and
+ * q = floor((h + 19) / 2^255) is 1 exactly when h >= p. The output is then
+ * h + 19q - 2^255 q, computed modulo 2^255 by dropping the top carry. */
+static void fe_tobytes(uint8_t *s, const fe f) {
+  fe h;
+  uint64_t q;
+
+  fe_carry(h, f);
+  fe_carry(h, h);
+
+  q = (h[0] + 19) >> 51;
+  q = (h[1] + q) >> 51;
+  q = (h[2] + q) >> 51;
+  q = (h[3] + q) >> 51;
+  q = (h[4] + q) >> 51;
+
+  h[0] += 19 * q;
+
+  h[1] += h[0] >> 51; h[0] &= kBottom51Bits;
+  h[2] += h[1] >> 51; h[1] &= kBottom51Bits;
+  h[3] += h[2] >> 51; h[2] &= kBottom51Bits;
+  h[4] += h[3] >> 51; h[3] &= kBottom51Bits;
+                      h[4] &= kBottom51Bits;
+
+  store_8(s, h[0] | (h[1] << 51));
+  store_8(s + 8, (h[1] >> 13) | (h[2] << 38));
+  store_8(s + 16, (h[2] >> 26) | (h[3] << 25));
+  store_8(s + 24, (h[3] >> 39) | (h[4] << 12));
+}
+
+/* h = f */
+static void fe_copy(fe h, const fe f) {
+  memmove(h, f, sizeof(uint64_t) * 5);
+}
+
+/* h = 0 */
+static void fe_0(fe h) { memset(h, 0, sizeof(uint64_t) * 5); }
+
+/* h = 1 */
+static void fe_1(fe h) {
+  memset(h, 0, sizeof(uint64_t) * 5);
+  h[0] = 1;
+}
+
+/* h = f + g
+ * Can overlap h with f or g. */
+static void fe_add(fe h, const fe f, const fe g) {
+  unsigned i;
+  for (i = 0; i < 5; i++) {
+    h[i] = f[i] + g[i];
+  }
+  fe_carry(h, h);
+}
+
+/* h = f - g
+ * Can overlap h with f or g.
+ *
+ * 2p is added first so that no limb goes negative; each limb of g is below
+ * 2^52 - 38. */
+static void fe_sub(fe h, const fe f, const fe g) {
+  h[0] = (f[0] + 0xfffffffffffdaULL) - g[0];
+  h[1] = (f[1] + 0xffffffffffffeULL) - g[1];
+  h[2] = (f[2] + 0xffffffffffffeULL) - g[2];
+  h[3] = (f[3] + 0xffffffffffffeULL) - g[3];
+  h[4] = (f[4] + 0xffffffffffffeULL) - g[4];
+  fe_carry(h, h);
+}
+
+/* h = f * g
+ * Can overlap h with f or g.
+ *
+ * Using schoolbook multiplication; the multiplications by 19 that fold the
+ * upper half of the product back into the lower half are precomputed on the
+ * 64-bit limbs of g. */
+static void fe_mul(fe h, const fe f, const fe g) {
+  uint64_t f0 = f[0];
+  uint64_t f1 = f[1];
+  uint64_t f2 = f[2];
+  uint64_t f3 = f[3];
+  uint64_t f4 = f[4];
+  uint64_t g0 = g[0];
+  uint64_t g1 = g[1];
+  uint64_t g2 = g[2];
+  uint64_t g3 = g[3];
+  uint64_t g4 = g[4];
+  uint64_t g1_19 = 19 * g1;
+  uint64_t g2_19 = 19 * g2;
+  uint64_t g3_19 = 19 * g3;
+  uint64_t g4_19 = 19 * g4;
+  uint128_t h0, h1, h2, h3, h4;
+
+  h0 = (uint128_t)f0 * g0 + (uint128_t)f1 * g4_19 + (uint128_t)f2 * g3_19 +
+       (uint128_t)f3 * g2_19 + (uint128_t)f4 * g1_19;
+  h1 = (uint128_t)f0 * g1 + (uint128_t)f1 * g0 + (uint128_t)f2 * g4_19 +
+       (uint128_t)f3 * g3_19 + (uint128_t)f4 * g2_19;
+  h2 = (uint128_t)f0 * g2 + (uint128_t)f1 * g1 + (uint128_t)f2 * g0 +
+       (uint128_t)f3 * g4_19 + (uint128_t)f4 * g3_19;
+  h3 = (uint128_t)f0 * g3 + (uint128_t)f1 * g2 + (uint128_t)f2 * g1 +
+       (uint128_t)f3 * g0 + (uint128_t)f4 * g4_19;
+  h4 = (uint128_t)f0 * g4 + (uint128_t)f1 * g3 + (uint128_t)f2 * g2 +
+       (uint128_t)f3 * g1 + (uint128_t)f4 * g0;
+
+  fe_carry_wide(h, h0, h1, h2, h3, h4);
+}
+
+/* h = f * f
+ * Can overlap h with f.
+ *
+ * See fe_mul for discussion of implementation strategy. */
+static void fe_sq(fe h, const fe f) {
+  uint64_t f0 = f[0];
+  uint64_t f1 = f[1];
+  uint64_t f2 = f[2];
+  uint64_t f3 = f[3];
+  uint64_t f4 = f[4];
+  uint64_t f0_2 = 2 * f0;
+  uint64_t f1_2 = 2 * f1;
+  uint64_t f2_2 = 2 * f2;
+  uint64_t f3_2 = 2 * f3;
+  uint64_t f3_19 = 19 * f3;
+  uint64_t f4_19 = 19 * f4;
+  uint128_t h0, h1, h2, h3, h4;
+
+  h0 = (uint128_t)f0 * f0 + (uint128_t)f1_2 * f4_19 +
+       (uint128_t)f2_2 * f3_19;
+  h1 = (uint128_t)f0_2 * f1 + (uint128_t)f2_2 * f4_19 +
+       (uint128_t)f3 * f3_19;
+  h2 = (uint128_t)f0_2 * f2 + (uint128_t)f1 * f1 +
+       (uint128_t)f3_2 * f4_19;
+  h3 = (uint128_t)f0_2 * f3 + (uint128_t)f1_2 * f2 +
+       (uint128_t)f4 * f4_19;
+  h4 = (uint128_t)f0_2 * f4 + (uint128_t)f1_2 * f3 +
+       (uint128_t)f2 * f2;
+
+  fe_carry_wide(h, h0, h1, h2, h3, h4);
+}
+
+/* h = -f */
+static void fe_neg(fe h, const fe f) {
+  h[0] = 0xfffffffffffdaULL - f[0];
+  h[1] = 0xffffffffffffeULL - f[1];
+  h[2] = 0xffffffffffffeULL - f[2];
+  h[3] = 0xffffffffffffeULL - f[3];
+  h[4] = 0xffffffffffffeULL - f[4];
+  fe_carry(h, h);
+}
+
+/* Replace (f,g) with (g,g) if b == 1;
+ * replace (f,g) with (f,g) if b == 0.
+ *
+ * Preconditions: b in {0,1}. */
+static void fe_cmov(fe f, const fe g, unsigned b) {
+  uint64_t mask = 0 - (uint64_t)b;
+  unsigned i;
+  for (i = 0; i < 5; i++) {
+    uint64_t x = f[i] ^ g[i];
+    x &= mask;
+    f[i] ^= x;
+  }
+}
+
+/* h = 2 * f * f
+ * Can overlap h with f. */
+static void fe_sq2(fe h, const fe f) {
+  fe_sq(h, f);
+  fe_add(h, h, h);
+}
+
+/* Replace (f,g) with (g,f) if b == 1;
+ * replace (f,g) with (f,g) if b == 0.
+ *
+ * Preconditions: b in {0,1}. */
+static void fe_cswap(fe f, fe g, unsigned int b) {
+  uint64_t mask = 0 - (uint64_t)b;
+  unsigned i;
+  for (i = 0; i < 5; i++) {
+    uint64_t x = f[i] ^ g[i];
+    x &= mask;
+    f[i] ^= x;
+    g[i] ^= x;
+  }
+}
+
+/* h = f * 121666
+ * Can overlap h with f. */
+static void fe_mul121666(fe h, fe f) {
+  fe_carry_wide(h, (uint128_t)f[0] * 121666, (uint128_t)f[1] * 121666,
+                (uint128_t)f[2] * 121666, (uint128_t)f[3] * 121666,
+                (uint128_t)f[4] * 121666);
+}
+
+/* h = f, where f is in the ten limb representation used by the precomputed
+ * tables.
+ *
+ * Preconditions:
+ *    |f| bounded by 1.1*2^26,1.1*2^25,1.1*2^26,1.1*2^25,etc. */
+static void fe_from_ref10(fe h, const int32_t f[10]) {
+  h[0] = f[0] + f[1] * ((int64_t)1 << 26) + 0xfffffffffffdaLL;
+  h[1] = f[2] + f[3] * ((int64_t)1 << 26) + 0xffffffffffffeLL;
+  h[2] = f[4] + f[5] * ((int64_t)1 << 26) + 0xffffffffffffeLL;
+  h[3] = f[6] + f[7] * ((int64_t)1 << 26) + 0xffffffffffffeLL;
+  h[4] = f[8] + f[9] * ((int64_t)1 << 26) + 0xffffffffffffeLL;
+  fe_carry(h, h);
+}
+
+#else
+
+static const int64_t kBottom25Bits = 0x1ffffffLL;
+static const int64_t kBottom26Bits = 0x3ffffffLL;
+static const int64_t kTop39Bits = 0xfffffffffe000000LL;
+static const int64_t kTop38Bits = 0xfffffffffc000000LL;
+
 static void fe_frombytes(fe h, const uint8_t *s) {
   /* Ignores top bit of h. */
   int64_t h0 = load_4(s);
@@ -634,64 +939,6 @@ static void fe_sq(fe h, const fe f) {
   h[9] = h9;
 }
 
-static void fe_invert(fe out, const fe z) {
-  fe t0;
-  fe t1;
-  fe t2;
-  fe t3;
-  int i;
-
-  fe_sq(t0, z);
-  fe_sq(t1, t0);
-  for (i = 1; i < 2; ++i) {
-    fe_sq(t1, t1);
-  }
-  fe_mul(t1, z, t1);
-  fe_mul(t0, t0, t1);
-  fe_sq(t2, t0);
-  fe_mul(t1, t1, t2);
-  fe_sq(t2, t1);
-  for (i = 1; i < 5; ++i) {
-    fe_sq(t2, t2);
-  }
-  fe_mul(t1, t2, t1);
-  fe_sq(t2, t1);
-  for (i = 1; i < 10; ++i) {
-    fe_sq(t2, t2);
-  }
-  fe_mul(t2, t2, t1);
-  fe_sq(t3, t2);
-  for (i = 1; i < 20; ++i) {
-    fe_sq(t3, t3);
-  }
-  fe_mul(t2, t3, t2);
-  fe_sq(t2, t2);
-  for (i = 1; i < 10; ++i) {
-    fe_sq(t2, t2);
-  }
-  fe_mul(t1, t2, t1);
-  fe_sq(t2, t1);
-  for (i = 1; i < 50; ++i) {
-    fe_sq(t2, t2);
-  }
-  fe_mul(t2, t2, t1);
-  fe_sq(t3, t2);
-  for (i = 1; i < 100; ++i) {
-    fe_sq(t3, t3);
-  }
-  fe_mul(t2, t3, t2);
-  fe_sq(t2, t2);
-  for (i = 1; i < 50; ++i) {
-    fe_sq(t2, t2);
-  }
-  fe_mul(t1, t2, t1);
-  fe_sq(t1, t1);
-  for (i = 1; i < 5; ++i) {
-    fe_sq(t1, t1);
-  }
-  fe_mul(out, t1, t0);
-}
-
 /* h = -f
  *
  * Preconditions:
@@ -720,30 +967,6 @@ static void fe_cmov(fe f, const fe g, unsigned b) {
   }
 }
 
-/* return 0 if f == 0
- * return 1 if f != 0
- *
- * Preconditions:
- *    |f| bounded by 1.1*2^26,1.1*2^25,1.1*2^26,1.1*2^25,etc. */
-static int fe_isnonzero(const fe f) {
-  uint8_t s[32];
-  fe_tobytes(s, f);
-
-  static const uint8_t zero[32] = {0};
-  return timingsafe_memcmp(s, zero, sizeof(zero)) != 0;
-}
-
-/* return 1 if f is in {1,3,5,...,q-2}
- * return 0 if f is in {0,2,4,...,q-1}
- *
- * Preconditions:
- *    |f| bounded by 1.1*2^26,1.1*2^25,1.1*2^26,1.1*2^25,etc. */
-static int fe_isnegative(const fe f) {
-  uint8_t s[32];
-  fe_tobytes(s, f);
-  return s[0] & 1;
-}
-
 /* h = 2 * f * f
  * Can overlap h with f.
  *
@@ -880,20 +1103,191 @@ static void fe_sq2(fe h, const fe f) {
   carry4 = h4 + (1 << 25); h5 += carry4 >> 26; h4 -= carry4 & kTop38Bits;
   carry8 = h8 + (1 << 25); h9 += carry8 >> 26; h8 -= carry8 & kTop38Bits;
 
-  carry9 = h9 + (1 << 24); h0 += (carry9 >> 25) * 19; h9 -= carry9 & kTop39Bits;
+  carry9 = h9 + (1 << 24); h0 += (carry9 >> 25) * 19; h9 -= carry9 & kTop39Bits;
+
+  carry0 = h0 + (1 << 25); h1 += carry0 >> 26; h0 -= carry0 & kTop38Bits;
+
+  h[0] = h0;
+  h[1] = h1;
+  h[2] = h2;
+  h[3] = h3;
+  h[4] = h4;
+  h[5] = h5;
+  h[6] = h6;
+  h[7] = h7;
+  h[8] = h8;
+  h[9] = h9;
+}
+
+/* Replace (f,g) with (g,f) if b == 1;
+ * replace (f,g) with (f,g) if b == 0.
+ *
+ * Preconditions: b in {0,1}. */
+static void fe_cswap(fe f, fe g, unsigned int b) {
+  b = 0-b;
+  unsigned i;
+  for (i = 0; i < 10; i++) {
+    int32_t x = f[i] ^ g[i];
+    x &= b;
+    f[i] ^= x;
+    g[i] ^= x;
+  }
+}
+
+/* h = f * 121666
+ * Can overlap h with f.
+ *
+ * Preconditions:
+ *    |f| bounded by 1.1*2^26,1.1*2^25,1.1*2^26,1.1*2^25,etc.
+ *
+ * Postconditions:
+ *    |h| bounded by 1.1*2^25,1.1*2^24,1.1*2^25,1.1*2^24,etc. */
+static void fe_mul121666(fe h, fe f) {
+  int32_t f0 = f[0];
+  int32_t f1 = f[1];
+  int32_t f2 = f[2];
+  int32_t f3 = f[3];
+  int32_t f4 = f[4];
+  int32_t f5 = f[5];
+  int32_t f6 = f[6];
+  int32_t f7 = f[7];
+  int32_t f8 = f[8];
+  int32_t f9 = f[9];
+  int64_t h0 = f0 * (int64_t) 121666;
+  int64_t h1 = f1 * (int64_t) 121666;
+  int64_t h2 = f2 * (int64_t) 121666;
+  int64_t h3 = f3 * (int64_t) 121666;
+  int64_t h4 = f4 * (int64_t) 121666;
+  int64_t h5 = f5 * (int64_t) 121666;
+  int64_t h6 = f6 * (int64_t) 121666;
+  int64_t h7 = f7 * (int64_t) 121666;
+  int64_t h8 = f8 * (int64_t) 121666;
+  int64_t h9 = f9 * (int64_t) 121666;
+  int64_t carry0;
+  int64_t carry1;
+  int64_t carry2;
+  int64_t carry3;
+  int64_t carry4;
+  int64_t carry5;
+  int64_t carry6;
+  int64_t carry7;
+  int64_t carry8;
+  int64_t carry9;
+
+  carry9 = h9 + (1 << 24); h0 += (carry9 >> 25) * 19; h9 -= carry9 & kTop39Bits;
+  carry1 = h1 + (1 << 24); h2 += carry1 >> 25; h1 -= carry1 & kTop39Bits;
+  carry3 = h3 + (1 << 24); h4 += carry3 >> 25; h3 -= carry3 & kTop39Bits;
+  carry5 = h5 + (1 << 24); h6 += carry5 >> 25; h5 -= carry5 & kTop39Bits;
+  carry7 = h7 + (1 << 24); h8 += carry7 >> 25; h7 -= carry7 & kTop39Bits;
+
+  carry0 = h0 + (1 << 25); h1 += carry0 >> 26; h0 -= carry0 & kTop38Bits;
+  carry2 = h2 + (1 << 25); h3 += carry2 >> 26; h2 -= carry2 & kTop38Bits;
+  carry4 = h4 + (1 << 25); h5 += carry4 >> 26; h4 -= carry4 & kTop38Bits;
+  carry6 = h6 + (1 << 25); h7 += carry6 >> 26; h6 -= carry6 & kTop38Bits;
+  carry8 = h8 + (1 << 25); h9 += carry8 >> 26; h8 -= carry8 & kTop38Bits;
+
+  h[0] = h0;
+  h[1] = h1;
+  h[2] = h2;
+  h[3] = h3;
+  h[4] = h4;
+  h[5] = h5;
+  h[6] = h6;
+  h[7] = h7;
+  h[8] = h8;
+  h[9] = h9;
+}
+
+/* h = f, where f is in the ten limb representation used by the precomputed
+ * tables. */
+static void fe_from_ref10(fe h, const int32_t f[10]) {
+  memmove(h, f, sizeof(int32_t) * 10);
+}
+
+#endif  /* CURVE25519_64BIT */
+
+static void fe_invert(fe out, const fe z) {
+  fe t0;
+  fe t1;
+  fe t2;
+  fe t3;
+  int i;
+
+  fe_sq(t0, z);
+  fe_sq(t1, t0);
+  for (i = 1; i < 2; ++i) {
+    fe_sq(t1, t1);
+  }
+  fe_mul(t1, z, t1);
+  fe_mul(t0, t0, t1);
+  fe_sq(t2, t0);
+  fe_mul(t1, t1, t2);
+  fe_sq(t2, t1);
+  for (i = 1; i < 5; ++i) {
+    fe_sq(t2, t2);
+  }
+  fe_mul(t1, t2, t1);
+  fe_sq(t2, t1);
+  for (i = 1; i < 10; ++i) {
+    fe_sq(t2, t2);
+  }
+  fe_mul(t2, t2, t1);
+  fe_sq(t3, t2);
+  for (i = 1; i < 20; ++i) {
+    fe_sq(t3, t3);
+  }
+  fe_mul(t2, t3, t2);
+  fe_sq(t2, t2);
+  for (i = 1; i < 10; ++i) {
+    fe_sq(t2, t2);
+  }
+  fe_mul(t1, t2, t1);
+  fe_sq(t2, t1);
+  for (i = 1; i < 50; ++i) {
+    fe_sq(t2, t2);
+  }
+  fe_mul(t2, t2, t1);
+  fe_sq(t3, t2);
+  for (i = 1; i < 100; ++i) {
+    fe_sq(t3, t3);
+  }
+  fe_mul(t2, t3, t2);
+  fe_sq(t2, t2);
+  for (i = 1; i < 50; ++i) {
+    fe_sq(t2, t2);
+  }
+  fe_mul(t1, t2, t1);
+  fe_sq(t1, t1);
+  for (i = 1; i < 5; ++i) {
+    fe_sq(t1, t1);
+  }
+  fe_mul(out, t1, t0);
+}
+
+/* return 0 if f == 0
+ * return 1 if f != 0
+ *
+ * Preconditions:
+ *    |f| bounded by 1.1*2^26,1.1*2^25,1.1*2^26,1.1*2^25,etc., or with
+ *    CURVE25519_64BIT, f[i] bounded by 1.1*2^51. */
+static int fe_isnonzero(const fe f) {
+  uint8_t s[32];
+  fe_tobytes(s, f);
 
-  carry0 = h0 + (1 << 25); h1 += carry0 >> 26; h0 -= carry0 & kTop38Bits;
+  static const uint8_t zero[32] = {0};
+  return timingsafe_memcmp(s, zero, sizeof(zero)) != 0;
+}
 
-  h[0] = h0;
-  h[1] = h1;
-  h[2] = h2;
-  h[3] = h3;
-  h[4] = h4;
-  h[5] = h5;
-  h[6] = h6;
-  h[7] = h7;
-  h[8] = h8;
-  h[9] = h9;
+/* return 1 if f is in {1,3,5,...,q-2}
+ * return 0 if f is in {0,2,4,...,q-1}
+ *
+ * Preconditions:
+ *    |f| bounded by 1.1*2^26,1.1*2^25,1.1*2^26,1.1*2^25,etc., or with
+ *    CURVE25519_64BIT, f[i] bounded by 1.1*2^51. */
+static int fe_isnegative(const fe f) {
+  uint8_t s[32];
+  fe_tobytes(s, f);
+  return s[0] & 1;
 }
 
 static void fe_pow22523(fe out, const fe z) {
@@ -977,11 +1371,19 @@ static void ge_p3_tobytes(uint8_t *s, const ge_p3 *h) {
   s[31] ^= fe_isnegative(x) << 7;
 }
 
+#if defined(CURVE25519_64BIT)
+static const fe d = {0x34dca135978a3, 0x1a8283b156ebd, 0x5e7a26001c029,
+                     0x739c663a03cbb, 0x52036cee2b6ff};
+
+static const fe sqrtm1 = {0x61b274a0ea0b0, 0xd5a5fc8f189d, 0x7ef5e9cbd0c60,
+                          0x78595a6804c9e, 0x2b8324804fc1d};
+#else
 static const fe d = {-10913610, 13857413, -15372611, 6949391,   114729,
                      -8787816,  -6275908, -3247719,  -18696448, -12055116};
 
 static const fe sqrtm1 = {-32595792, -7943725,  9377950,  3500415, 12389472,
                           -272473,   -25146209, -2005654, 326686,  11406482};
+#endif
 
 int x25519_ge_frombytes_vartime(ge_p3 *h, const uint8_t *s) {
   fe u;
@@ -1059,8 +1461,13 @@ static void ge_p3_to_p2(ge_p2 *r, const ge_p3 *p) {
   fe_copy(r->Z, p->Z);
 }
 
+#if defined(CURVE25519_64BIT)
+static const fe d2 = {0x69b9426b2f159, 0x35050762add7a, 0x3cf44c0038052,
+                      0x6738cc7407977, 0x2406d9dc56dff};
+#else
 static const fe d2 = {-21827239, -5839606,  -30745221, 13898782, 229458,
                       15978800,  -12551817, -6495438,  29715968, 9444199};
+#endif
 
 /* r = p */
 void x25519_ge_p3_to_cached(ge_cached *r, const ge_p3 *p) {
@@ -1248,6 +1655,21 @@ void x25519_ge_scalarmult_small_precomp(
   }
 }
 
+/* The precomputed multiples of the base point are stored in the ten limb
+ * representation whichever field implementation is in use, and are converted
+ * to |ge_precomp| as they are used. */
+typedef struct {
+  int32_t yplusx[10];
+  int32_t yminusx[10];
+  int32_t xy2d[10];
+} ge_precomp_ref10;
+
+static void ge_precomp_from_ref10(ge_precomp *r, const ge_precomp_ref10 *p) {
+  fe_from_ref10(r->yplusx, p->yplusx);
+  fe_from_ref10(r->yminusx, p->yminusx);
+  fe_from_ref10(r->xy2d, p->xy2d);
+}
+
 #if defined(OPENSSL_SMALL)
 
 /* This block of code replaces the standard base-point table with a much smaller
@@ -1348,7 +1770,7 @@ void x25519_ge_scalarmult_base(ge_p3 *h, const uint8_t a[32]) {
 #else
 
 /* k25519Precomp[i][j] = (j+1)*256^i*B */
-static const ge_precomp k25519Precomp[32][8] = {
+static const ge_precomp_ref10 k25519Precomp[32][8] = {
     {
         {
             {25967493, -14356035, 29566456, 3660896, -12694345, 4014787,
@@ -3469,20 +3891,32 @@ static uint8_t negative(signed char b) {
   return x;
 }
 
+static void cmov_ref10(ge_precomp_ref10 *t, const ge_precomp_ref10 *u,
+                       uint8_t b) {
+  int32_t mask = 0 - (int32_t)b;
+  unsigned i;
+  for (i = 0; i < 10; i++) {
+    t->yplusx[i] ^= (t->yplusx[i] ^ u->yplusx[i]) & mask;
+    t->yminusx[i] ^= (t->yminusx[i] ^ u->yminusx[i]) & mask;
+    t->xy2d[i] ^= (t->xy2d[i] ^ u->xy2d[i]) & mask;
+  }
+}
+
 static void table_select(ge_precomp *t, int pos, signed char b) {
+  ge_precomp_ref10 sel = {{1}, {1}, {0}};
   ge_precomp minust;
   uint8_t bnegative = negative(b);
   uint8_t babs = b - ((uint8_t)((-bnegative) & b) << 1);
 
-  ge_precomp_0(t);
-  cmov(t, &k25519Precomp[pos][0], equal(babs, 1));
-  cmov(t, &k25519Precomp[pos][1], equal(babs, 2));
-  cmov(t, &k25519Precomp[pos][2], equal(babs, 3));
-  cmov(t, &k25519Precomp[pos][3], equal(babs, 4));
-  cmov(t, &k25519Precomp[pos][4], equal(babs, 5));
-  cmov(t, &k25519Precomp[pos][5], equal(babs, 6));
-  cmov(t, &k25519Precomp[pos][6], equal(babs, 7));
-  cmov(t, &k25519Precomp[pos][7], equal(babs, 8));
+  cmov_ref10(&sel, &k25519Precomp[pos][0], equal(babs, 1));
+  cmov_ref10(&sel, &k25519Precomp[pos][1], equal(babs, 2));
+  cmov_ref10(&sel, &k25519Precomp[pos][2], equal(babs, 3));
+  cmov_ref10(&sel, &k25519Precomp[pos][3], equal(babs, 4));
+  cmov_ref10(&sel, &k25519Precomp[pos][4], equal(babs, 5));
+  cmov_ref10(&sel, &k25519Precomp[pos][5], equal(babs, 6));
+  cmov_ref10(&sel, &k25519Precomp[pos][6], equal(babs, 7));
+  cmov_ref10(&sel, &k25519Precomp[pos][7], equal(babs, 8));
+  ge_precomp_from_ref10(t, &sel);
   fe_copy(minust.yplusx, t->yminusx);
   fe_copy(minust.yminusx, t->yplusx);
   fe_neg(minust.xy2d, t->xy2d);
@@ -3640,7 +4074,7 @@ static void slide(signed char *r, const uint8_t *a) {
   }
 }
 
-static const ge_precomp Bi[8] = {
+static const ge_precomp_ref10 Bi[8] = {
     {
         {25967493, -14356035, 29566456, 3660896, -12694345, 4014787, 27544626,
          -11754271, -6079156, 2047605},
@@ -3717,6 +4151,7 @@ ge_double_scalarmult_vartime(ge_p2 *r, const uint8_t *a,
   signed char aslide[256];
   signed char bslide[256];
   ge_cached Ai[8]; /* A,3A,5A,7A,9A,11A,13A,15A */
+  ge_precomp Bj;
   ge_p1p1 t;
   ge_p3 u;
   ge_p3 A2;
@@ -3771,10 +4206,12 @@ ge_double_scalarmult_vartime(ge_p2 *r, const uint8_t *a,
 
     if (bslide[i] > 0) {
       x25519_ge_p1p1_to_p3(&u, &t);
-      ge_madd(&t, &u, &Bi[bslide[i] / 2]);
+      ge_precomp_from_ref10(&Bj, &Bi[bslide[i] / 2]);
+      ge_madd(&t, &u, &Bj);
     } else if (bslide[i] < 0) {
       x25519_ge_p1p1_to_p3(&u, &t);
-      ge_msub(&t, &u, &Bi[(-bslide[i]) / 2]);
+      ge_precomp_from_ref10(&Bj, &Bi[(-bslide[i]) / 2]);
+      ge_msub(&t, &u, &Bj);
     }
 
     x25519_ge_p1p1_to_p2(r, &t);
@@ -4683,11 +5120,24 @@ static const uint8_t order[] = {
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10,
 };
 
+/* Returns one if s is in the range [0, order). This value is public, so
+ * there is no need to make this constant time. */
+static int sc_is_canonical(const uint8_t s[32]) {
+  int i;
+
+  for (i = 31; i >= 0; i--) {
+    if (s[i] > order[i])
+      return 0;
+    if (s[i] < order[i])
+      return 1;
+  }
+  return 0;
+}
+
 int ED25519_verify(const uint8_t *message, size_t message_len,
     const uint8_t signature[ED25519_SIGNATURE_LENGTH],
     const uint8_t public_key[ED25519_PUBLIC_KEY_LENGTH]) {
   ge_p3 A;
-  int i;
   if ((signature[63] & 224) != 0 ||
       x25519_ge_frombytes_vartime(&A, public_key) != 0) {
     return 0;
@@ -4705,17 +5155,10 @@ int ED25519_verify(const uint8_t *message, size_t message_len,
 
   /*
    * https://tools.ietf.org/html/rfc8032#section-5.1.7 requires that scopy be
-   * in the range [0, order) to prevent signature malleability. This value is
-   * public, so there is no need to make this constant time.
+   * in the range [0, order) to prevent signature malleability.
    */
-  for (i = 31; i >= 0; i--) {
-    if (scopy[i] > order[i])
-      return 0;
-    if (scopy[i] < order[i])
-      break;
-    if (i == 0)
-      return 0;
-  }
+  if (!sc_is_canonical(scopy))
+    return 0;
 
   SHA512_CTX hash_ctx;
   SHA512_Init(&hash_ctx);
@@ -4736,83 +5179,394 @@ int ED25519_verify(const uint8_t *message, size_t message_len,
   return timingsafe_memcmp(rcheck, rcopy, sizeof(rcheck)) == 0;
 }
 
-/* Replace (f,g) with (g,f) if b == 1;
- * replace (f,g) with (f,g) if b == 0.
+/* Batch verification.
  *
- * Preconditions: b in {0,1}. */
-static void fe_cswap(fe f, fe g, unsigned int b) {
-  b = 0-b;
-  unsigned i;
-  for (i = 0; i < 10; i++) {
-    int32_t x = f[i] ^ g[i];
-    x &= b;
-    f[i] ^= x;
-    g[i] ^= x;
+ * A batch of signatures (R_i, s_i) by keys A_i with h_i = H(R_i || A_i || M_i)
+ * is checked with a random linear combination of the verification equations,
+ *
+ *   [8]([sum z_i s_i]B - sum [z_i]R_i - sum [z_i h_i]A_i) = 0,
+ *
+ * where the z_i are random 128-bit values. The sum over the R_i and A_i is
+ * computed with Pippenger's bucket method using signed radix 2^c digits. If
+ * the combined check fails, the batch is split in half and each half checked
+ * again until the halves are small enough to verify one signature at a time.
+ * Single signatures are checked with the same cofactored equation, so that
+ * the result for a signature does not depend on the batch it is in. */
+
+/* Maximum number of signatures in one multi-scalar multiplication. */
+#define ED25519_BATCH_MAX 1024
+
+/* Batches smaller than this are verified one signature at a time. */
+#define ED25519_BATCH_MIN 16
+
+struct ed25519_batch {
+  const uint8_t *const *messages;
+  const size_t *message_lens;
+  const uint8_t *const *signatures;
+  const uint8_t *const *public_keys;
+  size_t *index;          /* entry in the caller's arrays */
+  ge_precomp *points;     /* R_i, A_i */
+  uint8_t (*scalars)[32]; /* z_i, z_i h_i */
+  uint8_t (*zs)[32];      /* z_i s_i */
+  uint8_t *carries;
+  ge_p3 *buckets;
+  ge_p3 *windows;
+};
+
+/* Returns the window size for a multi-scalar multiplication of n points. */
+static unsigned ed25519_batch_window(size_t n) {
+  unsigned c = 4;
+
+  while (c < 16 && ((size_t)1 << (c + 3)) <= n) {
+    c++;
   }
+  return c;
 }
 
-/* h = f * 121666
- * Can overlap h with f.
+/* Returns the c bits of s starting at bit pos. */
+static unsigned sc_window(const uint8_t s[32], unsigned pos, unsigned c) {
+  unsigned i = pos >> 3;
+  uint32_t v = 0;
+
+  if (i < 32) {
+    v = s[i];
+  }
+  if (i + 1 < 32) {
+    v |= (uint32_t)s[i + 1] << 8;
+  }
+  if (i + 2 < 32) {
+    v |= (uint32_t)s[i + 2] << 16;
+  }
+  return (v >> (pos & 7)) & ((1 << c) - 1);
+}
+
+/* Sets h = sum [scalars[i]]points[i] for i < n. Each scalar is below 2^253. */
+static void ed25519_batch_msm(struct ed25519_batch *b, ge_p3 *h,
+                              const ge_precomp *points,
+                              const uint8_t (*scalars)[32], size_t n) {
+  unsigned c = ed25519_batch_window(n);
+  unsigned num_windows = 256 / c + 1;
+  size_t num_buckets = (size_t)1 << (c - 1);
+  ge_cached cached;
+  ge_p1p1 t;
+  ge_p2 s;
+  ge_p3 running;
+  size_t i, j;
+  unsigned k;
+
+  memset(b->carries, 0, n);
+
+  for (k = 0; k < num_windows; k++) {
+    for (j = 0; j < num_buckets; j++) {
+      ge_p3_0(&b->buckets[j]);
+    }
+
+    for (i = 0; i < n; i++) {
+      int w = b->carries[i] + sc_window(scalars[i], k * c, c);
+
+      b->carries[i] = w >= (int)num_buckets;
+      w -= b->carries[i] << c;
+      if (w > 0) {
+        ge_madd(&t, &b->buckets[w - 1], &points[i]);
+        x25519_ge_p1p1_to_p3(&b->buckets[w - 1], &t);
+      } else if (w < 0) {
+        ge_msub(&t, &b->buckets[-w - 1], &points[i]);
+        x25519_ge_p1p1_to_p3(&b->buckets[-w - 1], &t);
+      }
+    }
+
+    /* windows[k] = sum (j+1) buckets[j], accumulated from the top. */
+    ge_p3_0(&running);
+    ge_p3_0(&b->windows[k]);
+    for (j = num_buckets; j-- > 0;) {
+      x25519_ge_p3_to_cached(&cached, &b->buckets[j]);
+      x25519_ge_add(&t, &running, &cached);
+      x25519_ge_p1p1_to_p3(&running, &t);
+      x25519_ge_p3_to_cached(&cached, &running);
+      x25519_ge_add(&t, &b->windows[k], &cached);
+      x25519_ge_p1p1_to_p3(&b->windows[k], &t);
+    }
+  }
+
+  *h = b->windows[num_windows - 1];
+  for (k = num_windows - 1; k-- > 0;) {
+    unsigned d;
+
+    ge_p3_dbl(&t, h);
+    for (d = 1; d < c; d++) {
+      x25519_ge_p1p1_to_p2(&s, &t);
+      ge_p2_dbl(&t, &s);
+    }
+    x25519_ge_p1p1_to_p3(h, &t);
+    x25519_ge_p3_to_cached(&cached, &b->windows[k]);
+    x25519_ge_add(&t, h, &cached);
+    x25519_ge_p1p1_to_p3(h, &t);
+  }
+}
+
+/* Returns one if [8]t is the identity, (0:Z:Z). */
+static int ed25519_is_small_order(const ge_p1p1 *t) {
+  ge_p1p1 u;
+  ge_p2 s;
+  fe check;
+
+  x25519_ge_p1p1_to_p2(&s, t);
+  ge_p2_dbl(&u, &s);
+  x25519_ge_p1p1_to_p2(&s, &u);
+  ge_p2_dbl(&u, &s);
+  x25519_ge_p1p1_to_p2(&s, &u);
+  ge_p2_dbl(&u, &s);
+  x25519_ge_p1p1_to_p2(&s, &u);
+
+  fe_sub(check, s.Y, s.Z);
+  return !fe_isnonzero(s.X) && !fe_isnonzero(check);
+}
+
+/* Checks a single signature with the cofactored verification equation,
  *
- * Preconditions:
- *    |f| bounded by 1.1*2^26,1.1*2^25,1.1*2^26,1.1*2^25,etc.
+ *   [8]([s]B - R - [h]A) = 0,
  *
- * Postconditions:
- *    |h| bounded by 1.1*2^25,1.1*2^24,1.1*2^25,1.1*2^24,etc. */
-static void fe_mul121666(fe h, fe f) {
-  int32_t f0 = f[0];
-  int32_t f1 = f[1];
-  int32_t f2 = f[2];
-  int32_t f3 = f[3];
-  int32_t f4 = f[4];
-  int32_t f5 = f[5];
-  int32_t f6 = f[6];
-  int32_t f7 = f[7];
-  int32_t f8 = f[8];
-  int32_t f9 = f[9];
-  int64_t h0 = f0 * (int64_t) 121666;
-  int64_t h1 = f1 * (int64_t) 121666;
-  int64_t h2 = f2 * (int64_t) 121666;
-  int64_t h3 = f3 * (int64_t) 121666;
-  int64_t h4 = f4 * (int64_t) 121666;
-  int64_t h5 = f5 * (int64_t) 121666;
-  int64_t h6 = f6 * (int64_t) 121666;
-  int64_t h7 = f7 * (int64_t) 121666;
-  int64_t h8 = f8 * (int64_t) 121666;
-  int64_t h9 = f9 * (int64_t) 121666;
-  int64_t carry0;
-  int64_t carry1;
-  int64_t carry2;
-  int64_t carry3;
-  int64_t carry4;
-  int64_t carry5;
-  int64_t carry6;
-  int64_t carry7;
-  int64_t carry8;
-  int64_t carry9;
+ * rejecting the same encodings as ED25519_verify. */
+static int ed25519_verify_cofactored(const uint8_t *message,
+                                     size_t message_len,
+                                     const uint8_t signature[64],
+                                     const uint8_t public_key[32]) {
+  uint8_t h[SHA512_DIGEST_LENGTH];
+  uint8_t rcheck[32];
+  SHA512_CTX hash_ctx;
+  ge_cached cached;
+  ge_p1p1 t;
+  ge_p2 P;
+  ge_p3 A, R, Q;
 
-  carry9 = h9 + (1 << 24); h0 += (carry9 >> 25) * 19; h9 -= carry9 & kTop39Bits;
-  carry1 = h1 + (1 << 24); h2 += carry1 >> 25; h1 -= carry1 & kTop39Bits;
-  carry3 = h3 + (1 << 24); h4 += carry3 >> 25; h3 -= carry3 & kTop39Bits;
-  carry5 = h5 + (1 << 24); h6 += carry5 >> 25; h5 -= carry5 & kTop39Bits;
-  carry7 = h7 + (1 << 24); h8 += carry7 >> 25; h7 -= carry7 & kTop39Bits;
+  if ((signature[63] & 224) != 0 || !sc_is_canonical(signature + 32)) {
+    return 0;
+  }
+  if (x25519_ge_frombytes_vartime(&A, public_key) != 0 ||
+      x25519_ge_frombytes_vartime(&R, signature) != 0) {
+    return 0;
+  }
 
-  carry0 = h0 + (1 << 25); h1 += carry0 >> 26; h0 -= carry0 & kTop38Bits;
-  carry2 = h2 + (1 << 25); h3 += carry2 >> 26; h2 -= carry2 & kTop38Bits;
-  carry4 = h4 + (1 << 25); h5 += carry4 >> 26; h4 -= carry4 & kTop38Bits;
-  carry6 = h6 + (1 << 25); h7 += carry6 >> 26; h6 -= carry6 & kTop38Bits;
-  carry8 = h8 + (1 << 25); h9 += carry8 >> 26; h8 -= carry8 & kTop38Bits;
+  /* A non-canonical R never verifies with ED25519_verify. */
+  fe_tobytes(rcheck, R.Y);
+  rcheck[31] ^= fe_isnegative(R.X) << 7;
+  if (memcmp(rcheck, signature, sizeof(rcheck)) != 0) {
+    return 0;
+  }
 
-  h[0] = h0;
-  h[1] = h1;
-  h[2] = h2;
-  h[3] = h3;
-  h[4] = h4;
-  h[5] = h5;
-  h[6] = h6;
-  h[7] = h7;
-  h[8] = h8;
-  h[9] = h9;
+  SHA512_Init(&hash_ctx);
+  SHA512_Update(&hash_ctx, signature, 32);
+  SHA512_Update(&hash_ctx, public_key, 32);
+  SHA512_Update(&hash_ctx, message, message_len);
+  SHA512_Final(h, &hash_ctx);
+  x25519_sc_reduce(h);
+
+  fe_neg(A.X, A.X);
+  fe_neg(A.T, A.T);
+  ge_double_scalarmult_vartime(&P, h, &A, signature + 32);
+
+  /* Extend P = [s]B - [h]A to (XZ:YZ:Z^2:XY) and subtract R. */
+  fe_mul(Q.X, P.X, P.Z);
+  fe_mul(Q.Y, P.Y, P.Z);
+  fe_sq(Q.Z, P.Z);
+  fe_mul(Q.T, P.X, P.Y);
+  x25519_ge_p3_to_cached(&cached, &R);
+  x25519_ge_sub(&t, &Q, &cached);
+
+  return ed25519_is_small_order(&t);
+}
+
+/* Returns one if the combined verification equation holds for the prepared
+ * entries start, ..., start+num-1. */
+static int ed25519_batch_check(struct ed25519_batch *b, size_t start,
+                               size_t num) {
+  static const uint8_t one[32] = {1};
+  uint8_t sum[32] = {0};
+  ge_cached cached;
+  ge_p1p1 t;
+  ge_p3 sB, M;
+  size_t i;
+
+  for (i = start; i < start + num; i++) {
+    sc_muladd(sum, one, b->zs[i], sum);
+  }
+  x25519_ge_scalarmult_base(&sB, sum);
+
+  ed25519_batch_msm(b, &M, &b->points[2 * start],
+                    (const uint8_t (*)[32])&b->scalars[2 * start], 2 * num);
+
+  x25519_ge_p3_to_cached(&cached, &M);
+  x25519_ge_sub(&t, &sB, &cached);
+
+  return ed25519_is_small_order(&t);
+}
+
+/* Verifies the prepared entries start, ..., start+num-1, recording the result
+ * for each of them in valid. */
+static void ed25519_batch_verify(struct ed25519_batch *b, size_t start,
+                                 size_t num, int *valid) {
+  size_t i, half;
+
+  if (num < ED25519_BATCH_MIN) {
+    for (i = start; i < start + num; i++) {
+      size_t idx = b->index[i];
+      valid[idx] = ed25519_verify_cofactored(b->messages[idx],
+                                             b->message_lens[idx],
+                                             b->signatures[idx],
+                                             b->public_keys[idx]);
+    }
+    return;
+  }
+
+  if (ed25519_batch_check(b, start, num)) {
+    for (i = start; i < start + num; i++) {
+      valid[b->index[i]] = 1;
+    }
+    return;
+  }
+
+  half = num / 2;
+  ed25519_batch_verify(b, start, half, valid);
+  ed25519_batch_verify(b, start + half, num - half, valid);
+}
+
+/* Decodes entry idx and stores it as prepared entry i. Returns zero if the
+ * signature is invalid. */
+static int ed25519_batch_prepare(struct ed25519_batch *b, size_t i,
+                                 size_t idx) {
+  static const uint8_t zero[32] = {0};
+  const uint8_t *signature = b->signatures[idx];
+  const uint8_t *public_key = b->public_keys[idx];
+  uint8_t rcheck[32];
+  uint8_t z[32] = {0};
+  uint8_t h[SHA512_DIGEST_LENGTH];
+  SHA512_CTX hash_ctx;
+  ge_p3 A, R;
+
+  if ((signature[63] & 224) != 0 || !sc_is_canonical(signature + 32)) {
+    return 0;
+  }
+  if (x25519_ge_frombytes_vartime(&A, public_key) != 0 ||
+      x25519_ge_frombytes_vartime(&R, signature) != 0) {
+    return 0;
+  }
+
+  /* ED25519_verify compares R with a canonical encoding, so a non-canonical
+   * R can never verify. Both points have Z = 1. */
+  fe_tobytes(rcheck, R.Y);
+  rcheck[31] ^= fe_isnegative(R.X) << 7;
+  if (memcmp(rcheck, signature, sizeof(rcheck)) != 0) {
+    return 0;
+  }
+
+  SHA512_Init(&hash_ctx);
+  SHA512_Update(&hash_ctx, signature, 32);
+  SHA512_Update(&hash_ctx, public_key, 32);
+  SHA512_Update(&hash_ctx, b->messages[idx], b->message_lens[idx]);
+  SHA512_Final(h, &hash_ctx);
+  x25519_sc_reduce(h);
+
+  arc4random_buf(z, 16);
+
+  b->index[i] = idx;
+  memcpy(b->scalars[2 * i], z, 32);
+  sc_muladd(b->scalars[2 * i + 1], z, h, zero);
+  sc_muladd(b->zs[i], z, signature + 32, zero);
+
+  fe_add(b->points[2 * i].yplusx, R.Y, R.X);
+  fe_sub(b->points[2 * i].yminusx, R.Y, R.X);
+  fe_mul(b->points[2 * i].xy2d, R.T, d2);
+  fe_add(b->points[2 * i + 1].yplusx, A.Y, A.X);
+  fe_sub(b->points[2 * i + 1].yminusx, A.Y, A.X);
+  fe_mul(b->points[2 * i + 1].xy2d, A.T, d2);
+
+  return 1;
+}
+
+static void ed25519_batch_cleanup(struct ed25519_batch *b) {
+  free(b->index);
+  free(b->points);
+  free(b->scalars);
+  free(b->zs);
+  free(b->carries);
+  free(b->buckets);
+  free(b->windows);
+}
+
+/* Allocates the tables for batches of up to max signatures. */
+static int ed25519_batch_init(struct ed25519_batch *b, size_t max) {
+  unsigned c = ed25519_batch_window(2 * max);
+
+  if ((b->index = calloc(max, sizeof(*b->index))) == NULL)
+    return 0;
+  if ((b->points = calloc(2 * max, sizeof(*b->points))) == NULL)
+    return 0;
+  if ((b->scalars = calloc(2 * max, sizeof(*b->scalars))) == NULL)
+    return 0;
+  if ((b->zs = calloc(max, sizeof(*b->zs))) == NULL)
+    return 0;
+  if ((b->carries = calloc(2 * max, 1)) == NULL)
+    return 0;
+  if ((b->buckets = calloc((size_t)1 << (c - 1), sizeof(*b->buckets))) == NULL)
+    return 0;
+  if ((b->windows = calloc(256 / 4 + 1, sizeof(*b->windows))) == NULL)
+    return 0;
+
+  return 1;
+}
+
+int ED25519_verify_batch(const uint8_t *const *messages,
+    const size_t *message_lens, const uint8_t *const *signatures,
+    const uint8_t *const *public_keys, size_t num, int *out_valid) {
+  struct ed25519_batch b;
+  size_t chunk, i, n;
+  int *valid;
+  int ret = 1;
+
+  if (num == 0)
+    return 1;
+
+  if ((valid = out_valid) == NULL) {
+    if ((valid = calloc(num, sizeof(*valid))) == NULL)
+      return 0;
+  }
+
+  memset(&b, 0, sizeof(b));
+  b.messages = messages;
+  b.message_lens = message_lens;
+  b.signatures = signatures;
+  b.public_keys = public_keys;
+
+  chunk = num < ED25519_BATCH_MAX ? num : ED25519_BATCH_MAX;
+
+  if (num < ED25519_BATCH_MIN || !ed25519_batch_init(&b, chunk)) {
+    /* Too few signatures to gain anything, or no memory for the tables. */
+    for (i = 0; i < num; i++) {
+      valid[i] = ed25519_verify_cofactored(messages[i], message_lens[i],
+                                           signatures[i], public_keys[i]);
+    }
+  } else {
+    for (i = 0; i < num;) {
+      for (n = 0; n < chunk && i < num; i++) {
+        valid[i] = 0;
+        if (ed25519_batch_prepare(&b, n, i)) {
+          n++;
+        }
+      }
+      ed25519_batch_verify(&b, 0, n, valid);
+    }
+  }
+
+  for (i = 0; i < num; i++) {
+    if (!valid[i])
+      ret = 0;
+  }
+
+  ed25519_batch_cleanup(&b);
+  if (valid != out_valid)
+    free(valid);
+
+  return ret;
 }
 
 void
@@ -97,6 +97,22 @@ int ED25519_verify(const uint8_t *message, size_t message_len,
     const uint8_t signature[ED25519_SIGNATURE_LENGTH],
     const uint8_t public_key[ED25519_PUBLIC_KEY_LENGTH]);
 
+/*
+ * ED25519_verify_batch checks |num| signatures at once, where |signatures[i]|
+ * is checked as a signature by |public_keys[i]| of |message_lens[i]| bytes
+ * from |messages[i]|. It returns one iff all signatures are valid and zero
+ * otherwise, including on memory allocation failure when |out_valid| is NULL.
+ * If |out_valid| is not NULL, |out_valid[i]| is set to one if the i-th
+ * signature is valid and to zero otherwise.
+ *
+ * Signatures are checked with the cofactored verification equation, so a
+ * signature whose R or public key has a small order component may be accepted
+ * here but rejected by ED25519_verify.
+ */
+int ED25519_verify_batch(const uint8_t *const *messages,
+    const size_t *message_lens, const uint8_t *const *signatures,
+    const uint8_t *const *public_keys, size_t num, int *out_valid);
+
 #if defined(__cplusplus)
 }  /* extern C */
 #endif
@@ -22,11 +22,24 @@
 
 __BEGIN_HIDDEN_DECLS
 
+/* On LP64 targets with a 128-bit integer type the field arithmetic uses five
+ * 51-bit limbs, otherwise ten limbs of alternating 26 and 25 bits. */
+#if defined(_LP64) && defined(__SIZEOF_INT128__)
+#define CURVE25519_64BIT
+#endif
+
+#if defined(CURVE25519_64BIT)
+/* fe means field element. Here the field is \Z/(2^255-19). An element t,
+ * entries t[0]...t[4], represents the integer t[0]+2^51 t[1]+2^102 t[2]+2^153
+ * t[3]+2^204 t[4]. Each t[i] is kept close to 51 bits. */
+typedef uint64_t fe[5];
+#else
 /* fe means field element. Here the field is \Z/(2^255-19). An element t,
  * entries t[0]...t[9], represents the integer t[0]+2^26 t[1]+2^51 t[2]+2^77
  * t[3]+2^102 t[4]+...+2^230 t[9]. Bounds on each t[i] vary depending on
  * context.  */
 typedef int32_t fe[10];
+#endif
 
 /* ge means group element.
 
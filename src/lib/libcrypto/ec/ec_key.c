@@ -297,6 +297,7 @@ ossl_ec_key_gen(EC_KEY *eckey)
 	EC_POINT_free(eckey->pub_key);
 	eckey->pub_key = pub_key;
 	pub_key = NULL;
+	ec_wNAF_free_public_mult(eckey);
 
 	ret = 1;
 
@@ -455,6 +456,7 @@ EC_KEY_set_group(EC_KEY *key, const EC_GROUP *group)
 	if (key->meth->set_group != NULL &&
 	    key->meth->set_group(key, group) == 0)
 		return 0;
+	ec_wNAF_free_public_mult(key);
 	EC_GROUP_free(key->group);
 	key->group = EC_GROUP_dup(group);
 	return (key->group == NULL) ? 0 : 1;
@@ -493,6 +495,7 @@ EC_KEY_set_public_key(EC_KEY *key, const EC_POINT *pub_key)
 	    key->meth->set_public(key, pub_key) == 0)
 		return 0;
 
+	ec_wNAF_free_public_mult(key);
 	EC_POINT_free(key->pub_key);
 	if ((key->pub_key = EC_POINT_dup(pub_key, key->group)) == NULL)
 		return 0;
@@ -573,6 +576,40 @@ EC_KEY_precompute_mult(EC_KEY *key, BN_CTX *ctx)
 	return EC_GROUP_precompute_mult(key->group, ctx);
 }
 
+int
+EC_KEY_precompute_public_mult(EC_KEY *key, BN_CTX *ctx)
+{
+	if (key->group == NULL || key->pub_key == NULL) {
+		ECerror(ERR_R_PASSED_NULL_PARAMETER);
+		return 0;
+	}
+	if (EC_POINT_is_at_infinity(key->group, key->pub_key) > 0) {
+		ECerror(EC_R_POINT_AT_INFINITY);
+		return 0;
+	}
+	/* Only the generic wNAF multiplication makes use of the table. */
+	if (key->group->meth->mul_double_nonct !=
+	    ec_GFp_simple_mul_double_nonct)
+		return 1;
+	return ec_wNAF_precompute_public_mult(key, ctx);
+}
+
+/*
+ * Compute g_scalar * generator + p_scalar * pub_key for signature
+ * verification, using the multiples of the public key attached by
+ * EC_KEY_precompute_public_mult() if there are any.
+ */
+int
+ec_key_mul_public(const EC_KEY *key, EC_POINT *r, const BIGNUM *g_scalar,
+    const BIGNUM *p_scalar, BN_CTX *ctx)
+{
+	if (key->group->meth->mul_double_nonct ==
+	    ec_GFp_simple_mul_double_nonct)
+		return ec_wNAF_mul_public(key, r, g_scalar, p_scalar, ctx);
+	return EC_POINT_mul(key->group, r, g_scalar, key->pub_key, p_scalar,
+	    ctx);
+}
+
 int
 EC_KEY_get_flags(const EC_KEY *key)
 {
@@ -320,6 +320,10 @@ int ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
 	size_t num, const EC_POINT *points[], const BIGNUM *scalars[], BN_CTX *);
 int ec_wNAF_precompute_mult(EC_GROUP *group, BN_CTX *);
 int ec_wNAF_have_precompute_mult(const EC_GROUP *group);
+int ec_wNAF_precompute_public_mult(EC_KEY *key, BN_CTX *);
+void ec_wNAF_free_public_mult(EC_KEY *key);
+int ec_wNAF_mul_public(const EC_KEY *key, EC_POINT *r, const BIGNUM *g_scalar,
+	const BIGNUM *p_scalar, BN_CTX *);
 
 
 /* method functions in ecp_smpl.c */
@@ -367,6 +371,14 @@ int ec_GFp_simple_mul_single_ct(const EC_GROUP *, EC_POINT *r, const BIGNUM *sca
 int ec_GFp_simple_mul_double_nonct(const EC_GROUP *, EC_POINT *r, const BIGNUM *g_scalar,
 	const BIGNUM *p_scalar, const EC_POINT *point, BN_CTX *);
 
+/* fixed-base multiplication by the generator in ecp_fixed.c */
+#define EC_FIXED_WINDOW_BITS	5
+#define EC_FIXED_WINDOW_POINTS	(1 << (EC_FIXED_WINDOW_BITS - 1))
+
+const BN_ULONG *ec_GFp_fixed_table_points(const EC_GROUP *group,
+    int *windows);
+int ec_GFp_fixed_mul_generator(const EC_GROUP *group, EC_POINT *r,
+    const BIGNUM *scalar, BN_CTX *ctx);
 
 /* method functions in ecp_mont.c */
 int ec_GFp_mont_group_init(EC_GROUP *);
@@ -461,6 +473,14 @@ int ec_GFp_nistp256_have_precompute_mult(const EC_GROUP *group);
 const EC_METHOD *EC_GFp_nistz256_method(void);
 #endif
 
+/* NIST curves with 64-bit limbs in ecp_limb.c */
+#if defined(__SIZEOF_INT128__) && BN_BITS2 == 64
+#define OPENSSL_EC_LIMB64
+const EC_METHOD *EC_GFp_p256_method(void);
+const EC_METHOD *EC_GFp_p384_method(void);
+const EC_METHOD *EC_GFp_p521_method(void);
+#endif
+
 /* EC_METHOD definitions */
 
 struct ec_key_method_st {
@@ -492,6 +512,8 @@ struct ec_key_method_st {
 #define EC_KEY_METHOD_DYNAMIC   1
 
 int ossl_ec_key_gen(EC_KEY *eckey);
+int ec_key_mul_public(const EC_KEY *key, EC_POINT *r, const BIGNUM *g_scalar,
+    const BIGNUM *p_scalar, BN_CTX *ctx);
 int ossl_ecdh_compute_key(void *out, size_t outlen, const EC_POINT *pub_key, EC_KEY *ecdh,
     void *(*KDF) (const void *in, size_t inlen, void *out, size_t *outlen));
 int ossl_ecdsa_verify(int type, const unsigned char *dgst, int dgst_len,
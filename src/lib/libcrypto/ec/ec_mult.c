@@ -329,11 +329,14 @@ compute_wNAF(const BIGNUM *scalar, int w, size_t *ret_len)
  *      \sum scalars[i]*points[i],
  * also including
  *      scalar*generator
- * in the addition if scalar != NULL
+ * in the addition if scalar != NULL.
+ * If point_pre_comp != NULL, it holds the odd multiples of points[0],
+ * which are then used instead of computing them here.
  */
-int
-ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
-    size_t num, const EC_POINT *points[], const BIGNUM *scalars[], BN_CTX *ctx)
+static int
+ec_wNAF_mul_internal(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
+    size_t num, const EC_POINT *points[], const BIGNUM *scalars[],
+    const EC_PRE_COMP *point_pre_comp, BN_CTX *ctx)
 {
 	BN_CTX *new_ctx = NULL;
 	const EC_POINT *generator = NULL;
@@ -374,6 +377,14 @@ ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
 			return 0;
 		}
 	}
+	if (point_pre_comp != NULL) {
+		/* check that point_pre_comp looks sane */
+		if (num == 0 || point_pre_comp->numblocks != 1 ||
+		    point_pre_comp->num != (size_t) 1 << (point_pre_comp->w - 1)) {
+			ECerror(ERR_R_INTERNAL_ERROR);
+			return 0;
+		}
+	}
 
 	if (ctx == NULL) {
 		ctx = new_ctx = BN_CTX_new();
@@ -449,9 +460,15 @@ ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
 	for (i = 0; i < num + num_scalar; i++) {
 		size_t bits;
 
-		bits = i < num ? BN_num_bits(scalars[i]) : BN_num_bits(scalar);
-		wsize[i] = EC_window_bits_for_scalar_size(bits);
-		num_val += (size_t) 1 << (wsize[i] - 1);
+		if (i == 0 && point_pre_comp != NULL) {
+			/* use the window size of the precomputed multiples */
+			wsize[i] = point_pre_comp->w;
+		} else {
+			bits = i < num ? BN_num_bits(scalars[i]) :
+			    BN_num_bits(scalar);
+			wsize[i] = EC_window_bits_for_scalar_size(bits);
+			num_val += (size_t) 1 << (wsize[i] - 1);
+		}
 		wNAF[i + 1] = NULL;	/* make sure we always have a pivot */
 		wNAF[i] = compute_wNAF((i < num ? scalars[i] : scalar), wsize[i], &wNAF_len[i]);
 		if (wNAF[i] == NULL)
@@ -586,6 +603,10 @@ ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
 	/* allocate points for precomputation */
 	v = val;
 	for (i = 0; i < num + num_scalar; i++) {
+		if (i == 0 && point_pre_comp != NULL) {
+			val_sub[i] = point_pre_comp->points;
+			continue;
+		}
 		val_sub[i] = v;
 		for (j = 0; j < ((size_t) 1 << (wsize[i] - 1)); j++) {
 			*v = EC_POINT_new(group);
@@ -606,6 +627,8 @@ ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
 	 * val_sub[i][1] := 3 * points[i] val_sub[i][2] := 5 * points[i] ...
 	 */
 	for (i = 0; i < num + num_scalar; i++) {
+		if (i == 0 && point_pre_comp != NULL)
+			continue;
 		if (i < num) {
 			if (!EC_POINT_copy(val_sub[i][0], points[i]))
 				goto err;
@@ -701,84 +724,44 @@ ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
 	return ret;
 }
 
+int
+ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
+    size_t num, const EC_POINT *points[], const BIGNUM *scalars[], BN_CTX *ctx)
+{
+	return ec_wNAF_mul_internal(group, r, scalar, num, points, scalars,
+	    NULL, ctx);
+}
 
-/* ec_wNAF_precompute_mult()
- * creates an EC_PRE_COMP object with preprecomputed multiples of the generator
+
+/* ec_pre_comp_compute()
+ * fills in 'pre_comp' with precomputed multiples of 'base'
  * for use with wNAF splitting as implemented in ec_wNAF_mul().
  *
- * 'pre_comp->points' is an array of multiples of the generator
+ * 'pre_comp->points' is an array of multiples of 'base'
  * of the following form:
- * points[0] =     generator;
- * points[1] = 3 * generator;
+ * points[0] =     base;
+ * points[1] = 3 * base;
  * ...
- * points[2^(w-1)-1] =     (2^(w-1)-1) * generator;
- * points[2^(w-1)]   =     2^blocksize * generator;
- * points[2^(w-1)+1] = 3 * 2^blocksize * generator;
+ * points[2^(w-1)-1] =     (2^(w-1)-1) * base;
+ * points[2^(w-1)]   =     2^blocksize * base;
+ * points[2^(w-1)+1] = 3 * 2^blocksize * base;
  * ...
- * points[2^(w-1)*(numblocks-1)-1] = (2^(w-1)) *  2^(blocksize*(numblocks-2)) * generator
- * points[2^(w-1)*(numblocks-1)]   =              2^(blocksize*(numblocks-1)) * generator
+ * points[2^(w-1)*(numblocks-1)-1] = (2^(w-1)) *  2^(blocksize*(numblocks-2)) * base
+ * points[2^(w-1)*(numblocks-1)]   =              2^(blocksize*(numblocks-1)) * base
  * ...
- * points[2^(w-1)*numblocks-1]     = (2^(w-1)) *  2^(blocksize*(numblocks-1)) * generator
+ * points[2^(w-1)*numblocks-1]     = (2^(w-1)) *  2^(blocksize*(numblocks-1)) * base
  * points[2^(w-1)*numblocks]       = NULL
  */
-int
-ec_wNAF_precompute_mult(EC_GROUP *group, BN_CTX *ctx)
+static int
+ec_pre_comp_compute(EC_PRE_COMP *pre_comp, const EC_POINT *base_point,
+    size_t blocksize, size_t numblocks, size_t w, BN_CTX *ctx)
 {
-	const EC_POINT *generator;
+	const EC_GROUP *group = pre_comp->group;
 	EC_POINT *tmp_point = NULL, *base = NULL, **var;
-	BN_CTX *new_ctx = NULL;
-	BIGNUM *order;
-	size_t i, bits, w, pre_points_per_block, blocksize, numblocks,
-	 num;
+	size_t i, pre_points_per_block, num;
 	EC_POINT **points = NULL;
-	EC_PRE_COMP *pre_comp;
 	int ret = 0;
 
-	/* if there is an old EC_PRE_COMP object, throw it away */
-	EC_EX_DATA_free_data(&group->extra_data, ec_pre_comp_dup, ec_pre_comp_free, ec_pre_comp_clear_free);
-
-	if ((pre_comp = ec_pre_comp_new(group)) == NULL)
-		return 0;
-
-	generator = EC_GROUP_get0_generator(group);
-	if (generator == NULL) {
-		ECerror(EC_R_UNDEFINED_GENERATOR);
-		goto err;
-	}
-	if (ctx == NULL) {
-		ctx = new_ctx = BN_CTX_new();
-		if (ctx == NULL)
-			goto err;
-	}
-	BN_CTX_start(ctx);
-	if ((order = BN_CTX_get(ctx)) == NULL)
-		goto err;
-
-	if (!EC_GROUP_get_order(group, order, ctx))
-		goto err;
-	if (BN_is_zero(order)) {
-		ECerror(EC_R_UNKNOWN_ORDER);
-		goto err;
-	}
-	bits = BN_num_bits(order);
-	/*
-	 * The following parameters mean we precompute (approximately) one
-	 * point per bit.
-	 *
-	 * TBD: The combination  8, 4  is perfect for 160 bits; for other bit
-	 * lengths, other parameter combinations might provide better
-	 * efficiency.
-	 */
-	blocksize = 8;
-	w = 4;
-	if (EC_window_bits_for_scalar_size(bits) > w) {
-		/* let's not make the window too small ... */
-		w = EC_window_bits_for_scalar_size(bits);
-	}
-	numblocks = (bits + blocksize - 1) / blocksize;	/* max. number of blocks
-							 * to use for wNAF
-							 * splitting */
-
 	pre_points_per_block = (size_t) 1 << (w - 1);
 	num = pre_points_per_block * numblocks;	/* number of points to
 						 * compute and store */
@@ -801,7 +784,7 @@ ec_wNAF_precompute_mult(EC_GROUP *group, BN_CTX *ctx)
 		ECerror(ERR_R_MALLOC_FAILURE);
 		goto err;
 	}
-	if (!EC_POINT_copy(base, generator))
+	if (!EC_POINT_copy(base, base_point))
 		goto err;
 
 	/* do the precomputation */
@@ -843,7 +826,6 @@ ec_wNAF_precompute_mult(EC_GROUP *group, BN_CTX *ctx)
 	if (!EC_POINTs_make_affine(group, num, points, ctx))
 		goto err;
 
-	pre_comp->group = group;
 	pre_comp->blocksize = blocksize;
 	pre_comp->numblocks = numblocks;
 	pre_comp->w = w;
@@ -851,17 +833,8 @@ ec_wNAF_precompute_mult(EC_GROUP *group, BN_CTX *ctx)
 	points = NULL;
 	pre_comp->num = num;
 
-	if (!EC_EX_DATA_set_data(&group->extra_data, pre_comp,
-		ec_pre_comp_dup, ec_pre_comp_free, ec_pre_comp_clear_free))
-		goto err;
-	pre_comp = NULL;
-
 	ret = 1;
  err:
-	if (ctx != NULL)
-		BN_CTX_end(ctx);
-	BN_CTX_free(new_ctx);
-	ec_pre_comp_free(pre_comp);
 	if (points) {
 		EC_POINT **p;
 
@@ -874,6 +847,83 @@ ec_wNAF_precompute_mult(EC_GROUP *group, BN_CTX *ctx)
 	return ret;
 }
 
+/* ec_wNAF_precompute_mult()
+ * creates an EC_PRE_COMP object with preprecomputed multiples of the generator
+ * for use with wNAF splitting as implemented in ec_wNAF_mul().
+ */
+int
+ec_wNAF_precompute_mult(EC_GROUP *group, BN_CTX *ctx)
+{
+	const EC_POINT *generator;
+	BN_CTX *new_ctx = NULL;
+	BIGNUM *order;
+	size_t bits, w, blocksize, numblocks;
+	EC_PRE_COMP *pre_comp;
+	int ret = 0;
+
+	/* if there is an old EC_PRE_COMP object, throw it away */
+	EC_EX_DATA_free_data(&group->extra_data, ec_pre_comp_dup, ec_pre_comp_free, ec_pre_comp_clear_free);
+
+	if ((pre_comp = ec_pre_comp_new(group)) == NULL)
+		return 0;
+
+	generator = EC_GROUP_get0_generator(group);
+	if (generator == NULL) {
+		ECerror(EC_R_UNDEFINED_GENERATOR);
+		goto err;
+	}
+	if (ctx == NULL) {
+		ctx = new_ctx = BN_CTX_new();
+		if (ctx == NULL)
+			goto err;
+	}
+	BN_CTX_start(ctx);
+	if ((order = BN_CTX_get(ctx)) == NULL)
+		goto err;
+
+	if (!EC_GROUP_get_order(group, order, ctx))
+		goto err;
+	if (BN_is_zero(order)) {
+		ECerror(EC_R_UNKNOWN_ORDER);
+		goto err;
+	}
+	bits = BN_num_bits(order);
+	/*
+	 * The following parameters mean we precompute (approximately) one
+	 * point per bit.
+	 *
+	 * TBD: The combination  8, 4  is perfect for 160 bits; for other bit
+	 * lengths, other parameter combinations might provide better
+	 * efficiency.
+	 */
+	blocksize = 8;
+	w = 4;
+	if (EC_window_bits_for_scalar_size(bits) > w) {
+		/* let's not make the window too small ... */
+		w = EC_window_bits_for_scalar_size(bits);
+	}
+	numblocks = (bits + blocksize - 1) / blocksize;	/* max. number of blocks
+							 * to use for wNAF
+							 * splitting */
+
+	if (!ec_pre_comp_compute(pre_comp, generator, blocksize, numblocks, w,
+	    ctx))
+		goto err;
+
+	if (!EC_EX_DATA_set_data(&group->extra_data, pre_comp,
+		ec_pre_comp_dup, ec_pre_comp_free, ec_pre_comp_clear_free))
+		goto err;
+	pre_comp = NULL;
+
+	ret = 1;
+ err:
+	if (ctx != NULL)
+		BN_CTX_end(ctx);
+	BN_CTX_free(new_ctx);
+	ec_pre_comp_free(pre_comp);
+	return ret;
+}
+
 
 int
 ec_wNAF_have_precompute_mult(const EC_GROUP *group)
@@ -883,3 +933,102 @@ ec_wNAF_have_precompute_mult(const EC_GROUP *group)
 	else
 		return 0;
 }
+
+/*
+ * Window size for the multiples of a public key. The table is built once
+ * per key, so a larger window than EC_window_bits_for_scalar_size() picks
+ * for a single multiplication pays off: it saves additions on every
+ * multiplication at the cost of 2^(w-1) points per key.
+ */
+#define EC_PUBLIC_MULT_WINDOW_BITS 6
+
+/* ec_wNAF_precompute_public_mult()
+ * creates an EC_PRE_COMP object with the odd multiples of the public key
+ * up to (2^w-1) * pub_key and attaches it to 'key', replacing a previous one.
+ * There is no wNAF splitting for the public key since the multiples of the
+ * generator are not split either for most groups: numblocks is 1.
+ */
+int
+ec_wNAF_precompute_public_mult(EC_KEY *key, BN_CTX *ctx)
+{
+	BN_CTX *new_ctx = NULL;
+	EC_PRE_COMP *pre_comp;
+	int bits;
+	int ret = 0;
+
+	if ((pre_comp = ec_pre_comp_new(key->group)) == NULL)
+		return 0;
+
+	if (ctx == NULL) {
+		ctx = new_ctx = BN_CTX_new();
+		if (ctx == NULL)
+			goto err;
+	}
+	if ((bits = EC_GROUP_order_bits(key->group)) <= 0) {
+		ECerror(EC_R_UNKNOWN_ORDER);
+		goto err;
+	}
+	if (!ec_pre_comp_compute(pre_comp, key->pub_key, bits, 1,
+	    EC_PUBLIC_MULT_WINDOW_BITS, ctx))
+		goto err;
+
+	CRYPTO_w_lock(CRYPTO_LOCK_EC);
+	EC_EX_DATA_free_data(&key->method_data, ec_pre_comp_dup,
+	    ec_pre_comp_free, ec_pre_comp_clear_free);
+	ret = EC_EX_DATA_set_data(&key->method_data, pre_comp,
+	    ec_pre_comp_dup, ec_pre_comp_free, ec_pre_comp_clear_free);
+	CRYPTO_w_unlock(CRYPTO_LOCK_EC);
+	if (ret)
+		pre_comp = NULL;
+
+ err:
+	BN_CTX_free(new_ctx);
+	ec_pre_comp_free(pre_comp);
+	return ret;
+}
+
+void
+ec_wNAF_free_public_mult(EC_KEY *key)
+{
+	CRYPTO_w_lock(CRYPTO_LOCK_EC);
+	EC_EX_DATA_free_data(&key->method_data, ec_pre_comp_dup,
+	    ec_pre_comp_free, ec_pre_comp_clear_free);
+	CRYPTO_w_unlock(CRYPTO_LOCK_EC);
+}
+
+/*
+ * Compute g_scalar * generator + p_scalar * pub_key, using the multiples of
+ * the public key from ec_wNAF_precompute_public_mult() if they are present
+ * and still match the key.
+ */
+int
+ec_wNAF_mul_public(const EC_KEY *key, EC_POINT *r, const BIGNUM *g_scalar,
+    const BIGNUM *p_scalar, BN_CTX *ctx)
+{
+	const EC_GROUP *group = key->group;
+	const EC_POINT *point = key->pub_key;
+	EC_PRE_COMP *pre_comp;
+	int ret;
+
+	/* take a reference so that a concurrent update cannot free it */
+	CRYPTO_r_lock(CRYPTO_LOCK_EC);
+	pre_comp = EC_EX_DATA_get_data(key->method_data, ec_pre_comp_dup,
+	    ec_pre_comp_free, ec_pre_comp_clear_free);
+	if (pre_comp != NULL)
+		ec_pre_comp_dup(pre_comp);
+	CRYPTO_r_unlock(CRYPTO_LOCK_EC);
+
+	if (pre_comp != NULL && (pre_comp->points[0]->meth != group->meth ||
+	    EC_POINT_cmp(group, point, pre_comp->points[0], ctx) != 0)) {
+		/* the public key was changed behind our back */
+		ec_pre_comp_free(pre_comp);
+		pre_comp = NULL;
+	}
+
+	ret = ec_wNAF_mul_internal(group, r, g_scalar, 1, &point, &p_scalar,
+	    pre_comp, ctx);
+
+	ec_pre_comp_free(pre_comp);
+
+	return ret;
+}
@@ -0,0 +1,435 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Fixed-base scalar multiplication by the generator of P-256 and P-384.
+ *
+ * With a window width of w bits and m = ceil(bits(order) / w) windows, the
+ * table holds the affine points
+ *
+ *	(2i + 1) * 2^(wj) * G,	0 <= i < 2^(w - 1), 0 <= j < m.
+ *
+ * An odd scalar k < 2^(wm) has a signed representation without zero digits
+ *
+ *	k = sum_j d_j * 2^(wj),	d_j = 2 * u_j - (2^w - 1),
+ *
+ * where u_j is the j-th window of t = (k >> 1) + 2^(wm - 1). Each d_j is odd
+ * and |d_j| < 2^w, so k * G is the sum of exactly m table entries, each one
+ * possibly negated. Entries are selected by scanning the entire window and
+ * even scalars are replaced by order - k, with the result negated at the end.
+ * This replaces the doublings and additions of the ladder by m - 1 mixed
+ * additions, with neither the memory access pattern nor the sequence of
+ * point operations depending on the scalar.
+ *
+ * The tables are built on first use and are shared by all groups that have
+ * the same method and parameters as the corresponding named curve.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/objects.h>
+
+#include "bn_local.h"
+#include "ec_local.h"
+
+struct ec_fixed_table {
+	const EC_METHOD *meth;
+	BIGNUM *field;
+	BIGNUM *a;
+	BIGNUM *b;
+	BIGNUM *order;
+	BIGNUM *x;
+	BIGNUM *y;
+
+	int windows;
+	int words;
+
+	/*
+	 * EC_FIXED_WINDOW_POINTS entries per window, each consisting of the
+	 * X and Y coordinates padded to words, in the method's field encoding.
+	 */
+	BN_ULONG *points;
+};
+
+static struct ec_fixed_table *ec_fixed_p256;
+static struct ec_fixed_table *ec_fixed_p384;
+static pthread_once_t ec_fixed_p256_once = PTHREAD_ONCE_INIT;
+static pthread_once_t ec_fixed_p384_once = PTHREAD_ONCE_INIT;
+
+static void
+ec_fixed_table_free(struct ec_fixed_table *table)
+{
+	if (table == NULL)
+		return;
+
+	BN_free(table->field);
+	BN_free(table->a);
+	BN_free(table->b);
+	BN_free(table->order);
+	BN_free(table->x);
+	BN_free(table->y);
+	free(table->points);
+	free(table);
+}
+
+static int
+ec_fixed_table_words(BN_ULONG *out, const BIGNUM *bn, int words)
+{
+	if (bn->top > words)
+		return 0;
+
+	memset(out, 0, words * sizeof(*out));
+	memcpy(out, bn->d, bn->top * sizeof(*out));
+
+	return 1;
+}
+
+static struct ec_fixed_table *
+ec_fixed_table_new(int nid)
+{
+	struct ec_fixed_table *table = NULL;
+	EC_GROUP *group = NULL;
+	EC_POINT **points = NULL;
+	EC_POINT *base = NULL, *twice = NULL;
+	BN_CTX *ctx = NULL;
+	BN_ULONG *entry;
+	size_t i, j, num = 0;
+	int ok = 0;
+
+	if ((ctx = BN_CTX_new()) == NULL)
+		goto err;
+	if ((group = EC_GROUP_new_by_curve_name(nid)) == NULL)
+		goto err;
+	if (!BN_is_one(&group->cofactor) || !group->generator->Z_is_one)
+		goto err;
+
+	if ((table = calloc(1, sizeof(*table))) == NULL)
+		goto err;
+	table->meth = group->meth;
+	if ((table->field = BN_dup(&group->field)) == NULL)
+		goto err;
+	if ((table->a = BN_dup(&group->a)) == NULL)
+		goto err;
+	if ((table->b = BN_dup(&group->b)) == NULL)
+		goto err;
+	if ((table->order = BN_dup(&group->order)) == NULL)
+		goto err;
+	if ((table->x = BN_dup(&group->generator->X)) == NULL)
+		goto err;
+	if ((table->y = BN_dup(&group->generator->Y)) == NULL)
+		goto err;
+
+	table->words = group->field.top;
+	table->windows = (BN_num_bits(&group->order) + EC_FIXED_WINDOW_BITS - 1) /
+	    EC_FIXED_WINDOW_BITS;
+
+	num = table->windows * EC_FIXED_WINDOW_POINTS;
+	if ((points = calloc(num, sizeof(*points))) == NULL)
+		goto err;
+	for (i = 0; i < num; i++) {
+		if ((points[i] = EC_POINT_new(group)) == NULL)
+			goto err;
+	}
+	if ((base = EC_POINT_dup(group->generator, group)) == NULL)
+		goto err;
+	if ((twice = EC_POINT_new(group)) == NULL)
+		goto err;
+
+	/* Window j holds the odd multiples of base = 2^(wj) * G. */
+	for (j = 0; j < table->windows; j++) {
+		EC_POINT **window = &points[j * EC_FIXED_WINDOW_POINTS];
+
+		if (!EC_POINT_dbl(group, twice, base, ctx))
+			goto err;
+		if (!EC_POINT_copy(window[0], base))
+			goto err;
+		for (i = 1; i < EC_FIXED_WINDOW_POINTS; i++) {
+			if (!EC_POINT_add(group, window[i], window[i - 1],
+			    twice, ctx))
+				goto err;
+		}
+		for (i = 0; i < EC_FIXED_WINDOW_BITS; i++) {
+			if (!EC_POINT_dbl(group, base, base, ctx))
+				goto err;
+		}
+	}
+
+	if (!EC_POINTs_make_affine(group, num, points, ctx))
+		goto err;
+
+	if ((table->points = calloc(num, 2 * table->words *
+	    sizeof(*table->points))) == NULL)
+		goto err;
+
+	entry = table->points;
+	for (i = 0; i < num; i++) {
+		if (!points[i]->Z_is_one)
+			goto err;
+		if (!ec_fixed_table_words(entry, &points[i]->X, table->words))
+			goto err;
+		entry += table->words;
+		if (!ec_fixed_table_words(entry, &points[i]->Y, table->words))
+			goto err;
+		entry += table->words;
+	}
+
+	ok = 1;
+
+ err:
+	if (!ok) {
+		ec_fixed_table_free(table);
+		table = NULL;
+	}
+	if (points != NULL) {
+		for (i = 0; i < num; i++)
+			EC_POINT_free(points[i]);
+	}
+	free(points);
+	EC_POINT_free(base);
+	EC_POINT_free(twice);
+	EC_GROUP_free(group);
+	BN_CTX_free(ctx);
+
+	return table;
+}
+
+static void
+ec_fixed_p256_init(void)
+{
+	ec_fixed_p256 = ec_fixed_table_new(NID_X9_62_prime256v1);
+}
+
+static void
+ec_fixed_p384_init(void)
+{
+	ec_fixed_p384 = ec_fixed_table_new(NID_secp384r1);
+}
+
+static const struct ec_fixed_table *
+ec_fixed_table(const EC_GROUP *group)
+{
+	const struct ec_fixed_table *table;
+	const EC_POINT *generator = group->generator;
+
+	switch (group->curve_name) {
+	case NID_X9_62_prime256v1:
+		if (pthread_once(&ec_fixed_p256_once, ec_fixed_p256_init) != 0)
+			return NULL;
+		table = ec_fixed_p256;
+		break;
+	case NID_secp384r1:
+		if (pthread_once(&ec_fixed_p384_once, ec_fixed_p384_init) != 0)
+			return NULL;
+		table = ec_fixed_p384;
+		break;
+	default:
+		return NULL;
+	}
+
+	if (table == NULL)
+		return NULL;
+
+	/*
+	 * The curve name is only a hint - the group must have the parameters
+	 * of the named curve and use the same field encoding as the table.
+	 */
+	if (group->meth != table->meth)
+		return NULL;
+	if (generator == NULL || !generator->Z_is_one)
+		return NULL;
+	if (BN_cmp(&group->field, table->field) != 0 ||
+	    BN_cmp(&group->a, table->a) != 0 ||
+	    BN_cmp(&group->b, table->b) != 0 ||
+	    BN_cmp(&group->order, table->order) != 0 ||
+	    !BN_is_one(&group->cofactor) ||
+	    BN_cmp(&generator->X, table->x) != 0 ||
+	    BN_cmp(&generator->Y, table->y) != 0)
+		return NULL;
+
+	return table;
+}
+
+/*
+ * Return the table for methods that implement their own point arithmetic.
+ * Each of the windows holds EC_FIXED_WINDOW_POINTS affine entries, stored as
+ * field.top words of X followed by field.top words of Y.
+ */
+const BN_ULONG *
+ec_GFp_fixed_table_points(const EC_GROUP *group, int *windows)
+{
+	const struct ec_fixed_table *table;
+
+	if ((table = ec_fixed_table(group)) == NULL)
+		return NULL;
+	if (table->words != group->field.top)
+		return NULL;
+
+	*windows = table->windows;
+
+	return table->points;
+}
+
+/*
+ * Set p to the table entry for the digit 2u - (2^w - 1) in the given window.
+ * All entries of the window are read, so that the memory access pattern does
+ * not depend on u.
+ */
+static int
+ec_fixed_lookup(const EC_GROUP *group, const struct ec_fixed_table *table,
+    int window, BN_ULONG u, EC_POINT *p, BIGNUM *tmp, BN_CTX *ctx)
+{
+	const BN_ULONG *entry;
+	BN_ULONG idx, mask, neg;
+	int i, j, words = table->words;
+
+	if (!bn_wexpand(&p->X, words) || !bn_wexpand(&p->Y, words))
+		return 0;
+
+	/* Digits are negative if the top bit of u is clear. */
+	neg = ((u >> (EC_FIXED_WINDOW_BITS - 1)) & 1) ^ 1;
+	idx = (u ^ (0 - neg)) & (EC_FIXED_WINDOW_POINTS - 1);
+
+	memset(p->X.d, 0, words * sizeof(BN_ULONG));
+	memset(p->Y.d, 0, words * sizeof(BN_ULONG));
+
+	entry = &table->points[(size_t)window * EC_FIXED_WINDOW_POINTS *
+	    2 * words];
+	for (i = 0; i < EC_FIXED_WINDOW_POINTS; i++) {
+		mask = 0 - ((((BN_ULONG)i ^ idx) - 1) >> (BN_BITS2 - 1));
+		for (j = 0; j < words; j++) {
+			p->X.d[j] |= entry[j] & mask;
+			p->Y.d[j] |= entry[words + j] & mask;
+		}
+		entry += 2 * words;
+	}
+
+	p->X.top = words;
+	p->X.neg = 0;
+	bn_correct_top(&p->X);
+	p->Y.top = words;
+	p->Y.neg = 0;
+	bn_correct_top(&p->Y);
+
+	/* -(x, y) = (x, -y), so conditionally replace y by field - y. */
+	if (!BN_usub(tmp, &group->field, &p->Y))
+		return 0;
+	if (!BN_swap_ct(neg, &p->Y, tmp, words))
+		return 0;
+
+	if (group->meth->field_set_to_one != NULL) {
+		if (!group->meth->field_set_to_one(group, &p->Z, ctx))
+			return 0;
+	} else {
+		if (!BN_one(&p->Z))
+			return 0;
+	}
+	p->Z_is_one = 1;
+
+	return 1;
+}
+
+/*
+ * Compute r = scalar * generator using the precomputed table. Returns 1 on
+ * success and 0 on error. If the group has no table or the scalar is not in
+ * the range [0, order), -1 is returned and r is left untouched, so that the
+ * caller can fall back to another method.
+ */
+int
+ec_GFp_fixed_mul_generator(const EC_GROUP *group, EC_POINT *r,
+    const BIGNUM *scalar, BN_CTX *ctx)
+{
+	const struct ec_fixed_table *table;
+	BN_CTX *new_ctx = NULL;
+	EC_POINT *p = NULL;
+	BIGNUM *k, *tmp;
+	BN_ULONG negate, u;
+	int i, j;
+	int ret = 0;
+
+	if ((table = ec_fixed_table(group)) == NULL)
+		return -1;
+	if (BN_is_negative(scalar) || BN_cmp(scalar, &group->order) >= 0)
+		return -1;
+
+	if (ctx == NULL && (ctx = new_ctx = BN_CTX_new()) == NULL)
+		return 0;
+
+	BN_CTX_start(ctx);
+
+	if ((k = BN_CTX_get(ctx)) == NULL)
+		goto err;
+	if ((tmp = BN_CTX_get(ctx)) == NULL)
+		goto err;
+	if ((p = EC_POINT_new(group)) == NULL)
+		goto err;
+
+	if (!bn_wexpand(k, group->order.top) ||
+	    !bn_wexpand(tmp, group->order.top))
+		goto err;
+	if (!BN_copy(k, scalar))
+		goto err;
+	BN_set_flags(k, BN_FLG_CONSTTIME);
+
+	/* The recoding needs an odd scalar, so use order - k if k is even. */
+	if (!BN_usub(tmp, &group->order, k))
+		goto err;
+	negate = !BN_is_odd(k);
+	if (!BN_swap_ct(negate, k, tmp, group->order.top))
+		goto err;
+
+	for (i = 0; i < table->windows; i++) {
+		u = 0;
+		for (j = 0; j < EC_FIXED_WINDOW_BITS; j++) {
+			u |= (BN_ULONG)BN_is_bit_set(k,
+			    i * EC_FIXED_WINDOW_BITS + j + 1) << j;
+		}
+		if (i == table->windows - 1)
+			u |= 1 << (EC_FIXED_WINDOW_BITS - 1);
+
+		if (i == 0) {
+			if (!ec_fixed_lookup(group, table, i, u, r, tmp, ctx))
+				goto err;
+			if (!ec_point_blind_coordinates(group, r, ctx))
+				goto err;
+			continue;
+		}
+
+		if (!ec_fixed_lookup(group, table, i, u, p, tmp, ctx))
+			goto err;
+		if (!EC_POINT_add(group, r, r, p, ctx))
+			goto err;
+	}
+
+	/* Undo the negation of the scalar. */
+	if (!BN_usub(tmp, &group->field, &r->Y))
+		goto err;
+	if (!BN_swap_ct(negate, &r->Y, tmp, group->field.top))
+		goto err;
+
+	ret = 1;
+
+ err:
+	EC_POINT_free(p);
+	BN_CTX_end(ctx);
+	BN_CTX_free(new_ctx);
+
+	return ret;
+}
@@ -0,0 +1,1092 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * EC_METHODs for P-256, P-384 and P-521 with field elements held in a fixed
+ * number of 64-bit limbs.
+ *
+ * The field is described by a table of constants, so that all curves share
+ * one implementation: four limbs for P-256, six limbs for P-384 and nine
+ * limbs for P-521. Field elements are kept in the Montgomery domain with
+ * R = 2^(64 * limbs), the same encoding as used by EC_GFp_mont_method(), so
+ * that coordinates can be moved between EC_POINTs and the fixed size
+ * representation by copying words. Point doubling, point addition and scalar
+ * multiplication work on fixed size arrays and do not allocate. Everything
+ * else uses the generic GFp functions on top of the field operations
+ * provided here.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/err.h>
+#include <openssl/objects.h>
+
+#include "bn_local.h"
+#include "ec_local.h"
+
+#ifdef OPENSSL_EC_LIMB64
+
+#define EC_LIMB_MAX	9
+
+typedef uint64_t ec_limb_felem[EC_LIMB_MAX];
+
+typedef struct {
+	ec_limb_felem X;
+	ec_limb_felem Y;
+	ec_limb_felem Z;
+} ec_limb_point;
+
+struct ec_limb_field {
+	int limbs;
+
+	/* -p^-1 mod 2^64 */
+	uint64_t n0;
+
+	ec_limb_felem p;
+
+	/* R mod p, which is one in the Montgomery domain. */
+	ec_limb_felem one;
+
+	/* R^2 mod p, used to convert into the Montgomery domain. */
+	ec_limb_felem rr;
+
+	const BIGNUM *(*prime)(void);
+};
+
+/* p = 2^256 - 2^224 + 2^192 + 2^96 - 1 */
+static const struct ec_limb_field ec_limb_p256 = {
+	.limbs = 4,
+	.n0 = 0x0000000000000001ULL,
+	.p = {
+		0xffffffffffffffffULL, 0x00000000ffffffffULL,
+		0x0000000000000000ULL, 0xffffffff00000001ULL,
+	},
+	.one = {
+		0x0000000000000001ULL, 0xffffffff00000000ULL,
+		0xffffffffffffffffULL, 0x00000000fffffffeULL,
+	},
+	.rr = {
+		0x0000000000000003ULL, 0xfffffffbffffffffULL,
+		0xfffffffffffffffeULL, 0x00000004fffffffdULL,
+	},
+	.prime = BN_get0_nist_prime_256,
+};
+
+/* p = 2^384 - 2^128 - 2^96 + 2^32 - 1 */
+static const struct ec_limb_field ec_limb_p384 = {
+	.limbs = 6,
+	.n0 = 0x0000000100000001ULL,
+	.p = {
+		0x00000000ffffffffULL, 0xffffffff00000000ULL,
+		0xfffffffffffffffeULL, 0xffffffffffffffffULL,
+		0xffffffffffffffffULL, 0xffffffffffffffffULL,
+	},
+	.one = {
+		0xffffffff00000001ULL, 0x00000000ffffffffULL,
+		0x0000000000000001ULL, 0x0000000000000000ULL,
+		0x0000000000000000ULL, 0x0000000000000000ULL,
+	},
+	.rr = {
+		0xfffffffe00000001ULL, 0x0000000200000000ULL,
+		0xfffffffe00000000ULL, 0x0000000200000000ULL,
+		0x0000000000000001ULL, 0x0000000000000000ULL,
+	},
+	.prime = BN_get0_nist_prime_384,
+};
+
+/* p = 2^521 - 1 */
+static const struct ec_limb_field ec_limb_p521 = {
+	.limbs = 9,
+	.n0 = 0x0000000000000001ULL,
+	.p = {
+		0xffffffffffffffffULL, 0xffffffffffffffffULL,
+		0xffffffffffffffffULL, 0xffffffffffffffffULL,
+		0xffffffffffffffffULL, 0xffffffffffffffffULL,
+		0xffffffffffffffffULL, 0xffffffffffffffffULL,
+		0x00000000000001ffULL,
+	},
+	.one = {
+		0x0080000000000000ULL,
+	},
+	.rr = {
+		0x0000000000000000ULL, 0x0000400000000000ULL,
+	},
+	.prime = BN_get0_nist_prime_521,
+};
+
+static const struct ec_limb_field *
+ec_limb_group_field(const EC_GROUP *group)
+{
+	if (group->meth == EC_GFp_p256_method())
+		return &ec_limb_p256;
+	if (group->meth == EC_GFp_p384_method())
+		return &ec_limb_p384;
+	return &ec_limb_p521;
+}
+
+/* Return an all ones mask if a is zero, otherwise zero. */
+static inline uint64_t
+ec_limb_felem_is_zero(const struct ec_limb_field *f, const ec_limb_felem a)
+{
+	uint64_t t = 0;
+	int i;
+
+	for (i = 0; i < f->limbs; i++)
+		t |= a[i];
+
+	return ((t | (0 - t)) >> 63) - 1;
+}
+
+/* r = a if mask is all ones, r = b if mask is zero. */
+static inline void
+ec_limb_felem_select(const struct ec_limb_field *f, ec_limb_felem r,
+    uint64_t mask, const ec_limb_felem a, const ec_limb_felem b)
+{
+	int i;
+
+	for (i = 0; i < f->limbs; i++)
+		r[i] = (a[i] & mask) | (b[i] & ~mask);
+}
+
+/* r = carry:a mod p, where carry:a < 2p. */
+static inline void
+ec_limb_felem_reduce_once(const struct ec_limb_field *f, ec_limb_felem r,
+    const uint64_t *a, uint64_t carry)
+{
+	unsigned __int128 d;
+	ec_limb_felem t;
+	uint64_t borrow = 0;
+	int i;
+
+	for (i = 0; i < f->limbs; i++) {
+		d = (unsigned __int128)a[i] - f->p[i] - borrow;
+		t[i] = (uint64_t)d;
+		borrow = (uint64_t)(d >> 64) & 1;
+	}
+
+	/* Keep a - p unless the subtraction borrowed beyond the carry. */
+	ec_limb_felem_select(f, r, 0 - ((carry | (borrow ^ 1)) & 1), t, a);
+}
+
+static void
+ec_limb_felem_add(const struct ec_limb_field *f, ec_limb_felem r,
+    const ec_limb_felem a, const ec_limb_felem b)
+{
+	unsigned __int128 s;
+	ec_limb_felem t;
+	uint64_t carry = 0;
+	int i;
+
+	for (i = 0; i < f->limbs; i++) {
+		s = (unsigned __int128)a[i] + b[i] + carry;
+		t[i] = (uint64_t)s;
+		carry = (uint64_t)(s >> 64);
+	}
+
+	ec_limb_felem_reduce_once(f, r, t, carry);
+}
+
+static void
+ec_limb_felem_sub(const struct ec_limb_field *f, ec_limb_felem r,
+    const ec_limb_felem a, const ec_limb_felem b)
+{
+	unsigned __int128 d, s;
+	ec_limb_felem t;
+	uint64_t borrow = 0, carry = 0, mask;
+	int i;
+
+	for (i = 0; i < f->limbs; i++) {
+		d = (unsigned __int128)a[i] - b[i] - borrow;
+		t[i] = (uint64_t)d;
+		borrow = (uint64_t)(d >> 64) & 1;
+	}
+
+	/* Add p back if the subtraction borrowed. */
+	mask = 0 - borrow;
+	for (i = 0; i < f->limbs; i++) {
+		s = (unsigned __int128)t[i] + (f->p[i] & mask) + carry;
+		r[i] = (uint64_t)s;
+		carry = (uint64_t)(s >> 64);
+	}
+}
+
+/*
+ * Montgomery multiplication, r = a * b * R^-1 mod p. For P-256 and P-521,
+ * p = -1 mod 2^64 and the Montgomery constant n0 is one.
+ */
+static void
+ec_limb_felem_mul(const struct ec_limb_field *f, ec_limb_felem r,
+    const ec_limb_felem a, const ec_limb_felem b)
+{
+	unsigned __int128 acc;
+	uint64_t t[EC_LIMB_MAX + 2] = { 0 };
+	uint64_t carry, m;
+	int i, j, n = f->limbs;
+
+	for (i = 0; i < n; i++) {
+		carry = 0;
+		for (j = 0; j < n; j++) {
+			acc = (unsigned __int128)a[j] * b[i] + t[j] + carry;
+			t[j] = (uint64_t)acc;
+			carry = (uint64_t)(acc >> 64);
+		}
+		acc = (unsigned __int128)t[n] + carry;
+		t[n] = (uint64_t)acc;
+		t[n + 1] = (uint64_t)(acc >> 64);
+
+		m = t[0] * f->n0;
+		acc = (unsigned __int128)m * f->p[0] + t[0];
+		carry = (uint64_t)(acc >> 64);
+		for (j = 1; j < n; j++) {
+			acc = (unsigned __int128)m * f->p[j] + t[j] + carry;
+			t[j - 1] = (uint64_t)acc;
+			carry = (uint64_t)(acc >> 64);
+		}
+		acc = (unsigned __int128)t[n] + carry;
+		t[n - 1] = (uint64_t)acc;
+		t[n] = t[n + 1] + (uint64_t)(acc >> 64);
+	}
+
+	ec_limb_felem_reduce_once(f, r, t, t[n]);
+}
+
+static inline void
+ec_limb_felem_sqr(const struct ec_limb_field *f, ec_limb_felem r,
+    const ec_limb_felem a)
+{
+	ec_limb_felem_mul(f, r, a, a);
+}
+
+/* Replace a by -a mod p if mask is all ones. */
+static void
+ec_limb_felem_cond_negate(const struct ec_limb_field *f, ec_limb_felem a,
+    uint64_t mask)
+{
+	static const ec_limb_felem zero;
+	ec_limb_felem t;
+
+	ec_limb_felem_sub(f, t, zero, a);
+	ec_limb_felem_select(f, a, mask, t, a);
+}
+
+static int
+ec_limb_felem_from_bn(const struct ec_limb_field *f, ec_limb_felem r,
+    const BIGNUM *bn)
+{
+	int i;
+
+	if (BN_is_negative(bn) || bn->top > f->limbs)
+		return 0;
+
+	memset(r, 0, sizeof(ec_limb_felem));
+	for (i = 0; i < bn->top; i++)
+		r[i] = bn->d[i];
+
+	return 1;
+}
+
+static int
+ec_limb_felem_to_bn(const struct ec_limb_field *f, BIGNUM *bn,
+    const ec_limb_felem a)
+{
+	int i;
+
+	if (!bn_wexpand(bn, f->limbs))
+		return 0;
+
+	for (i = 0; i < f->limbs; i++)
+		bn->d[i] = a[i];
+	bn->top = f->limbs;
+	bn->neg = 0;
+	bn_correct_top(bn);
+
+	return 1;
+}
+
+/*
+ * Convert a to a field element or scalar modulo m. Values outside of [0, m)
+ * are unusual and are reduced without any constant time guarantees.
+ */
+static int
+ec_limb_felem_from_bn_mod(const struct ec_limb_field *f, ec_limb_felem r,
+    const BIGNUM *a, const BIGNUM *m, BN_CTX *ctx)
+{
+	BN_CTX *new_ctx = NULL;
+	BIGNUM *t;
+	int ret = 0;
+
+	if (!BN_is_negative(a) && BN_ucmp(a, m) < 0)
+		return ec_limb_felem_from_bn(f, r, a);
+
+	if (ctx == NULL && (ctx = new_ctx = BN_CTX_new()) == NULL)
+		return 0;
+
+	BN_CTX_start(ctx);
+	if ((t = BN_CTX_get(ctx)) == NULL)
+		goto err;
+	if (!BN_nnmod(t, a, m, ctx))
+		goto err;
+
+	ret = ec_limb_felem_from_bn(f, r, t);
+
+ err:
+	BN_CTX_end(ctx);
+	BN_CTX_free(new_ctx);
+
+	return ret;
+}
+
+static int
+ec_limb_point_from_ec_point(const struct ec_limb_field *f, ec_limb_point *r,
+    const EC_POINT *point)
+{
+	return ec_limb_felem_from_bn(f, r->X, &point->X) &&
+	    ec_limb_felem_from_bn(f, r->Y, &point->Y) &&
+	    ec_limb_felem_from_bn(f, r->Z, &point->Z);
+}
+
+static int
+ec_limb_point_to_ec_point(const struct ec_limb_field *f, EC_POINT *r,
+    const ec_limb_point *a)
+{
+	if (!ec_limb_felem_to_bn(f, &r->X, a->X))
+		return 0;
+	if (!ec_limb_felem_to_bn(f, &r->Y, a->Y))
+		return 0;
+	if (!ec_limb_felem_to_bn(f, &r->Z, a->Z))
+		return 0;
+	r->Z_is_one = memcmp(a->Z, f->one, f->limbs * sizeof(uint64_t)) == 0;
+
+	return 1;
+}
+
+/* r = a if mask is all ones, r = b if mask is zero. */
+static inline void
+ec_limb_point_select(const struct ec_limb_field *f, ec_limb_point *r,
+    uint64_t mask, const ec_limb_point *a, const ec_limb_point *b)
+{
+	ec_limb_felem_select(f, r->X, mask, a->X, b->X);
+	ec_limb_felem_select(f, r->Y, mask, a->Y, b->Y);
+	ec_limb_felem_select(f, r->Z, mask, a->Z, b->Z);
+}
+
+/*
+ * Point doubling in Jacobian coordinates for a = -3, using dbl-2001-b from
+ * the Explicit-Formulas Database. The point at infinity (Z = 0) is mapped to
+ * itself.
+ */
+static void
+ec_limb_point_double(const struct ec_limb_field *f, ec_limb_point *r,
+    const ec_limb_point *a)
+{
+	ec_limb_felem alpha, beta, gamma, delta, t0, t1;
+
+	ec_limb_felem_sqr(f, delta, a->Z);
+	ec_limb_felem_sqr(f, gamma, a->Y);
+	ec_limb_felem_mul(f, beta, a->X, gamma);
+
+	/* alpha = 3 * (X1 - delta) * (X1 + delta) */
+	ec_limb_felem_sub(f, t0, a->X, delta);
+	ec_limb_felem_add(f, t1, a->X, delta);
+	ec_limb_felem_mul(f, alpha, t0, t1);
+	ec_limb_felem_add(f, t0, alpha, alpha);
+	ec_limb_felem_add(f, alpha, t0, alpha);
+
+	/* Z3 = (Y1 + Z1)^2 - gamma - delta */
+	ec_limb_felem_add(f, t0, a->Y, a->Z);
+	ec_limb_felem_sqr(f, t0, t0);
+	ec_limb_felem_sub(f, t0, t0, gamma);
+	ec_limb_felem_sub(f, r->Z, t0, delta);
+
+	/* X3 = alpha^2 - 8 * beta */
+	ec_limb_felem_add(f, beta, beta, beta);
+	ec_limb_felem_add(f, beta, beta, beta);
+	ec_limb_felem_sqr(f, t0, alpha);
+	ec_limb_felem_sub(f, t0, t0, beta);
+	ec_limb_felem_sub(f, r->X, t0, beta);
+
+	/* Y3 = alpha * (4 * beta - X3) - 8 * gamma^2 */
+	ec_limb_felem_sub(f, t0, beta, r->X);
+	ec_limb_felem_mul(f, t0, alpha, t0);
+	ec_limb_felem_sqr(f, t1, gamma);
+	ec_limb_felem_add(f, t1, t1, t1);
+	ec_limb_felem_add(f, t1, t1, t1);
+	ec_limb_felem_add(f, t1, t1, t1);
+	ec_limb_felem_sub(f, r->Y, t0, t1);
+}
+
+/*
+ * Point addition in Jacobian coordinates, using add-2007-bl from the
+ * Explicit-Formulas Database. Either point being at infinity is handled in
+ * constant time. Adding a point to itself only happens with negligible
+ * probability during scalar multiplication and falls back to doubling.
+ */
+static void
+ec_limb_point_add(const struct ec_limb_field *f, ec_limb_point *r,
+    const ec_limb_point *a, const ec_limb_point *b)
+{
+	ec_limb_felem z1z1, z2z2, u1, u2, s1, s2, h, i, j, rr, v, t;
+	ec_limb_point sum;
+	uint64_t a_inf, b_inf;
+
+	a_inf = ec_limb_felem_is_zero(f, a->Z);
+	b_inf = ec_limb_felem_is_zero(f, b->Z);
+
+	ec_limb_felem_sqr(f, z1z1, a->Z);
+	ec_limb_felem_sqr(f, z2z2, b->Z);
+	ec_limb_felem_mul(f, u1, a->X, z2z2);
+	ec_limb_felem_mul(f, u2, b->X, z1z1);
+	ec_limb_felem_mul(f, s1, a->Y, b->Z);
+	ec_limb_felem_mul(f, s1, s1, z2z2);
+	ec_limb_felem_mul(f, s2, b->Y, a->Z);
+	ec_limb_felem_mul(f, s2, s2, z1z1);
+	ec_limb_felem_sub(f, h, u2, u1);
+	ec_limb_felem_sub(f, rr, s2, s1);
+
+	if ((ec_limb_felem_is_zero(f, h) & ec_limb_felem_is_zero(f, rr) &
+	    ~a_inf & ~b_inf) != 0) {
+		ec_limb_point_double(f, r, a);
+		return;
+	}
+
+	/* I = (2 * H)^2, J = H * I, r = 2 * (S2 - S1), V = U1 * I */
+	ec_limb_felem_add(f, i, h, h);
+	ec_limb_felem_sqr(f, i, i);
+	ec_limb_felem_mul(f, j, h, i);
+	ec_limb_felem_add(f, rr, rr, rr);
+	ec_limb_felem_mul(f, v, u1, i);
+
+	/* X3 = r^2 - J - 2 * V */
+	ec_limb_felem_sqr(f, sum.X, rr);
+	ec_limb_felem_sub(f, sum.X, sum.X, j);
+	ec_limb_felem_sub(f, sum.X, sum.X, v);
+	ec_limb_felem_sub(f, sum.X, sum.X, v);
+
+	/* Y3 = r * (V - X3) - 2 * S1 * J */
+	ec_limb_felem_sub(f, t, v, sum.X);
+	ec_limb_felem_mul(f, t, rr, t);
+	ec_limb_felem_mul(f, s1, s1, j);
+	ec_limb_felem_add(f, s1, s1, s1);
+	ec_limb_felem_sub(f, sum.Y, t, s1);
+
+	/* Z3 = ((Z1 + Z2)^2 - Z1Z1 - Z2Z2) * H */
+	ec_limb_felem_add(f, t, a->Z, b->Z);
+	ec_limb_felem_sqr(f, t, t);
+	ec_limb_felem_sub(f, t, t, z1z1);
+	ec_limb_felem_sub(f, t, t, z2z2);
+	ec_limb_felem_mul(f, sum.Z, t, h);
+
+	ec_limb_point_select(f, &sum, a_inf, b, &sum);
+	ec_limb_point_select(f, &sum, b_inf, a, &sum);
+
+	*r = sum;
+}
+
+/*
+ * Mixed addition of an affine point (x2, y2), which is never at infinity,
+ * using madd-2007-bl from the Explicit-Formulas Database.
+ */
+static void
+ec_limb_point_add_affine(const struct ec_limb_field *f, ec_limb_point *r,
+    const ec_limb_point *a, const ec_limb_felem x2, const ec_limb_felem y2)
+{
+	ec_limb_felem z1z1, u2, s2, h, hh, i, j, rr, v, t;
+	ec_limb_point b, sum;
+	uint64_t a_inf;
+
+	memcpy(b.X, x2, sizeof(b.X));
+	memcpy(b.Y, y2, sizeof(b.Y));
+	memcpy(b.Z, f->one, sizeof(b.Z));
+
+	a_inf = ec_limb_felem_is_zero(f, a->Z);
+
+	ec_limb_felem_sqr(f, z1z1, a->Z);
+	ec_limb_felem_mul(f, u2, x2, z1z1);
+	ec_limb_felem_mul(f, s2, y2, a->Z);
+	ec_limb_felem_mul(f, s2, s2, z1z1);
+	ec_limb_felem_sub(f, h, u2, a->X);
+	ec_limb_felem_sub(f, rr, s2, a->Y);
+
+	if ((ec_limb_felem_is_zero(f, h) & ec_limb_felem_is_zero(f, rr) &
+	    ~a_inf) != 0) {
+		ec_limb_point_double(f, r, &b);
+		return;
+	}
+
+	/* HH = H^2, I = 4 * HH, J = H * I, r = 2 * (S2 - Y1), V = X1 * I */
+	ec_limb_felem_sqr(f, hh, h);
+	ec_limb_felem_add(f, i, hh, hh);
+	ec_limb_felem_add(f, i, i, i);
+	ec_limb_felem_mul(f, j, h, i);
+	ec_limb_felem_add(f, rr, rr, rr);
+	ec_limb_felem_mul(f, v, a->X, i);
+
+	/* X3 = r^2 - J - 2 * V */
+	ec_limb_felem_sqr(f, sum.X, rr);
+	ec_limb_felem_sub(f, sum.X, sum.X, j);
+	ec_limb_felem_sub(f, sum.X, sum.X, v);
+	ec_limb_felem_sub(f, sum.X, sum.X, v);
+
+	/* Y3 = r * (V - X3) - 2 * Y1 * J */
+	ec_limb_felem_sub(f, t, v, sum.X);
+	ec_limb_felem_mul(f, t, rr, t);
+	ec_limb_felem_mul(f, j, a->Y, j);
+	ec_limb_felem_add(f, j, j, j);
+	ec_limb_felem_sub(f, sum.Y, t, j);
+
+	/* Z3 = (Z1 + H)^2 - Z1Z1 - HH */
+	ec_limb_felem_add(f, t, a->Z, h);
+	ec_limb_felem_sqr(f, t, t);
+	ec_limb_felem_sub(f, t, t, z1z1);
+	ec_limb_felem_sub(f, sum.Z, t, hh);
+
+	ec_limb_point_select(f, &sum, a_inf, &b, &sum);
+
+	*r = sum;
+}
+
+/* Randomise the projective representation of p. */
+static void
+ec_limb_point_blind(const struct ec_limb_field *f, ec_limb_point *p)
+{
+	ec_limb_felem lambda, t;
+
+	/* A random value below 2^(bits(p) - 1) is a valid field element. */
+	do {
+		memset(lambda, 0, sizeof(lambda));
+		arc4random_buf(lambda, f->limbs * sizeof(uint64_t));
+		lambda[f->limbs - 1] &= f->p[f->limbs - 1] >> 1;
+	} while (ec_limb_felem_is_zero(f, lambda) != 0);
+
+	ec_limb_felem_mul(f, p->Z, p->Z, lambda);
+	ec_limb_felem_sqr(f, t, lambda);
+	ec_limb_felem_mul(f, p->X, p->X, t);
+	ec_limb_felem_mul(f, t, t, lambda);
+	ec_limb_felem_mul(f, p->Y, p->Y, t);
+
+	explicit_bzero(lambda, sizeof(lambda));
+}
+
+/*
+ * Scalars are recoded as for the generator tables in ecp_fixed.c: an odd
+ * scalar k is written as sum_j (2 * u_j - (2^w - 1)) * 2^(wj), where u_j is
+ * window j of (k >> 1) + 2^(wm - 1). Even scalars are replaced by order - k,
+ * and an all ones mask is returned if the result needs to be negated.
+ */
+static uint64_t
+ec_limb_scalar_make_odd(const struct ec_limb_field *f, ec_limb_felem k,
+    const ec_limb_felem n)
+{
+	unsigned __int128 d;
+	ec_limb_felem t;
+	uint64_t borrow = 0, mask;
+	int i;
+
+	for (i = 0; i < f->limbs; i++) {
+		d = (unsigned __int128)n[i] - k[i] - borrow;
+		t[i] = (uint64_t)d;
+		borrow = (uint64_t)(d >> 64) & 1;
+	}
+
+	mask = (k[0] & 1) - 1;
+	ec_limb_felem_select(f, k, mask, t, k);
+
+	return mask;
+}
+
+/*
+ * Return the table index for the given window of k and set *negate to an all
+ * ones mask if the table entry needs to be negated.
+ */
+static uint64_t
+ec_limb_scalar_window(const struct ec_limb_field *f, const ec_limb_felem k,
+    int window, int windows, uint64_t *negate)
+{
+	uint64_t neg, u = 0;
+	int bit, i;
+
+	for (i = 0; i < EC_FIXED_WINDOW_BITS; i++) {
+		bit = window * EC_FIXED_WINDOW_BITS + i + 1;
+		if (bit < 64 * f->limbs)
+			u |= ((k[bit / 64] >> (bit % 64)) & 1) << i;
+	}
+	if (window == windows - 1)
+		u |= 1 << (EC_FIXED_WINDOW_BITS - 1);
+
+	neg = ((u >> (EC_FIXED_WINDOW_BITS - 1)) & 1) ^ 1;
+	*negate = 0 - neg;
+
+	return (u ^ *negate) & (EC_FIXED_WINDOW_POINTS - 1);
+}
+
+/* Select table[idx] while reading every entry of the table. */
+static void
+ec_limb_point_lookup(const struct ec_limb_field *f, ec_limb_point *r,
+    const ec_limb_point *table, uint64_t idx)
+{
+	uint64_t i, mask;
+	int j;
+
+	memset(r, 0, sizeof(*r));
+
+	for (i = 0; i < EC_FIXED_WINDOW_POINTS; i++) {
+		mask = 0 - (((i ^ idx) - 1) >> 63);
+		for (j = 0; j < f->limbs; j++) {
+			r->X[j] |= table[i].X[j] & mask;
+			r->Y[j] |= table[i].Y[j] & mask;
+			r->Z[j] |= table[i].Z[j] & mask;
+		}
+	}
+}
+
+/* Select an affine entry from a window of the generator table. */
+static void
+ec_limb_affine_lookup(const struct ec_limb_field *f, ec_limb_felem x,
+    ec_limb_felem y, const BN_ULONG *window, uint64_t idx)
+{
+	uint64_t i, mask;
+	int j;
+
+	memset(x, 0, sizeof(ec_limb_felem));
+	memset(y, 0, sizeof(ec_limb_felem));
+
+	for (i = 0; i < EC_FIXED_WINDOW_POINTS; i++) {
+		mask = 0 - (((i ^ idx) - 1) >> 63);
+		for (j = 0; j < f->limbs; j++) {
+			x[j] |= window[j] & mask;
+			y[j] |= window[f->limbs + j] & mask;
+		}
+		window += 2 * f->limbs;
+	}
+}
+
+/*
+ * The recoding relies on the scalar multiple of every point being determined
+ * by the scalar modulo an odd order, which holds for the named curves.
+ */
+static int
+ec_limb_group_is_prime_order(const struct ec_limb_field *f,
+    const EC_GROUP *group)
+{
+	return BN_is_odd(&group->order) && BN_is_one(&group->cofactor) &&
+	    BN_num_bits(&group->order) <= 64 * f->limbs;
+}
+
+static int
+ec_limb_mul_point(const struct ec_limb_field *f, const EC_GROUP *group,
+    ec_limb_point *r, const BIGNUM *scalar, const EC_POINT *point,
+    BN_CTX *ctx)
+{
+	ec_limb_point table[EC_FIXED_WINDOW_POINTS], p, q;
+	ec_limb_felem k, n;
+	uint64_t idx, neg, negate;
+	int i, j, windows;
+	int ret = 0;
+
+	if (!ec_limb_felem_from_bn_mod(f, k, scalar, &group->order, ctx))
+		goto err;
+	if (!ec_limb_felem_from_bn(f, n, &group->order))
+		goto err;
+	if (!ec_limb_point_from_ec_point(f, &p, point))
+		goto err;
+
+	/* Table of the odd multiples (2i + 1) * point. */
+	ec_limb_point_blind(f, &p);
+	table[0] = p;
+	ec_limb_point_double(f, &q, &p);
+	for (i = 1; i < EC_FIXED_WINDOW_POINTS; i++)
+		ec_limb_point_add(f, &table[i], &table[i - 1], &q);
+
+	negate = ec_limb_scalar_make_odd(f, k, n);
+	windows = (BN_num_bits(&group->order) + EC_FIXED_WINDOW_BITS - 1) /
+	    EC_FIXED_WINDOW_BITS;
+
+	for (i = windows - 1; i >= 0; i--) {
+		idx = ec_limb_scalar_window(f, k, i, windows, &neg);
+		ec_limb_point_lookup(f, &q, table, idx);
+		ec_limb_felem_cond_negate(f, q.Y, neg);
+
+		if (i == windows - 1) {
+			p = q;
+			continue;
+		}
+
+		for (j = 0; j < EC_FIXED_WINDOW_BITS; j++)
+			ec_limb_point_double(f, &p, &p);
+		ec_limb_point_add(f, &p, &p, &q);
+	}
+	ec_limb_felem_cond_negate(f, p.Y, negate);
+
+	*r = p;
+
+	ret = 1;
+
+ err:
+	explicit_bzero(table, sizeof(table));
+	explicit_bzero(k, sizeof(k));
+	explicit_bzero(&p, sizeof(p));
+	explicit_bzero(&q, sizeof(q));
+
+	return ret;
+}
+
+static int
+ec_limb_mul_generator(const struct ec_limb_field *f, const EC_GROUP *group,
+    ec_limb_point *r, const BIGNUM *scalar, BN_CTX *ctx)
+{
+	const BN_ULONG *table;
+	ec_limb_felem x, y, k, n;
+	ec_limb_point p;
+	uint64_t idx, neg, negate;
+	int i, windows;
+	int ret = 0;
+
+	/* Without a precomputed table, use the generator as any other point. */
+	if ((table = ec_GFp_fixed_table_points(group, &windows)) == NULL)
+		return ec_limb_mul_point(f, group, r, scalar, group->generator,
+		    ctx);
+
+	if (!ec_limb_felem_from_bn_mod(f, k, scalar, &group->order, ctx))
+		goto err;
+	if (!ec_limb_felem_from_bn(f, n, &group->order))
+		goto err;
+
+	negate = ec_limb_scalar_make_odd(f, k, n);
+
+	for (i = 0; i < windows; i++) {
+		idx = ec_limb_scalar_window(f, k, i, windows, &neg);
+		ec_limb_affine_lookup(f, x, y, &table[(size_t)i *
+		    EC_FIXED_WINDOW_POINTS * 2 * f->limbs], idx);
+		ec_limb_felem_cond_negate(f, y, neg);
+
+		if (i == 0) {
+			memcpy(p.X, x, sizeof(p.X));
+			memcpy(p.Y, y, sizeof(p.Y));
+			memcpy(p.Z, f->one, sizeof(p.Z));
+			ec_limb_point_blind(f, &p);
+			continue;
+		}
+
+		ec_limb_point_add_affine(f, &p, &p, x, y);
+	}
+	ec_limb_felem_cond_negate(f, p.Y, negate);
+
+	*r = p;
+
+	ret = 1;
+
+ err:
+	explicit_bzero(k, sizeof(k));
+	explicit_bzero(x, sizeof(x));
+	explicit_bzero(y, sizeof(y));
+	explicit_bzero(&p, sizeof(p));
+
+	return ret;
+}
+
+static int
+ec_GFp_limb_group_set_curve(const struct ec_limb_field *f, EC_GROUP *group,
+    const BIGNUM *p, const BIGNUM *a, const BIGNUM *b, BN_CTX *ctx)
+{
+	if (BN_ucmp(f->prime(), p) != 0) {
+		ECerror(EC_R_NOT_A_NIST_PRIME);
+		return 0;
+	}
+
+	if (!ec_GFp_simple_group_set_curve(group, p, a, b, ctx))
+		return 0;
+
+	/* Point doubling assumes a = -3. */
+	if (!group->a_is_minus3) {
+		ECerror(EC_R_INVALID_ARGUMENT);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int
+ec_GFp_p256_group_set_curve(EC_GROUP *group, const BIGNUM *p,
+    const BIGNUM *a, const BIGNUM *b, BN_CTX *ctx)
+{
+	return ec_GFp_limb_group_set_curve(&ec_limb_p256, group, p, a, b, ctx);
+}
+
+static int
+ec_GFp_p384_group_set_curve(EC_GROUP *group, const BIGNUM *p,
+    const BIGNUM *a, const BIGNUM *b, BN_CTX *ctx)
+{
+	return ec_GFp_limb_group_set_curve(&ec_limb_p384, group, p, a, b, ctx);
+}
+
+static int
+ec_GFp_p521_group_set_curve(EC_GROUP *group, const BIGNUM *p,
+    const BIGNUM *a, const BIGNUM *b, BN_CTX *ctx)
+{
+	return ec_GFp_limb_group_set_curve(&ec_limb_p521, group, p, a, b, ctx);
+}
+
+static int
+ec_GFp_limb_add(const EC_GROUP *group, EC_POINT *r, const EC_POINT *a,
+    const EC_POINT *b, BN_CTX *ctx)
+{
+	const struct ec_limb_field *f = ec_limb_group_field(group);
+	ec_limb_point pa, pb;
+
+	if (!ec_limb_point_from_ec_point(f, &pa, a))
+		return 0;
+	if (!ec_limb_point_from_ec_point(f, &pb, b))
+		return 0;
+
+	ec_limb_point_add(f, &pa, &pa, &pb);
+
+	return ec_limb_point_to_ec_point(f, r, &pa);
+}
+
+static int
+ec_GFp_limb_dbl(const EC_GROUP *group, EC_POINT *r, const EC_POINT *a,
+    BN_CTX *ctx)
+{
+	const struct ec_limb_field *f = ec_limb_group_field(group);
+	ec_limb_point pa;
+
+	if (!ec_limb_point_from_ec_point(f, &pa, a))
+		return 0;
+
+	ec_limb_point_double(f, &pa, &pa);
+
+	return ec_limb_point_to_ec_point(f, r, &pa);
+}
+
+static int
+ec_GFp_limb_mul_generator_ct(const EC_GROUP *group, EC_POINT *r,
+    const BIGNUM *scalar, BN_CTX *ctx)
+{
+	const struct ec_limb_field *f = ec_limb_group_field(group);
+	ec_limb_point p;
+	int ret;
+
+	if (!ec_limb_group_is_prime_order(f, group))
+		return ec_GFp_simple_mul_generator_ct(group, r, scalar, ctx);
+
+	if (!ec_limb_mul_generator(f, group, &p, scalar, ctx))
+		return 0;
+	ret = ec_limb_point_to_ec_point(f, r, &p);
+	explicit_bzero(&p, sizeof(p));
+
+	return ret;
+}
+
+static int
+ec_GFp_limb_mul_single_ct(const EC_GROUP *group, EC_POINT *r,
+    const BIGNUM *scalar, const EC_POINT *point, BN_CTX *ctx)
+{
+	const struct ec_limb_field *f = ec_limb_group_field(group);
+	ec_limb_point p;
+	int ret;
+
+	if (!ec_limb_group_is_prime_order(f, group))
+		return ec_GFp_simple_mul_single_ct(group, r, scalar, point,
+		    ctx);
+
+	if (EC_POINT_is_at_infinity(group, point))
+		return EC_POINT_set_to_infinity(group, r);
+
+	if (!ec_limb_mul_point(f, group, &p, scalar, point, ctx))
+		return 0;
+	ret = ec_limb_point_to_ec_point(f, r, &p);
+	explicit_bzero(&p, sizeof(p));
+
+	return ret;
+}
+
+static int
+ec_GFp_limb_mul_double_nonct(const EC_GROUP *group, EC_POINT *r,
+    const BIGNUM *g_scalar, const BIGNUM *p_scalar, const EC_POINT *point,
+    BN_CTX *ctx)
+{
+	const struct ec_limb_field *f = ec_limb_group_field(group);
+	ec_limb_point p, q;
+
+	if (!ec_limb_group_is_prime_order(f, group))
+		return ec_GFp_simple_mul_double_nonct(group, r, g_scalar,
+		    p_scalar, point, ctx);
+
+	if (!ec_limb_mul_generator(f, group, &p, g_scalar, ctx))
+		return 0;
+	if (EC_POINT_is_at_infinity(group, point))
+		return ec_limb_point_to_ec_point(f, r, &p);
+	if (!ec_limb_mul_point(f, group, &q, p_scalar, point, ctx))
+		return 0;
+
+	ec_limb_point_add(f, &p, &p, &q);
+
+	return ec_limb_point_to_ec_point(f, r, &p);
+}
+
+static int
+ec_GFp_limb_field_mul(const EC_GROUP *group, BIGNUM *r, const BIGNUM *a,
+    const BIGNUM *b, BN_CTX *ctx)
+{
+	const struct ec_limb_field *f = ec_limb_group_field(group);
+	ec_limb_felem fa, fb;
+
+	if (!ec_limb_felem_from_bn_mod(f, fa, a, &group->field, ctx))
+		return 0;
+	if (!ec_limb_felem_from_bn_mod(f, fb, b, &group->field, ctx))
+		return 0;
+
+	ec_limb_felem_mul(f, fa, fa, fb);
+
+	return ec_limb_felem_to_bn(f, r, fa);
+}
+
+static int
+ec_GFp_limb_field_sqr(const EC_GROUP *group, BIGNUM *r, const BIGNUM *a,
+    BN_CTX *ctx)
+{
+	const struct ec_limb_field *f = ec_limb_group_field(group);
+	ec_limb_felem fa;
+
+	if (!ec_limb_felem_from_bn_mod(f, fa, a, &group->field, ctx))
+		return 0;
+
+	ec_limb_felem_sqr(f, fa, fa);
+
+	return ec_limb_felem_to_bn(f, r, fa);
+}
+
+static int
+ec_GFp_limb_field_encode(const EC_GROUP *group, BIGNUM *r, const BIGNUM *a,
+    BN_CTX *ctx)
+{
+	const struct ec_limb_field *f = ec_limb_group_field(group);
+	ec_limb_felem fa;
+
+	if (!ec_limb_felem_from_bn_mod(f, fa, a, &group->field, ctx))
+		return 0;
+
+	ec_limb_felem_mul(f, fa, fa, f->rr);
+
+	return ec_limb_felem_to_bn(f, r, fa);
+}
+
+static int
+ec_GFp_limb_field_decode(const EC_GROUP *group, BIGNUM *r, const BIGNUM *a,
+    BN_CTX *ctx)
+{
+	static const ec_limb_felem unit = { 1 };
+	const struct ec_limb_field *f = ec_limb_group_field(group);
+	ec_limb_felem fa;
+
+	if (!ec_limb_felem_from_bn_mod(f, fa, a, &group->field, ctx))
+		return 0;
+
+	ec_limb_felem_mul(f, fa, fa, unit);
+
+	return ec_limb_felem_to_bn(f, r, fa);
+}
+
+static int
+ec_GFp_limb_field_set_to_one(const EC_GROUP *group, BIGNUM *r, BN_CTX *ctx)
+{
+	const struct ec_limb_field *f = ec_limb_group_field(group);
+
+	return ec_limb_felem_to_bn(f, r, f->one);
+}
+
+#define EC_GFP_LIMB_METHOD_INITIALIZER(set_curve) {			\
+	.flags = EC_FLAGS_DEFAULT_OCT,					\
+	.field_type = NID_X9_62_prime_field,				\
+	.group_init = ec_GFp_simple_group_init,				\
+	.group_finish = ec_GFp_simple_group_finish,			\
+	.group_clear_finish = ec_GFp_simple_group_clear_finish,		\
+	.group_copy = ec_GFp_simple_group_copy,				\
+	.group_set_curve = set_curve,					\
+	.group_get_curve = ec_GFp_simple_group_get_curve,		\
+	.group_get_degree = ec_GFp_simple_group_get_degree,		\
+	.group_order_bits = ec_group_simple_order_bits,			\
+	.group_check_discriminant =					\
+	    ec_GFp_simple_group_check_discriminant,			\
+	.point_init = ec_GFp_simple_point_init,				\
+	.point_finish = ec_GFp_simple_point_finish,			\
+	.point_clear_finish = ec_GFp_simple_point_clear_finish,		\
+	.point_copy = ec_GFp_simple_point_copy,				\
+	.point_set_to_infinity = ec_GFp_simple_point_set_to_infinity,	\
+	.point_set_Jprojective_coordinates =				\
+	    ec_GFp_simple_set_Jprojective_coordinates,			\
+	.point_get_Jprojective_coordinates =				\
+	    ec_GFp_simple_get_Jprojective_coordinates,			\
+	.point_set_affine_coordinates =					\
+	    ec_GFp_simple_point_set_affine_coordinates,			\
+	.point_get_affine_coordinates =					\
+	    ec_GFp_simple_point_get_affine_coordinates,			\
+	.add = ec_GFp_limb_add,						\
+	.dbl = ec_GFp_limb_dbl,						\
+	.invert = ec_GFp_simple_invert,					\
+	.is_at_infinity = ec_GFp_simple_is_at_infinity,			\
+	.is_on_curve = ec_GFp_simple_is_on_curve,			\
+	.point_cmp = ec_GFp_simple_cmp,					\
+	.make_affine = ec_GFp_simple_make_affine,			\
+	.points_make_affine = ec_GFp_simple_points_make_affine,		\
+	.mul_generator_ct = ec_GFp_limb_mul_generator_ct,		\
+	.mul_single_ct = ec_GFp_limb_mul_single_ct,			\
+	.mul_double_nonct = ec_GFp_limb_mul_double_nonct,		\
+	.field_mul = ec_GFp_limb_field_mul,				\
+	.field_sqr = ec_GFp_limb_field_sqr,				\
+	.field_encode = ec_GFp_limb_field_encode,			\
+	.field_decode = ec_GFp_limb_field_decode,			\
+	.field_set_to_one = ec_GFp_limb_field_set_to_one,		\
+	.blind_coordinates = ec_GFp_simple_blind_coordinates,		\
+}
+
+/*
+ * Apart from setting the curve, all methods share all functions and the
+ * field constants are looked up by the address of the method.
+ */
+const EC_METHOD *
+EC_GFp_p256_method(void)
+{
+	static const EC_METHOD ret =
+	    EC_GFP_LIMB_METHOD_INITIALIZER(ec_GFp_p256_group_set_curve);
+
+	return &ret;
+}
+
+const EC_METHOD *
+EC_GFp_p384_method(void)
+{
+	static const EC_METHOD ret =
+	    EC_GFP_LIMB_METHOD_INITIALIZER(ec_GFp_p384_group_set_curve);
+
+	return &ret;
+}
+
+const EC_METHOD *
+EC_GFp_p521_method(void)
+{
+	static const EC_METHOD ret =
+	    EC_GFP_LIMB_METHOD_INITIALIZER(ec_GFp_p521_group_set_curve);
+
+	return &ret;
+}
+
+#endif /* OPENSSL_EC_LIMB64 */
@@ -1706,6 +1706,12 @@ int
 ec_GFp_simple_mul_generator_ct(const EC_GROUP *group, EC_POINT *r,
     const BIGNUM *scalar, BN_CTX *ctx)
 {
+	int ret;
+
+	/* Use the precomputed generator table, if it applies. */
+	if ((ret = ec_GFp_fixed_mul_generator(group, r, scalar, ctx)) >= 0)
+		return ret;
+
 	return ec_GFp_simple_mul_ct(group, r, scalar, NULL, ctx);
 }
 
@@ -66,6 +66,7 @@
 
 #include "bn_local.h"
 #include "ecs_local.h"
+#include "ec_local.h"
 
 static int ecdsa_prepare_digest(const unsigned char *dgst, int dgst_len,
     BIGNUM *order, BIGNUM *ret);
@@ -510,7 +511,7 @@ ecdsa_do_verify(const unsigned char *dgst, int dgst_len, const ECDSA_SIG *sig,
 		ECDSAerror(ERR_R_MALLOC_FAILURE);
 		goto err;
 	}
-	if (!EC_POINT_mul(group, point, u1, pub_key, u2, ctx)) {
+	if (!ec_key_mul_public(eckey, point, u1, u2, ctx)) {
 		ECDSAerror(ERR_R_EC_LIB);
 		goto err;
 	}
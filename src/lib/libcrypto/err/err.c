@@ -230,9 +230,7 @@ struct st_ERR_FNS {
 	ERR_STRING_DATA *(*cb_err_get_item)(const ERR_STRING_DATA *);
 	ERR_STRING_DATA *(*cb_err_set_item)(ERR_STRING_DATA *);
 	ERR_STRING_DATA *(*cb_err_del_item)(ERR_STRING_DATA *);
-	/* Works on the "thread_hash" error-state table */
-	LHASH_OF(ERR_STATE) *(*cb_thread_get)(int create);
-	void (*cb_thread_release)(LHASH_OF(ERR_STATE) **hash);
+	/* Works on the current thread's error state */
 	ERR_STATE *(*cb_thread_get_item)(const ERR_STATE *);
 	ERR_STATE *(*cb_thread_set_item)(ERR_STATE *);
 	void (*cb_thread_del_item)(const ERR_STATE *);
@@ -246,8 +244,6 @@ static void int_err_del(void);
 static ERR_STRING_DATA *int_err_get_item(const ERR_STRING_DATA *);
 static ERR_STRING_DATA *int_err_set_item(ERR_STRING_DATA *);
 static ERR_STRING_DATA *int_err_del_item(ERR_STRING_DATA *);
-static LHASH_OF(ERR_STATE) *int_thread_get(int create);
-static void int_thread_release(LHASH_OF(ERR_STATE) **hash);
 static ERR_STATE *int_thread_get_item(const ERR_STATE *);
 static ERR_STATE *int_thread_set_item(ERR_STATE *);
 static void int_thread_del_item(const ERR_STATE *);
@@ -260,8 +256,6 @@ static const ERR_FNS err_defaults = {
 	int_err_get_item,
 	int_err_set_item,
 	int_err_del_item,
-	int_thread_get,
-	int_thread_release,
 	int_thread_get_item,
 	int_thread_set_item,
 	int_thread_del_item,
@@ -280,8 +274,6 @@ static const ERR_FNS *err_fns = NULL;
  * ERR state operation (together with requisite locking) to the implementations
  * and state in the loading application. */
 static LHASH_OF(ERR_STRING_DATA) *int_error_hash = NULL;
-static LHASH_OF(ERR_STATE) *int_thread_hash = NULL;
-static int int_thread_hash_references = 0;
 static int int_err_library_number = ERR_LIB_USER;
 
 static pthread_t err_init_thread;
@@ -434,89 +426,67 @@ int_err_del_item(ERR_STRING_DATA *d)
 	return p;
 }
 
-static unsigned long
-err_state_hash(const ERR_STATE *a)
-{
-	return CRYPTO_THREADID_hash(&a->tid) * 13;
-}
-static IMPLEMENT_LHASH_HASH_FN(err_state, ERR_STATE)
+/*
+ * Error state is kept in thread-specific storage, rather than in a table that
+ * is shared between threads, so that it can be found without taking a lock.
+ * The state is freed when the thread exits, or when it is explicitly removed.
+ * The state of another thread is not accessible, hence there is no state
+ * table to return and lookups by anything other than the current thread ID
+ * fail.
+ */
+static pthread_once_t err_state_once = PTHREAD_ONCE_INIT;
+static pthread_key_t err_state_key;
+static int err_state_key_created;
 
-static int
-err_state_cmp(const ERR_STATE *a, const ERR_STATE *b)
+static void
+err_state_thread_free(void *arg)
 {
-	return CRYPTO_THREADID_cmp(&a->tid, &b->tid);
+	ERR_STATE_free(arg);
 }
-static IMPLEMENT_LHASH_COMP_FN(err_state, ERR_STATE)
 
-static
-LHASH_OF(ERR_STATE) *int_thread_get(int create)
+static void
+err_state_key_create(void)
 {
-	LHASH_OF(ERR_STATE) *ret = NULL;
-
-	CRYPTO_w_lock(CRYPTO_LOCK_ERR);
-	if (!int_thread_hash && create) {
-		CRYPTO_push_info("int_thread_get (err.c)");
-		int_thread_hash = lh_ERR_STATE_new();
-		CRYPTO_pop_info();
-	}
-	if (int_thread_hash) {
-		int_thread_hash_references++;
-		ret = int_thread_hash;
-	}
-	CRYPTO_w_unlock(CRYPTO_LOCK_ERR);
-	return ret;
+	if (pthread_key_create(&err_state_key, err_state_thread_free) == 0)
+		err_state_key_created = 1;
 }
 
-static void
-int_thread_release(LHASH_OF(ERR_STATE) **hash)
+static int
+err_state_is_current(const ERR_STATE *d)
 {
-	int i;
+	CRYPTO_THREADID tid;
 
-	if (hash == NULL || *hash == NULL)
-		return;
+	if (pthread_once(&err_state_once, err_state_key_create) != 0)
+		return 0;
+	if (!err_state_key_created)
+		return 0;
 
-	i = CRYPTO_add(&int_thread_hash_references, -1, CRYPTO_LOCK_ERR);
-	if (i > 0)
-		return;
+	CRYPTO_THREADID_current(&tid);
 
-	*hash = NULL;
+	return CRYPTO_THREADID_cmp(&d->tid, &tid) == 0;
 }
 
 static ERR_STATE *
 int_thread_get_item(const ERR_STATE *d)
 {
-	ERR_STATE *p;
-	LHASH_OF(ERR_STATE) *hash;
-
-	err_fns_check();
-	hash = ERRFN(thread_get)(0);
-	if (!hash)
+	if (!err_state_is_current(d))
 		return NULL;
 
-	CRYPTO_r_lock(CRYPTO_LOCK_ERR);
-	p = lh_ERR_STATE_retrieve(hash, d);
-	CRYPTO_r_unlock(CRYPTO_LOCK_ERR);
-
-	ERRFN(thread_release)(&hash);
-	return p;
+	return pthread_getspecific(err_state_key);
 }
 
 static ERR_STATE *
 int_thread_set_item(ERR_STATE *d)
 {
 	ERR_STATE *p;
-	LHASH_OF(ERR_STATE) *hash;
 
-	err_fns_check();
-	hash = ERRFN(thread_get)(1);
-	if (!hash)
+	if (!err_state_is_current(d))
 		return NULL;
 
-	CRYPTO_w_lock(CRYPTO_LOCK_ERR);
-	p = lh_ERR_STATE_insert(hash, d);
-	CRYPTO_w_unlock(CRYPTO_LOCK_ERR);
+	p = pthread_getspecific(err_state_key);
+	if (pthread_setspecific(err_state_key, d) != 0)
+		return NULL;
 
-	ERRFN(thread_release)(&hash);
 	return p;
 }
 
@@ -524,26 +494,16 @@ static void
 int_thread_del_item(const ERR_STATE *d)
 {
 	ERR_STATE *p;
-	LHASH_OF(ERR_STATE) *hash;
 
-	err_fns_check();
-	hash = ERRFN(thread_get)(0);
-	if (!hash)
+	if (!err_state_is_current(d))
 		return;
 
-	CRYPTO_w_lock(CRYPTO_LOCK_ERR);
-	p = lh_ERR_STATE_delete(hash, d);
-	/* make sure we don't leak memory */
-	if (int_thread_hash_references == 1 &&
-	    int_thread_hash && lh_ERR_STATE_num_items(int_thread_hash) == 0) {
-		lh_ERR_STATE_free(int_thread_hash);
-		int_thread_hash = NULL;
-	}
-	CRYPTO_w_unlock(CRYPTO_LOCK_ERR);
+	if ((p = pthread_getspecific(err_state_key)) == NULL)
+		return;
+	if (pthread_setspecific(err_state_key, NULL) != 0)
+		return;
 
-	ERRFN(thread_release)(&hash);
-	if (p)
-		ERR_STATE_free(p);
+	ERR_STATE_free(p);
 }
 
 static int
@@ -960,17 +920,17 @@ LHASH_OF(ERR_STRING_DATA) *ERR_get_string_table(void)
 	return ERRFN(err_get)(0);
 }
 
+/* Error state is thread-specific, hence there is no table to return. */
 LHASH_OF(ERR_STATE) *ERR_get_err_state_table(void)
 {
-	err_fns_check();
-	return ERRFN(thread_get)(0);
+	return NULL;
 }
 
 void
 ERR_release_err_state_table(LHASH_OF(ERR_STATE) **hash)
 {
-	err_fns_check();
-	ERRFN(thread_release)(hash);
+	if (hash != NULL)
+		*hash = NULL;
 }
 
 const char *
@@ -1031,8 +991,6 @@ ERR_remove_thread_state(const CRYPTO_THREADID *id)
 	else
 		CRYPTO_THREADID_current(&tmp.tid);
 	err_fns_check();
-	/* thread_del_item automatically destroys the LHASH if the number of
-	 * items reaches zero. */
 	ERRFN(thread_del_item)(&tmp);
 }
 
@@ -198,6 +198,17 @@ void aesni_ccm64_decrypt_blocks (const unsigned char *in, unsigned char *out,
     size_t blocks, const void *key, const unsigned char ivec[16],
     unsigned char cmac[16]);
 
+static void
+aesni_gcm_set_bulk(GCM128_CONTEXT *gcm)
+{
+#ifdef AESNI_GCM
+	if ((OPENSSL_cpu_caps() & CPUCAP_MASK_PCLMUL) != 0) {
+		gcm->bulk_encrypt = aesni_gcm_encrypt;
+		gcm->bulk_decrypt = aesni_gcm_decrypt;
+	}
+#endif
+}
+
 static int
 aesni_init_key(EVP_CIPHER_CTX *ctx, const unsigned char *key,
     const unsigned char *iv, int enc)
@@ -269,6 +280,7 @@ aesni_gcm_init_key(EVP_CIPHER_CTX *ctx, const unsigned char *key,
 		aesni_set_encrypt_key(key, ctx->key_len * 8, &gctx->ks);
 		CRYPTO_gcm128_init(&gctx->gcm, &gctx->ks,
 		    (block128_f)aesni_encrypt);
+		aesni_gcm_set_bulk(&gctx->gcm);
 		gctx->ctr = (ctr128_f)aesni_ctr32_encrypt_blocks;
 		/* If we have an iv can set it directly, otherwise use
 		 * saved IV.
@@ -2264,6 +2276,7 @@ aead_aes_gcm_init(EVP_AEAD_CTX *ctx, const unsigned char *key, size_t key_len,
 		aesni_set_encrypt_key(key, key_bits, &gcm_ctx->ks.ks);
 		CRYPTO_gcm128_init(&gcm_ctx->gcm, &gcm_ctx->ks.ks,
 		    (block128_f)aesni_encrypt);
+		aesni_gcm_set_bulk(&gcm_ctx->gcm);
 		gcm_ctx->ctr = (ctr128_f) aesni_ctr32_encrypt_blocks;
 	} else
 #endif
@@ -2286,16 +2299,28 @@ aead_aes_gcm_cleanup(EVP_AEAD_CTX *ctx)
 }
 
 static int
-aead_aes_gcm_seal(const EVP_AEAD_CTX *ctx, unsigned char *out, size_t *out_len,
-    size_t max_out_len, const unsigned char *nonce, size_t nonce_len,
-    const unsigned char *in, size_t in_len, const unsigned char *ad,
-    size_t ad_len)
+aead_aes_gcm_encrypt(const struct aead_aes_gcm_ctx *gcm_ctx,
+    GCM128_CONTEXT *gcm, const unsigned char *in, unsigned char *out,
+    size_t len)
+{
+	if (gcm_ctx->ctr)
+		return CRYPTO_gcm128_encrypt_ctr32(gcm, in, out, len,
+		    gcm_ctx->ctr) == 0;
+
+	return CRYPTO_gcm128_encrypt(gcm, in, out, len) == 0;
+}
+
+static int
+aead_aes_gcm_seal_scatter(const EVP_AEAD_CTX *ctx, unsigned char *out,
+    unsigned char *out_tag, size_t *out_tag_len, size_t max_out_tag_len,
+    const unsigned char *nonce, size_t nonce_len, const unsigned char *in,
+    size_t in_len, const unsigned char *extra_in, size_t extra_in_len,
+    const unsigned char *ad, size_t ad_len)
 {
 	const struct aead_aes_gcm_ctx *gcm_ctx = ctx->aead_state;
 	GCM128_CONTEXT gcm;
-	size_t bulk = 0;
 
-	if (max_out_len < in_len + gcm_ctx->tag_len) {
+	if (max_out_tag_len < extra_in_len + gcm_ctx->tag_len) {
 		EVPerror(EVP_R_BUFFER_TOO_SMALL);
 		return 0;
 	}
@@ -2311,18 +2336,15 @@ aead_aes_gcm_seal(const EVP_AEAD_CTX *ctx, unsigned char *out, size_t *out_len,
 	if (ad_len > 0 && CRYPTO_gcm128_aad(&gcm, ad, ad_len))
 		return 0;
 
-	if (gcm_ctx->ctr) {
-		if (CRYPTO_gcm128_encrypt_ctr32(&gcm, in + bulk, out + bulk,
-		    in_len - bulk, gcm_ctx->ctr))
-			return 0;
-	} else {
-		if (CRYPTO_gcm128_encrypt(&gcm, in + bulk, out + bulk,
-		    in_len - bulk))
-			return 0;
-	}
+	/* GCM is a stream mode, so the extra input simply follows the input. */
+	if (!aead_aes_gcm_encrypt(gcm_ctx, &gcm, in, out, in_len))
+		return 0;
+	if (!aead_aes_gcm_encrypt(gcm_ctx, &gcm, extra_in, out_tag,
+	    extra_in_len))
+		return 0;
 
-	CRYPTO_gcm128_tag(&gcm, out + in_len, gcm_ctx->tag_len);
-	*out_len = in_len + gcm_ctx->tag_len;
+	CRYPTO_gcm128_tag(&gcm, out_tag + extra_in_len, gcm_ctx->tag_len);
+	*out_tag_len = extra_in_len + gcm_ctx->tag_len;
 
 	return 1;
 }
@@ -2391,7 +2413,7 @@ static const EVP_AEAD aead_aes_128_gcm = {
 
 	.init = aead_aes_gcm_init,
 	.cleanup = aead_aes_gcm_cleanup,
-	.seal = aead_aes_gcm_seal,
+	.seal_scatter = aead_aes_gcm_seal_scatter,
 	.open = aead_aes_gcm_open,
 };
 
@@ -2403,7 +2425,7 @@ static const EVP_AEAD aead_aes_256_gcm = {
 
 	.init = aead_aes_gcm_init,
 	.cleanup = aead_aes_gcm_cleanup,
-	.seal = aead_aes_gcm_seal,
+	.seal_scatter = aead_aes_gcm_seal_scatter,
 	.open = aead_aes_gcm_open,
 };
 
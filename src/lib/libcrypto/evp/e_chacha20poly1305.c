@@ -121,19 +121,79 @@ poly1305_update_with_pad16(poly1305_state *poly1305,
 	poly1305_pad16(poly1305, data_len);
 }
 
+/*
+ * Encrypt or decrypt len bytes of input, starting offset bytes into the
+ * ChaCha20 key stream for the given counter.
+ */
+static void
+chacha20_crypt_at_offset(unsigned char *out, const unsigned char *in,
+    size_t len, const unsigned char key[32], const unsigned char *iv,
+    uint64_t ctr, size_t offset)
+{
+	unsigned char block[64];
+	size_t i, n;
+
+	ctr += offset / sizeof(block);
+	offset %= sizeof(block);
+
+	if (offset > 0 && len > 0) {
+		memset(block, 0, sizeof(block));
+		CRYPTO_chacha_20(block, block, sizeof(block), key, iv, ctr);
+
+		if ((n = sizeof(block) - offset) > len)
+			n = len;
+		for (i = 0; i < n; i++)
+			out[i] = in[i] ^ block[offset + i];
+
+		explicit_bzero(block, sizeof(block));
+
+		out += n;
+		in += n;
+		len -= n;
+		ctr++;
+	}
+
+	if (len > 0)
+		CRYPTO_chacha_20(out, in, len, key, iv, ctr);
+}
+
+/*
+ * Compute the Poly1305 tag for the additional data and the ciphertext, where
+ * the ciphertext may be split into two parts (RFC 7539 section 2.8).
+ */
+static void
+chacha20_poly1305_tag(unsigned char tag[POLY1305_TAG_LEN],
+    const unsigned char poly1305_key[32], const unsigned char *ad,
+    size_t ad_len, const unsigned char *ct, size_t ct_len,
+    const unsigned char *extra_ct, size_t extra_ct_len)
+{
+	poly1305_state poly1305;
+
+	CRYPTO_poly1305_init(&poly1305, poly1305_key);
+	poly1305_update_with_pad16(&poly1305, ad, ad_len);
+	CRYPTO_poly1305_update(&poly1305, ct, ct_len);
+	if (extra_ct_len > 0)
+		CRYPTO_poly1305_update(&poly1305, extra_ct, extra_ct_len);
+	poly1305_pad16(&poly1305, ct_len + extra_ct_len);
+	poly1305_update_with_length(&poly1305, NULL, ad_len);
+	poly1305_update_with_length(&poly1305, NULL, ct_len + extra_ct_len);
+	CRYPTO_poly1305_finish(&poly1305, tag);
+}
+
 static int
-aead_chacha20_poly1305_seal(const EVP_AEAD_CTX *ctx, unsigned char *out,
-    size_t *out_len, size_t max_out_len, const unsigned char *nonce,
-    size_t nonce_len, const unsigned char *in, size_t in_len,
-    const unsigned char *ad, size_t ad_len)
+aead_chacha20_poly1305_seal_scatter(const EVP_AEAD_CTX *ctx,
+    unsigned char *out, unsigned char *out_tag, size_t *out_tag_len,
+    size_t max_out_tag_len, const unsigned char *nonce, size_t nonce_len,
+    const unsigned char *in, size_t in_len, const unsigned char *extra_in,
+    size_t extra_in_len, const unsigned char *ad, size_t ad_len)
 {
 	const struct aead_chacha20_poly1305_ctx *c20_ctx = ctx->aead_state;
+	unsigned char tag[POLY1305_TAG_LEN];
 	unsigned char poly1305_key[32];
-	poly1305_state poly1305;
 	const unsigned char *iv;
 	uint64_t ctr;
 
-	if (max_out_len < in_len + c20_ctx->tag_len) {
+	if (max_out_tag_len < extra_in_len + c20_ctx->tag_len) {
 		EVPerror(EVP_R_BUFFER_TOO_SMALL);
 		return 0;
 	}
@@ -151,23 +211,16 @@ aead_chacha20_poly1305_seal(const EVP_AEAD_CTX *ctx, unsigned char *out,
 	CRYPTO_chacha_20(poly1305_key, poly1305_key,
 	    sizeof(poly1305_key), c20_ctx->key, iv, ctr);
 
-	CRYPTO_poly1305_init(&poly1305, poly1305_key);
-	poly1305_update_with_pad16(&poly1305, ad, ad_len);
 	CRYPTO_chacha_20(out, in, in_len, c20_ctx->key, iv, ctr + 1);
-	poly1305_update_with_pad16(&poly1305, out, in_len);
-	poly1305_update_with_length(&poly1305, NULL, ad_len);
-	poly1305_update_with_length(&poly1305, NULL, in_len);
+	chacha20_crypt_at_offset(out_tag, extra_in, extra_in_len,
+	    c20_ctx->key, iv, ctr + 1, in_len);
 
-	if (c20_ctx->tag_len != POLY1305_TAG_LEN) {
-		unsigned char tag[POLY1305_TAG_LEN];
-		CRYPTO_poly1305_finish(&poly1305, tag);
-		memcpy(out + in_len, tag, c20_ctx->tag_len);
-		*out_len = in_len + c20_ctx->tag_len;
-		return 1;
-	}
+	chacha20_poly1305_tag(tag, poly1305_key, ad, ad_len, out, in_len,
+	    out_tag, extra_in_len);
+
+	memcpy(out_tag + extra_in_len, tag, c20_ctx->tag_len);
+	*out_tag_len = extra_in_len + c20_ctx->tag_len;
 
-	CRYPTO_poly1305_finish(&poly1305, out + in_len);
-	*out_len = in_len + POLY1305_TAG_LEN;
 	return 1;
 }
 
@@ -229,17 +282,18 @@ aead_chacha20_poly1305_open(const EVP_AEAD_CTX *ctx, unsigned char *out,
 }
 
 static int
-aead_xchacha20_poly1305_seal(const EVP_AEAD_CTX *ctx, unsigned char *out,
-    size_t *out_len, size_t max_out_len, const unsigned char *nonce,
-    size_t nonce_len, const unsigned char *in, size_t in_len,
-    const unsigned char *ad, size_t ad_len)
+aead_xchacha20_poly1305_seal_scatter(const EVP_AEAD_CTX *ctx,
+    unsigned char *out, unsigned char *out_tag, size_t *out_tag_len,
+    size_t max_out_tag_len, const unsigned char *nonce, size_t nonce_len,
+    const unsigned char *in, size_t in_len, const unsigned char *extra_in,
+    size_t extra_in_len, const unsigned char *ad, size_t ad_len)
 {
 	const struct aead_chacha20_poly1305_ctx *c20_ctx = ctx->aead_state;
+	unsigned char tag[POLY1305_TAG_LEN];
 	unsigned char poly1305_key[32];
 	unsigned char subkey[32];
-	poly1305_state poly1305;
 
-	if (max_out_len < in_len + c20_ctx->tag_len) {
+	if (max_out_tag_len < extra_in_len + c20_ctx->tag_len) {
 		EVPerror(EVP_R_BUFFER_TOO_SMALL);
 		return 0;
 	}
@@ -252,27 +306,19 @@ aead_xchacha20_poly1305_seal(const EVP_AEAD_CTX *ctx, unsigned char *out,
 	CRYPTO_hchacha_20(subkey, c20_ctx->key, nonce);
 
 	CRYPTO_chacha_20(out, in, in_len, subkey, nonce + 16, 1);
+	chacha20_crypt_at_offset(out_tag, extra_in, extra_in_len,
+	    subkey, nonce + 16, 1, in_len);
 
 	memset(poly1305_key, 0, sizeof(poly1305_key));
 	CRYPTO_chacha_20(poly1305_key, poly1305_key, sizeof(poly1305_key),
 	    subkey, nonce + 16, 0);
 
-	CRYPTO_poly1305_init(&poly1305, poly1305_key);
-	poly1305_update_with_pad16(&poly1305, ad, ad_len);
-	poly1305_update_with_pad16(&poly1305, out, in_len);
-	poly1305_update_with_length(&poly1305, NULL, ad_len);
-	poly1305_update_with_length(&poly1305, NULL, in_len);
+	chacha20_poly1305_tag(tag, poly1305_key, ad, ad_len, out, in_len,
+	    out_tag, extra_in_len);
 
-	if (c20_ctx->tag_len != POLY1305_TAG_LEN) {
-		unsigned char tag[POLY1305_TAG_LEN];
-		CRYPTO_poly1305_finish(&poly1305, tag);
-		memcpy(out + in_len, tag, c20_ctx->tag_len);
-		*out_len = in_len + c20_ctx->tag_len;
-		return 1;
-	}
+	memcpy(out_tag + extra_in_len, tag, c20_ctx->tag_len);
+	*out_tag_len = extra_in_len + c20_ctx->tag_len;
 
-	CRYPTO_poly1305_finish(&poly1305, out + in_len);
-	*out_len = in_len + POLY1305_TAG_LEN;
 	return 1;
 }
 
@@ -339,7 +385,7 @@ static const EVP_AEAD aead_chacha20_poly1305 = {
 
 	.init = aead_chacha20_poly1305_init,
 	.cleanup = aead_chacha20_poly1305_cleanup,
-	.seal = aead_chacha20_poly1305_seal,
+	.seal_scatter = aead_chacha20_poly1305_seal_scatter,
 	.open = aead_chacha20_poly1305_open,
 };
 
@@ -357,7 +403,7 @@ static const EVP_AEAD aead_xchacha20_poly1305 = {
 
 	.init = aead_chacha20_poly1305_init,
 	.cleanup = aead_chacha20_poly1305_cleanup,
-	.seal = aead_xchacha20_poly1305_seal,
+	.seal_scatter = aead_xchacha20_poly1305_seal_scatter,
 	.open = aead_xchacha20_poly1305_open,
 };
 
@@ -1273,6 +1273,30 @@ int EVP_AEAD_CTX_seal(const EVP_AEAD_CTX *ctx, unsigned char *out,
     size_t nonce_len, const unsigned char *in, size_t in_len,
     const unsigned char *ad, size_t ad_len);
 
+/* EVP_AEAD_CTX_seal_scatter encrypts and authenticates the input and the
+ * extra input, while authenticating any additional data (AD). The encrypted
+ * input is written to out, while the encrypted extra input followed by the
+ * authentication tag are written to out_tag. One is returned on success,
+ * otherwise zero.
+ *
+ * This allows the output to be scattered across two buffers and the input to
+ * be gathered from two buffers, without copying - the result is the same as
+ * that produced by EVP_AEAD_CTX_seal for the concatenated input.
+ *
+ * At most max_out_tag_len bytes are written to out_tag and, in order to
+ * ensure success, this value should be the length of the extra input plus the
+ * result of EVP_AEAD_max_overhead. Exactly in_len bytes are written to out.
+ * On successful return, out_tag_len is set to the number of bytes written to
+ * out_tag.
+ *
+ * If the input and output are aliased then out must be <= in. Likewise for
+ * extra_in and out_tag. */
+int EVP_AEAD_CTX_seal_scatter(const EVP_AEAD_CTX *ctx, unsigned char *out,
+    unsigned char *out_tag, size_t *out_tag_len, size_t max_out_tag_len,
+    const unsigned char *nonce, size_t nonce_len, const unsigned char *in,
+    size_t in_len, const unsigned char *extra_in, size_t extra_in_len,
+    const unsigned char *ad, size_t ad_len);
+
 /* EVP_AEAD_CTX_open authenticates the input and additional data, decrypting
  * the input and writing it as output. One is returned on success, otherwise
  * zero.
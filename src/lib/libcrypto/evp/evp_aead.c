@@ -109,6 +109,7 @@ EVP_AEAD_CTX_seal(const EVP_AEAD_CTX *ctx, unsigned char *out, size_t *out_len,
     size_t ad_len)
 {
 	size_t possible_out_len = in_len + ctx->aead->overhead;
+	size_t tag_len;
 
 	/* Overflow. */
 	if (possible_out_len < in_len) {
@@ -121,8 +122,15 @@ EVP_AEAD_CTX_seal(const EVP_AEAD_CTX *ctx, unsigned char *out, size_t *out_len,
 		goto error;
 	}
 
-	if (ctx->aead->seal(ctx, out, out_len, max_out_len, nonce, nonce_len,
-	    in, in_len, ad, ad_len)) {
+	if (max_out_len < in_len) {
+		EVPerror(EVP_R_BUFFER_TOO_SMALL);
+		goto error;
+	}
+
+	if (ctx->aead->seal_scatter(ctx, out, out + in_len, &tag_len,
+	    max_out_len - in_len, nonce, nonce_len, in, in_len, NULL, 0,
+	    ad, ad_len)) {
+		*out_len = in_len + tag_len;
 		return 1;
 	}
 
@@ -134,6 +142,43 @@ error:
 	return 0;
 }
 
+int
+EVP_AEAD_CTX_seal_scatter(const EVP_AEAD_CTX *ctx, unsigned char *out,
+    unsigned char *out_tag, size_t *out_tag_len, size_t max_out_tag_len,
+    const unsigned char *nonce, size_t nonce_len, const unsigned char *in,
+    size_t in_len, const unsigned char *extra_in, size_t extra_in_len,
+    const unsigned char *ad, size_t ad_len)
+{
+	size_t possible_out_tag_len = extra_in_len + ctx->aead->overhead;
+
+	/* Overflow. */
+	if (possible_out_tag_len < extra_in_len) {
+		EVPerror(EVP_R_TOO_LARGE);
+		goto error;
+	}
+
+	if (!check_alias(in, in_len, out)) {
+		EVPerror(EVP_R_OUTPUT_ALIASES_INPUT);
+		goto error;
+	}
+	if (!check_alias(extra_in, extra_in_len, out_tag)) {
+		EVPerror(EVP_R_OUTPUT_ALIASES_INPUT);
+		goto error;
+	}
+
+	if (ctx->aead->seal_scatter(ctx, out, out_tag, out_tag_len,
+	    max_out_tag_len, nonce, nonce_len, in, in_len, extra_in,
+	    extra_in_len, ad, ad_len))
+		return 1;
+
+error:
+	/* As with EVP_AEAD_CTX_seal, ensure that no raw data is output. */
+	memset(out, 0, in_len);
+	memset(out_tag, 0, max_out_tag_len);
+	*out_tag_len = 0;
+	return 0;
+}
+
 int
 EVP_AEAD_CTX_open(const EVP_AEAD_CTX *ctx, unsigned char *out, size_t *out_len,
     size_t max_out_len, const unsigned char *nonce, size_t nonce_len,
@@ -296,9 +296,11 @@ struct evp_aead_st {
 	    size_t key_len, size_t tag_len);
 	void (*cleanup)(struct evp_aead_ctx_st*);
 
-	int (*seal)(const struct evp_aead_ctx_st *ctx, unsigned char *out,
-	    size_t *out_len, size_t max_out_len, const unsigned char *nonce,
+	int (*seal_scatter)(const struct evp_aead_ctx_st *ctx,
+	    unsigned char *out, unsigned char *out_tag, size_t *out_tag_len,
+	    size_t max_out_tag_len, const unsigned char *nonce,
 	    size_t nonce_len, const unsigned char *in, size_t in_len,
+	    const unsigned char *extra_in, size_t extra_in_len,
 	    const unsigned char *ad, size_t ad_len);
 
 	int (*open)(const struct evp_aead_ctx_st *ctx, unsigned char *out,
@@ -45,6 +45,7 @@ LCRYPTO_USED(X509_STORE_set_purpose);
 LCRYPTO_USED(X509_STORE_set_trust);
 LCRYPTO_USED(X509_STORE_set1_param);
 LCRYPTO_USED(X509_STORE_get0_param);
+LCRYPTO_USED(X509_STORE_set_verify_cache);
 LCRYPTO_USED(X509_STORE_get_verify_cb);
 LCRYPTO_USED(X509_STORE_set_verify_cb);
 LCRYPTO_USED(X509_STORE_get_check_issued);
@@ -108,6 +108,9 @@
 #define UP_LOAD		(2*LH_LOAD_MULT) /* load times 256  (default 2) */
 #define DOWN_LOAD	(LH_LOAD_MULT)   /* load times 256  (default 1) */
 
+/* Statistics are updated by lookups that may run concurrently. */
+#define LH_STAT_INC(x)	__atomic_fetch_add(&(x), 1, __ATOMIC_RELAXED)
+
 static void expand(_LHASH *lh);
 static void contract(_LHASH *lh);
 static LHASH_NODE **getrn(_LHASH *lh, const void *data, unsigned long *rhash);
@@ -228,15 +231,20 @@ lh_retrieve(_LHASH *lh, const void *data)
 	LHASH_NODE **rn;
 	void *ret;
 
-	lh->error = 0;
+	/*
+	 * Retrievals may be made concurrently under a read lock, hence avoid
+	 * writing to the hash other than for updating statistics.
+	 */
+	if (lh->error != 0)
+		lh->error = 0;
 	rn = getrn(lh, data, &hash);
 
 	if (*rn == NULL) {
-		lh->num_retrieve_miss++;
+		LH_STAT_INC(lh->num_retrieve_miss);
 		return (NULL);
 	} else {
 		ret = (*rn)->data;
-		lh->num_retrieve++;
+		LH_STAT_INC(lh->num_retrieve);
 	}
 	return (ret);
 }
@@ -375,7 +383,7 @@ static LHASH_NODE **getrn(_LHASH *lh, const void *data, unsigned long *rhash)
 	LHASH_COMP_FN_TYPE cf;
 
 	hash = (*(lh->hash))(data);
-	lh->num_hash_calls++;
+	LH_STAT_INC(lh->num_hash_calls);
 	*rhash = hash;
 
 	nn = hash % lh->pmax;
@@ -386,13 +394,13 @@ static LHASH_NODE **getrn(_LHASH *lh, const void *data, unsigned long *rhash)
 	ret = &(lh->b[(int)nn]);
 	for (n1 = *ret; n1 != NULL; n1 = n1->next) {
 #ifndef OPENSSL_NO_HASH_COMP
-		lh->num_hash_comps++;
+		LH_STAT_INC(lh->num_hash_comps);
 		if (n1->hash != hash) {
 			ret = &(n1->next);
 			continue;
 		}
 #endif
-		lh->num_comp_calls++;
+		LH_STAT_INC(lh->num_comp_calls);
 		if (cf(n1->data, data) == 0)
 			break;
 		ret = &(n1->next);
@@ -0,0 +1,373 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Stitched AES-GCM for amd64, using AES-NI and PCLMULQDQ.
+ *
+ * Each step encrypts eight counter blocks and, interleaved with the AES
+ * rounds, hashes eight blocks of ciphertext with aggregated reduction:
+ *
+ *	Xi' = (Xi + C1) * H^8 + C2 * H^7 + ... + C8 * H
+ *
+ * with the eight products summed unreduced and reduced once. When
+ * encrypting, the ciphertext hashed is that of the previous step; when
+ * decrypting, it is the input of the current step. GHASH operates on
+ * byte reversed blocks, as described in Intel's "Carry-Less Multiplication
+ * Instruction and its Usage for Computing the GCM Mode" white paper.
+ */
+
+#include <immintrin.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <openssl/aes.h>
+
+#include "modes_local.h"
+
+#define GCM_BLOCKS	8
+#define GCM_CHUNKLEN	(GCM_BLOCKS * 16)
+
+/* Below this, the powers of H cost more than the stitching saves. */
+#define AESNI_GCM_MIN	(2 * GCM_CHUNKLEN)
+
+#define AESNI_GCM_FUNC	__attribute__((__target__("aes,pclmul,sse4.1")))
+
+struct gcm_acc {
+	__m128i lo, mid, hi;
+};
+
+static inline __m128i AESNI_GCM_FUNC
+gcm_bswap(__m128i x)
+{
+	return _mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+	    8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+static inline void AESNI_GCM_FUNC
+gcm_acc_init(struct gcm_acc *acc)
+{
+	acc->lo = _mm_setzero_si128();
+	acc->mid = _mm_setzero_si128();
+	acc->hi = _mm_setzero_si128();
+}
+
+/* acc += a * b, unreduced. */
+static inline void AESNI_GCM_FUNC
+gcm_acc_mul(struct gcm_acc *acc, __m128i a, __m128i b)
+{
+	acc->lo = _mm_xor_si128(acc->lo, _mm_clmulepi64_si128(a, b, 0x00));
+	acc->hi = _mm_xor_si128(acc->hi, _mm_clmulepi64_si128(a, b, 0x11));
+	acc->mid = _mm_xor_si128(acc->mid, _mm_clmulepi64_si128(a, b, 0x01));
+	acc->mid = _mm_xor_si128(acc->mid, _mm_clmulepi64_si128(a, b, 0x10));
+}
+
+/* Reduce the 256 bit sum of products in acc modulo the GCM polynomial. */
+static inline __m128i AESNI_GCM_FUNC
+gcm_acc_reduce(const struct gcm_acc *acc)
+{
+	__m128i lo, hi, t0, t1, t2;
+
+	lo = _mm_xor_si128(acc->lo, _mm_slli_si128(acc->mid, 8));
+	hi = _mm_xor_si128(acc->hi, _mm_srli_si128(acc->mid, 8));
+
+	/* Shift the product left by one bit, since the operands are reflected. */
+	t0 = _mm_srli_epi32(lo, 31);
+	t1 = _mm_srli_epi32(hi, 31);
+	lo = _mm_slli_epi32(lo, 1);
+	hi = _mm_slli_epi32(hi, 1);
+	t2 = _mm_srli_si128(t0, 12);
+	t1 = _mm_slli_si128(t1, 4);
+	t0 = _mm_slli_si128(t0, 4);
+	lo = _mm_or_si128(lo, t0);
+	hi = _mm_or_si128(hi, t1);
+	hi = _mm_or_si128(hi, t2);
+
+	/* Reduce modulo x^128 + x^7 + x^2 + x + 1. */
+	t0 = _mm_slli_epi32(lo, 31);
+	t1 = _mm_slli_epi32(lo, 30);
+	t2 = _mm_slli_epi32(lo, 25);
+	t0 = _mm_xor_si128(t0, t1);
+	t0 = _mm_xor_si128(t0, t2);
+	t1 = _mm_srli_si128(t0, 4);
+	t0 = _mm_slli_si128(t0, 12);
+	lo = _mm_xor_si128(lo, t0);
+
+	t2 = _mm_srli_epi32(lo, 1);
+	t0 = _mm_srli_epi32(lo, 2);
+	t2 = _mm_xor_si128(t2, t0);
+	t0 = _mm_srli_epi32(lo, 7);
+	t2 = _mm_xor_si128(t2, t0);
+	t2 = _mm_xor_si128(t2, t1);
+	lo = _mm_xor_si128(lo, t2);
+
+	return _mm_xor_si128(hi, lo);
+}
+
+static inline __m128i AESNI_GCM_FUNC
+gcm_mul(__m128i a, __m128i b)
+{
+	struct gcm_acc acc;
+
+	gcm_acc_init(&acc);
+	gcm_acc_mul(&acc, a, b);
+
+	return gcm_acc_reduce(&acc);
+}
+
+/* hp[i] = H^(i + 1), byte reversed. */
+static void AESNI_GCM_FUNC
+gcm_powers(__m128i hp[GCM_BLOCKS], const u64 H[2])
+{
+	int i;
+
+	/* H is held in host byte order, most significant word first. */
+	hp[0] = _mm_set_epi64x(H[0], H[1]);
+	for (i = 1; i < GCM_BLOCKS; i++)
+		hp[i] = gcm_mul(hp[i - 1], hp[0]);
+}
+
+/*
+ * Load the round keys. aesni_set_encrypt_key() stores one less than the
+ * number of rounds in the schedule.
+ */
+static int AESNI_GCM_FUNC
+gcm_round_keys(__m128i rk[15], const AES_KEY *key)
+{
+	int i, nr;
+
+	nr = key->rounds + 1;
+	for (i = 0; i <= nr; i++)
+		rk[i] = _mm_loadu_si128((const __m128i *)&key->rd_key[4 * i]);
+
+	return nr;
+}
+
+static inline __m128i AESNI_GCM_FUNC
+gcm_counter(__m128i iv, uint32_t ctr)
+{
+	return _mm_insert_epi32(iv, (int)__builtin_bswap32(ctr), 3);
+}
+
+#define GCM_AES_ROUND8(f, rk) do {					\
+	k0 = f(k0, rk);							\
+	k1 = f(k1, rk);							\
+	k2 = f(k2, rk);							\
+	k3 = f(k3, rk);							\
+	k4 = f(k4, rk);							\
+	k5 = f(k5, rk);							\
+	k6 = f(k6, rk);							\
+	k7 = f(k7, rk);							\
+} while (0)
+
+#define GCM_AES_FIRST(rk) do {						\
+	k0 = _mm_xor_si128(gcm_counter(iv, ctr + 0), rk);		\
+	k1 = _mm_xor_si128(gcm_counter(iv, ctr + 1), rk);		\
+	k2 = _mm_xor_si128(gcm_counter(iv, ctr + 2), rk);		\
+	k3 = _mm_xor_si128(gcm_counter(iv, ctr + 3), rk);		\
+	k4 = _mm_xor_si128(gcm_counter(iv, ctr + 4), rk);		\
+	k5 = _mm_xor_si128(gcm_counter(iv, ctr + 5), rk);		\
+	k6 = _mm_xor_si128(gcm_counter(iv, ctr + 6), rk);		\
+	k7 = _mm_xor_si128(gcm_counter(iv, ctr + 7), rk);		\
+} while (0)
+
+#define GCM_AES_STORE(ks) do {						\
+	ks[0] = k0;							\
+	ks[1] = k1;							\
+	ks[2] = k2;							\
+	ks[3] = k3;							\
+	ks[4] = k4;							\
+	ks[5] = k5;							\
+	ks[6] = k6;							\
+	ks[7] = k7;							\
+} while (0)
+
+/*
+ * Encrypt eight counter blocks starting at ctr, while hashing the byte
+ * reversed blocks c into *xi. Returns the keystream in ks.
+ */
+static void AESNI_GCM_FUNC
+gcm_stitch(__m128i ks[GCM_BLOCKS], __m128i iv, uint32_t ctr,
+    const __m128i rk[15], int nr, __m128i *xi, const __m128i c[GCM_BLOCKS],
+    const __m128i hp[GCM_BLOCKS])
+{
+	__m128i k0, k1, k2, k3, k4, k5, k6, k7;
+	struct gcm_acc acc;
+	int r;
+
+	gcm_acc_init(&acc);
+
+	/* There are at least nine middle rounds to spread the hashing over. */
+	GCM_AES_FIRST(rk[0]);
+	GCM_AES_ROUND8(_mm_aesenc_si128, rk[1]);
+	gcm_acc_mul(&acc, _mm_xor_si128(*xi, c[0]), hp[7]);
+	GCM_AES_ROUND8(_mm_aesenc_si128, rk[2]);
+	gcm_acc_mul(&acc, c[1], hp[6]);
+	GCM_AES_ROUND8(_mm_aesenc_si128, rk[3]);
+	gcm_acc_mul(&acc, c[2], hp[5]);
+	GCM_AES_ROUND8(_mm_aesenc_si128, rk[4]);
+	gcm_acc_mul(&acc, c[3], hp[4]);
+	GCM_AES_ROUND8(_mm_aesenc_si128, rk[5]);
+	gcm_acc_mul(&acc, c[4], hp[3]);
+	GCM_AES_ROUND8(_mm_aesenc_si128, rk[6]);
+	gcm_acc_mul(&acc, c[5], hp[2]);
+	GCM_AES_ROUND8(_mm_aesenc_si128, rk[7]);
+	gcm_acc_mul(&acc, c[6], hp[1]);
+	GCM_AES_ROUND8(_mm_aesenc_si128, rk[8]);
+	gcm_acc_mul(&acc, c[7], hp[0]);
+	GCM_AES_ROUND8(_mm_aesenc_si128, rk[9]);
+	*xi = gcm_acc_reduce(&acc);
+	for (r = 10; r < nr; r++)
+		GCM_AES_ROUND8(_mm_aesenc_si128, rk[r]);
+	GCM_AES_ROUND8(_mm_aesenclast_si128, rk[nr]);
+
+	GCM_AES_STORE(ks);
+}
+
+/* Encrypt eight counter blocks starting at ctr, without hashing. */
+static void AESNI_GCM_FUNC
+gcm_ctr(__m128i ks[GCM_BLOCKS], __m128i iv, uint32_t ctr,
+    const __m128i rk[15], int nr)
+{
+	__m128i k0, k1, k2, k3, k4, k5, k6, k7;
+	int r;
+
+	GCM_AES_FIRST(rk[0]);
+	for (r = 1; r < nr; r++)
+		GCM_AES_ROUND8(_mm_aesenc_si128, rk[r]);
+	GCM_AES_ROUND8(_mm_aesenclast_si128, rk[nr]);
+
+	GCM_AES_STORE(ks);
+}
+
+/* Hash eight byte reversed blocks c into *xi. */
+static inline void AESNI_GCM_FUNC
+gcm_ghash8(__m128i *xi, const __m128i c[GCM_BLOCKS],
+    const __m128i hp[GCM_BLOCKS])
+{
+	struct gcm_acc acc;
+	int i;
+
+	gcm_acc_init(&acc);
+	gcm_acc_mul(&acc, _mm_xor_si128(*xi, c[0]), hp[GCM_BLOCKS - 1]);
+	for (i = 1; i < GCM_BLOCKS; i++)
+		gcm_acc_mul(&acc, c[i], hp[GCM_BLOCKS - 1 - i]);
+
+	*xi = gcm_acc_reduce(&acc);
+}
+
+size_t AESNI_GCM_FUNC
+aesni_gcm_encrypt(const unsigned char *in, unsigned char *out, size_t len,
+    const void *key, const unsigned char ivec[16], u8 Xi[16], const u64 H[2])
+{
+	__m128i rk[15], hp[GCM_BLOCKS], ks[GCM_BLOCKS], c[GCM_BLOCKS];
+	__m128i iv, xi;
+	size_t chunks, done;
+	uint32_t ctr;
+	int i, nr;
+
+	if (len < AESNI_GCM_MIN)
+		return 0;
+
+	chunks = len / GCM_CHUNKLEN;
+	done = chunks * GCM_CHUNKLEN;
+
+	nr = gcm_round_keys(rk, key);
+	gcm_powers(hp, H);
+	xi = gcm_bswap(_mm_loadu_si128((const __m128i *)Xi));
+	iv = _mm_loadu_si128((const __m128i *)ivec);
+	ctr = GETU32(ivec + 12);
+
+	/* The first chunk has no ciphertext before it to hash. */
+	gcm_ctr(ks, iv, ctr, rk, nr);
+	for (i = 0; i < GCM_BLOCKS; i++) {
+		ks[i] = _mm_xor_si128(ks[i],
+		    _mm_loadu_si128((const __m128i *)(in + 16 * i)));
+		_mm_storeu_si128((__m128i *)(out + 16 * i), ks[i]);
+		c[i] = gcm_bswap(ks[i]);
+	}
+	ctr += GCM_BLOCKS;
+	in += GCM_CHUNKLEN;
+	out += GCM_CHUNKLEN;
+
+	while (--chunks > 0) {
+		gcm_stitch(ks, iv, ctr, rk, nr, &xi, c, hp);
+		for (i = 0; i < GCM_BLOCKS; i++) {
+			ks[i] = _mm_xor_si128(ks[i],
+			    _mm_loadu_si128((const __m128i *)(in + 16 * i)));
+			_mm_storeu_si128((__m128i *)(out + 16 * i), ks[i]);
+			c[i] = gcm_bswap(ks[i]);
+		}
+		ctr += GCM_BLOCKS;
+		in += GCM_CHUNKLEN;
+		out += GCM_CHUNKLEN;
+	}
+
+	gcm_ghash8(&xi, c, hp);
+	_mm_storeu_si128((__m128i *)Xi, gcm_bswap(xi));
+
+	explicit_bzero(rk, sizeof(rk));
+	explicit_bzero(hp, sizeof(hp));
+	explicit_bzero(ks, sizeof(ks));
+
+	return done;
+}
+
+size_t AESNI_GCM_FUNC
+aesni_gcm_decrypt(const unsigned char *in, unsigned char *out, size_t len,
+    const void *key, const unsigned char ivec[16], u8 Xi[16], const u64 H[2])
+{
+	__m128i rk[15], hp[GCM_BLOCKS], ks[GCM_BLOCKS], c[GCM_BLOCKS];
+	__m128i iv, xi;
+	size_t chunks, done;
+	uint32_t ctr;
+	int i, nr;
+
+	if (len < AESNI_GCM_MIN)
+		return 0;
+
+	chunks = len / GCM_CHUNKLEN;
+	done = chunks * GCM_CHUNKLEN;
+
+	nr = gcm_round_keys(rk, key);
+	gcm_powers(hp, H);
+	xi = gcm_bswap(_mm_loadu_si128((const __m128i *)Xi));
+	iv = _mm_loadu_si128((const __m128i *)ivec);
+	ctr = GETU32(ivec + 12);
+
+	while (chunks-- > 0) {
+		for (i = 0; i < GCM_BLOCKS; i++)
+			c[i] = gcm_bswap(_mm_loadu_si128(
+			    (const __m128i *)(in + 16 * i)));
+		gcm_stitch(ks, iv, ctr, rk, nr, &xi, c, hp);
+		for (i = 0; i < GCM_BLOCKS; i++) {
+			ks[i] = _mm_xor_si128(ks[i],
+			    _mm_loadu_si128((const __m128i *)(in + 16 * i)));
+			_mm_storeu_si128((__m128i *)(out + 16 * i), ks[i]);
+		}
+		ctr += GCM_BLOCKS;
+		in += GCM_CHUNKLEN;
+		out += GCM_CHUNKLEN;
+	}
+
+	_mm_storeu_si128((__m128i *)Xi, gcm_bswap(xi));
+
+	explicit_bzero(rk, sizeof(rk));
+	explicit_bzero(hp, sizeof(hp));
+	explicit_bzero(ks, sizeof(ks));
+
+	return done;
+}
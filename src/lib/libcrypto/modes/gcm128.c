@@ -1305,6 +1305,23 @@ int CRYPTO_gcm128_encrypt_ctr32(GCM128_CONTEXT *ctx,
 			return 0;
 		}
 	}
+	if (ctx->bulk_encrypt != NULL) {
+		i = (*ctx->bulk_encrypt)(in,out,len,key,ctx->Yi.c,ctx->Xi.c,
+		    ctx->H.u);
+		ctr += (unsigned int)(i/16);
+#if BYTE_ORDER == LITTLE_ENDIAN
+#ifdef BSWAP4
+		ctx->Yi.d[3] = BSWAP4(ctr);
+#else
+		PUTU32(ctx->Yi.c+12,ctr);
+#endif
+#else /* BIG_ENDIAN */
+		ctx->Yi.d[3] = ctr;
+#endif
+		out += i;
+		in  += i;
+		len -= i;
+	}
 #if defined(GHASH) && !defined(OPENSSL_SMALL_FOOTPRINT)
 	while (len>=GHASH_CHUNK) {
 		(*stream)(in,out,GHASH_CHUNK/16,key,ctx->Yi.c);
@@ -1425,6 +1442,23 @@ int CRYPTO_gcm128_decrypt_ctr32(GCM128_CONTEXT *ctx,
 			return 0;
 		}
 	}
+	if (ctx->bulk_decrypt != NULL) {
+		i = (*ctx->bulk_decrypt)(in,out,len,key,ctx->Yi.c,ctx->Xi.c,
+		    ctx->H.u);
+		ctr += (unsigned int)(i/16);
+#if BYTE_ORDER == LITTLE_ENDIAN
+#ifdef BSWAP4
+		ctx->Yi.d[3] = BSWAP4(ctr);
+#else
+		PUTU32(ctx->Yi.c+12,ctr);
+#endif
+#else /* BIG_ENDIAN */
+		ctx->Yi.d[3] = ctr;
+#endif
+		out += i;
+		in  += i;
+		len -= i;
+	}
 #if defined(GHASH) && !defined(OPENSSL_SMALL_FOOTPRINT)
 	while (len>=GHASH_CHUNK) {
 		GHASH(ctx,in,GHASH_CHUNK);
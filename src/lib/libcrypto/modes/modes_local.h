@@ -69,6 +69,10 @@ typedef unsigned char u8;
 
 typedef struct { u64 hi,lo; } u128;
 
+typedef size_t (*gcm128_bulk_f)(const unsigned char *in, unsigned char *out,
+    size_t len, const void *key, const unsigned char ivec[16], u8 Xi[16],
+    const u64 H[2]);
+
 #ifdef	TABLE_BITS
 #undef	TABLE_BITS
 #endif
@@ -94,6 +98,11 @@ struct gcm128_context {
 	unsigned int mres, ares;
 	block128_f block;
 	void *key;
+	/*
+	 * Optional single pass CTR and GHASH over the bulk of the data, used
+	 * by the ctr32 functions. Returns the number of bytes processed.
+	 */
+	gcm128_bulk_f bulk_encrypt, bulk_decrypt;
 };
 
 struct xts128_context {
@@ -108,4 +117,17 @@ struct ccm128_context {
 	void *key;
 };
 
+#ifdef AESNI_GCM
+/*
+ * Stitched AES-NI and PCLMULQDQ AES-GCM, for key schedules set up by
+ * aesni_set_encrypt_key().
+ */
+size_t aesni_gcm_encrypt(const unsigned char *in, unsigned char *out,
+    size_t len, const void *key, const unsigned char ivec[16], u8 Xi[16],
+    const u64 H[2]);
+size_t aesni_gcm_decrypt(const unsigned char *in, unsigned char *out,
+    size_t len, const void *key, const unsigned char ivec[16], u8 Xi[16],
+    const u64 H[2]);
+#endif
+
 __END_HIDDEN_DECLS
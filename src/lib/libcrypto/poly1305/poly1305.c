@@ -16,7 +16,11 @@
  */
 
 #include <openssl/poly1305.h>
+#if defined(__SIZEOF_INT128__)
+#include "poly1305-donna-64.c"
+#else
 #include "poly1305-donna.c"
+#endif
 
 void
 CRYPTO_poly1305_init(poly1305_context *ctx, const unsigned char key[32])
@@ -0,0 +1,267 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Multi-block Poly1305 for amd64, absorbing four blocks at a time with AVX2.
+ *
+ * The message is split into four interleaved streams, one per 64-bit vector
+ * lane, with lane j accumulating blocks j, j + 4, j + 8 and so on. Each lane
+ * is multiplied by r^4 per chunk, except for the last chunk, where the lanes
+ * are multiplied by r^4, r^3, r^2 and r respectively, so that the sum of the
+ * lanes is the same as absorbing the blocks one at a time. The lanes hold
+ * h in radix 2^26 so that the 32 x 32 bit multiplies of vpmuludq suffice.
+ */
+
+#include <immintrin.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <openssl/crypto.h>
+
+#include "poly1305_local.h"
+#include "x86_arch.h"
+
+#define POLY1305_CHUNKLEN	64
+
+/* Below this, computing the powers of r costs more than it saves. */
+#define POLY1305_AMD64_MIN	(4 * POLY1305_CHUNKLEN)
+
+#define AVX2_FUNC	__attribute__((__target__("avx2")))
+
+#define M26		0x3ffffff
+#define M44		0xfffffffffff
+#define M42		0x3ffffffffff
+
+/* out = a * b (partially reduced) in radix 2^44. */
+static void
+poly1305_mul44(uint64_t out[3], const uint64_t a[3], const uint64_t b[3])
+{
+	unsigned __int128 d0, d1, d2;
+	uint64_t s1, s2, c;
+
+	s1 = b[1] * (5 << 2);
+	s2 = b[2] * (5 << 2);
+
+	d0 = (unsigned __int128)a[0] * b[0] + (unsigned __int128)a[1] * s2 +
+	    (unsigned __int128)a[2] * s1;
+	d1 = (unsigned __int128)a[0] * b[1] + (unsigned __int128)a[1] * b[0] +
+	    (unsigned __int128)a[2] * s2;
+	d2 = (unsigned __int128)a[0] * b[2] + (unsigned __int128)a[1] * b[1] +
+	    (unsigned __int128)a[2] * b[0];
+
+	c = (uint64_t)(d0 >> 44);
+	out[0] = (uint64_t)d0 & M44;
+	d1 += c;
+	c = (uint64_t)(d1 >> 44);
+	out[1] = (uint64_t)d1 & M44;
+	d2 += c;
+	c = (uint64_t)(d2 >> 42);
+	out[2] = (uint64_t)d2 & M42;
+	out[0] += c * 5;
+	c = out[0] >> 44;
+	out[0] &= M44;
+	out[1] += c;
+}
+
+/* Convert from radix 2^44 to radix 2^26, without reducing. */
+static void
+poly1305_to26(uint64_t out[5], const uint64_t in[3])
+{
+	out[0] = in[0] & M26;
+	out[1] = (in[0] >> 26) + ((in[1] << 18) & M26);
+	out[2] = (in[1] >> 8) & M26;
+	out[3] = (in[1] >> 34) + ((in[2] << 10) & M26);
+	out[4] = in[2] >> 16;
+}
+
+/* Convert from radix 2^26 to radix 2^44, without reducing. */
+static void
+poly1305_from26(uint64_t out[3], const uint64_t in[5])
+{
+	uint64_t t, c;
+
+	t = in[0] + (in[1] << 26);
+	out[0] = t & M44;
+	c = t >> 44;
+	t = c + (in[2] << 8) + (in[3] << 34);
+	out[1] = t & M44;
+	c = t >> 44;
+	out[2] = c + (in[4] << 16);
+}
+
+static void AVX2_FUNC
+poly1305_mul_avx2(__m256i h[5], const __m256i r[5], const __m256i s[5])
+{
+	__m256i d0, d1, d2, d3, d4, c;
+	__m256i m26 = _mm256_set1_epi64x(M26);
+
+	d0 = _mm256_mul_epu32(h[0], r[0]);
+	d0 = _mm256_add_epi64(d0, _mm256_mul_epu32(h[1], s[4]));
+	d0 = _mm256_add_epi64(d0, _mm256_mul_epu32(h[2], s[3]));
+	d0 = _mm256_add_epi64(d0, _mm256_mul_epu32(h[3], s[2]));
+	d0 = _mm256_add_epi64(d0, _mm256_mul_epu32(h[4], s[1]));
+
+	d1 = _mm256_mul_epu32(h[0], r[1]);
+	d1 = _mm256_add_epi64(d1, _mm256_mul_epu32(h[1], r[0]));
+	d1 = _mm256_add_epi64(d1, _mm256_mul_epu32(h[2], s[4]));
+	d1 = _mm256_add_epi64(d1, _mm256_mul_epu32(h[3], s[3]));
+	d1 = _mm256_add_epi64(d1, _mm256_mul_epu32(h[4], s[2]));
+
+	d2 = _mm256_mul_epu32(h[0], r[2]);
+	d2 = _mm256_add_epi64(d2, _mm256_mul_epu32(h[1], r[1]));
+	d2 = _mm256_add_epi64(d2, _mm256_mul_epu32(h[2], r[0]));
+	d2 = _mm256_add_epi64(d2, _mm256_mul_epu32(h[3], s[4]));
+	d2 = _mm256_add_epi64(d2, _mm256_mul_epu32(h[4], s[3]));
+
+	d3 = _mm256_mul_epu32(h[0], r[3]);
+	d3 = _mm256_add_epi64(d3, _mm256_mul_epu32(h[1], r[2]));
+	d3 = _mm256_add_epi64(d3, _mm256_mul_epu32(h[2], r[1]));
+	d3 = _mm256_add_epi64(d3, _mm256_mul_epu32(h[3], r[0]));
+	d3 = _mm256_add_epi64(d3, _mm256_mul_epu32(h[4], s[4]));
+
+	d4 = _mm256_mul_epu32(h[0], r[4]);
+	d4 = _mm256_add_epi64(d4, _mm256_mul_epu32(h[1], r[3]));
+	d4 = _mm256_add_epi64(d4, _mm256_mul_epu32(h[2], r[2]));
+	d4 = _mm256_add_epi64(d4, _mm256_mul_epu32(h[3], r[1]));
+	d4 = _mm256_add_epi64(d4, _mm256_mul_epu32(h[4], r[0]));
+
+	/* (partial) h %= p */
+	c = _mm256_srli_epi64(d0, 26);
+	h[0] = _mm256_and_si256(d0, m26);
+	d1 = _mm256_add_epi64(d1, c);
+	c = _mm256_srli_epi64(d1, 26);
+	h[1] = _mm256_and_si256(d1, m26);
+	d2 = _mm256_add_epi64(d2, c);
+	c = _mm256_srli_epi64(d2, 26);
+	h[2] = _mm256_and_si256(d2, m26);
+	d3 = _mm256_add_epi64(d3, c);
+	c = _mm256_srli_epi64(d3, 26);
+	h[3] = _mm256_and_si256(d3, m26);
+	d4 = _mm256_add_epi64(d4, c);
+	c = _mm256_srli_epi64(d4, 26);
+	h[4] = _mm256_and_si256(d4, m26);
+	h[0] = _mm256_add_epi64(h[0],
+	    _mm256_add_epi64(c, _mm256_slli_epi64(c, 2)));
+	c = _mm256_srli_epi64(h[0], 26);
+	h[0] = _mm256_and_si256(h[0], m26);
+	h[1] = _mm256_add_epi64(h[1], c);
+}
+
+static void AVX2_FUNC
+poly1305_blocks_avx2(uint64_t h[3], const uint64_t r[3],
+    const unsigned char *m, size_t chunks)
+{
+	uint64_t rp[4][3], rl[4][5], hl[5], lanes[4];
+	__m256i r4[5], s4[5], rf[5], sf[5], hv[5];
+	__m256i m26 = _mm256_set1_epi64x(M26);
+	__m256i hibit = _mm256_set1_epi64x(1 << 24);
+	__m256i a, b, lo, hi;
+	uint64_t c;
+	int i;
+
+	/* rp[i] = r^(i + 1). */
+	for (i = 0; i < 3; i++)
+		rp[0][i] = r[i];
+	for (i = 1; i < 4; i++)
+		poly1305_mul44(rp[i], rp[i - 1], r);
+	for (i = 0; i < 4; i++)
+		poly1305_to26(rl[i], rp[i]);
+
+	for (i = 0; i < 5; i++) {
+		r4[i] = _mm256_set1_epi64x(rl[3][i]);
+		s4[i] = _mm256_add_epi64(r4[i], _mm256_slli_epi64(r4[i], 2));
+		rf[i] = _mm256_setr_epi64x(rl[3][i], rl[2][i], rl[1][i],
+		    rl[0][i]);
+		sf[i] = _mm256_add_epi64(rf[i], _mm256_slli_epi64(rf[i], 2));
+	}
+
+	/* The incoming accumulator goes into the first lane. */
+	poly1305_to26(hl, h);
+	for (i = 0; i < 5; i++)
+		hv[i] = _mm256_setr_epi64x(hl[i], 0, 0, 0);
+
+	while (chunks-- > 0) {
+		/* Gather the low and high halves of the four blocks. */
+		a = _mm256_loadu_si256((const __m256i *)m);
+		b = _mm256_loadu_si256((const __m256i *)(m + 32));
+		lo = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b),
+		    _MM_SHUFFLE(3, 1, 2, 0));
+		hi = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b),
+		    _MM_SHUFFLE(3, 1, 2, 0));
+
+		/* h += m[i] */
+		hv[0] = _mm256_add_epi64(hv[0], _mm256_and_si256(lo, m26));
+		hv[1] = _mm256_add_epi64(hv[1],
+		    _mm256_and_si256(_mm256_srli_epi64(lo, 26), m26));
+		hv[2] = _mm256_add_epi64(hv[2],
+		    _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(lo, 52),
+		    _mm256_slli_epi64(hi, 12)), m26));
+		hv[3] = _mm256_add_epi64(hv[3],
+		    _mm256_and_si256(_mm256_srli_epi64(hi, 14), m26));
+		hv[4] = _mm256_add_epi64(hv[4],
+		    _mm256_or_si256(_mm256_srli_epi64(hi, 40), hibit));
+
+		/* h *= r^4, or by r^4, r^3, r^2 and r for the last chunk. */
+		if (chunks > 0)
+			poly1305_mul_avx2(hv, r4, s4);
+		else
+			poly1305_mul_avx2(hv, rf, sf);
+
+		m += POLY1305_CHUNKLEN;
+	}
+
+	/* Sum the lanes and carry. */
+	for (i = 0; i < 5; i++) {
+		_mm256_storeu_si256((__m256i *)lanes, hv[i]);
+		hl[i] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	}
+	for (i = 0; i < 4; i++) {
+		c = hl[i] >> 26;
+		hl[i] &= M26;
+		hl[i + 1] += c;
+	}
+	c = hl[4] >> 26;
+	hl[4] &= M26;
+	hl[0] += c * 5;
+	c = hl[0] >> 26;
+	hl[0] &= M26;
+	hl[1] += c;
+
+	poly1305_from26(h, hl);
+
+	explicit_bzero(rp, sizeof(rp));
+	explicit_bzero(rl, sizeof(rl));
+	explicit_bzero(hl, sizeof(hl));
+	explicit_bzero(lanes, sizeof(lanes));
+}
+
+size_t
+poly1305_blocks_amd64(uint64_t h[3], const uint64_t r[3],
+    const unsigned char *m, size_t bytes)
+{
+	size_t chunks;
+
+	if ((OPENSSL_cpu_caps() & CPUCAP_MASK_AVX2) == 0)
+		return 0;
+	if (bytes < POLY1305_AMD64_MIN)
+		return 0;
+
+	chunks = bytes / POLY1305_CHUNKLEN;
+	poly1305_blocks_avx2(h, r, m, chunks);
+
+	return chunks * POLY1305_CHUNKLEN;
+}
@@ -0,0 +1,39 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef HEADER_POLY1305_LOCAL_H
+#define HEADER_POLY1305_LOCAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+__BEGIN_HIDDEN_DECLS
+
+#ifdef POLY1305_AMD64
+/*
+ * Absorb as many whole multi-block chunks of m as the CPU supports into the
+ * accumulator h, using the key r, both in radix 2^44. All blocks are treated
+ * as full (non-final) blocks. Returns the number of bytes processed, which is
+ * zero if no vector unit is available or m is too short to be worthwhile.
+ */
+size_t poly1305_blocks_amd64(uint64_t h[3], const uint64_t r[3],
+    const unsigned char *m, size_t bytes);
+#endif
+
+__END_HIDDEN_DECLS
+
+#endif /* HEADER_POLY1305_LOCAL_H */
@@ -119,25 +119,79 @@ RSA_flags(const RSA *r)
 	return r == NULL ? 0 : r->meth->flags;
 }
 
+/*
+ * Each private key operation takes a blinding from the pool and returns it
+ * once done, so that a blinding is only ever used by one thread at a time and
+ * needs no locking. Slots are claimed and released with atomic operations,
+ * so threads using the same key do not contend on a lock. If no blinding is
+ * available a new one is set up, while a blinding that is released when the
+ * pool is full is freed.
+ */
+BN_BLINDING *
+rsa_blinding_get(RSA *rsa, BN_CTX *ctx)
+{
+	BN_BLINDING *b;
+	size_t i;
+
+	for (i = 0; i < RSA_BLINDING_POOL_SIZE; i++) {
+		if (__atomic_load_n(&rsa->blinding[i],
+		    __ATOMIC_RELAXED) == NULL)
+			continue;
+		if ((b = __atomic_exchange_n(&rsa->blinding[i], NULL,
+		    __ATOMIC_ACQUIRE)) != NULL)
+			return b;
+	}
+
+	return RSA_setup_blinding(rsa, ctx);
+}
+
+void
+rsa_blinding_release(RSA *rsa, BN_BLINDING *b)
+{
+	BN_BLINDING *empty;
+	size_t i;
+
+	if (b == NULL)
+		return;
+
+	for (i = 0; i < RSA_BLINDING_POOL_SIZE; i++) {
+		empty = NULL;
+		if (__atomic_compare_exchange_n(&rsa->blinding[i], &empty, b,
+		    0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			return;
+	}
+
+	BN_BLINDING_free(b);
+}
+
+void
+rsa_blinding_free(RSA *rsa)
+{
+	size_t i;
+
+	for (i = 0; i < RSA_BLINDING_POOL_SIZE; i++)
+		BN_BLINDING_free(__atomic_exchange_n(&rsa->blinding[i], NULL,
+		    __ATOMIC_ACQUIRE));
+}
+
 void
 RSA_blinding_off(RSA *rsa)
 {
-	BN_BLINDING_free(rsa->blinding);
-	rsa->blinding = NULL;
+	rsa_blinding_free(rsa);
 	rsa->flags |= RSA_FLAG_NO_BLINDING;
 }
 
 int
 RSA_blinding_on(RSA *rsa, BN_CTX *ctx)
 {
+	BN_BLINDING *b;
 	int ret = 0;
 
-	if (rsa->blinding != NULL)
-		RSA_blinding_off(rsa);
+	rsa_blinding_free(rsa);
 
-	rsa->blinding = RSA_setup_blinding(rsa, ctx);
-	if (rsa->blinding == NULL)
+	if ((b = RSA_setup_blinding(rsa, ctx)) == NULL)
 		goto err;
+	rsa_blinding_release(rsa, b);
 
 	rsa->flags &= ~RSA_FLAG_NO_BLINDING;
 	ret = 1;
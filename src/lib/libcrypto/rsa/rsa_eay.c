@@ -252,99 +252,6 @@ err:
 	return r;
 }
 
-static BN_BLINDING *
-rsa_get_blinding(RSA *rsa, int *local, BN_CTX *ctx)
-{
-	BN_BLINDING *ret;
-	int got_write_lock = 0;
-	CRYPTO_THREADID cur;
-
-	CRYPTO_r_lock(CRYPTO_LOCK_RSA);
-
-	if (rsa->blinding == NULL) {
-		CRYPTO_r_unlock(CRYPTO_LOCK_RSA);
-		CRYPTO_w_lock(CRYPTO_LOCK_RSA);
-		got_write_lock = 1;
-
-		if (rsa->blinding == NULL)
-			rsa->blinding = RSA_setup_blinding(rsa, ctx);
-	}
-
-	ret = rsa->blinding;
-	if (ret == NULL)
-		goto err;
-
-	CRYPTO_THREADID_current(&cur);
-	if (!CRYPTO_THREADID_cmp(&cur, BN_BLINDING_thread_id(ret))) {
-		/* rsa->blinding is ours! */
-		*local = 1;
-	} else {
-		/* resort to rsa->mt_blinding instead */
-		/*
-		 * Instruct rsa_blinding_convert(), rsa_blinding_invert()
-		 * that the BN_BLINDING is shared, meaning that accesses
-		 * require locks, and that the blinding factor must be
-		 * stored outside the BN_BLINDING
-		 */
-		*local = 0;
-
-		if (rsa->mt_blinding == NULL) {
-			if (!got_write_lock) {
-				CRYPTO_r_unlock(CRYPTO_LOCK_RSA);
-				CRYPTO_w_lock(CRYPTO_LOCK_RSA);
-				got_write_lock = 1;
-			}
-
-			if (rsa->mt_blinding == NULL)
-				rsa->mt_blinding = RSA_setup_blinding(rsa, ctx);
-		}
-		ret = rsa->mt_blinding;
-	}
-
-err:
-	if (got_write_lock)
-		CRYPTO_w_unlock(CRYPTO_LOCK_RSA);
-	else
-		CRYPTO_r_unlock(CRYPTO_LOCK_RSA);
-	return ret;
-}
-
-static int
-rsa_blinding_convert(BN_BLINDING *b, BIGNUM *f, BIGNUM *unblind, BN_CTX *ctx)
-{
-	if (unblind == NULL)
-		/*
-		 * Local blinding: store the unblinding factor
-		 * in BN_BLINDING.
-		 */
-		return BN_BLINDING_convert_ex(f, NULL, b, ctx);
-	else {
-		/*
-		 * Shared blinding: store the unblinding factor
-		 * outside BN_BLINDING.
-		 */
-		int ret;
-		CRYPTO_w_lock(CRYPTO_LOCK_RSA_BLINDING);
-		ret = BN_BLINDING_convert_ex(f, unblind, b, ctx);
-		CRYPTO_w_unlock(CRYPTO_LOCK_RSA_BLINDING);
-		return ret;
-	}
-}
-
-static int
-rsa_blinding_invert(BN_BLINDING *b, BIGNUM *f, BIGNUM *unblind, BN_CTX *ctx)
-{
-	/*
-	 * For local blinding, unblind is set to NULL, and BN_BLINDING_invert_ex
-	 * will use the unblinding factor stored in BN_BLINDING.
-	 * If BN_BLINDING is shared between threads, unblind must be non-null:
-	 * BN_BLINDING_invert_ex will then use the local unblinding factor,
-	 * and will only read the modulus from BN_BLINDING.
-	 * In both cases it's safe to access the blinding without a lock.
-	 */
-	return BN_BLINDING_invert_ex(f, unblind, b, ctx);
-}
-
 /* signing */
 static int
 RSA_eay_private_encrypt(int flen, const unsigned char *from, unsigned char *to,
@@ -354,13 +261,6 @@ RSA_eay_private_encrypt(int flen, const unsigned char *from, unsigned char *to,
 	int i, j, k, num = 0, r = -1;
 	unsigned char *buf = NULL;
 	BN_CTX *ctx = NULL;
-	int local_blinding = 0;
-	/*
-	 * Used only if the blinding structure is shared. A non-NULL unblind
-	 * instructs rsa_blinding_convert() and rsa_blinding_invert() to store
-	 * the unblinding factor outside the blinding structure.
-	 */
-	BIGNUM *unblind = NULL;
 	BN_BLINDING *blinding = NULL;
 
 	if ((ctx = BN_CTX_new()) == NULL)
@@ -404,19 +304,11 @@ RSA_eay_private_encrypt(int flen, const unsigned char *from, unsigned char *to,
 	}
 
 	if (!(rsa->flags & RSA_FLAG_NO_BLINDING)) {
-		blinding = rsa_get_blinding(rsa, &local_blinding, ctx);
-		if (blinding == NULL) {
+		if ((blinding = rsa_blinding_get(rsa, ctx)) == NULL) {
 			RSAerror(ERR_R_INTERNAL_ERROR);
 			goto err;
 		}
-	}
-
-	if (blinding != NULL) {
-		if (!local_blinding && ((unblind = BN_CTX_get(ctx)) == NULL)) {
-			RSAerror(ERR_R_MALLOC_FAILURE);
-			goto err;
-		}
-		if (!rsa_blinding_convert(blinding, f, unblind, ctx))
+		if (!BN_BLINDING_convert_ex(f, NULL, blinding, ctx))
 			goto err;
 	}
 
@@ -442,8 +334,8 @@ RSA_eay_private_encrypt(int flen, const unsigned char *from, unsigned char *to,
 		}
 	}
 
-	if (blinding)
-		if (!rsa_blinding_invert(blinding, ret, unblind, ctx))
+	if (blinding != NULL)
+		if (!BN_BLINDING_invert_ex(ret, NULL, blinding, ctx))
 			goto err;
 
 	if (padding == RSA_X931_PADDING) {
@@ -465,6 +357,7 @@ RSA_eay_private_encrypt(int flen, const unsigned char *from, unsigned char *to,
 
 	r = num;
 err:
+	rsa_blinding_release(rsa, blinding);
 	if (ctx != NULL) {
 		BN_CTX_end(ctx);
 		BN_CTX_free(ctx);
@@ -482,13 +375,6 @@ RSA_eay_private_decrypt(int flen, const unsigned char *from, unsigned char *to,
 	unsigned char *p;
 	unsigned char *buf = NULL;
 	BN_CTX *ctx = NULL;
-	int local_blinding = 0;
-	/*
-	 * Used only if the blinding structure is shared. A non-NULL unblind
-	 * instructs rsa_blinding_convert() and rsa_blinding_invert() to store
-	 * the unblinding factor outside the blinding structure.
-	 */
-	BIGNUM *unblind = NULL;
 	BN_BLINDING *blinding = NULL;
 
 	if ((ctx = BN_CTX_new()) == NULL)
@@ -522,19 +408,11 @@ RSA_eay_private_decrypt(int flen, const unsigned char *from, unsigned char *to,
 	}
 
 	if (!(rsa->flags & RSA_FLAG_NO_BLINDING)) {
-		blinding = rsa_get_blinding(rsa, &local_blinding, ctx);
-		if (blinding == NULL) {
+		if ((blinding = rsa_blinding_get(rsa, ctx)) == NULL) {
 			RSAerror(ERR_R_INTERNAL_ERROR);
 			goto err;
 		}
-	}
-
-	if (blinding != NULL) {
-		if (!local_blinding && ((unblind = BN_CTX_get(ctx)) == NULL)) {
-			RSAerror(ERR_R_MALLOC_FAILURE);
-			goto err;
-		}
-		if (!rsa_blinding_convert(blinding, f, unblind, ctx))
+		if (!BN_BLINDING_convert_ex(f, NULL, blinding, ctx))
 			goto err;
 	}
 
@@ -561,8 +439,8 @@ RSA_eay_private_decrypt(int flen, const unsigned char *from, unsigned char *to,
 		}
 	}
 
-	if (blinding)
-		if (!rsa_blinding_invert(blinding, ret, unblind, ctx))
+	if (blinding != NULL)
+		if (!BN_BLINDING_invert_ex(ret, NULL, blinding, ctx))
 			goto err;
 
 	p = buf;
@@ -588,6 +466,7 @@ RSA_eay_private_decrypt(int flen, const unsigned char *from, unsigned char *to,
 		RSAerror(RSA_R_PADDING_CHECK_FAILED);
 
 err:
+	rsa_blinding_release(rsa, blinding);
 	if (ctx != NULL) {
 		BN_CTX_end(ctx);
 		BN_CTX_free(ctx);
@@ -208,8 +208,7 @@ RSA_free(RSA *r)
 	BN_clear_free(r->dmp1);
 	BN_clear_free(r->dmq1);
 	BN_clear_free(r->iqmp);
-	BN_BLINDING_free(r->blinding);
-	BN_BLINDING_free(r->mt_blinding);
+	rsa_blinding_free(r);
 	RSA_PSS_PARAMS_free(r->pss);
 	free(r);
 }
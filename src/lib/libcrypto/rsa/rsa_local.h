@@ -2,6 +2,8 @@
 
 __BEGIN_HIDDEN_DECLS
 
+#define RSA_BLINDING_POOL_SIZE	32
+
 #define RSA_MIN_MODULUS_BITS	512
 
 /* Macros to test if a pkey or ctx is for a PSS key */
@@ -76,10 +78,11 @@ struct rsa_st {
 	BN_MONT_CTX *_method_mod_p;
 	BN_MONT_CTX *_method_mod_q;
 
-	/* all BIGNUM values are actually in the following data, if it is not
-	 * NULL */
-	BN_BLINDING *blinding;
-	BN_BLINDING *mt_blinding;
+	/*
+	 * Blindings that are not currently in use by a private key operation.
+	 * Slots are claimed and released atomically, see rsa_blinding_get().
+	 */
+	BN_BLINDING *blinding[RSA_BLINDING_POOL_SIZE];
 };
 
 RSA_PSS_PARAMS *rsa_pss_params_create(const EVP_MD *sigmd, const EVP_MD *mgf1md,
@@ -87,6 +90,10 @@ RSA_PSS_PARAMS *rsa_pss_params_create(const EVP_MD *sigmd, const EVP_MD *mgf1md,
 int rsa_pss_get_param(const RSA_PSS_PARAMS *pss, const EVP_MD **pmd,
     const EVP_MD **pmgf1md, int *psaltlen);
 
+BN_BLINDING *rsa_blinding_get(RSA *rsa, BN_CTX *ctx);
+void rsa_blinding_release(RSA *rsa, BN_BLINDING *b);
+void rsa_blinding_free(RSA *rsa);
+
 extern int int_rsa_verify(int dtype, const unsigned char *m,
     unsigned int m_len, unsigned char *rm, size_t *prm_len,
     const unsigned char *sigbuf, size_t siglen, RSA *rsa);
@@ -17,6 +17,8 @@
 #include <openssl/sha.h>
 #include <openssl/opensslv.h>
 
+#include "sha256_local.h"
+
 int SHA224_Init(SHA256_CTX *c)
 	{
 	memset (c,0,sizeof(*c));
@@ -107,7 +109,13 @@ int SHA224_Final (unsigned char *md, SHA256_CTX *c)
 #define	HASH_UPDATE		SHA256_Update
 #define	HASH_TRANSFORM		SHA256_Transform
 #define	HASH_FINAL		SHA256_Final
+#ifdef SHA256_AMD64
+#define	HASH_BLOCK_DATA_ORDER	sha256_block_data_order_amd64
+static void sha256_block_data_order_amd64(SHA256_CTX *ctx, const void *in,
+    size_t num);
+#else
 #define	HASH_BLOCK_DATA_ORDER	sha256_block_data_order
+#endif
 #ifndef SHA256_ASM
 static
 #endif
@@ -115,6 +123,24 @@ void sha256_block_data_order (SHA256_CTX *ctx, const void *in, size_t num);
 
 #include "md32_common.h"
 
+#ifdef SHA256_AMD64
+/*
+ * Use the SHA extensions where available, leaving any remaining blocks to
+ * sha256_block_data_order().
+ */
+static void
+sha256_block_data_order_amd64(SHA256_CTX *ctx, const void *in, size_t num)
+{
+	size_t done;
+
+	done = sha256_blocks_amd64(ctx->h, in, num);
+	if (done < num)
+		sha256_block_data_order(ctx,
+		    (const unsigned char *)in + done * SHA256_CBLOCK,
+		    num - done);
+}
+#endif
+
 #ifndef SHA256_ASM
 static const SHA_LONG K256[64] = {
 	0x428a2f98UL,0x71374491UL,0xb5c0fbcfUL,0xe9b5dba5UL,
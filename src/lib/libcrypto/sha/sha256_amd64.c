@@ -0,0 +1,144 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * SHA-256 block function for amd64, using the SHA extensions.
+ *
+ * sha256rnds2 performs two rounds at a time on the state held as ABEF and
+ * CDGH, while sha256msg1 and sha256msg2 compute the message schedule.
+ */
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#include <openssl/crypto.h>
+#include <openssl/sha.h>
+
+#include "sha256_local.h"
+#include "x86_arch.h"
+
+#define SHA_FUNC	__attribute__((__target__("sha,sse4.1")))
+
+static const SHA_LONG K256[64] __attribute__((__aligned__(16))) = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/*
+ * Four rounds with the SHA extensions. m0 holds the message words for these
+ * rounds; m1 is completed by sha256msg2 and m3 is started by sha256msg1,
+ * where the schedule still needs them.
+ */
+#define SHANI_ROUNDS(i, m0, m1, m3) do {				\
+	msg = _mm_add_epi32(m0,						\
+	    _mm_load_si128((const __m128i *)&K256[4 * (i)]));		\
+	state1 = _mm_sha256rnds2_epu32(state1, state0, msg);		\
+	if ((i) >= 3 && (i) <= 14) {					\
+		tmp = _mm_alignr_epi8(m0, m3, 4);			\
+		m1 = _mm_add_epi32(m1, tmp);				\
+		m1 = _mm_sha256msg2_epu32(m1, m0);			\
+	}								\
+	msg = _mm_shuffle_epi32(msg, 0x0e);				\
+	state0 = _mm_sha256rnds2_epu32(state0, state1, msg);		\
+	if ((i) >= 1 && (i) <= 12)					\
+		m3 = _mm_sha256msg1_epu32(m3, m0);			\
+} while (0)
+
+static void SHA_FUNC
+sha256_blocks_shani(SHA_LONG h[8], const unsigned char *in, size_t num)
+{
+	__m128i state0, state1, abef, cdgh, msg, tmp, mask;
+	__m128i m0, m1, m2, m3;
+
+	mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+	/* Rearrange ABCD EFGH into ABEF CDGH. */
+	tmp = _mm_loadu_si128((const __m128i *)&h[0]);
+	state1 = _mm_loadu_si128((const __m128i *)&h[4]);
+	tmp = _mm_shuffle_epi32(tmp, 0xb1);
+	state1 = _mm_shuffle_epi32(state1, 0x1b);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+	while (num-- > 0) {
+		abef = state0;
+		cdgh = state1;
+
+		m0 = _mm_shuffle_epi8(
+		    _mm_loadu_si128((const __m128i *)(in + 0)), mask);
+		m1 = _mm_shuffle_epi8(
+		    _mm_loadu_si128((const __m128i *)(in + 16)), mask);
+		m2 = _mm_shuffle_epi8(
+		    _mm_loadu_si128((const __m128i *)(in + 32)), mask);
+		m3 = _mm_shuffle_epi8(
+		    _mm_loadu_si128((const __m128i *)(in + 48)), mask);
+
+		SHANI_ROUNDS(0, m0, m1, m3);
+		SHANI_ROUNDS(1, m1, m2, m0);
+		SHANI_ROUNDS(2, m2, m3, m1);
+		SHANI_ROUNDS(3, m3, m0, m2);
+		SHANI_ROUNDS(4, m0, m1, m3);
+		SHANI_ROUNDS(5, m1, m2, m0);
+		SHANI_ROUNDS(6, m2, m3, m1);
+		SHANI_ROUNDS(7, m3, m0, m2);
+		SHANI_ROUNDS(8, m0, m1, m3);
+		SHANI_ROUNDS(9, m1, m2, m0);
+		SHANI_ROUNDS(10, m2, m3, m1);
+		SHANI_ROUNDS(11, m3, m0, m2);
+		SHANI_ROUNDS(12, m0, m1, m3);
+		SHANI_ROUNDS(13, m1, m2, m0);
+		SHANI_ROUNDS(14, m2, m3, m1);
+		SHANI_ROUNDS(15, m3, m0, m2);
+
+		state0 = _mm_add_epi32(state0, abef);
+		state1 = _mm_add_epi32(state1, cdgh);
+
+		in += SHA256_CBLOCK;
+	}
+
+	/* Rearrange ABEF CDGH back into ABCD EFGH. */
+	tmp = _mm_shuffle_epi32(state0, 0x1b);
+	state1 = _mm_shuffle_epi32(state1, 0xb1);
+	state0 = _mm_blend_epi16(tmp, state1, 0xf0);
+	state1 = _mm_alignr_epi8(state1, tmp, 8);
+	_mm_storeu_si128((__m128i *)&h[0], state0);
+	_mm_storeu_si128((__m128i *)&h[4], state1);
+}
+
+size_t
+sha256_blocks_amd64(SHA_LONG h[8], const void *in, size_t num)
+{
+	if ((OPENSSL_cpu_caps() & CPUCAP_MASK_SHA) != 0) {
+		sha256_blocks_shani(h, in, num);
+		return num;
+	}
+	return 0;
+}
@@ -0,0 +1,38 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef HEADER_SHA256_LOCAL_H
+#define HEADER_SHA256_LOCAL_H
+
+#include <stddef.h>
+
+#include <openssl/sha.h>
+
+__BEGIN_HIDDEN_DECLS
+
+#ifdef SHA256_AMD64
+/*
+ * Process num 64 byte blocks of in, updating the state in h, if the CPU
+ * supports the SHA extensions. Returns the number of blocks processed, which
+ * is either num or zero.
+ */
+size_t sha256_blocks_amd64(SHA_LONG h[8], const void *in, size_t num);
+#endif
+
+__END_HIDDEN_DECLS
+
+#endif /* HEADER_SHA256_LOCAL_H */
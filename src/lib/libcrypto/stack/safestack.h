@@ -443,6 +443,28 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define sk_BY_DIR_HASH_sort(st) SKM_sk_sort(BY_DIR_HASH, (st))
 #define sk_BY_DIR_HASH_is_sorted(st) SKM_sk_is_sorted(BY_DIR_HASH, (st))
 
+#define sk_BY_DIR_NAME_new(cmp) SKM_sk_new(BY_DIR_NAME, (cmp))
+#define sk_BY_DIR_NAME_new_null() SKM_sk_new_null(BY_DIR_NAME)
+#define sk_BY_DIR_NAME_free(st) SKM_sk_free(BY_DIR_NAME, (st))
+#define sk_BY_DIR_NAME_num(st) SKM_sk_num(BY_DIR_NAME, (st))
+#define sk_BY_DIR_NAME_value(st, i) SKM_sk_value(BY_DIR_NAME, (st), (i))
+#define sk_BY_DIR_NAME_set(st, i, val) SKM_sk_set(BY_DIR_NAME, (st), (i), (val))
+#define sk_BY_DIR_NAME_zero(st) SKM_sk_zero(BY_DIR_NAME, (st))
+#define sk_BY_DIR_NAME_push(st, val) SKM_sk_push(BY_DIR_NAME, (st), (val))
+#define sk_BY_DIR_NAME_unshift(st, val) SKM_sk_unshift(BY_DIR_NAME, (st), (val))
+#define sk_BY_DIR_NAME_find(st, val) SKM_sk_find(BY_DIR_NAME, (st), (val))
+#define sk_BY_DIR_NAME_find_ex(st, val) SKM_sk_find_ex(BY_DIR_NAME, (st), (val))
+#define sk_BY_DIR_NAME_delete(st, i) SKM_sk_delete(BY_DIR_NAME, (st), (i))
+#define sk_BY_DIR_NAME_delete_ptr(st, ptr) SKM_sk_delete_ptr(BY_DIR_NAME, (st), (ptr))
+#define sk_BY_DIR_NAME_insert(st, val, i) SKM_sk_insert(BY_DIR_NAME, (st), (val), (i))
+#define sk_BY_DIR_NAME_set_cmp_func(st, cmp) SKM_sk_set_cmp_func(BY_DIR_NAME, (st), (cmp))
+#define sk_BY_DIR_NAME_dup(st) SKM_sk_dup(BY_DIR_NAME, st)
+#define sk_BY_DIR_NAME_pop_free(st, free_func) SKM_sk_pop_free(BY_DIR_NAME, (st), (free_func))
+#define sk_BY_DIR_NAME_shift(st) SKM_sk_shift(BY_DIR_NAME, (st))
+#define sk_BY_DIR_NAME_pop(st) SKM_sk_pop(BY_DIR_NAME, (st))
+#define sk_BY_DIR_NAME_sort(st) SKM_sk_sort(BY_DIR_NAME, (st))
+#define sk_BY_DIR_NAME_is_sorted(st) SKM_sk_is_sorted(BY_DIR_NAME, (st))
+
 #define sk_CMS_CertificateChoices_new(cmp) SKM_sk_new(CMS_CertificateChoices, (cmp))
 #define sk_CMS_CertificateChoices_new_null() SKM_sk_new_null(CMS_CertificateChoices)
 #define sk_CMS_CertificateChoices_free(st) SKM_sk_free(CMS_CertificateChoices, (st))
@@ -62,6 +62,8 @@
 #include <openssl/objects.h>
 #include <openssl/stack.h>
 
+#include "stack_local.h"
+
 #undef MIN_NODES
 #define MIN_NODES	4
 
@@ -166,6 +168,39 @@ sk_insert(_STACK *st, void *data, int loc)
 }
 LCRYPTO_ALIAS(sk_insert);
 
+/*
+ * Insert data into a stack with a comparison function, keeping it sorted.
+ * The stack is sorted first if needed, then data is placed after any elements
+ * that compare equal to it, so these stay in the order they were inserted.
+ * Returns the index of data, or -1 on failure.
+ */
+int
+sk_insert_sorted(_STACK *st, void *data)
+{
+	int lo, hi, mid;
+
+	if (st == NULL || st->comp == NULL)
+		return -1;
+
+	sk_sort(st);
+
+	lo = 0;
+	hi = st->num;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (st->comp(&data, &st->data[mid]) < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	if (sk_insert(st, data, lo) == 0)
+		return -1;
+	st->sorted = 1;
+
+	return lo;
+}
+
 void *
 sk_delete_ptr(_STACK *st, void *p)
 {
@@ -0,0 +1,33 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef HEADER_STACK_LOCAL_H
+#define HEADER_STACK_LOCAL_H
+
+#include <openssl/safestack.h>
+#include <openssl/stack.h>
+
+__BEGIN_HIDDEN_DECLS
+
+int sk_insert_sorted(_STACK *st, void *data);
+
+#define SKM_sk_insert_sorted(type, st, val) \
+	sk_insert_sorted(CHECKED_STACK_OF(type, st), CHECKED_PTR_OF(type, val))
+
+__END_HIDDEN_DECLS
+
+#endif /* HEADER_STACK_LOCAL_H */
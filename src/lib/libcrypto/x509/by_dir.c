@@ -59,7 +59,9 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <dirent.h>
 #include <errno.h>
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
@@ -70,6 +72,7 @@
 #include <openssl/err.h>
 #include <openssl/x509.h>
 
+#include "stack_local.h"
 #include "x509_local.h"
 
 typedef struct lookup_dir_hashes_st {
@@ -77,25 +80,53 @@ typedef struct lookup_dir_hashes_st {
 	int suffix;
 } BY_DIR_HASH;
 
+typedef struct lookup_dir_name_st {
+	unsigned long hash;
+	int type;
+	int suffix;
+} BY_DIR_NAME;
+
+DECLARE_STACK_OF(BY_DIR_NAME)
+
 typedef struct lookup_dir_entry_st {
 	char *dir;
 	int dir_type;
 	STACK_OF(BY_DIR_HASH) *hashes;
+
+	/* Names with no files in the directory, with a suffix of zero. */
+	STACK_OF(BY_DIR_NAME) *misses;
+	/* All files in the directory, in snapshot mode. */
+	STACK_OF(BY_DIR_NAME) *snapshot;
+	time_t mtime;		/* Of the directory when it was last checked. */
+	time_t checked;		/* When the directory was last checked. */
+	int stable;		/* Set if the directory may be cached. */
+	unsigned int generation; /* Incremented when the cache is dropped. */
 } BY_DIR_ENTRY;
 
 typedef struct lookup_dir_st {
 	BUF_MEM *buffer;
 	STACK_OF(BY_DIR_ENTRY) *dirs;
+	int snapshot;
 } BY_DIR;
 
 DECLARE_STACK_OF(BY_DIR_HASH)
 DECLARE_STACK_OF(BY_DIR_ENTRY)
 
+/*
+ * A directory is checked for changes at most once per interval, in seconds.
+ * Until then, names that were not found are assumed to still be missing.
+ */
+#define BY_DIR_CHECK_INTERVAL	1
+
+/* Forget all misses once there are this many in one directory. */
+#define BY_DIR_MISSES_MAX	4096
+
 static int dir_ctrl(X509_LOOKUP *ctx, int cmd, const char *argp, long argl,
     char **ret);
 static int new_dir(X509_LOOKUP *lu);
 static void free_dir(X509_LOOKUP *lu);
 static int add_cert_dir(BY_DIR *ctx, const char *dir, int type);
+static void by_dir_entry_reset(BY_DIR_ENTRY *ent);
 static int get_cert_by_subject(X509_LOOKUP *xl, int type, X509_NAME *name,
     X509_OBJECT *ret);
 
@@ -125,6 +156,7 @@ dir_ctrl(X509_LOOKUP *ctx, int cmd, const char *argp, long argl,
 {
 	int ret = 0;
 	BY_DIR *ld;
+	int i;
 
 	ld = (BY_DIR *)ctx->method_data;
 
@@ -139,6 +171,14 @@ dir_ctrl(X509_LOOKUP *ctx, int cmd, const char *argp, long argl,
 		} else
 			ret = add_cert_dir(ld, argp, (int)argl);
 		break;
+	case X509_L_DIR_SNAPSHOT:
+		CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
+		ld->snapshot = argl != 0;
+		for (i = 0; i < sk_BY_DIR_ENTRY_num(ld->dirs); i++)
+			by_dir_entry_reset(sk_BY_DIR_ENTRY_value(ld->dirs, i));
+		CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+		ret = 1;
+		break;
 	}
 	return ret;
 }
@@ -158,6 +198,7 @@ new_dir(X509_LOOKUP *lu)
 		return 0;
 	}
 	a->dirs = NULL;
+	a->snapshot = 0;
 	lu->method_data = (char *)a;
 	return 1;
 }
@@ -179,11 +220,31 @@ by_dir_hash_cmp(const BY_DIR_HASH * const *a,
 	return 0;
 }
 
+static void
+by_dir_name_free(BY_DIR_NAME *name)
+{
+	free(name);
+}
+
+static int
+by_dir_name_cmp(const BY_DIR_NAME * const *a, const BY_DIR_NAME * const *b)
+{
+	if ((*a)->hash != (*b)->hash)
+		return (*a)->hash > (*b)->hash ? 1 : -1;
+	if ((*a)->type != (*b)->type)
+		return (*a)->type > (*b)->type ? 1 : -1;
+	if ((*a)->suffix != (*b)->suffix)
+		return (*a)->suffix > (*b)->suffix ? 1 : -1;
+	return 0;
+}
+
 static void
 by_dir_entry_free(BY_DIR_ENTRY *ent)
 {
 	free(ent->dir);
 	sk_BY_DIR_HASH_pop_free(ent->hashes, by_dir_hash_free);
+	sk_BY_DIR_NAME_pop_free(ent->misses, by_dir_name_free);
+	sk_BY_DIR_NAME_pop_free(ent->snapshot, by_dir_name_free);
 	free(ent);
 }
 
@@ -243,12 +304,21 @@ add_cert_dir(BY_DIR *ctx, const char *dir, int type)
 			}
 			ent->dir_type = type;
 			ent->hashes = sk_BY_DIR_HASH_new(by_dir_hash_cmp);
+			ent->misses = sk_BY_DIR_NAME_new(by_dir_name_cmp);
+			ent->snapshot = NULL;
+			ent->mtime = 0;
+			ent->checked = 0;
+			ent->stable = 0;
+			ent->generation = 0;
 			ent->dir = strndup(ss, (size_t)len);
-			if (ent->dir == NULL || ent->hashes == NULL) {
+			if (ent->dir == NULL || ent->hashes == NULL ||
+			    ent->misses == NULL) {
 				X509error(ERR_R_MALLOC_FAILURE);
 				by_dir_entry_free(ent);
 				return 0;
 			}
+			sk_BY_DIR_HASH_sort(ent->hashes);
+			sk_BY_DIR_NAME_sort(ent->misses);
 			if (!sk_BY_DIR_ENTRY_push(ctx->dirs, ent)) {
 				X509error(ERR_R_MALLOC_FAILURE);
 				by_dir_entry_free(ent);
@@ -259,6 +329,233 @@ add_cert_dir(BY_DIR *ctx, const char *dir, int type)
 	return 1;
 }
 
+/*
+ * Parse a file name of the form hash.N or hash.rN, as looked for by
+ * get_cert_by_subject(). Returns 0 for any other name.
+ */
+static int
+by_dir_name_parse(const char *s, BY_DIR_NAME *name)
+{
+	unsigned long hash = 0;
+	int i, suffix = 0;
+
+	for (i = 0; i < 8; i++) {
+		if (s[i] >= '0' && s[i] <= '9')
+			hash = hash << 4 | (s[i] - '0');
+		else if (s[i] >= 'a' && s[i] <= 'f')
+			hash = hash << 4 | (s[i] - 'a' + 10);
+		else
+			return 0;
+	}
+	if (s[i++] != '.')
+		return 0;
+
+	name->type = X509_LU_X509;
+	if (s[i] == 'r') {
+		name->type = X509_LU_CRL;
+		i++;
+	}
+
+	if (s[i] == '\0' || (s[i] == '0' && s[i + 1] != '\0'))
+		return 0;
+	for (; s[i] != '\0'; i++) {
+		if (s[i] < '0' || s[i] > '9')
+			return 0;
+		if (suffix > (INT_MAX - (s[i] - '0')) / 10)
+			return 0;
+		suffix = suffix * 10 + (s[i] - '0');
+	}
+
+	name->hash = hash;
+	name->suffix = suffix;
+
+	return 1;
+}
+
+static STACK_OF(BY_DIR_NAME) *
+by_dir_snapshot_new(const char *dir)
+{
+	STACK_OF(BY_DIR_NAME) *snapshot;
+	BY_DIR_NAME name, *n;
+	struct dirent *dp;
+	DIR *dirp;
+
+	if ((snapshot = sk_BY_DIR_NAME_new(by_dir_name_cmp)) == NULL)
+		return NULL;
+	if ((dirp = opendir(dir)) == NULL)
+		goto err;
+
+	while ((dp = readdir(dirp)) != NULL) {
+		if (!by_dir_name_parse(dp->d_name, &name))
+			continue;
+		if ((n = malloc(sizeof(*n))) == NULL)
+			goto err;
+		*n = name;
+		if (!sk_BY_DIR_NAME_push(snapshot, n)) {
+			free(n);
+			goto err;
+		}
+	}
+	closedir(dirp);
+
+	sk_BY_DIR_NAME_sort(snapshot);
+
+	return snapshot;
+
+ err:
+	if (dirp != NULL)
+		closedir(dirp);
+	sk_BY_DIR_NAME_pop_free(snapshot, by_dir_name_free);
+
+	return NULL;
+}
+
+static void
+by_dir_entry_clear_misses(BY_DIR_ENTRY *ent)
+{
+	BY_DIR_NAME *name;
+
+	while ((name = sk_BY_DIR_NAME_pop(ent->misses)) != NULL)
+		by_dir_name_free(name);
+}
+
+/*
+ * Drop everything cached about the directory, so that it is checked again
+ * on the next lookup. Called with the store locked for writing.
+ */
+static void
+by_dir_entry_reset(BY_DIR_ENTRY *ent)
+{
+	sk_BY_DIR_NAME_pop_free(ent->snapshot, by_dir_name_free);
+	ent->snapshot = NULL;
+	by_dir_entry_clear_misses(ent);
+	ent->generation++;
+	ent->checked = 0;
+	ent->stable = 0;
+}
+
+static int
+by_dir_entry_fresh(BY_DIR_ENTRY *ent, time_t now)
+{
+	return ent->checked != 0 && now >= ent->checked &&
+	    now - ent->checked < BY_DIR_CHECK_INTERVAL;
+}
+
+/*
+ * Drop everything cached about the directory if it has been modified since
+ * it was last checked. Called with the store locked for writing.
+ */
+static void
+by_dir_entry_check(BY_DIR_ENTRY *ent, int snapshot, time_t now)
+{
+	struct stat st;
+	time_t mtime = 0;
+
+	if (by_dir_entry_fresh(ent, now))
+		return;
+	ent->checked = now;
+
+	if (stat(ent->dir, &st) == 0)
+		mtime = st.st_mtime;
+	if (ent->stable && mtime == ent->mtime)
+		return;
+
+	by_dir_entry_reset(ent);
+	ent->checked = now;
+
+	/*
+	 * A directory modified within the current second may be modified
+	 * again without its mtime changing, so only cache it after that.
+	 */
+	ent->mtime = mtime;
+	ent->stable = mtime < now;
+	if (ent->stable && snapshot)
+		ent->snapshot = by_dir_snapshot_new(ent->dir);
+}
+
+/*
+ * Look up the files for hash in the cache, starting at suffix. Returns the
+ * number of files with consecutive suffixes that exist, or -1 if this is not
+ * known and the directory needs to be searched.
+ */
+static int
+by_dir_entry_cached(BY_DIR_ENTRY *ent, int type, unsigned long hash,
+    int suffix)
+{
+	BY_DIR_NAME name;
+
+	name.hash = hash;
+	name.type = type;
+	name.suffix = suffix;
+
+	if (ent->snapshot != NULL) {
+		while (sk_BY_DIR_NAME_find(ent->snapshot, &name) >= 0)
+			name.suffix++;
+		return name.suffix - suffix;
+	}
+
+	name.suffix = 0;
+	if (sk_BY_DIR_NAME_find(ent->misses, &name) >= 0)
+		return 0;
+
+	return -1;
+}
+
+static int
+by_dir_entry_lookup(BY_DIR *ctx, BY_DIR_ENTRY *ent, int type,
+    unsigned long hash, int suffix, unsigned int *generation)
+{
+	time_t now;
+	int ret;
+
+	now = time(NULL);
+
+	CRYPTO_r_lock(CRYPTO_LOCK_X509_STORE);
+	if (by_dir_entry_fresh(ent, now)) {
+		ret = by_dir_entry_cached(ent, type, hash, suffix);
+		*generation = ent->generation;
+		CRYPTO_r_unlock(CRYPTO_LOCK_X509_STORE);
+		return ret;
+	}
+	CRYPTO_r_unlock(CRYPTO_LOCK_X509_STORE);
+
+	CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
+	by_dir_entry_check(ent, ctx->snapshot, now);
+	ret = by_dir_entry_cached(ent, type, hash, suffix);
+	*generation = ent->generation;
+	CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+
+	return ret;
+}
+
+/*
+ * Remember that the directory has nothing for hash, unless it has changed
+ * since it was searched. Called with the store locked for writing.
+ */
+static void
+by_dir_entry_add_miss(BY_DIR_ENTRY *ent, int type, unsigned long hash,
+    unsigned int generation)
+{
+	BY_DIR_NAME *name;
+
+	if (!ent->stable || ent->generation != generation)
+		return;
+	if (by_dir_entry_cached(ent, type, hash, 0) == 0)
+		return;
+
+	if (sk_BY_DIR_NAME_num(ent->misses) >= BY_DIR_MISSES_MAX)
+		by_dir_entry_clear_misses(ent);
+
+	/* This is only a cache, so failing to add to it is not an error. */
+	if ((name = malloc(sizeof(*name))) == NULL)
+		return;
+	name->hash = hash;
+	name->type = type;
+	name->suffix = 0;
+	if (SKM_sk_insert_sorted(BY_DIR_NAME, ent->misses, name) < 0)
+		free(name);
+}
+
 static int
 get_cert_by_subject(X509_LOOKUP *xl, int type, X509_NAME *name,
     X509_OBJECT *ret)
@@ -275,7 +572,8 @@ get_cert_by_subject(X509_LOOKUP *xl, int type, X509_NAME *name,
 		} crl;
 	} data;
 	int ok = 0;
-	int i, j, k;
+	int i, j, k, nfiles, failed;
+	unsigned int generation;
 	unsigned long h;
 	BUF_MEM *b = NULL;
 	X509_OBJECT stmp, *tmp;
@@ -335,34 +633,51 @@ get_cert_by_subject(X509_LOOKUP *xl, int type, X509_NAME *name,
 			k = 0;
 			hent = NULL;
 		}
+		nfiles = by_dir_entry_lookup(ctx, ent, type, h, k, &generation);
+		failed = 0;
 		for (;;) {
 			(void) snprintf(b->data, b->max, "%s/%08lx.%s%d",
 			    ent->dir, h, postfix, k);
 
-			{
+			if (nfiles < 0) {
 				struct stat st;
 				if (stat(b->data, &st) < 0)
 					break;
-			}
+			} else if (nfiles-- == 0)
+				break;
 			/* found one. */
 			if (type == X509_LU_X509) {
 				if ((X509_load_cert_file(xl, b->data,
-				    ent->dir_type)) == 0)
+				    ent->dir_type)) == 0) {
+					failed = 1;
 					break;
+				}
 			} else if (type == X509_LU_CRL) {
 				if ((X509_load_crl_file(xl, b->data,
-				    ent->dir_type)) == 0)
+				    ent->dir_type)) == 0) {
+					failed = 1;
 					break;
+				}
 			}
 			/* else case will caught higher up */
 			k++;
 		}
 
 		/* we have added it to the cache so now pull it out again */
-		CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
+		x509_store_objs_read_lock(xl->store_ctx);
 		j = sk_X509_OBJECT_find(xl->store_ctx->objs, &stmp);
 		tmp = sk_X509_OBJECT_value(xl->store_ctx->objs, j);
-		CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+		CRYPTO_r_unlock(CRYPTO_LOCK_X509_STORE);
+
+		/*
+		 * Chain building looks for many issuers that do not exist,
+		 * so avoid searching the directory for them every time.
+		 */
+		if (tmp == NULL && nfiles < 0 && !failed) {
+			CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
+			by_dir_entry_add_miss(ent, type, h, generation);
+			CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+		}
 
 		/* If a CRL, update the last file suffix added for this */
 		if (type == X509_LU_CRL) {
@@ -386,7 +701,12 @@ get_cert_by_subject(X509_LOOKUP *xl, int type, X509_NAME *name,
 				}
 				hent->hash = h;
 				hent->suffix = k;
-				if (!sk_BY_DIR_HASH_push(ent->hashes, hent)) {
+				/*
+				 * Keep the hashes sorted, since finding an entry
+				 * under a read lock must not sort the stack.
+				 */
+				if (SKM_sk_insert_sorted(BY_DIR_HASH, ent->hashes,
+				    hent) < 0) {
 					X509error(ERR_R_MALLOC_FAILURE);
 					CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
 					free(hent);
@@ -64,6 +64,26 @@ struct x509_verify_chain {
 	struct x509_constraints_names *names;	/* All names from all certs */
 };
 
+/*
+ * Index of a stack of certificates by subject name hash and by subject key
+ * identifier. Each bucket lists the positions of its certificates in stack
+ * order, linked through the entries, and ends with -1.
+ */
+struct x509_verify_index_entry {
+	unsigned long name_hash;	/* Hash of the subject name */
+	uint32_t skid_hash;		/* Hash of the subject key identifier */
+	int has_skid;
+	int next_name;			/* Next entry in the name bucket */
+	int next_skid;			/* Next entry in the skid bucket */
+};
+
+struct x509_verify_index {
+	struct x509_verify_index_entry *entries;
+	int *name_buckets;
+	int *skid_buckets;
+	size_t mask;			/* Number of buckets minus one */
+};
+
 struct x509_verify_ctx {
 	X509_STORE_CTX *xsc;
 	struct x509_verify_chain **chains;	/* Validated chains */
@@ -73,6 +93,8 @@ struct x509_verify_ctx {
 	size_t chains_count;
 	STACK_OF(X509) *roots;		/* Trusted roots for this validation */
 	STACK_OF(X509) *intermediates;	/* Intermediates provided by peer */
+	struct x509_verify_index *roots_index;
+	struct x509_verify_index *intermediates_index;
 	time_t *check_time;		/* Time for validity checks */
 	int purpose;			/* Cert purpose we are validating */
 	size_t max_chains;		/* Max chains to return */
@@ -88,6 +110,7 @@ int ASN1_time_tm_clamp_notafter(struct tm *tm);
 __BEGIN_HIDDEN_DECLS
 
 int x509_vfy_check_id(X509_STORE_CTX *ctx);
+int x509_vfy_check_issued(X509_STORE_CTX *ctx, X509 *subject, X509 *issuer);
 int x509_vfy_check_revocation(X509_STORE_CTX *ctx);
 int x509_vfy_check_policy(X509_STORE_CTX *ctx);
 int x509_vfy_check_trust(X509_STORE_CTX *ctx);
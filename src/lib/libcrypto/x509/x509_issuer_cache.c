@@ -29,6 +29,12 @@
  * validity of "child". It allows us to skip doing the public key math
  * when validating a certificate chain. It does not allow us to skip
  * any other steps of validation (times, names, key usage, etc.)
+ *
+ * The cache is split into shards by the first byte of the child hash,
+ * each with its own lock, so that verifications in different threads
+ * rarely contend. Lookups only take a read lock. Instead of moving
+ * entries on an LRU list, a lookup marks the entry as referenced and
+ * entries are evicted using the CLOCK algorithm.
  */
 
 #include <pthread.h>
@@ -36,6 +42,14 @@
 
 #include "x509_issuer_cache.h"
 
+struct x509_issuer_shard {
+	pthread_rwlock_t lock;
+	RB_HEAD(x509_issuer_tree, x509_issuer) tree;
+	TAILQ_HEAD(x509_issuer_ring, x509_issuer) ring;
+	struct x509_issuer *hand;	/* Next entry to consider evicting */
+	size_t count;
+};
+
 static int
 x509_issuer_cmp(struct x509_issuer *x1, struct x509_issuer *x2)
 {
@@ -45,53 +59,120 @@ x509_issuer_cmp(struct x509_issuer *x1, struct x509_issuer *x2)
 	return memcmp(x1->child_md, x2->child_md, EVP_MAX_MD_SIZE);
 }
 
-static size_t x509_issuer_cache_count;
 static size_t x509_issuer_cache_max = X509_ISSUER_CACHE_MAX;
-static RB_HEAD(x509_issuer_tree, x509_issuer) x509_issuer_cache =
-    RB_INITIALIZER(&x509_issuer_cache);
-static TAILQ_HEAD(lruqueue, x509_issuer) x509_issuer_lru =
-    TAILQ_HEAD_INITIALIZER(x509_issuer_lru);
-static pthread_mutex_t x509_issuer_tree_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct x509_issuer_shard x509_issuer_shards[X509_ISSUER_CACHE_SHARDS];
+static pthread_once_t x509_issuer_shards_once = PTHREAD_ONCE_INIT;
+static int x509_issuer_shards_ready;
 
 RB_PROTOTYPE(x509_issuer_tree, x509_issuer, entry, x509_issuer_cmp);
 RB_GENERATE(x509_issuer_tree, x509_issuer, entry, x509_issuer_cmp);
 
+static void
+x509_issuer_shards_init(void)
+{
+	struct x509_issuer_shard *shard;
+	size_t i;
+
+	for (i = 0; i < X509_ISSUER_CACHE_SHARDS; i++) {
+		shard = &x509_issuer_shards[i];
+		if (pthread_rwlock_init(&shard->lock, NULL) != 0)
+			return;
+		RB_INIT(&shard->tree);
+		TAILQ_INIT(&shard->ring);
+	}
+	x509_issuer_shards_ready = 1;
+}
+
+static int
+x509_issuer_shards_setup(void)
+{
+	if (pthread_once(&x509_issuer_shards_once,
+	    x509_issuer_shards_init) != 0)
+		return 0;
+
+	return x509_issuer_shards_ready;
+}
+
+/*
+ * Return the shard holding entries for child_md, or NULL if the shards
+ * could not be initialized.
+ */
+static struct x509_issuer_shard *
+x509_issuer_shard(unsigned char *child_md)
+{
+	if (!x509_issuer_shards_setup())
+		return NULL;
+
+	return &x509_issuer_shards[child_md[0] % X509_ISSUER_CACHE_SHARDS];
+}
+
+static size_t
+x509_issuer_shard_max(void)
+{
+	size_t max;
+
+	max = __atomic_load_n(&x509_issuer_cache_max, __ATOMIC_RELAXED);
+
+	return (max + X509_ISSUER_CACHE_SHARDS - 1) / X509_ISSUER_CACHE_SHARDS;
+}
+
 /*
  * Set the maximum number of cached entries. On additions to the cache
- * the least recently used entries will be discarded so that the cache
- * stays under the maximum number of entries.  Setting a maximum of 0
+ * entries that have not been used recently will be discarded so that the
+ * cache stays under the maximum number of entries.  Setting a maximum of 0
  * disables the cache.
  */
 int
 x509_issuer_cache_set_max(size_t max)
 {
-	if (pthread_mutex_lock(&x509_issuer_tree_mutex) != 0)
-		return 0;
-	x509_issuer_cache_max = max;
-	(void) pthread_mutex_unlock(&x509_issuer_tree_mutex);
+	__atomic_store_n(&x509_issuer_cache_max, max, __ATOMIC_RELAXED);
 
 	return 1;
 }
 
+static void
+x509_issuer_free(struct x509_issuer *issuer)
+{
+	free(issuer->parent_md);
+	free(issuer->child_md);
+	free(issuer);
+}
+
 /*
- * Free the oldest entry in the issuer cache. Returns 1
- * if an entry was successfully freed, 0 otherwise. Must
- * be called with x509_issuer_tree_mutex held.
+ * Remove an entry from a shard and free it. Must be called with the
+ * shard lock held for writing.
  */
-void
-x509_issuer_cache_free_oldest()
+static void
+x509_issuer_shard_remove(struct x509_issuer_shard *shard,
+    struct x509_issuer *old)
 {
-	struct x509_issuer *old;
+	if (shard->hand == old)
+		shard->hand = TAILQ_NEXT(old, queue);
+	TAILQ_REMOVE(&shard->ring, old, queue);
+	RB_REMOVE(x509_issuer_tree, &shard->tree, old);
+	x509_issuer_free(old);
+	shard->count--;
+}
 
-	if (x509_issuer_cache_count == 0)
+/*
+ * Free the first entry in the shard that the clock hand finds unreferenced,
+ * clearing the referenced flag of the entries it passes on the way. Must be
+ * called with the shard lock held for writing.
+ */
+static void
+x509_issuer_shard_evict(struct x509_issuer_shard *shard)
+{
+	if (shard->count == 0)
 		return;
-	old = TAILQ_LAST(&x509_issuer_lru, lruqueue);
-	TAILQ_REMOVE(&x509_issuer_lru, old, queue);
-	RB_REMOVE(x509_issuer_tree, &x509_issuer_cache, old);
-	free(old->parent_md);
-	free(old->child_md);
-	free(old);
-	x509_issuer_cache_count--;
+	for (;;) {
+		if (shard->hand == NULL)
+			shard->hand = TAILQ_FIRST(&shard->ring);
+		if (!shard->hand->referenced)
+			break;
+		shard->hand->referenced = 0;
+		shard->hand = TAILQ_NEXT(shard->hand, queue);
+	}
+	x509_issuer_shard_remove(shard, shard->hand);
 }
 
 /*
@@ -100,11 +181,21 @@ x509_issuer_cache_free_oldest()
 void
 x509_issuer_cache_free()
 {
-	if (pthread_mutex_lock(&x509_issuer_tree_mutex) != 0)
+	struct x509_issuer_shard *shard;
+	size_t i;
+
+	if (!x509_issuer_shards_setup())
 		return;
-	while (x509_issuer_cache_count > 0)
-		x509_issuer_cache_free_oldest();
-	(void) pthread_mutex_unlock(&x509_issuer_tree_mutex);
+
+	for (i = 0; i < X509_ISSUER_CACHE_SHARDS; i++) {
+		shard = &x509_issuer_shards[i];
+		if (pthread_rwlock_wrlock(&shard->lock) != 0)
+			continue;
+		while (shard->count > 0)
+			x509_issuer_shard_remove(shard,
+			    TAILQ_FIRST(&shard->ring));
+		(void) pthread_rwlock_unlock(&shard->lock);
+	}
 }
 
 /*
@@ -118,6 +209,7 @@ x509_issuer_cache_free()
 int
 x509_issuer_cache_find(unsigned char *parent_md, unsigned char *child_md)
 {
+	struct x509_issuer_shard *shard;
 	struct x509_issuer candidate, *found;
 	int ret = -1;
 
@@ -125,18 +217,21 @@ x509_issuer_cache_find(unsigned char *parent_md, unsigned char *child_md)
 	candidate.parent_md = parent_md;
 	candidate.child_md = child_md;
 
-	if (x509_issuer_cache_max == 0)
+	if (__atomic_load_n(&x509_issuer_cache_max, __ATOMIC_RELAXED) == 0)
 		return -1;
 
-	if (pthread_mutex_lock(&x509_issuer_tree_mutex) != 0)
+	if ((shard = x509_issuer_shard(child_md)) == NULL)
+		return -1;
+	if (pthread_rwlock_rdlock(&shard->lock) != 0)
 		return -1;
-	if ((found = RB_FIND(x509_issuer_tree, &x509_issuer_cache,
+	if ((found = RB_FIND(x509_issuer_tree, &shard->tree,
 	    &candidate)) != NULL) {
-		TAILQ_REMOVE(&x509_issuer_lru, found, queue);
-		TAILQ_INSERT_HEAD(&x509_issuer_lru, found, queue);
+		if (!__atomic_load_n(&found->referenced, __ATOMIC_RELAXED))
+			__atomic_store_n(&found->referenced, 1,
+			    __ATOMIC_RELAXED);
 		ret = found->valid;
 	}
-	(void) pthread_mutex_unlock(&x509_issuer_tree_mutex);
+	(void) pthread_rwlock_unlock(&shard->lock);
 
 	return ret;
 }
@@ -154,12 +249,16 @@ void
 x509_issuer_cache_add(unsigned char *parent_md, unsigned char *child_md,
     int valid)
 {
+	struct x509_issuer_shard *shard;
 	struct x509_issuer *new;
+	size_t max;
 
-	if (x509_issuer_cache_max == 0)
+	if ((max = x509_issuer_shard_max()) == 0)
 		return;
 	if (valid != 0 && valid != 1)
 		return;
+	if ((shard = x509_issuer_shard(child_md)) == NULL)
+		return;
 
 	if ((new = calloc(1, sizeof(struct x509_issuer))) == NULL)
 		return;
@@ -172,22 +271,24 @@ x509_issuer_cache_add(unsigned char *parent_md, unsigned char *child_md,
 
 	new->valid = valid;
 
-	if (pthread_mutex_lock(&x509_issuer_tree_mutex) != 0)
+	if (pthread_rwlock_wrlock(&shard->lock) != 0)
 		goto err;
-	while (x509_issuer_cache_count >= x509_issuer_cache_max)
-		x509_issuer_cache_free_oldest();
-	if (RB_INSERT(x509_issuer_tree, &x509_issuer_cache, new) == NULL) {
-		TAILQ_INSERT_HEAD(&x509_issuer_lru, new, queue);
-		x509_issuer_cache_count++;
+	if (RB_FIND(x509_issuer_tree, &shard->tree, new) == NULL) {
+		while (shard->count >= max)
+			x509_issuer_shard_evict(shard);
+		RB_INSERT(x509_issuer_tree, &shard->tree, new);
+		/* Insert just behind the hand, to be considered last. */
+		if (shard->hand != NULL)
+			TAILQ_INSERT_BEFORE(shard->hand, new, queue);
+		else
+			TAILQ_INSERT_TAIL(&shard->ring, new, queue);
+		shard->count++;
 		new = NULL;
 	}
-	(void) pthread_mutex_unlock(&x509_issuer_tree_mutex);
+	(void) pthread_rwlock_unlock(&shard->lock);
 
  err:
-	if (new != NULL) {
-		free(new->parent_md);
-		free(new->child_md);
-	}
-	free(new);
+	if (new != NULL)
+		x509_issuer_free(new);
 	return;
 }
@@ -28,14 +28,16 @@ __BEGIN_HIDDEN_DECLS
 
 struct x509_issuer {
 	RB_ENTRY(x509_issuer) entry;
-	TAILQ_ENTRY(x509_issuer) queue;	/* LRU of entries */
+	TAILQ_ENTRY(x509_issuer) queue;	/* CLOCK ring of entries */
 	/* parent_md and child_md must point to EVP_MAX_MD_SIZE of memory */
 	unsigned char *parent_md;
 	unsigned char *child_md;
 	int valid;			/* Result of signature validation. */
+	int referenced;			/* Used since the clock hand passed. */
 };
 
 #define X509_ISSUER_CACHE_MAX 40000	/* Approx 7.5 MB, entries 200 bytes */
+#define X509_ISSUER_CACHE_SHARDS 16	/* Selected by child digest prefix */
 
 int x509_issuer_cache_set_max(size_t max);
 int x509_issuer_cache_find(unsigned char *parent_md, unsigned char *child_md);
@@ -183,6 +183,8 @@ struct x509_st {
 	unsigned char hash[X509_CERT_HASH_LEN];
 	time_t not_before;
 	time_t not_after;
+	unsigned long issuer_name_hash;
+	unsigned long subject_name_hash;
 	X509_CERT_AUX *aux;
 } /* X509 */;
 
@@ -304,6 +306,10 @@ struct x509_store_st {
 	STACK_OF(X509_CRL) * (*lookup_crls)(X509_STORE_CTX *ctx, X509_NAME *nm);
 	int (*cleanup)(X509_STORE_CTX *ctx);
 
+	/* Cache of verification results, NULL unless enabled */
+	struct x509_verify_cache *verify_cache;
+	unsigned int generation;	/* Bumped whenever objs changes */
+
 	CRYPTO_EX_DATA ex_data;
 	int references;
 } /* X509_STORE */;
@@ -373,6 +379,8 @@ struct x509_store_ctx_st {
 
 int x509_check_cert_time(X509_STORE_CTX *ctx, X509 *x, int quiet);
 
+void x509_store_objs_read_lock(X509_STORE *store);
+
 int name_cmp(const char *name, const char *cmp);
 
 __END_HIDDEN_DECLS
@@ -63,7 +63,9 @@
 #include <openssl/lhash.h>
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
+#include "stack_local.h"
 #include "x509_local.h"
+#include "x509_verify_cache.h"
 
 X509_LOOKUP *
 X509_LOOKUP_new(X509_LOOKUP_METHOD *method)
@@ -278,6 +280,7 @@ X509_STORE_free(X509_STORE *store)
 
 	CRYPTO_free_ex_data(CRYPTO_EX_INDEX_X509_STORE, store, &store->ex_data);
 	X509_VERIFY_PARAM_free(store->param);
+	x509_verify_cache_free(store->verify_cache);
 	free(store);
 }
 LCRYPTO_ALIAS(X509_STORE_free);
@@ -335,6 +338,27 @@ X509_STORE_CTX_get_obj_by_subject(X509_STORE_CTX *vs, X509_LOOKUP_TYPE type,
 }
 LCRYPTO_ALIAS(X509_STORE_CTX_get_obj_by_subject);
 
+/*
+ * Take a read lock on the store objects. Looking up an object sorts the stack
+ * if it is not already sorted, so sort it under a write lock first. Objects
+ * are inserted in sorted order, so this is only needed if the stack has been
+ * modified through X509_STORE_get0_objects().
+ */
+void
+x509_store_objs_read_lock(X509_STORE *store)
+{
+	for (;;) {
+		CRYPTO_r_lock(CRYPTO_LOCK_X509_STORE);
+		if (sk_X509_OBJECT_is_sorted(store->objs))
+			return;
+		CRYPTO_r_unlock(CRYPTO_LOCK_X509_STORE);
+
+		CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
+		sk_X509_OBJECT_sort(store->objs);
+		CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+	}
+}
+
 int
 X509_STORE_CTX_get_by_subject(X509_STORE_CTX *vs, X509_LOOKUP_TYPE type,
     X509_NAME *name, X509_OBJECT *ret)
@@ -349,9 +373,9 @@ X509_STORE_CTX_get_by_subject(X509_STORE_CTX *vs, X509_LOOKUP_TYPE type,
 
 	memset(&stmp, 0, sizeof(stmp));
 
-	CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
+	x509_store_objs_read_lock(ctx);
 	tmp = X509_OBJECT_retrieve_by_subject(ctx->objs, type, name);
-	CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+	CRYPTO_r_unlock(CRYPTO_LOCK_X509_STORE);
 
 	if (tmp == NULL || type == X509_LU_CRL) {
 		for (i = 0; i < sk_X509_LOOKUP_num(ctx->get_cert_methods); i++) {
@@ -388,10 +412,11 @@ X509_STORE_add_object(X509_STORE *store, X509_OBJECT *obj)
 		goto out;
 	}
 
-	if (sk_X509_OBJECT_push(store->objs, obj) <= 0) {
+	if (SKM_sk_insert_sorted(X509_OBJECT, store->objs, obj) < 0) {
 		X509error(ERR_R_MALLOC_FAILURE);
 		goto out;
 	}
+	store->generation++;
 
 	obj = NULL;
 	ret = 1;
@@ -560,7 +585,7 @@ X509_get1_certs_from_cache(X509_STORE *store, X509_NAME *name)
 	X509_OBJECT *obj;
 	int i, idx, cnt;
 
-	CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
+	x509_store_objs_read_lock(store);
 
 	idx = x509_object_idx_cnt(store->objs, X509_LU_X509, name, &cnt);
 	if (idx < 0)
@@ -581,12 +606,12 @@ X509_get1_certs_from_cache(X509_STORE *store, X509_NAME *name)
 			goto err;
 	}
 
-	CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+	CRYPTO_r_unlock(CRYPTO_LOCK_X509_STORE);
 
 	return sk;
 
  err:
-	CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+	CRYPTO_r_unlock(CRYPTO_LOCK_X509_STORE);
 	sk_X509_pop_free(sk, X509_free);
 	X509_free(x);
 
@@ -636,7 +661,7 @@ X509_STORE_get1_crls(X509_STORE_CTX *ctx, X509_NAME *name)
 	X509_OBJECT_free(obj);
 	obj = NULL;
 
-	CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
+	x509_store_objs_read_lock(store);
 	idx = x509_object_idx_cnt(store->objs, X509_LU_CRL, name, &cnt);
 	if (idx < 0)
 		goto err;
@@ -656,11 +681,11 @@ X509_STORE_get1_crls(X509_STORE_CTX *ctx, X509_NAME *name)
 			goto err;
 	}
 
-	CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+	CRYPTO_r_unlock(CRYPTO_LOCK_X509_STORE);
 	return sk;
 
  err:
-	CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+	CRYPTO_r_unlock(CRYPTO_LOCK_X509_STORE);
 	X509_CRL_free(x);
 	sk_X509_CRL_pop_free(sk, X509_CRL_free);
 	return NULL;
@@ -748,7 +773,7 @@ X509_STORE_CTX_get1_issuer(X509 **out_issuer, X509_STORE_CTX *ctx, X509 *x)
 		return 0;
 
 	/* Else find index of first cert accepted by 'check_issued' */
-	CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
+	x509_store_objs_read_lock(ctx->store);
 	idx = X509_OBJECT_idx_by_subject(ctx->store->objs, X509_LU_X509, xn);
 	if (idx != -1) /* should be true as we've had at least one match */ {
 		/* Look through all matching certs for suitable issuer */
@@ -782,7 +807,7 @@ X509_STORE_CTX_get1_issuer(X509 **out_issuer, X509_STORE_CTX *ctx, X509 *x)
 			ret = 1;
 		}
 	}
-	CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+	CRYPTO_r_unlock(CRYPTO_LOCK_X509_STORE);
 	return ret;
 }
 LCRYPTO_ALIAS(X509_STORE_CTX_get1_issuer);
@@ -851,6 +876,26 @@ X509_STORE_get0_param(X509_STORE *ctx)
 }
 LCRYPTO_ALIAS(X509_STORE_get0_param);
 
+/*
+ * Cache up to max results of X509_verify_cert() with this store, replacing
+ * any previous cache. A maximum of 0 disables the cache.
+ */
+int
+X509_STORE_set_verify_cache(X509_STORE *store, size_t max)
+{
+	struct x509_verify_cache *cache = NULL;
+
+	if (max > 0 && (cache = x509_verify_cache_new(max)) == NULL) {
+		X509error(ERR_R_MALLOC_FAILURE);
+		return 0;
+	}
+	x509_verify_cache_free(store->verify_cache);
+	store->verify_cache = cache;
+
+	return 1;
+}
+LCRYPTO_ALIAS(X509_STORE_set_verify_cache);
+
 void
 X509_STORE_set_verify(X509_STORE *store, X509_STORE_CTX_verify_fn verify)
 {
@@ -91,6 +91,10 @@ x509_verify_cert_info_populate(X509 *cert)
 	 */
 	cert->not_before = x509_verify_asn1_time_to_time_t(X509_get_notBefore(cert), 0);
 	cert->not_after = x509_verify_asn1_time_to_time_t(X509_get_notAfter(cert), 1);
+
+	/* Save the name hashes used to index potential parents. */
+	cert->issuer_name_hash = X509_NAME_hash(X509_get_issuer_name(cert));
+	cert->subject_name_hash = X509_NAME_hash(X509_get_subject_name(cert));
 }
 
 struct x509_verify_chain *
@@ -229,11 +233,14 @@ x509_verify_ctx_reset(struct x509_verify_ctx *ctx)
 	ctx->check_time = NULL;
 }
 
+static void x509_verify_index_free(struct x509_verify_index *index);
+
 static void
 x509_verify_ctx_clear(struct x509_verify_ctx *ctx)
 {
 	x509_verify_ctx_reset(ctx);
 	sk_X509_pop_free(ctx->intermediates, X509_free);
+	x509_verify_index_free(ctx->intermediates_index);
 	free(ctx->chains);
 
 }
@@ -244,6 +251,191 @@ x509_verify_cert_cache_extensions(X509 *cert)
 	return x509v3_cache_extensions(cert);
 }
 
+static void
+x509_verify_index_free(struct x509_verify_index *index)
+{
+	if (index == NULL)
+		return;
+	free(index->entries);
+	free(index->name_buckets);
+	free(index->skid_buckets);
+	free(index);
+}
+
+static uint32_t
+x509_verify_index_skid_hash(const ASN1_OCTET_STRING *skid)
+{
+	uint32_t hash = 2166136261U;
+	int i;
+
+	/* FNV-1a */
+	for (i = 0; i < skid->length; i++) {
+		hash ^= skid->data[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static struct x509_verify_index *
+x509_verify_index_new(STACK_OF(X509) *certs)
+{
+	struct x509_verify_index *index;
+	struct x509_verify_index_entry *entry;
+	size_t i, num_buckets = 1;
+	X509 *cert;
+	int num, pos, bucket;
+
+	if ((num = sk_X509_num(certs)) <= 0)
+		return NULL;
+	while (num_buckets < (size_t)num)
+		num_buckets <<= 1;
+
+	if ((index = calloc(1, sizeof(*index))) == NULL)
+		goto err;
+	if ((index->entries = calloc(num, sizeof(*index->entries))) == NULL)
+		goto err;
+	if ((index->name_buckets = calloc(num_buckets,
+	    sizeof(*index->name_buckets))) == NULL)
+		goto err;
+	if ((index->skid_buckets = calloc(num_buckets,
+	    sizeof(*index->skid_buckets))) == NULL)
+		goto err;
+	index->mask = num_buckets - 1;
+
+	for (i = 0; i < num_buckets; i++) {
+		index->name_buckets[i] = -1;
+		index->skid_buckets[i] = -1;
+	}
+
+	/* Insert backwards, so that the buckets list certs in stack order. */
+	for (pos = num - 1; pos >= 0; pos--) {
+		cert = sk_X509_value(certs, pos);
+		entry = &index->entries[pos];
+		entry->next_name = -1;
+		entry->next_skid = -1;
+
+		/* A cert whose extensions cannot be cached is never a parent. */
+		if (!x509_verify_cert_cache_extensions(cert))
+			continue;
+
+		entry->name_hash = cert->subject_name_hash;
+		bucket = entry->name_hash & index->mask;
+		entry->next_name = index->name_buckets[bucket];
+		index->name_buckets[bucket] = pos;
+
+		if (cert->skid != NULL) {
+			entry->has_skid = 1;
+			entry->skid_hash = x509_verify_index_skid_hash(cert->skid);
+			bucket = entry->skid_hash & index->mask;
+			entry->next_skid = index->skid_buckets[bucket];
+			index->skid_buckets[bucket] = pos;
+		}
+	}
+
+	return index;
+
+ err:
+	x509_verify_index_free(index);
+	return NULL;
+}
+
+/*
+ * Return the position after prev of the next indexed cert with a subject
+ * name hash of name_hash, or -1 if there is none. If keyid is not NULL,
+ * certs with a subject key identifier must also match keyid, as required
+ * by X509_check_akid(). Positions are returned in stack order, which is
+ * the order in which a scan of the stack would find them.
+ */
+static int
+x509_verify_index_next(struct x509_verify_index *index,
+    unsigned long name_hash, const ASN1_OCTET_STRING *keyid, int prev)
+{
+	struct x509_verify_index_entry *entry;
+	uint32_t skid_hash;
+	int pos, next = -1;
+
+	if (keyid != NULL) {
+		skid_hash = x509_verify_index_skid_hash(keyid);
+		pos = index->skid_buckets[skid_hash & index->mask];
+		for (; pos != -1; pos = entry->next_skid) {
+			entry = &index->entries[pos];
+			if (pos > prev && entry->skid_hash == skid_hash &&
+			    entry->name_hash == name_hash) {
+				next = pos;
+				break;
+			}
+		}
+	}
+
+	pos = index->name_buckets[name_hash & index->mask];
+	for (; pos != -1 && (next == -1 || pos < next); pos = entry->next_name) {
+		entry = &index->entries[pos];
+		if (pos <= prev || entry->name_hash != name_hash)
+			continue;
+		if (keyid != NULL && entry->has_skid)
+			continue;
+		next = pos;
+		break;
+	}
+
+	return next;
+}
+
+/*
+ * Return the position after prev of the next cert in certs that may have
+ * issued child, using index if there is one.
+ */
+static int
+x509_verify_next_parent(STACK_OF(X509) *certs,
+    struct x509_verify_index *index, X509 *child, int prev)
+{
+	const ASN1_OCTET_STRING *keyid = NULL;
+
+	if (index == NULL) {
+		if (++prev >= sk_X509_num(certs))
+			return -1;
+		return prev;
+	}
+
+	if (!x509_verify_cert_cache_extensions(child))
+		return -1;
+	if (child->akid != NULL)
+		keyid = child->akid->keyid;
+
+	return x509_verify_index_next(index, child->issuer_name_hash, keyid,
+	    prev);
+}
+
+/* Stacks with fewer certs than this are scanned rather than indexed. */
+#define X509_VERIFY_INDEX_MIN	8
+
+/*
+ * Index the roots and intermediates by subject, unless a legacy
+ * check_issued callback may accept parents with a different name.
+ */
+static int
+x509_verify_ctx_index(struct x509_verify_ctx *ctx)
+{
+	if (ctx->xsc != NULL &&
+	    ctx->xsc->check_issued != x509_vfy_check_issued)
+		return 1;
+
+	if (ctx->roots_index == NULL &&
+	    sk_X509_num(ctx->roots) >= X509_VERIFY_INDEX_MIN) {
+		if ((ctx->roots_index = x509_verify_index_new(ctx->roots)) ==
+		    NULL)
+			return 0;
+	}
+	if (ctx->intermediates_index == NULL &&
+	    sk_X509_num(ctx->intermediates) >= X509_VERIFY_INDEX_MIN) {
+		if ((ctx->intermediates_index =
+		    x509_verify_index_new(ctx->intermediates)) == NULL)
+			return 0;
+	}
+
+	return 1;
+}
+
 static int
 x509_verify_cert_self_signed(X509 *cert)
 {
@@ -277,6 +469,15 @@ x509_verify_ctx_cert_is_root(struct x509_verify_ctx *ctx, X509 *cert,
 			return x509_verify_check_chain_end(cert, full_chain);
 
 		}
+	} else if (ctx->roots_index != NULL) {
+		/* Check the provided roots with the same subject */
+		i = -1;
+		while ((i = x509_verify_index_next(ctx->roots_index,
+		    cert->subject_name_hash, NULL, i)) != -1) {
+			if (X509_cmp(sk_X509_value(ctx->roots, i), cert) == 0)
+				return x509_verify_check_chain_end(cert,
+				    full_chain);
+		}
 	} else {
 		/* Check the provided roots */
 		for (i = 0; i < sk_X509_num(ctx->roots); i++) {
@@ -528,7 +729,7 @@ x509_verify_potential_parent(struct x509_verify_ctx *ctx, X509 *parent,
 		return (ctx->xsc->check_issued(ctx->xsc, child, parent));
 
 	/* XXX key usage */
-	return X509_check_issued(child, parent) != X509_V_OK;
+	return X509_check_issued(parent, child) == X509_V_OK;
 }
 
 static int
@@ -709,7 +910,9 @@ x509_verify_build_chains(struct x509_verify_ctx *ctx, X509 *cert,
 		}
 	} else {
 		/* Check to see if we have a trusted root issuer. */
-		for (i = 0; i < sk_X509_num(ctx->roots); i++) {
+		i = -1;
+		while ((i = x509_verify_next_parent(ctx->roots,
+		    ctx->roots_index, cert, i)) != -1) {
 			candidate = sk_X509_value(ctx->roots, i);
 			if (x509_verify_potential_parent(ctx, candidate, cert)) {
 				is_root = x509_verify_check_chain_end(candidate,
@@ -723,7 +926,9 @@ x509_verify_build_chains(struct x509_verify_ctx *ctx, X509 *cert,
 
 	/* Check intermediates after checking roots */
 	if (ctx->intermediates != NULL) {
-		for (i = 0; i < sk_X509_num(ctx->intermediates); i++) {
+		i = -1;
+		while ((i = x509_verify_next_parent(ctx->intermediates,
+		    ctx->intermediates_index, cert, i)) != -1) {
 			candidate = sk_X509_value(ctx->intermediates, i);
 			if (x509_verify_potential_parent(ctx, candidate, cert)) {
 				x509_verify_consider_candidate(ctx, cert,
@@ -1025,6 +1230,7 @@ x509_verify_ctx_free(struct x509_verify_ctx *ctx)
 	if (ctx == NULL)
 		return;
 	sk_X509_pop_free(ctx->roots, X509_free);
+	x509_verify_index_free(ctx->roots_index);
 	x509_verify_ctx_clear(ctx);
 	free(ctx);
 }
@@ -1069,6 +1275,8 @@ int
 x509_verify_ctx_set_intermediates(struct x509_verify_ctx *ctx,
     STACK_OF(X509) *intermediates)
 {
+	x509_verify_index_free(ctx->intermediates_index);
+	ctx->intermediates_index = NULL;
 	if ((ctx->intermediates = X509_chain_up_ref(intermediates)) == NULL)
 		return 0;
 	return 1;
@@ -1105,6 +1313,11 @@ x509_verify(struct x509_verify_ctx *ctx, X509 *leaf, char *name)
 		goto err;
 	}
 
+	if (!x509_verify_ctx_index(ctx)) {
+		ctx->error = X509_V_ERR_OUT_OF_MEM;
+		goto err;
+	}
+
 	if (ctx->xsc != NULL) {
 		if (leaf != NULL || name != NULL) {
 			ctx->error = X509_V_ERR_INVALID_CALL;
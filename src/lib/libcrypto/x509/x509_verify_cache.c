@@ -0,0 +1,442 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* x509_verify_cache */
+
+/*
+ * The verify cache is a per X509_STORE cache of complete results of
+ * X509_verify_cert().
+ *
+ * Entries are keyed by a digest of the certificate being verified, the
+ * untrusted certificates and CRLs passed in and the verification
+ * parameters. Each entry holds the result, the error and the verified
+ * chain, along with the store generation it was computed against. Any
+ * object added to the store bumps the generation, which invalidates all
+ * previous results. Successful results expire when the first certificate
+ * in the chain expires. Failures, and results that depend on CRLs that
+ * may be found outside the store, are recomputed after a short time.
+ *
+ * The cache is split into shards by the first byte of the digest, each
+ * with its own lock, tree and LRU.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/objects.h>
+#include <openssl/sha.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+#include "vpm_int.h"
+#include "x509_internal.h"
+#include "x509_verify_cache.h"
+
+static int
+x509_verify_cache_cmp(struct x509_verify_cache_entry *e1,
+    struct x509_verify_cache_entry *e2)
+{
+	return memcmp(e1->md, e2->md, X509_VERIFY_CACHE_MD_LEN);
+}
+
+RB_PROTOTYPE_STATIC(x509_verify_cache_tree, x509_verify_cache_entry, entry,
+    x509_verify_cache_cmp);
+RB_GENERATE_STATIC(x509_verify_cache_tree, x509_verify_cache_entry, entry,
+    x509_verify_cache_cmp);
+
+static void
+x509_verify_cache_entry_free(struct x509_verify_cache_entry *entry)
+{
+	if (entry == NULL)
+		return;
+
+	sk_X509_pop_free(entry->chain, X509_free);
+	free(entry->peername);
+	free(entry);
+}
+
+/*
+ * Create a cache holding up to max results. Returns NULL on failure.
+ */
+struct x509_verify_cache *
+x509_verify_cache_new(size_t max)
+{
+	struct x509_verify_cache *cache;
+	struct x509_verify_cache_shard *shard;
+	size_t i;
+
+	if (max == 0)
+		return NULL;
+
+	if ((cache = calloc(1, sizeof(*cache))) == NULL)
+		return NULL;
+
+	for (i = 0; i < X509_VERIFY_CACHE_SHARDS; i++) {
+		shard = &cache->shards[i];
+		if (pthread_mutex_init(&shard->mutex, NULL) != 0) {
+			while (i-- > 0)
+				pthread_mutex_destroy(&cache->shards[i].mutex);
+			free(cache);
+			return NULL;
+		}
+		RB_INIT(&shard->tree);
+		TAILQ_INIT(&shard->lru);
+	}
+	cache->shard_max = (max + X509_VERIFY_CACHE_SHARDS - 1) /
+	    X509_VERIFY_CACHE_SHARDS;
+
+	return cache;
+}
+
+/*
+ * Remove an entry from its shard and free it. Must be called with the
+ * shard mutex held.
+ */
+static void
+x509_verify_cache_remove(struct x509_verify_cache_shard *shard,
+    struct x509_verify_cache_entry *entry)
+{
+	TAILQ_REMOVE(&shard->lru, entry, queue);
+	RB_REMOVE(x509_verify_cache_tree, &shard->tree, entry);
+	x509_verify_cache_entry_free(entry);
+	shard->count--;
+}
+
+void
+x509_verify_cache_free(struct x509_verify_cache *cache)
+{
+	struct x509_verify_cache_shard *shard;
+	size_t i;
+
+	if (cache == NULL)
+		return;
+
+	for (i = 0; i < X509_VERIFY_CACHE_SHARDS; i++) {
+		shard = &cache->shards[i];
+		while (shard->count > 0)
+			x509_verify_cache_remove(shard,
+			    TAILQ_LAST(&shard->lru, x509_verify_cache_lru));
+		pthread_mutex_destroy(&shard->mutex);
+	}
+	free(cache);
+}
+
+static void
+x509_verify_cache_md_bytes(SHA256_CTX *sha, const void *data, size_t len)
+{
+	uint64_t n = len;
+
+	SHA256_Update(sha, &n, sizeof(n));
+	if (len > 0)
+		SHA256_Update(sha, data, len);
+}
+
+static void
+x509_verify_cache_md_int(SHA256_CTX *sha, int64_t value)
+{
+	SHA256_Update(sha, &value, sizeof(value));
+}
+
+/*
+ * Compute the cache key for the verification that ctx is set up for.
+ * Returns 0 if the verification can not be cached.
+ */
+int
+x509_verify_cache_md(X509_STORE_CTX *ctx,
+    unsigned char md[X509_VERIFY_CACHE_MD_LEN])
+{
+	X509_VERIFY_PARAM *param = ctx->param;
+	X509_VERIFY_PARAM_ID *id = param->id;
+	unsigned char crl_md[X509_CRL_HASH_LEN];
+	SHA256_CTX sha;
+	X509 *x;
+	X509_CRL *crl;
+	ASN1_OBJECT *obj;
+	const char *host;
+	int i, num;
+
+	SHA256_Init(&sha);
+
+	if (!x509v3_cache_extensions(ctx->cert))
+		return 0;
+	x509_verify_cache_md_bytes(&sha, ctx->cert->hash, X509_CERT_HASH_LEN);
+
+	num = sk_X509_num(ctx->untrusted);
+	x509_verify_cache_md_int(&sha, num);
+	for (i = 0; i < num; i++) {
+		x = sk_X509_value(ctx->untrusted, i);
+		if (!x509v3_cache_extensions(x))
+			return 0;
+		x509_verify_cache_md_bytes(&sha, x->hash, X509_CERT_HASH_LEN);
+	}
+
+	/*
+	 * The hash cached in a CRL is only set when it is decoded, so digest
+	 * CRLs that were built in memory or modified since just the same.
+	 */
+	num = sk_X509_CRL_num(ctx->crls);
+	x509_verify_cache_md_int(&sha, num);
+	for (i = 0; i < num; i++) {
+		crl = sk_X509_CRL_value(ctx->crls, i);
+		if (!X509_CRL_digest(crl, X509_CRL_HASH_EVP, crl_md, NULL))
+			return 0;
+		x509_verify_cache_md_bytes(&sha, crl_md, X509_CRL_HASH_LEN);
+	}
+
+	x509_verify_cache_md_int(&sha, param->flags);
+	x509_verify_cache_md_int(&sha, param->purpose);
+	x509_verify_cache_md_int(&sha, param->trust);
+	x509_verify_cache_md_int(&sha, param->depth);
+	x509_verify_cache_md_int(&sha, param->security_level);
+	if ((param->flags & X509_V_FLAG_USE_CHECK_TIME) != 0)
+		x509_verify_cache_md_int(&sha, param->check_time);
+
+	num = sk_ASN1_OBJECT_num(param->policies);
+	x509_verify_cache_md_int(&sha, num);
+	for (i = 0; i < num; i++) {
+		obj = sk_ASN1_OBJECT_value(param->policies, i);
+		x509_verify_cache_md_bytes(&sha, OBJ_get0_data(obj),
+		    OBJ_length(obj));
+	}
+
+	num = sk_OPENSSL_STRING_num(id->hosts);
+	x509_verify_cache_md_int(&sha, num);
+	for (i = 0; i < num; i++) {
+		host = sk_OPENSSL_STRING_value(id->hosts, i);
+		x509_verify_cache_md_bytes(&sha, host, strlen(host));
+	}
+	x509_verify_cache_md_int(&sha, id->hostflags);
+	x509_verify_cache_md_bytes(&sha, id->email, id->emaillen);
+	x509_verify_cache_md_bytes(&sha, id->ip, id->iplen);
+
+	SHA256_Final(md, &sha);
+
+	return 1;
+}
+
+/*
+ * Replace certificates in chain with the equal ones passed in by the
+ * caller, so that a cached chain refers to the caller's leaf and
+ * untrusted certificates just like a freshly built one.
+ */
+static void
+x509_verify_cache_chain_fixup(X509_STORE_CTX *ctx, STACK_OF(X509) *chain)
+{
+	X509 *x, *match;
+	int i, j;
+
+	for (i = 0; i < sk_X509_num(chain); i++) {
+		x = sk_X509_value(chain, i);
+		match = NULL;
+		if (memcmp(x->hash, ctx->cert->hash, X509_CERT_HASH_LEN) == 0)
+			match = ctx->cert;
+		for (j = 0; match == NULL && j < sk_X509_num(ctx->untrusted);
+		    j++) {
+			match = sk_X509_value(ctx->untrusted, j);
+			if (memcmp(x->hash, match->hash,
+			    X509_CERT_HASH_LEN) != 0)
+				match = NULL;
+		}
+		if (match == NULL || match == x)
+			continue;
+		if (!X509_up_ref(match))
+			continue;
+		(void)sk_X509_set(chain, i, match);
+		X509_free(x);
+	}
+}
+
+/*
+ * Look up a previous result of verifying the chain and parameters with
+ * digest md against a store of the given generation. If one is found,
+ * the verified chain, the error and the error depth are restored in ctx.
+ *
+ * Returns:
+ *	-1 : No usable entry exists in the cache. The chain must be verified.
+ *	0 : The chain failed to verify.
+ *	1 : The chain was successfully verified.
+ */
+int
+x509_verify_cache_find(struct x509_verify_cache *cache,
+    const unsigned char *md, unsigned int generation, X509_STORE_CTX *ctx)
+{
+	struct x509_verify_cache_shard *shard;
+	struct x509_verify_cache_entry candidate, *found, result;
+	STACK_OF(X509) *chain = NULL;
+	char *peername = NULL;
+	time_t now;
+	int ret = -1;
+
+	shard = &cache->shards[md[0] % X509_VERIFY_CACHE_SHARDS];
+
+	memset(&candidate, 0, sizeof(candidate));
+	memcpy(candidate.md, md, X509_VERIFY_CACHE_MD_LEN);
+
+	now = time(NULL);
+
+	if (pthread_mutex_lock(&shard->mutex) != 0)
+		return -1;
+	if ((found = RB_FIND(x509_verify_cache_tree, &shard->tree,
+	    &candidate)) == NULL)
+		goto done;
+	if (found->generation != generation ||
+	    (found->expires != 0 && now > found->expires)) {
+		x509_verify_cache_remove(shard, found);
+		goto done;
+	}
+	if (found->chain != NULL &&
+	    (chain = X509_chain_up_ref(found->chain)) == NULL)
+		goto done;
+	if (found->peername != NULL &&
+	    (peername = strdup(found->peername)) == NULL)
+		goto done;
+	TAILQ_REMOVE(&shard->lru, found, queue);
+	TAILQ_INSERT_HEAD(&shard->lru, found, queue);
+	result = *found;
+	ret = found->ret;
+ done:
+	(void)pthread_mutex_unlock(&shard->mutex);
+
+	if (ret == -1) {
+		sk_X509_pop_free(chain, X509_free);
+		free(peername);
+		return -1;
+	}
+
+	x509_verify_cache_chain_fixup(ctx, chain);
+
+	sk_X509_pop_free(ctx->chain, X509_free);
+	ctx->chain = chain;
+	ctx->num_untrusted = result.num_untrusted;
+	ctx->explicit_policy = result.explicit_policy;
+	ctx->error = result.error;
+	ctx->error_depth = result.error_depth;
+	if (result.current_depth >= 0)
+		ctx->current_cert = sk_X509_value(chain, result.current_depth);
+	else if (result.current_depth == -2)
+		ctx->current_cert = ctx->cert;
+	else
+		ctx->current_cert = NULL;
+
+	if (peername != NULL) {
+		free(ctx->param->id->peername);
+		ctx->param->id->peername = peername;
+	}
+
+	return ret;
+}
+
+/*
+ * Attempt to add the result of verifying the chain and parameters with
+ * digest md against a store of the given generation to the cache. The
+ * result is taken from ctx after verification.
+ *
+ * ret must be:
+ *	0: The chain failed to verify.
+ *	1: The chain was successfully verified.
+ *
+ * A previously added entry for the same digest is replaced.
+ */
+void
+x509_verify_cache_add(struct x509_verify_cache *cache,
+    const unsigned char *md, unsigned int generation, X509_STORE_CTX *ctx,
+    int ret)
+{
+	struct x509_verify_cache_shard *shard;
+	struct x509_verify_cache_entry *new, *old;
+	unsigned long flags = ctx->param->flags;
+	time_t now;
+	X509 *x;
+	int current_depth = -1;
+	int i;
+
+	if (ret != 0 && ret != 1)
+		return;
+	if (ctx->error == X509_V_ERR_OUT_OF_MEM)
+		return;
+
+	/*
+	 * The current certificate must be restorable from the chain or the
+	 * ctx, since nothing else is kept alive with the result.
+	 */
+	if (ctx->current_cert != NULL) {
+		current_depth = -2;
+		for (i = 0; i < sk_X509_num(ctx->chain); i++) {
+			if (sk_X509_value(ctx->chain, i) == ctx->current_cert) {
+				current_depth = i;
+				break;
+			}
+		}
+		if (current_depth == -2 && ctx->current_cert != ctx->cert)
+			return;
+	}
+
+	if ((new = calloc(1, sizeof(*new))) == NULL)
+		return;
+
+	memcpy(new->md, md, X509_VERIFY_CACHE_MD_LEN);
+	new->generation = generation;
+	new->ret = ret;
+	new->error = ctx->error;
+	new->error_depth = ctx->error_depth;
+	new->current_depth = current_depth;
+	new->num_untrusted = ctx->num_untrusted;
+	new->explicit_policy = ctx->explicit_policy;
+
+	now = time(NULL);
+	if (ret == 1 && (flags & X509_V_FLAG_USE_CHECK_TIME) == 0) {
+		for (i = 0; i < sk_X509_num(ctx->chain); i++) {
+			x = sk_X509_value(ctx->chain, i);
+			if (x->not_after == -1)
+				goto err;
+			if (new->expires == 0 || x->not_after < new->expires)
+				new->expires = x->not_after;
+		}
+	}
+	if (ret == 0 || (flags & X509_V_FLAG_CRL_CHECK) != 0) {
+		if (new->expires == 0 ||
+		    now + X509_VERIFY_CACHE_TTL < new->expires)
+			new->expires = now + X509_VERIFY_CACHE_TTL;
+	}
+
+	if (ctx->chain != NULL &&
+	    (new->chain = X509_chain_up_ref(ctx->chain)) == NULL)
+		goto err;
+	if (ctx->param->id->peername != NULL &&
+	    (new->peername = strdup(ctx->param->id->peername)) == NULL)
+		goto err;
+
+	shard = &cache->shards[md[0] % X509_VERIFY_CACHE_SHARDS];
+
+	if (pthread_mutex_lock(&shard->mutex) != 0)
+		goto err;
+	if ((old = RB_FIND(x509_verify_cache_tree, &shard->tree, new)) != NULL)
+		x509_verify_cache_remove(shard, old);
+	while (shard->count >= cache->shard_max)
+		x509_verify_cache_remove(shard,
+		    TAILQ_LAST(&shard->lru, x509_verify_cache_lru));
+	RB_INSERT(x509_verify_cache_tree, &shard->tree, new);
+	TAILQ_INSERT_HEAD(&shard->lru, new, queue);
+	shard->count++;
+	new = NULL;
+	(void)pthread_mutex_unlock(&shard->mutex);
+
+ err:
+	x509_verify_cache_entry_free(new);
+}
@@ -0,0 +1,83 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* x509_verify_cache */
+#ifndef HEADER_X509_VERIFY_CACHE_H
+#define HEADER_X509_VERIFY_CACHE_H
+
+#include <sys/tree.h>
+#include <sys/queue.h>
+
+#include <pthread.h>
+#include <time.h>
+
+#include <openssl/sha.h>
+#include <openssl/x509.h>
+
+__BEGIN_HIDDEN_DECLS
+
+#define X509_VERIFY_CACHE_MD_LEN	SHA256_DIGEST_LENGTH
+
+struct x509_verify_cache_entry {
+	RB_ENTRY(x509_verify_cache_entry) entry;
+	TAILQ_ENTRY(x509_verify_cache_entry) queue;	/* LRU of entries */
+	unsigned char md[X509_VERIFY_CACHE_MD_LEN];	/* Chain and params */
+	unsigned int generation;	/* Store generation of the result */
+	time_t expires;			/* Result must be recomputed after */
+	int ret;			/* Result of X509_verify_cert() */
+	int error;
+	int error_depth;
+	int current_depth;		/* Position of current_cert */
+	int num_untrusted;
+	int explicit_policy;
+	STACK_OF(X509) *chain;		/* Verified chain, may be NULL */
+	char *peername;			/* Matched host name, may be NULL */
+};
+
+RB_HEAD(x509_verify_cache_tree, x509_verify_cache_entry);
+TAILQ_HEAD(x509_verify_cache_lru, x509_verify_cache_entry);
+
+struct x509_verify_cache_shard {
+	pthread_mutex_t mutex;
+	struct x509_verify_cache_tree tree;
+	struct x509_verify_cache_lru lru;
+	size_t count;
+};
+
+#define X509_VERIFY_CACHE_SHARDS	16
+
+/* Seconds before failures and CRL checked results are recomputed. */
+#define X509_VERIFY_CACHE_TTL		60
+
+struct x509_verify_cache {
+	struct x509_verify_cache_shard shards[X509_VERIFY_CACHE_SHARDS];
+	size_t shard_max;		/* Maximum entries in each shard */
+};
+
+struct x509_verify_cache *x509_verify_cache_new(size_t max);
+void x509_verify_cache_free(struct x509_verify_cache *cache);
+int x509_verify_cache_md(X509_STORE_CTX *ctx,
+    unsigned char md[X509_VERIFY_CACHE_MD_LEN]);
+int x509_verify_cache_find(struct x509_verify_cache *cache,
+    const unsigned char *md, unsigned int generation, X509_STORE_CTX *ctx);
+void x509_verify_cache_add(struct x509_verify_cache *cache,
+    const unsigned char *md, unsigned int generation, X509_STORE_CTX *ctx,
+    int ret);
+
+__END_HIDDEN_DECLS
+
+#endif
@@ -76,6 +76,7 @@
 #include "asn1_local.h"
 #include "vpm_int.h"
 #include "x509_internal.h"
+#include "x509_verify_cache.h"
 
 /* CRL score values */
 
@@ -116,7 +117,6 @@
 #define CRL_SCORE_TIME_DELTA	0x002
 
 static int null_callback(int ok, X509_STORE_CTX *e);
-static int check_issued(X509_STORE_CTX *ctx, X509 *subject, X509 *issuer);
 static X509 *find_issuer(X509_STORE_CTX *ctx, STACK_OF(X509) *sk, X509 *x,
     int allow_expired);
 static int check_chain_extensions(X509_STORE_CTX *ctx);
@@ -125,6 +125,8 @@ static int check_trust(X509_STORE_CTX *ctx);
 static int check_revocation(X509_STORE_CTX *ctx);
 static int check_cert(X509_STORE_CTX *ctx, STACK_OF(X509) *chain, int depth);
 static int check_policy(X509_STORE_CTX *ctx);
+static int check_crl(X509_STORE_CTX *ctx, X509_CRL *crl);
+static int cert_crl(X509_STORE_CTX *ctx, X509_CRL *crl, X509 *x);
 
 static int get_crl_score(X509_STORE_CTX *ctx, X509 **pissuer,
     unsigned int *preasons, X509_CRL *crl, X509 *x);
@@ -596,13 +598,81 @@ X509_verify_cert_legacy(X509_STORE_CTX *ctx)
 	return ok;
 }
 
-int
-X509_verify_cert(X509_STORE_CTX *ctx)
+static int
+verify_cert(X509_STORE_CTX *ctx)
 {
 	STACK_OF(X509) *roots = NULL;
 	struct x509_verify_ctx *vctx = NULL;
 	int chain_count = 0;
 
+	/*
+	 * If the certificate's public key is too weak, don't bother
+	 * continuing.
+	 */
+	if (!check_key_level(ctx, ctx->cert) &&
+	    !verify_cb_cert(ctx, ctx->cert, 0, X509_V_ERR_EE_KEY_TOO_SMALL))
+		return 0;
+
+	/*
+	 * If flags request legacy, use the legacy verifier. If we
+	 * requested "no alt chains" from the age of hammer pants, use
+	 * the legacy verifier because the multi chain verifier really
+	 * does find all the "alt chains".
+	 *
+	 * XXX deprecate the NO_ALT_CHAINS flag?
+	 */
+	if ((ctx->param->flags & X509_V_FLAG_LEGACY_VERIFY) ||
+	    (ctx->param->flags & X509_V_FLAG_NO_ALT_CHAINS))
+		return X509_verify_cert_legacy(ctx);
+
+	/* Use the modern multi-chain verifier from x509_verify_cert */
+
+	if ((vctx = x509_verify_ctx_new_from_xsc(ctx)) != NULL) {
+		ctx->error = X509_V_OK; /* Initialize to OK */
+		chain_count = x509_verify(vctx, NULL, NULL);
+	}
+	x509_verify_ctx_free(vctx);
+
+	sk_X509_pop_free(roots, X509_free);
+
+	/* if we succeed we have a chain in ctx->chain */
+	return (chain_count > 0 && ctx->chain != NULL);
+}
+
+/*
+ * The result of a verification can only be cached if it is determined by
+ * the certificates, the parameters and the store alone. This is not the
+ * case if any callback has been replaced, or for CRL path validation.
+ */
+static int
+verify_cache_eligible(X509_STORE_CTX *ctx)
+{
+	if (ctx->store == NULL || ctx->store->verify_cache == NULL)
+		return 0;
+	if (ctx->other_ctx != NULL || ctx->parent != NULL)
+		return 0;
+
+	return ctx->verify == internal_verify &&
+	    ctx->verify_cb == null_callback &&
+	    ctx->get_issuer == X509_STORE_CTX_get1_issuer &&
+	    ctx->check_issued == x509_vfy_check_issued &&
+	    ctx->check_revocation == check_revocation &&
+	    ctx->get_crl == NULL &&
+	    ctx->check_crl == check_crl &&
+	    ctx->cert_crl == cert_crl &&
+	    ctx->check_policy == check_policy &&
+	    ctx->lookup_certs == X509_STORE_get1_certs &&
+	    ctx->lookup_crls == X509_STORE_get1_crls;
+}
+
+int
+X509_verify_cert(X509_STORE_CTX *ctx)
+{
+	struct x509_verify_cache *cache;
+	unsigned char md[X509_VERIFY_CACHE_MD_LEN];
+	unsigned int generation;
+	int ret;
+
 	if (ctx->cert == NULL) {
 		X509error(X509_R_NO_CERT_SET_FOR_US_TO_VERIFY);
 		ctx->error = X509_V_ERR_INVALID_CALL;
@@ -635,38 +705,25 @@ X509_verify_cert(X509_STORE_CTX *ctx)
 		return -1;
 	}
 
-	/*
-	 * If the certificate's public key is too weak, don't bother
-	 * continuing.
-	 */
-	if (!check_key_level(ctx, ctx->cert) &&
-	    !verify_cb_cert(ctx, ctx->cert, 0, X509_V_ERR_EE_KEY_TOO_SMALL))
-		return 0;
+	if (!verify_cache_eligible(ctx) || !x509_verify_cache_md(ctx, md))
+		return verify_cert(ctx);
 
 	/*
-	 * If flags request legacy, use the legacy verifier. If we
-	 * requested "no alt chains" from the age of hammer pants, use
-	 * the legacy verifier because the multi chain verifier really
-	 * does find all the "alt chains".
-	 *
-	 * XXX deprecate the NO_ALT_CHAINS flag?
+	 * Take the store generation before verifying, so that a result is
+	 * never cached against objects added while it was computed.
 	 */
-	if ((ctx->param->flags & X509_V_FLAG_LEGACY_VERIFY) ||
-	    (ctx->param->flags & X509_V_FLAG_NO_ALT_CHAINS))
-		return X509_verify_cert_legacy(ctx);
+	cache = ctx->store->verify_cache;
+	CRYPTO_r_lock(CRYPTO_LOCK_X509_STORE);
+	generation = ctx->store->generation;
+	CRYPTO_r_unlock(CRYPTO_LOCK_X509_STORE);
 
-	/* Use the modern multi-chain verifier from x509_verify_cert */
-
-	if ((vctx = x509_verify_ctx_new_from_xsc(ctx)) != NULL) {
-		ctx->error = X509_V_OK; /* Initialize to OK */
-		chain_count = x509_verify(vctx, NULL, NULL);
-	}
-	x509_verify_ctx_free(vctx);
+	if ((ret = x509_verify_cache_find(cache, md, generation, ctx)) != -1)
+		return ret;
 
-	sk_X509_pop_free(roots, X509_free);
+	ret = verify_cert(ctx);
+	x509_verify_cache_add(cache, md, generation, ctx, ret);
 
-	/* if we succeed we have a chain in ctx->chain */
-	return (chain_count > 0 && ctx->chain != NULL);
+	return ret;
 }
 LCRYPTO_ALIAS(X509_verify_cert);
 
@@ -694,8 +751,8 @@ find_issuer(X509_STORE_CTX *ctx, STACK_OF(X509) *sk, X509 *x,
 
 /* Given a possible certificate and issuer check them */
 
-static int
-check_issued(X509_STORE_CTX *ctx, X509 *subject, X509 *issuer)
+int
+x509_vfy_check_issued(X509_STORE_CTX *ctx, X509 *subject, X509 *issuer)
 {
 	/*
 	 * Yes, the arguments of X509_STORE_CTX_check_issued_fn were exposed in
@@ -2415,7 +2472,7 @@ X509_STORE_CTX_init(X509_STORE_CTX *ctx, X509_STORE *store, X509 *x509,
 	if (store && store->check_issued)
 		ctx->check_issued = store->check_issued;
 	else
-		ctx->check_issued = check_issued;
+		ctx->check_issued = x509_vfy_check_issued;
 
 	if (store && store->check_revocation)
 		ctx->check_revocation = store->check_revocation;
@@ -121,6 +121,7 @@ void X509_STORE_CTX_set_depth(X509_STORE_CTX *ctx, int depth);
 #define X509_L_FILE_LOAD	1
 #define X509_L_ADD_DIR		2
 #define X509_L_MEM		3
+#define X509_L_DIR_SNAPSHOT	4
 
 #define X509_LOOKUP_load_file(x,name,type) \
 		X509_LOOKUP_ctrl((x),X509_L_FILE_LOAD,(name),(long)(type),NULL)
@@ -132,6 +133,9 @@ void X509_STORE_CTX_set_depth(X509_STORE_CTX *ctx, int depth);
 		X509_LOOKUP_ctrl((x),X509_L_MEM,(const char *)(iov),\
 		(long)(type),NULL)
 
+#define X509_LOOKUP_set_dir_snapshot(x,on) \
+		X509_LOOKUP_ctrl((x),X509_L_DIR_SNAPSHOT,NULL,(long)(on),NULL)
+
 #define		X509_V_OK					0
 #define		X509_V_ERR_UNSPECIFIED				1
 #define		X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT		2
@@ -300,6 +304,7 @@ int X509_STORE_set_purpose(X509_STORE *ctx, int purpose);
 int X509_STORE_set_trust(X509_STORE *ctx, int trust);
 int X509_STORE_set1_param(X509_STORE *ctx, X509_VERIFY_PARAM *pm);
 X509_VERIFY_PARAM *X509_STORE_get0_param(X509_STORE *ctx);
+int X509_STORE_set_verify_cache(X509_STORE *store, size_t max);
 
 typedef int (*X509_STORE_CTX_verify_cb)(int, X509_STORE_CTX *);
 
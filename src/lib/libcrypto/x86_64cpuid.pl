@@ -128,17 +128,38 @@ OPENSSL_ia32_cpuid:
 
 .Lgeneric:
 	and	\$IA32CAP_MASK1_AMD_XOP,%r9d	# isolate AMD XOP flag
-	and	\$(~IA32CAP_MASK1_AMD_XOP),%ecx
+	and	\$(~(IA32CAP_MASK1_AMD_XOP | IA32CAP_MASK1_SHA | IA32CAP_MASK1_ADX)),%ecx
 	or	%ecx,%r9d		# merge AMD XOP flag
 
+	and	\$(~IA32CAP_MASK0_AVX2),%edx	# force reserved bit to 0
 	mov	%edx,%r10d		# %r9d:%r10d is copy of %ecx:%edx
+	cmp	\$7,%r11d
+	mov	\$0,%r11d		# no structured extended features
+	jb	.Lnoleaf7
+	mov	\$7,%eax		# structured extended features
+	xor	%ecx,%ecx
+	cpuid
+	mov	%ebx,%r11d
+	bt	\$29,%ebx		# test SHA bit
+	jnc	.Lnosha
+	or	\$IA32CAP_MASK1_SHA,%r9d	# set reserved bit#16 for SHA
+.Lnosha:
+	and	\$0x80100,%ebx		# isolate BMI2 and ADX bits
+	cmp	\$0x80100,%ebx
+	jne	.Lnoleaf7
+	or	\$IA32CAP_MASK1_ADX,%r9d	# reuse CNXT-ID bit#10 for BMI2+ADX
+.Lnoleaf7:
 	bt	\$IA32CAP_BIT1_OSXSAVE,%r9d	# check OSXSAVE bit
 	jnc	.Lclear_avx
 	xor	%ecx,%ecx		# XCR0
 	.byte	0x0f,0x01,0xd0		# xgetbv
 	and	\$6,%eax		# isolate XMM and YMM state support
 	cmp	\$6,%eax
-	je	.Ldone
+	jne	.Lclear_avx
+	bt	\$5,%r11d		# test AVX2 bit
+	jnc	.Ldone
+	or	\$IA32CAP_MASK0_AVX2,%r10d	# set reserved bit#10 for AVX2
+	jmp	.Ldone
 .Lclear_avx:
 	mov	\$(~(IA32CAP_MASK1_AVX | IA32CAP_MASK1_FMA3 | IA32CAP_MASK1_AMD_XOP)),%eax
 	and	%eax,%r9d		# clear AVX, FMA and AMD XOP bits
@@ -48,6 +48,7 @@
 #define	IA32CAP_BIT0_HT		28
 
 /* the following bits are not obtained from cpuid */
+#define	IA32CAP_BIT0_AVX2	10
 #define	IA32CAP_BIT0_INTELP4	20
 #define	IA32CAP_BIT0_INTEL	30
 
@@ -59,7 +60,9 @@
 #define	IA32CAP_BIT1_OSXSAVE	27
 #define	IA32CAP_BIT1_AVX	28
 
+#define	IA32CAP_BIT1_ADX	10
 #define	IA32CAP_BIT1_AMD_XOP	11
+#define	IA32CAP_BIT1_SHA	16
 
 /* bit masks for the low word */
 #define	IA32CAP_MASK0_MMX	(1 << IA32CAP_BIT0_MMX)
@@ -68,6 +71,7 @@
 #define	IA32CAP_MASK0_SSE2	(1 << IA32CAP_BIT0_SSE2)
 #define	IA32CAP_MASK0_HT	(1 << IA32CAP_BIT0_HT)
 
+#define	IA32CAP_MASK0_AVX2	(1 << IA32CAP_BIT0_AVX2)
 #define	IA32CAP_MASK0_INTELP4	(1 << IA32CAP_BIT0_INTELP4)
 #define	IA32CAP_MASK0_INTEL	(1 << IA32CAP_BIT0_INTEL)
 
@@ -78,13 +82,18 @@
 #define	IA32CAP_MASK1_AESNI	(1 << IA32CAP_BIT1_AESNI)
 #define	IA32CAP_MASK1_AVX	(1 << IA32CAP_BIT1_AVX)
 
+#define	IA32CAP_MASK1_ADX	(1 << IA32CAP_BIT1_ADX)
 #define	IA32CAP_MASK1_AMD_XOP	(1 << IA32CAP_BIT1_AMD_XOP)
+#define	IA32CAP_MASK1_SHA	(1 << IA32CAP_BIT1_SHA)
 
 /* bit masks for OPENSSL_cpu_caps() */
 #define	CPUCAP_MASK_MMX		IA32CAP_MASK0_MMX
 #define	CPUCAP_MASK_FXSR	IA32CAP_MASK0_FXSR
 #define	CPUCAP_MASK_SSE		IA32CAP_MASK0_SSE
 #define	CPUCAP_MASK_INTELP4	IA32CAP_MASK0_INTELP4
+#define	CPUCAP_MASK_AVX2	IA32CAP_MASK0_AVX2
 #define	CPUCAP_MASK_PCLMUL	(1ULL << (32 + IA32CAP_BIT1_PCLMUL))
 #define	CPUCAP_MASK_SSSE3	(1ULL << (32 + IA32CAP_BIT1_SSSE3))
 #define	CPUCAP_MASK_AESNI	(1ULL << (32 + IA32CAP_BIT1_AESNI))
+#define	CPUCAP_MASK_SHA		(1ULL << (32 + IA32CAP_BIT1_SHA))
+#define	CPUCAP_MASK_ADX		(1ULL << (32 + IA32CAP_BIT1_ADX))
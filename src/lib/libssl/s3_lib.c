@@ -1575,6 +1575,7 @@ ssl3_free(SSL *s)
 	tls13_secrets_destroy(s->s3->hs.tls13.secrets);
 	freezero(s->s3->hs.tls13.cookie, s->s3->hs.tls13.cookie_len);
 	tls13_clienthello_hash_clear(&s->s3->hs.tls13);
+	SSL_SESSION_free(s->s3->hs.tls13.psk_session);
 
 	tls_buffer_free(s->s3->hs.tls13.quic_read_buffer);
 
@@ -1628,6 +1629,8 @@ ssl3_clear(SSL *s)
 	s->s3->hs.tls13.cookie = NULL;
 	s->s3->hs.tls13.cookie_len = 0;
 	tls13_clienthello_hash_clear(&s->s3->hs.tls13);
+	SSL_SESSION_free(s->s3->hs.tls13.psk_session);
+	s->s3->hs.tls13.psk_session = NULL;
 
 	tls_buffer_free(s->s3->hs.tls13.quic_read_buffer);
 	s->s3->hs.tls13.quic_read_buffer = NULL;
@@ -467,6 +467,9 @@ typedef int (*tls_session_secret_cb_fn)(SSL *s, void *secret, int *secret_len,
  * TLS only.)  "Released" buffers are put onto a free-list in the context
  * or just freed (depending on the context's setting for freelist_max_len). */
 #define SSL_MODE_RELEASE_BUFFERS 0x00000010L
+/* Seal large TLSv1.3 writes into multiple records that are written out
+ * together, at the cost of a larger write buffer. */
+#define SSL_MODE_COALESCE_WRITES 0x00010000L
 
 /* Note: SSL[_CTX]_set_{options,mode} use |= op on the previous value,
  * they cannot be used to clear bits. */
@@ -32,6 +32,7 @@
 #define SSLASN1_HOSTNAME_TAG		(SSLASN1_TAG | 6)
 #define SSLASN1_LIFETIME_TAG		(SSLASN1_TAG | 9)
 #define SSLASN1_TICKET_TAG		(SSLASN1_TAG | 10)
+#define SSLASN1_TICKET_AGE_ADD_TAG	(SSLASN1_TAG | 14)
 
 static uint64_t
 time_max(void)
@@ -49,6 +50,7 @@ SSL_SESSION_encode(SSL_SESSION *s, unsigned char **out, size_t *out_len,
 {
 	CBB cbb, session, cipher_suite, session_id, master_key, time, timeout;
 	CBB peer_cert, sidctx, verify_result, hostname, lifetime, ticket, value;
+	CBB age_add;
 	unsigned char *peer_cert_bytes = NULL;
 	int len, rv = 0;
 	uint16_t cid;
@@ -177,6 +179,16 @@ SSL_SESSION_encode(SSL_SESSION *s, unsigned char **out, size_t *out_len,
 
 	/* Compression method [11]. */
 	/* SRP username [12]. */
+	/* Flags [13]. */
+
+	/* Ticket age add [14]. */
+	if (s->tlsext_tick_age_add != 0) {
+		if (!CBB_add_asn1(&session, &age_add,
+		    SSLASN1_TICKET_AGE_ADD_TAG))
+			goto err;
+		if (!CBB_add_asn1_uint64(&age_add, s->tlsext_tick_age_add))
+			goto err;
+	}
 
 	if (!CBB_finish(&cbb, out, out_len))
 		goto err;
@@ -245,6 +257,7 @@ d2i_SSL_SESSION(SSL_SESSION **a, const unsigned char **pp, long length)
 	CBS cbs, session, cipher_suite, session_id, master_key, peer_cert;
 	CBS hostname, ticket;
 	uint64_t version, tls_version, stime, timeout, verify_result, lifetime;
+	uint64_t age_add;
 	const unsigned char *peer_cert_bytes;
 	uint16_t cipher_value;
 	SSL_SESSION *s = NULL;
@@ -400,6 +413,16 @@ d2i_SSL_SESSION(SSL_SESSION **a, const unsigned char **pp, long length)
 
 	/* Compression method [11]. */
 	/* SRP username [12]. */
+	/* Flags [13]. */
+
+	/* Ticket age add [14]. */
+	s->tlsext_tick_age_add = 0;
+	if (!CBS_get_optional_asn1_uint64(&session, &age_add,
+	    SSLASN1_TICKET_AGE_ADD_TAG, 0))
+		goto err;
+	if (age_add > UINT32_MAX)
+		goto err;
+	s->tlsext_tick_age_add = (uint32_t)age_add;
 
 	*pp = CBS_data(&cbs);
 
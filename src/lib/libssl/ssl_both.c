@@ -161,7 +161,7 @@ ssl3_do_write(SSL *s, int type)
 	return (0);
 }
 
-static int
+int
 ssl3_add_cert(CBB *cbb, X509 *x)
 {
 	unsigned char *data;
@@ -193,6 +193,7 @@ ssl3_output_cert_chain(SSL *s, CBB *cbb, SSL_CERT_PKEY *cpk)
 	X509_STORE_CTX *xs_ctx = NULL;
 	STACK_OF(X509) *chain;
 	CBB cert_list;
+	CBS chain_der;
 	X509 *x;
 	int ret = 0;
 	int i;
@@ -204,13 +205,16 @@ ssl3_output_cert_chain(SSL *s, CBB *cbb, SSL_CERT_PKEY *cpk)
 	if (cpk == NULL)
 		goto done;
 
-	if ((chain = cpk->chain) == NULL)
-		chain = s->ctx->extra_certs;
+	/* The certificate and any chain that it has are already encoded. */
+	ssl_cert_pkey_chain_der(cpk, &chain_der);
+	if (!CBB_add_bytes(&cert_list, CBS_data(&chain_der),
+	    CBS_len(&chain_der)))
+		goto err;
+	if (cpk->chain != NULL)
+		goto done;
 
-	if (chain != NULL || (s->mode & SSL_MODE_NO_AUTO_CHAIN)) {
-		if (!ssl3_add_cert(&cert_list, cpk->x509))
-			goto err;
-	} else {
+	if ((chain = s->ctx->extra_certs) == NULL &&
+	    !(s->mode & SSL_MODE_NO_AUTO_CHAIN)) {
 		if ((xs_ctx = X509_STORE_CTX_new()) == NULL)
 			goto err;
 		if (!X509_STORE_CTX_init(xs_ctx, s->ctx->cert_store,
@@ -227,6 +231,11 @@ ssl3_output_cert_chain(SSL *s, CBB *cbb, SSL_CERT_PKEY *cpk)
 
 	for (i = 0; i < sk_X509_num(chain); i++) {
 		x = sk_X509_value(chain, i);
+
+		/* An auto chain has the leaf certificate at the top. */
+		if (i == 0 && x == cpk->x509)
+			continue;
+
 		if (!ssl3_add_cert(&cert_list, x))
 			goto err;
 	}
@@ -176,6 +176,19 @@ ssl_cert_new(void)
 	return (ret);
 }
 
+static void
+ssl_cert_der_free(SSL_CERT_DER *der)
+{
+	if (der == NULL)
+		return;
+
+	if (CRYPTO_add(&der->references, -1, CRYPTO_LOCK_SSL_CERT) > 0)
+		return;
+
+	free(der->data);
+	free(der);
+}
+
 SSL_CERT *
 ssl_cert_dup(SSL_CERT *cert)
 {
@@ -247,6 +260,12 @@ ssl_cert_dup(SSL_CERT *cert)
 			    X509_chain_up_ref(cert->pkeys[i].chain)) == NULL)
 				goto err;
 		}
+
+		if (cert->pkeys[i].chain_der != NULL) {
+			CRYPTO_add(&cert->pkeys[i].chain_der->references, 1,
+			    CRYPTO_LOCK_SSL_CERT);
+			ret->pkeys[i].chain_der = cert->pkeys[i].chain_der;
+		}
 	}
 
 	ret->security_cb = cert->security_cb;
@@ -269,6 +288,7 @@ ssl_cert_dup(SSL_CERT *cert)
 		X509_free(ret->pkeys[i].x509);
 		EVP_PKEY_free(ret->pkeys[i].privatekey);
 		sk_X509_pop_free(ret->pkeys[i].chain, X509_free);
+		ssl_cert_der_free(ret->pkeys[i].chain_der);
 	}
 	free (ret);
 	return NULL;
@@ -293,11 +313,66 @@ ssl_cert_free(SSL_CERT *c)
 		X509_free(c->pkeys[i].x509);
 		EVP_PKEY_free(c->pkeys[i].privatekey);
 		sk_X509_pop_free(c->pkeys[i].chain, X509_free);
+		ssl_cert_der_free(c->pkeys[i].chain_der);
 	}
 
 	free(c);
 }
 
+/*
+ * Encode the certificate and its chain, so that they can be sent without
+ * being encoded again on every handshake. This must be called whenever the
+ * certificate or chain is changed.
+ */
+int
+ssl_cert_pkey_encode_chain(SSL_CERT_PKEY *cpk)
+{
+	SSL_CERT_DER *der = NULL;
+	CBB cbb;
+	int i;
+
+	memset(&cbb, 0, sizeof(cbb));
+
+	if (cpk->x509 != NULL) {
+		if ((der = calloc(1, sizeof(*der))) == NULL)
+			goto err;
+		der->references = 1;
+		if (!CBB_init(&cbb, 0))
+			goto err;
+		if (!ssl3_add_cert(&cbb, cpk->x509))
+			goto err;
+		for (i = 0; i < sk_X509_num(cpk->chain); i++) {
+			if (!ssl3_add_cert(&cbb, sk_X509_value(cpk->chain, i)))
+				goto err;
+		}
+		if (!CBB_finish(&cbb, &der->data, &der->data_len))
+			goto err;
+	}
+
+	ssl_cert_der_free(cpk->chain_der);
+	cpk->chain_der = der;
+
+	return 1;
+
+ err:
+	CBB_cleanup(&cbb);
+	ssl_cert_der_free(der);
+
+	return 0;
+}
+
+/*
+ * Provide the encoded certificate and chain, which is empty if there is no
+ * certificate.
+ */
+void
+ssl_cert_pkey_chain_der(const SSL_CERT_PKEY *cpk, CBS *cbs)
+{
+	CBS_init(cbs, NULL, 0);
+	if (cpk->chain_der != NULL)
+		CBS_init(cbs, cpk->chain_der->data, cpk->chain_der->data_len);
+}
+
 SSL_CERT *
 ssl_get0_cert(SSL_CTX *ctx, SSL *ssl)
 {
@@ -310,6 +385,7 @@ ssl_get0_cert(SSL_CTX *ctx, SSL *ssl)
 int
 ssl_cert_set0_chain(SSL_CTX *ctx, SSL *ssl, STACK_OF(X509) *chain)
 {
+	STACK_OF(X509) *old_chain;
 	SSL_CERT *ssl_cert;
 	SSL_CERT_PKEY *cpk;
 	X509 *x509;
@@ -330,9 +406,16 @@ ssl_cert_set0_chain(SSL_CTX *ctx, SSL *ssl, STACK_OF(X509) *chain)
 		}
 	}
 
-	sk_X509_pop_free(cpk->chain, X509_free);
+	old_chain = cpk->chain;
 	cpk->chain = chain;
 
+	if (!ssl_cert_pkey_encode_chain(cpk)) {
+		cpk->chain = old_chain;
+		return 0;
+	}
+
+	sk_X509_pop_free(old_chain, X509_free);
+
 	return 1;
 }
 
@@ -378,6 +461,11 @@ ssl_cert_add0_chain_cert(SSL_CTX *ctx, SSL *ssl, X509 *cert)
 	if (!sk_X509_push(cpk->chain, cert))
 		return 0;
 
+	if (!ssl_cert_pkey_encode_chain(cpk)) {
+		(void)sk_X509_pop(cpk->chain);
+		return 0;
+	}
+
 	return 1;
 }
 
@@ -420,14 +420,16 @@ SSL_has_matching_session_id(const SSL *ssl, const unsigned char *id,
 	if (id_len > sizeof r.session_id)
 		return (0);
 
+	memset(&r, 0, sizeof(r));
 	r.ssl_version = ssl->version;
 	r.session_id_length = id_len;
 	memcpy(r.session_id, id, id_len);
 
-	CRYPTO_r_lock(CRYPTO_LOCK_SSL_CTX);
-	p = lh_SSL_SESSION_retrieve(ssl->ctx->sessions, &r);
-	CRYPTO_r_unlock(CRYPTO_LOCK_SSL_CTX);
-	return (p != NULL);
+	if ((p = ssl_session_cache_get1(ssl->ctx, &r)) == NULL)
+		return (0);
+	SSL_SESSION_free(p);
+
+	return (1);
 }
 
 int
@@ -1335,7 +1337,7 @@ SSL_callback_ctrl(SSL *s, int cmd, void (*fp)(void))
 struct lhash_st_SSL_SESSION *
 SSL_CTX_sessions(SSL_CTX *ctx)
 {
-	return (ctx->sessions);
+	return ssl_session_cache_view(ctx);
 }
 
 long
@@ -1376,7 +1378,7 @@ SSL_CTX_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
 		return (ctx->session_cache_mode);
 
 	case SSL_CTRL_SESS_NUMBER:
-		return (lh_SSL_SESSION_num_items(ctx->sessions));
+		return (ssl_session_cache_count(ctx));
 	case SSL_CTRL_SESS_CONNECT:
 		return (ctx->stats.sess_connect);
 	case SSL_CTRL_SESS_CONNECT_GOOD:
@@ -1885,61 +1887,6 @@ SSL_export_keying_material(SSL *s, unsigned char *out, size_t out_len,
 	    use_context, out, out_len);
 }
 
-static unsigned long
-ssl_session_hash(const SSL_SESSION *a)
-{
-	unsigned long	l;
-
-	l = (unsigned long)
-	    ((unsigned int) a->session_id[0]     )|
-	    ((unsigned int) a->session_id[1]<< 8L)|
-	    ((unsigned long)a->session_id[2]<<16L)|
-	    ((unsigned long)a->session_id[3]<<24L);
-	return (l);
-}
-
-/*
- * NB: If this function (or indeed the hash function which uses a sort of
- * coarser function than this one) is changed, ensure
- * SSL_CTX_has_matching_session_id() is checked accordingly. It relies on being
- * able to construct an SSL_SESSION that will collide with any existing session
- * with a matching session ID.
- */
-static int
-ssl_session_cmp(const SSL_SESSION *a, const SSL_SESSION *b)
-{
-	if (a->ssl_version != b->ssl_version)
-		return (1);
-	if (a->session_id_length != b->session_id_length)
-		return (1);
-	if (timingsafe_memcmp(a->session_id, b->session_id, a->session_id_length) != 0)
-		return (1);
-	return (0);
-}
-
-/*
- * These wrapper functions should remain rather than redeclaring
- * SSL_SESSION_hash and SSL_SESSION_cmp for void* types and casting each
- * variable. The reason is that the functions aren't static, they're exposed via
- * ssl.h.
- */
-static unsigned long
-ssl_session_LHASH_HASH(const void *arg)
-{
-	const SSL_SESSION *a = arg;
-
-	return ssl_session_hash(a);
-}
-
-static int
-ssl_session_LHASH_COMP(const void *arg1, const void *arg2)
-{
-	const SSL_SESSION *a = arg1;
-	const SSL_SESSION *b = arg2;
-
-	return ssl_session_cmp(a, b);
-}
-
 SSL_CTX *
 SSL_CTX_new(const SSL_METHOD *meth)
 {
@@ -1975,8 +1922,6 @@ SSL_CTX_new(const SSL_METHOD *meth)
 	ret->cert_store = NULL;
 	ret->session_cache_mode = SSL_SESS_CACHE_SERVER;
 	ret->session_cache_size = SSL_SESSION_CACHE_MAX_SIZE_DEFAULT;
-	ret->session_cache_head = NULL;
-	ret->session_cache_tail = NULL;
 
 	/* We take the system default */
 	ret->session_timeout = ssl_get_default_timeout();
@@ -2013,8 +1958,7 @@ SSL_CTX_new(const SSL_METHOD *meth)
 	ret->app_gen_cookie_cb = 0;
 	ret->app_verify_cookie_cb = 0;
 
-	ret->sessions = lh_SSL_SESSION_new();
-	if (ret->sessions == NULL)
+	if (!ssl_session_cache_init(ret))
 		goto err;
 	ret->cert_store = X509_STORE_new();
 	if (ret->cert_store == NULL)
@@ -2109,12 +2053,11 @@ SSL_CTX_free(SSL_CTX *ctx)
 	 * free ex_data, then finally free the cache.
 	 * (See ticket [openssl.org #212].)
 	 */
-	if (ctx->sessions != NULL)
-		SSL_CTX_flush_sessions(ctx, 0);
+	SSL_CTX_flush_sessions(ctx, 0);
 
 	CRYPTO_free_ex_data(CRYPTO_EX_INDEX_SSL_CTX, ctx, &ctx->ex_data);
 
-	lh_SSL_SESSION_free(ctx->sessions);
+	ssl_session_cache_free(ctx);
 
 	X509_STORE_free(ctx->cert_store);
 	sk_SSL_CIPHER_free(ctx->cipher_list);
@@ -2421,12 +2364,11 @@ ssl_should_update_internal_cache(SSL *s, int mode)
 void
 ssl_update_cache(SSL *s, int mode)
 {
-	int cache_mode, do_callback;
+	int do_callback;
 
 	if (s->session->session_id_length == 0)
 		return;
 
-	cache_mode = s->session_ctx->session_cache_mode;
 	do_callback = ssl_should_update_external_cache(s, mode);
 
 	if (ssl_should_update_internal_cache(s, mode)) {
@@ -2452,18 +2394,6 @@ ssl_update_cache(SSL *s, int mode)
 		    if (!s->session_ctx->new_session_cb(s, s->session))
 			    SSL_SESSION_free(s->session);
 	}
-
-	/* Auto flush every 255 connections. */
-	if (!(cache_mode & SSL_SESS_CACHE_NO_AUTO_CLEAR) &&
-	    (cache_mode & mode) != 0) {
-		int connections;
-		if (mode & SSL_SESS_CACHE_CLIENT)
-			connections = s->session_ctx->stats.sess_connect_good;
-		else
-			connections = s->session_ctx->stats.sess_accept_good;
-		if ((connections & 0xff) == 0xff)
-			SSL_CTX_flush_sessions(s->session_ctx, time(NULL));
-	}
 }
 
 const SSL_METHOD *
@@ -146,6 +146,7 @@
 #include <sys/types.h>
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -356,10 +357,22 @@ __BEGIN_HIDDEN_DECLS
 #define EXPLICIT_CHAR2_CURVE_TYPE  2
 #define NAMED_CURVE_TYPE           3
 
+/*
+ * The certificate followed by its chain, each DER encoded and prefixed with
+ * a 24-bit length, as sent in a Certificate message. An encoding is never
+ * modified once built, so that it can be shared by duplicated SSL_CERTs.
+ */
+typedef struct ssl_cert_der_st {
+	uint8_t *data;
+	size_t data_len;
+	int references;
+} SSL_CERT_DER;
+
 typedef struct ssl_cert_pkey_st {
 	X509 *x509;
 	EVP_PKEY *privatekey;
 	STACK_OF(X509) *chain;
+	SSL_CERT_DER *chain_der;
 } SSL_CERT_PKEY;
 
 typedef struct ssl_cert_st {
@@ -461,6 +474,7 @@ struct ssl_method_st {
  *	Ticket [10]             EXPLICIT OCTET STRING, -- session ticket (clients only)
  *	Compression_meth [11]   EXPLICIT OCTET STRING, -- optional compression method
  *	SRP_username [ 12 ] EXPLICIT OCTET STRING -- optional SRP username
+ *	Ticket_age_add [ 14 ] EXPLICIT INTEGER -- TLSv1.3 ticket age obfuscation
  * }
  * Look in ssl/ssl_asn1.c for more details
  * I'm using EXPLICIT tags so I can read the damn things using asn1parse :-).
@@ -469,6 +483,7 @@ struct ssl_session_st {
 	int ssl_version;	/* what ssl version session info is
 				 * being kept in here? */
 
+	/* Master secret, or the resumption PSK for TLSv1.3. */
 	size_t master_key_length;
 	unsigned char master_key[SSL_MAX_MASTER_KEY_LENGTH];
 
@@ -508,7 +523,6 @@ struct ssl_session_st {
 	size_t tlsext_ticklen;			/* Session ticket length */
 	uint32_t tlsext_tick_lifetime_hint;	/* Session lifetime hint in seconds */
 	uint32_t tlsext_tick_age_add; /* TLSv1.3 ticket age obfuscation (in ms) */
-	struct tls13_secret resumption_master_secret;
 
 	CRYPTO_EX_DATA ex_data; /* application specific data */
 
@@ -558,6 +572,21 @@ typedef struct ssl_handshake_tls13_st {
 	/* Client indicates psk_dhe_ke support in PskKeyExchangeMode. */
 	int use_psk_dhe_ke;
 
+	/* Client is offering a PSK for resumption in its ClientHello. */
+	int psk_offered;
+
+	/*
+	 * Session resumption - the session decrypted from the ticket offered
+	 * by the client, the index of its identity and the associated binder,
+	 * along with the length of the binders list that follows the partial
+	 * ClientHello (RFC 8446 section 4.2.11.2).
+	 */
+	SSL_SESSION *psk_session;
+	uint16_t psk_identity;
+	uint8_t psk_binder[EVP_MAX_MD_SIZE];
+	size_t psk_binder_len;
+	size_t psk_binders_len;
+
 	/* Certificate selected for use (static pointer). */
 	const SSL_CERT_PKEY *cpk;
 
@@ -712,6 +741,19 @@ int tls12_record_layer_seal_record(struct tls12_record_layer *rl,
     uint8_t content_type, const uint8_t *content, size_t content_len,
     CBB *out);
 
+/*
+ * The internal session cache is split into shards by session ID hash, each
+ * with its own lock, hash and list of sessions in order of insertion.
+ */
+#define SSL_SESSION_CACHE_SHARDS	16
+
+typedef struct ssl_session_cache_shard_st {
+	pthread_mutex_t lock;
+	struct lhash_st_SSL_SESSION *sessions;
+	struct ssl_session_st *head;
+	struct ssl_session_st *tail;
+} SSL_SESSION_CACHE_SHARD;
+
 typedef void (ssl_info_callback_fn)(const SSL *s, int type, int val);
 typedef void (ssl_msg_callback_fn)(int is_write, int version, int content_type,
     const void *buf, size_t len, SSL *ssl, void *arg);
@@ -817,13 +859,19 @@ struct ssl_ctx_st {
 	int (*tlsext_status_cb)(SSL *ssl, void *arg);
 	void *tlsext_status_arg;
 
-	struct lhash_st_SSL_SESSION *sessions;
+	SSL_SESSION_CACHE_SHARD session_cache[SSL_SESSION_CACHE_SHARDS];
+	int session_cache_count;
+
+	/*
+	 * Combined view of all shards for SSL_CTX_sessions(), which is only
+	 * created once requested. It is modified with the shard lock and
+	 * CRYPTO_LOCK_SSL_CTX held.
+	 */
+	struct lhash_st_SSL_SESSION *session_cache_view;
 
 	/* Most session-ids that will be cached, default is
 	 * SSL_SESSION_CACHE_MAX_SIZE_DEFAULT. 0 is unlimited. */
 	unsigned long session_cache_size;
-	struct ssl_session_st *session_cache_head;
-	struct ssl_session_st *session_cache_tail;
 
 	/* This can have one of 2 values, ored together,
 	 * SSL_SESS_CACHE_CLIENT,
@@ -1294,6 +1342,8 @@ int ssl_cert_set0_chain(SSL_CTX *ctx, SSL *ssl, STACK_OF(X509) *chain);
 int ssl_cert_set1_chain(SSL_CTX *ctx, SSL *ssl, STACK_OF(X509) *chain);
 int ssl_cert_add0_chain_cert(SSL_CTX *ctx, SSL *ssl, X509 *cert);
 int ssl_cert_add1_chain_cert(SSL_CTX *ctx, SSL *ssl, X509 *cert);
+int ssl_cert_pkey_encode_chain(SSL_CERT_PKEY *cpk);
+void ssl_cert_pkey_chain_der(const SSL_CERT_PKEY *cpk, CBS *cbs);
 
 int ssl_security_default_cb(const SSL *ssl, const SSL_CTX *ctx, int op,
     int bits, int nid, void *other, void *ex_data);
@@ -1314,6 +1364,11 @@ int ssl_security_shared_group(const SSL *ssl, uint16_t group_id);
 int ssl_security_supported_group(const SSL *ssl, uint16_t group_id);
 
 SSL_SESSION *ssl_session_dup(SSL_SESSION *src, int include_ticket);
+int ssl_session_cache_init(SSL_CTX *ctx);
+void ssl_session_cache_free(SSL_CTX *ctx);
+int ssl_session_cache_count(SSL_CTX *ctx);
+struct lhash_st_SSL_SESSION *ssl_session_cache_view(SSL_CTX *ctx);
+SSL_SESSION *ssl_session_cache_get1(SSL_CTX *ctx, const SSL_SESSION *key);
 int ssl_get_new_session(SSL *s, int session);
 int ssl_get_prev_session(SSL *s, CBS *session_id, CBS *ext_block,
     int *alert);
@@ -1372,6 +1427,7 @@ int ssl3_read_alert(SSL *s);
 int ssl3_read_change_cipher_spec(SSL *s);
 int ssl3_read_bytes(SSL *s, int type, unsigned char *buf, int len, int peek);
 int ssl3_write_bytes(SSL *s, int type, const void *buf, int len);
+int ssl3_add_cert(CBB *cbb, X509 *x);
 int ssl3_output_cert_chain(SSL *s, CBB *cbb, SSL_CERT_PKEY *cpk);
 SSL_CIPHER *ssl3_choose_cipher(SSL *ssl, STACK_OF(SSL_CIPHER) *clnt,
     STACK_OF(SSL_CIPHER) *srvr);
@@ -1502,6 +1558,8 @@ int ssl_check_serverhello_tlsext(SSL *s);
 #define TLS1_TICKET_DECRYPTED		 3
 
 int tls1_process_ticket(SSL *s, CBS *ext_block, int *alert, SSL_SESSION **ret);
+int tls1_decrypt_ticket(SSL *s, CBS *ticket, int *alert, SSL_SESSION **psess);
+int tls1_encrypt_ticket(SSL *s, SSL_SESSION *sess, CBB *cbb);
 
 int tls1_check_ec_server_key(SSL *s);
 
@@ -206,6 +206,7 @@ ssl_set_pkey(SSL_CTX *ctx, SSL *ssl, EVP_PKEY *pkey)
 			if (!X509_check_private_key(c->pkeys[i].x509, pkey)) {
 				X509_free(c->pkeys[i].x509);
 				c->pkeys[i].x509 = NULL;
+				ssl_cert_pkey_encode_chain(&c->pkeys[i]);
 				return 0;
 			}
 		}
@@ -371,6 +372,7 @@ ssl_get_password_cb_and_arg(SSL_CTX *ctx, SSL *ssl,
 static int
 ssl_set_cert(SSL_CTX *ctx, SSL *ssl, X509 *x)
 {
+	X509 *old_x509;
 	SSL_CERT *c;
 	EVP_PKEY *pkey;
 	int ssl_err;
@@ -425,9 +427,14 @@ ssl_set_cert(SSL_CTX *ctx, SSL *ssl, X509 *x)
 
 	EVP_PKEY_free(pkey);
 
-	X509_free(c->pkeys[i].x509);
-	X509_up_ref(x);
+	old_x509 = c->pkeys[i].x509;
 	c->pkeys[i].x509 = x;
+	if (!ssl_cert_pkey_encode_chain(&c->pkeys[i])) {
+		c->pkeys[i].x509 = old_x509;
+		return (0);
+	}
+	X509_free(old_x509);
+	X509_up_ref(x);
 	c->key = &(c->pkeys[i]);
 
 	c->valid = 0;
@@ -144,9 +144,302 @@
 
 #include "ssl_local.h"
 
-static void SSL_SESSION_list_remove(SSL_CTX *ctx, SSL_SESSION *s);
-static void SSL_SESSION_list_add(SSL_CTX *ctx, SSL_SESSION *s);
-static int remove_session_lock(SSL_CTX *ctx, SSL_SESSION *c, int lck);
+static void SSL_SESSION_list_remove(SSL_SESSION_CACHE_SHARD *shard,
+    SSL_SESSION *s);
+static void SSL_SESSION_list_add(SSL_SESSION_CACHE_SHARD *shard,
+    SSL_SESSION *s);
+
+/* Maximum number of expired sessions to remove when adding a session. */
+#define SSL_SESSION_CACHE_EXPIRE_MAX	4
+
+static unsigned long
+ssl_session_hash(const SSL_SESSION *a)
+{
+	unsigned long	l;
+
+	l = (unsigned long)
+	    ((unsigned int) a->session_id[0]     )|
+	    ((unsigned int) a->session_id[1]<< 8L)|
+	    ((unsigned long)a->session_id[2]<<16L)|
+	    ((unsigned long)a->session_id[3]<<24L);
+	return (l);
+}
+
+/*
+ * NB: If this function (or indeed the hash function which uses a sort of
+ * coarser function than this one) is changed, ensure
+ * SSL_CTX_has_matching_session_id() is checked accordingly. It relies on being
+ * able to construct an SSL_SESSION that will collide with any existing session
+ * with a matching session ID.
+ */
+static int
+ssl_session_cmp(const SSL_SESSION *a, const SSL_SESSION *b)
+{
+	if (a->ssl_version != b->ssl_version)
+		return (1);
+	if (a->session_id_length != b->session_id_length)
+		return (1);
+	if (timingsafe_memcmp(a->session_id, b->session_id, a->session_id_length) != 0)
+		return (1);
+	return (0);
+}
+
+/*
+ * These wrapper functions should remain rather than redeclaring
+ * SSL_SESSION_hash and SSL_SESSION_cmp for void* types and casting each
+ * variable. The reason is that the functions aren't static, they're exposed via
+ * ssl.h.
+ */
+static unsigned long
+ssl_session_LHASH_HASH(const void *arg)
+{
+	const SSL_SESSION *a = arg;
+
+	return ssl_session_hash(a);
+}
+
+static int
+ssl_session_LHASH_COMP(const void *arg1, const void *arg2)
+{
+	const SSL_SESSION *a = arg1;
+	const SSL_SESSION *b = arg2;
+
+	return ssl_session_cmp(a, b);
+}
+
+static size_t
+ssl_session_cache_shard(const SSL_SESSION *s)
+{
+	/*
+	 * The lhash uses the low bits of the hash to select a bucket, hence
+	 * use the high bits to select a shard.
+	 */
+	return (ssl_session_hash(s) >> 24) % SSL_SESSION_CACHE_SHARDS;
+}
+
+int
+ssl_session_cache_init(SSL_CTX *ctx)
+{
+	SSL_SESSION_CACHE_SHARD *shard;
+	size_t i;
+
+	for (i = 0; i < SSL_SESSION_CACHE_SHARDS; i++) {
+		shard = &ctx->session_cache[i];
+		if ((shard->sessions = lh_SSL_SESSION_new()) == NULL)
+			return 0;
+		if (pthread_mutex_init(&shard->lock, NULL) != 0) {
+			lh_SSL_SESSION_free(shard->sessions);
+			shard->sessions = NULL;
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+void
+ssl_session_cache_free(SSL_CTX *ctx)
+{
+	SSL_SESSION_CACHE_SHARD *shard;
+	size_t i;
+
+	for (i = 0; i < SSL_SESSION_CACHE_SHARDS; i++) {
+		shard = &ctx->session_cache[i];
+		if (shard->sessions == NULL)
+			continue;
+		lh_SSL_SESSION_free(shard->sessions);
+		shard->sessions = NULL;
+		pthread_mutex_destroy(&shard->lock);
+	}
+
+	lh_SSL_SESSION_free(ctx->session_cache_view);
+	ctx->session_cache_view = NULL;
+}
+
+int
+ssl_session_cache_count(SSL_CTX *ctx)
+{
+	return CRYPTO_add(&ctx->session_cache_count, 0, CRYPTO_LOCK_SSL_CTX);
+}
+
+/*
+ * Return the combined view of the cache, creating it from the shards if this
+ * is the first time that it has been requested. From then on, the view is
+ * kept in step with the shards as sessions are added and removed.
+ */
+struct lhash_st_SSL_SESSION *
+ssl_session_cache_view(SSL_CTX *ctx)
+{
+	struct lhash_st_SSL_SESSION *view = NULL;
+	SSL_SESSION_CACHE_SHARD *shard;
+	SSL_SESSION *s;
+	size_t i;
+
+	for (i = 0; i < SSL_SESSION_CACHE_SHARDS; i++)
+		pthread_mutex_lock(&ctx->session_cache[i].lock);
+
+	if (ctx->session_cache_view != NULL)
+		goto done;
+
+	if ((view = lh_SSL_SESSION_new()) == NULL)
+		goto done;
+
+	for (i = 0; i < SSL_SESSION_CACHE_SHARDS; i++) {
+		shard = &ctx->session_cache[i];
+		for (s = shard->head; s != NULL; s = s->next) {
+			(void)lh_SSL_SESSION_insert(view, s);
+			if (lh_SSL_SESSION_error(view) > 0) {
+				lh_SSL_SESSION_free(view);
+				goto done;
+			}
+			if (s == shard->tail)
+				break;
+		}
+	}
+
+	CRYPTO_w_lock(CRYPTO_LOCK_SSL_CTX);
+	ctx->session_cache_view = view;
+	CRYPTO_w_unlock(CRYPTO_LOCK_SSL_CTX);
+
+ done:
+	for (i = SSL_SESSION_CACHE_SHARDS; i > 0; i--)
+		pthread_mutex_unlock(&ctx->session_cache[i - 1].lock);
+
+	return ctx->session_cache_view;
+}
+
+/*
+ * Update the combined view, if there is one, after a session has been
+ * inserted into a shard. The shard must be locked.
+ */
+static int
+ssl_session_cache_view_insert(SSL_CTX *ctx, SSL_SESSION *s)
+{
+	int ret = 1;
+
+	if (ctx->session_cache_view == NULL)
+		return 1;
+
+	CRYPTO_w_lock(CRYPTO_LOCK_SSL_CTX);
+	(void)lh_SSL_SESSION_insert(ctx->session_cache_view, s);
+	if (lh_SSL_SESSION_error(ctx->session_cache_view) > 0)
+		ret = 0;
+	CRYPTO_w_unlock(CRYPTO_LOCK_SSL_CTX);
+
+	return ret;
+}
+
+/* Remove a session from the combined view - the shard must be locked. */
+static void
+ssl_session_cache_view_delete(SSL_CTX *ctx, SSL_SESSION *s)
+{
+	if (ctx->session_cache_view == NULL)
+		return;
+
+	CRYPTO_w_lock(CRYPTO_LOCK_SSL_CTX);
+	if (lh_SSL_SESSION_retrieve(ctx->session_cache_view, s) == s)
+		(void)lh_SSL_SESSION_delete(ctx->session_cache_view, s);
+	CRYPTO_w_unlock(CRYPTO_LOCK_SSL_CTX);
+}
+
+SSL_SESSION *
+ssl_session_cache_get1(SSL_CTX *ctx, const SSL_SESSION *key)
+{
+	SSL_SESSION_CACHE_SHARD *shard;
+	SSL_SESSION *sess;
+
+	shard = &ctx->session_cache[ssl_session_cache_shard(key)];
+
+	pthread_mutex_lock(&shard->lock);
+	sess = lh_SSL_SESSION_retrieve(shard->sessions, key);
+	if (sess != NULL)
+		CRYPTO_add(&sess->references, 1, CRYPTO_LOCK_SSL_SESSION);
+	pthread_mutex_unlock(&shard->lock);
+
+	return sess;
+}
+
+/* Unlink a session from the cache - the shard must be locked. */
+static void
+ssl_session_cache_unlink(SSL_CTX *ctx, SSL_SESSION_CACHE_SHARD *shard,
+    SSL_SESSION *s)
+{
+	(void)lh_SSL_SESSION_delete(shard->sessions, s);
+	ssl_session_cache_view_delete(ctx, s);
+	SSL_SESSION_list_remove(shard, s);
+	CRYPTO_add(&ctx->session_cache_count, -1, CRYPTO_LOCK_SSL_CTX);
+}
+
+/* Release the cache reference for a session that has been unlinked. */
+static void
+ssl_session_cache_release(SSL_CTX *ctx, SSL_SESSION *s)
+{
+	s->not_resumable = 1;
+	if (ctx->remove_session_cb != NULL)
+		ctx->remove_session_cb(ctx, s);
+	SSL_SESSION_free(s);
+}
+
+/*
+ * Unlink expired sessions from the tail of the shard, which holds those that
+ * were added earliest. Only a few sessions are examined on each call so that
+ * expiry is spread across insertions, rather than requiring full sweeps of
+ * the cache. The shard must be locked.
+ */
+static size_t
+ssl_session_cache_expire(SSL_CTX *ctx, SSL_SESSION_CACHE_SHARD *shard,
+    const SSL_SESSION *c, time_t now,
+    SSL_SESSION *expired[SSL_SESSION_CACHE_EXPIRE_MAX])
+{
+	SSL_SESSION *s;
+	size_t n = 0;
+
+	while (n < SSL_SESSION_CACHE_EXPIRE_MAX) {
+		if ((s = shard->tail) == NULL || s == c)
+			break;
+		if (now <= s->time + s->timeout)
+			break;
+		ssl_session_cache_unlink(ctx, shard, s);
+		expired[n++] = s;
+	}
+
+	return n;
+}
+
+/*
+ * Remove sessions while the cache is over its maximum size, starting with the
+ * oldest session in the shard that the session c was just added to.
+ */
+static void
+ssl_session_cache_evict(SSL_CTX *ctx, size_t idx, const SSL_SESSION *c)
+{
+	SSL_SESSION_CACHE_SHARD *shard;
+	SSL_SESSION *s;
+	size_t i = 0;
+
+	if (SSL_CTX_sess_get_cache_size(ctx) <= 0)
+		return;
+
+	while (i < SSL_SESSION_CACHE_SHARDS) {
+		if (SSL_CTX_sess_number(ctx) <= SSL_CTX_sess_get_cache_size(ctx))
+			return;
+
+		shard = &ctx->session_cache[(idx + i) % SSL_SESSION_CACHE_SHARDS];
+
+		pthread_mutex_lock(&shard->lock);
+		if ((s = shard->tail) == NULL || s == c) {
+			pthread_mutex_unlock(&shard->lock);
+			i++;
+			continue;
+		}
+		ssl_session_cache_unlink(ctx, shard, s);
+		pthread_mutex_unlock(&shard->lock);
+
+		CRYPTO_add(&ctx->stats.sess_cache_full, 1,
+		    CRYPTO_LOCK_SSL_CTX);
+		ssl_session_cache_release(ctx, s);
+	}
+}
 
 /* aka SSL_get0_session; gets 0 objects, just returns a copy of the pointer */
 SSL_SESSION *
@@ -169,7 +462,7 @@ SSL_get1_session(SSL *ssl)
 	CRYPTO_w_lock(CRYPTO_LOCK_SSL_SESSION);
 	sess = ssl->session;
 	if (sess)
-		sess->references++;
+		CRYPTO_add(&sess->references, 1, CRYPTO_LOCK_SSL_SESSION);
 	CRYPTO_w_unlock(CRYPTO_LOCK_SSL_SESSION);
 
 	return (sess);
@@ -303,11 +596,7 @@ ssl_session_dup(SSL_SESSION *sess, int include_ticket)
 			goto err;
 		copy->tlsext_tick_lifetime_hint =
 		    sess->tlsext_tick_lifetime_hint;
-
-		/*
-		 * XXX - copy sess->resumption_master_secret and all other
-		 * TLSv1.3 info here.
-		 */
+		copy->tlsext_tick_age_add = sess->tlsext_tick_age_add;
 	}
 
 	if (!CRYPTO_new_ex_data(CRYPTO_EX_INDEX_SSL_SESSION, copy,
@@ -547,11 +836,7 @@ ssl_session_from_cache(SSL *s, CBS *session_id)
 	    sizeof(data.session_id), &data.session_id_length))
 		return NULL;
 
-	CRYPTO_r_lock(CRYPTO_LOCK_SSL_CTX);
-	sess = lh_SSL_SESSION_retrieve(s->session_ctx->sessions, &data);
-	if (sess != NULL)
-		CRYPTO_add(&sess->references, 1, CRYPTO_LOCK_SSL_SESSION);
-	CRYPTO_r_unlock(CRYPTO_LOCK_SSL_CTX);
+	sess = ssl_session_cache_get1(s->session_ctx, &data);
 
 	if (sess == NULL)
 		s->session_ctx->stats.sess_miss++;
@@ -703,6 +988,10 @@ ssl_get_prev_session(SSL *s, CBS *session_id, CBS *ext_block, int *alert)
 		goto err;
 	}
 
+	/* TLSv1.3 sessions can only be resumed via a pre-shared key. */
+	if (sess->ssl_version == TLS1_3_VERSION)
+		goto err;
+
 	if (sess->cipher == NULL) {
 		sess->cipher = ssl3_get_cipher_by_id(sess->cipher_id);
 		if (sess->cipher == NULL)
@@ -745,8 +1034,11 @@ ssl_get_prev_session(SSL *s, CBS *session_id, CBS *ext_block, int *alert)
 int
 SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
 {
+	SSL_SESSION_CACHE_SHARD *shard;
+	SSL_SESSION *expired[SSL_SESSION_CACHE_EXPIRE_MAX];
+	SSL_SESSION *s, *replaced = NULL;
+	size_t i, idx, num_expired = 0;
 	int ret = 0;
-	SSL_SESSION *s;
 
 	/*
 	 * Add just 1 reference count for the SSL_CTX's session cache
@@ -755,22 +1047,42 @@ SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
 	 */
 	CRYPTO_add(&c->references, 1, CRYPTO_LOCK_SSL_SESSION);
 
+	idx = ssl_session_cache_shard(c);
+	shard = &ctx->session_cache[idx];
+
 	/*
 	 * If session c is in already in cache, we take back the increment
 	 * later.
 	 */
-	CRYPTO_w_lock(CRYPTO_LOCK_SSL_CTX);
-	s = lh_SSL_SESSION_insert(ctx->sessions, c);
+	pthread_mutex_lock(&shard->lock);
+	s = lh_SSL_SESSION_insert(shard->sessions, c);
+
+	if (s == NULL && lh_SSL_SESSION_error(shard->sessions) > 0) {
+		pthread_mutex_unlock(&shard->lock);
+		SSL_SESSION_free(c);
+		return 0;
+	}
+
+	if (!ssl_session_cache_view_insert(ctx, c)) {
+		/* Put back any session with the same ID, otherwise remove c. */
+		if (s != NULL)
+			(void)lh_SSL_SESSION_insert(shard->sessions, s);
+		else
+			(void)lh_SSL_SESSION_delete(shard->sessions, c);
+		pthread_mutex_unlock(&shard->lock);
+		SSL_SESSION_free(c);
+		return 0;
+	}
 
 	/*
 	 * s != NULL iff we already had a session with the given PID.
 	 * In this case, s == c should hold (then we did not really modify
-	 * ctx->sessions), or we're in trouble.
+	 * the cache), or we're in trouble.
 	 */
 	if (s != NULL && s != c) {
 		/* We *are* in trouble ... */
-		SSL_SESSION_list_remove(ctx, s);
-		SSL_SESSION_free(s);
+		SSL_SESSION_list_remove(shard, s);
+		replaced = s;
 		/*
 		 * ... so pretend the other session did not exist in cache
 		 * (we cannot handle two SSL_SESSION structures with identical
@@ -782,71 +1094,57 @@ SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
 	}
 
 	/* Put at the head of the queue unless it is already in the cache */
-	if (s == NULL)
-		SSL_SESSION_list_add(ctx, c);
+	if (s == NULL) {
+		SSL_SESSION_list_add(shard, c);
+		if (replaced == NULL)
+			CRYPTO_add(&ctx->session_cache_count, 1,
+			    CRYPTO_LOCK_SSL_CTX);
+		ret = 1;
+	}
 
-	if (s != NULL) {
-		/*
-		 * existing cache entry -- decrement previously incremented
-		 * reference count because it already takes into account the
-		 * cache.
-		 */
-		SSL_SESSION_free(s); /* s == c */
-		ret = 0;
-	} else {
-		/*
-		 * New cache entry -- remove old ones if cache has become
-		 * too large.
-		 */
+	if (!(ctx->session_cache_mode & SSL_SESS_CACHE_NO_AUTO_CLEAR))
+		num_expired = ssl_session_cache_expire(ctx, shard, c,
+		    time(NULL), expired);
 
-		ret = 1;
+	pthread_mutex_unlock(&shard->lock);
 
-		if (SSL_CTX_sess_get_cache_size(ctx) > 0) {
-			while (SSL_CTX_sess_number(ctx) >
-			    SSL_CTX_sess_get_cache_size(ctx)) {
-				if (!remove_session_lock(ctx,
-				    ctx->session_cache_tail, 0))
-					break;
-				else
-					ctx->stats.sess_cache_full++;
-			}
-		}
-	}
-	CRYPTO_w_unlock(CRYPTO_LOCK_SSL_CTX);
-	return (ret);
+	/*
+	 * For an existing cache entry, decrement the previously incremented
+	 * reference count because it already takes into account the cache.
+	 */
+	SSL_SESSION_free(s);
+	SSL_SESSION_free(replaced);
+
+	for (i = 0; i < num_expired; i++)
+		ssl_session_cache_release(ctx, expired[i]);
+
+	/* New cache entry - remove old ones if cache has become too large. */
+	if (ret == 1)
+		ssl_session_cache_evict(ctx, idx, c);
+
+	return ret;
 }
 
 int
 SSL_CTX_remove_session(SSL_CTX *ctx, SSL_SESSION *c)
 {
-	return remove_session_lock(ctx, c, 1);
-}
-
-static int
-remove_session_lock(SSL_CTX *ctx, SSL_SESSION *c, int lck)
-{
-	SSL_SESSION *r;
+	SSL_SESSION_CACHE_SHARD *shard;
 	int ret = 0;
 
 	if (c == NULL || c->session_id_length == 0)
 		return 0;
 
-	if (lck)
-		CRYPTO_w_lock(CRYPTO_LOCK_SSL_CTX);
-	if ((r = lh_SSL_SESSION_retrieve(ctx->sessions, c)) == c) {
+	shard = &ctx->session_cache[ssl_session_cache_shard(c)];
+
+	pthread_mutex_lock(&shard->lock);
+	if (lh_SSL_SESSION_retrieve(shard->sessions, c) == c) {
+		ssl_session_cache_unlink(ctx, shard, c);
 		ret = 1;
-		r = lh_SSL_SESSION_delete(ctx->sessions, c);
-		SSL_SESSION_list_remove(ctx, c);
-	}
-	if (lck)
-		CRYPTO_w_unlock(CRYPTO_LOCK_SSL_CTX);
-
-	if (ret) {
-		r->not_resumable = 1;
-		if (ctx->remove_session_cb != NULL)
-			ctx->remove_session_cb(ctx, r);
-		SSL_SESSION_free(r);
 	}
+	pthread_mutex_unlock(&shard->lock);
+
+	if (ret)
+		ssl_session_cache_release(ctx, c);
 
 	return ret;
 }
@@ -877,8 +1175,6 @@ SSL_SESSION_free(SSL_SESSION *ss)
 	free(ss->tlsext_ecpointformatlist);
 	free(ss->tlsext_supportedgroups);
 
-	tls13_secret_cleanup(&ss->resumption_master_secret);
-
 	freezero(ss, sizeof(*ss));
 }
 
@@ -1096,23 +1392,41 @@ SSL_set_session_ticket_ext(SSL *s, void *ext_data, int ext_len)
 
 typedef struct timeout_param_st {
 	SSL_CTX *ctx;
+	SSL_SESSION_CACHE_SHARD *shard;
 	long time;
-	struct lhash_st_SSL_SESSION *cache;
+	SSL_SESSION **expired;
+	size_t num_expired;
+	size_t max_expired;
 } TIMEOUT_PARAM;
 
 static void
 timeout_doall_arg(SSL_SESSION *s, TIMEOUT_PARAM *p)
 {
+	SSL_SESSION **expired;
+	size_t max_expired;
+
 	if ((p->time == 0) || (p->time > (s->time + s->timeout))) {
 		/* timeout */
 		/* The reason we don't call SSL_CTX_remove_session() is to
 		 * save on locking overhead */
-		(void)lh_SSL_SESSION_delete(p->cache, s);
-		SSL_SESSION_list_remove(p->ctx, s);
-		s->not_resumable = 1;
-		if (p->ctx->remove_session_cb != NULL)
-			p->ctx->remove_session_cb(p->ctx, s);
-		SSL_SESSION_free(s);
+		if (p->num_expired == p->max_expired) {
+			max_expired = p->max_expired * 2;
+			if (max_expired == 0)
+				max_expired = 16;
+			/* On failure, leave it for a later flush. */
+			if ((expired = reallocarray(p->expired, max_expired,
+			    sizeof(*expired))) == NULL)
+				return;
+			p->expired = expired;
+			p->max_expired = max_expired;
+		}
+
+		/*
+		 * Sessions are released once the shard has been unlocked, so
+		 * that the remove callback is not called with it held.
+		 */
+		ssl_session_cache_unlink(p->ctx, p->shard, s);
+		p->expired[p->num_expired++] = s;
 	}
 }
 
@@ -1129,21 +1443,36 @@ timeout_LHASH_DOALL_ARG(void *arg1, void *arg2)
 void
 SSL_CTX_flush_sessions(SSL_CTX *s, long t)
 {
+	SSL_SESSION_CACHE_SHARD *shard;
 	unsigned long i;
+	size_t j, k;
 	TIMEOUT_PARAM tp;
 
+	memset(&tp, 0, sizeof(tp));
 	tp.ctx = s;
-	tp.cache = s->sessions;
-	if (tp.cache == NULL)
-		return;
 	tp.time = t;
-	CRYPTO_w_lock(CRYPTO_LOCK_SSL_CTX);
-	i = CHECKED_LHASH_OF(SSL_SESSION, tp.cache)->down_load;
-	CHECKED_LHASH_OF(SSL_SESSION, tp.cache)->down_load = 0;
-	lh_SSL_SESSION_doall_arg(tp.cache, timeout_LHASH_DOALL_ARG,
-	TIMEOUT_PARAM, &tp);
-	CHECKED_LHASH_OF(SSL_SESSION, tp.cache)->down_load = i;
-	CRYPTO_w_unlock(CRYPTO_LOCK_SSL_CTX);
+
+	for (j = 0; j < SSL_SESSION_CACHE_SHARDS; j++) {
+		shard = &s->session_cache[j];
+		if (shard->sessions == NULL)
+			continue;
+
+		tp.shard = shard;
+		tp.num_expired = 0;
+
+		pthread_mutex_lock(&shard->lock);
+		i = CHECKED_LHASH_OF(SSL_SESSION, shard->sessions)->down_load;
+		CHECKED_LHASH_OF(SSL_SESSION, shard->sessions)->down_load = 0;
+		lh_SSL_SESSION_doall_arg(shard->sessions,
+		    timeout_LHASH_DOALL_ARG, TIMEOUT_PARAM, &tp);
+		CHECKED_LHASH_OF(SSL_SESSION, shard->sessions)->down_load = i;
+		pthread_mutex_unlock(&shard->lock);
+
+		for (k = 0; k < tp.num_expired; k++)
+			ssl_session_cache_release(s, tp.expired[k]);
+	}
+
+	free(tp.expired);
 }
 
 int
@@ -1157,30 +1486,28 @@ ssl_clear_bad_session(SSL *s)
 		return (0);
 }
 
-/* locked by SSL_CTX in the calling function */
+/* locked by the shard in the calling function */
 static void
-SSL_SESSION_list_remove(SSL_CTX *ctx, SSL_SESSION *s)
+SSL_SESSION_list_remove(SSL_SESSION_CACHE_SHARD *shard, SSL_SESSION *s)
 {
 	if (s->next == NULL || s->prev == NULL)
 		return;
 
-	if (s->next == (SSL_SESSION *)&(ctx->session_cache_tail)) {
+	if (s->next == (SSL_SESSION *)&(shard->tail)) {
 		/* last element in list */
-		if (s->prev == (SSL_SESSION *)&(ctx->session_cache_head)) {
+		if (s->prev == (SSL_SESSION *)&(shard->head)) {
 			/* only one element in list */
-			ctx->session_cache_head = NULL;
-			ctx->session_cache_tail = NULL;
+			shard->head = NULL;
+			shard->tail = NULL;
 		} else {
-			ctx->session_cache_tail = s->prev;
-			s->prev->next =
-			    (SSL_SESSION *)&(ctx->session_cache_tail);
+			shard->tail = s->prev;
+			s->prev->next = (SSL_SESSION *)&(shard->tail);
 		}
 	} else {
-		if (s->prev == (SSL_SESSION *)&(ctx->session_cache_head)) {
+		if (s->prev == (SSL_SESSION *)&(shard->head)) {
 			/* first element in list */
-			ctx->session_cache_head = s->next;
-			s->next->prev =
-			    (SSL_SESSION *)&(ctx->session_cache_head);
+			shard->head = s->next;
+			s->next->prev = (SSL_SESSION *)&(shard->head);
 		} else {
 			/* middle of list */
 			s->next->prev = s->prev;
@@ -1191,21 +1518,21 @@ SSL_SESSION_list_remove(SSL_CTX *ctx, SSL_SESSION *s)
 }
 
 static void
-SSL_SESSION_list_add(SSL_CTX *ctx, SSL_SESSION *s)
+SSL_SESSION_list_add(SSL_SESSION_CACHE_SHARD *shard, SSL_SESSION *s)
 {
 	if (s->next != NULL && s->prev != NULL)
-		SSL_SESSION_list_remove(ctx, s);
+		SSL_SESSION_list_remove(shard, s);
 
-	if (ctx->session_cache_head == NULL) {
-		ctx->session_cache_head = s;
-		ctx->session_cache_tail = s;
-		s->prev = (SSL_SESSION *)&(ctx->session_cache_head);
-		s->next = (SSL_SESSION *)&(ctx->session_cache_tail);
+	if (shard->head == NULL) {
+		shard->head = s;
+		shard->tail = s;
+		s->prev = (SSL_SESSION *)&(shard->head);
+		s->next = (SSL_SESSION *)&(shard->tail);
 	} else {
-		s->next = ctx->session_cache_head;
+		s->next = shard->head;
 		s->next->prev = s;
-		s->prev = (SSL_SESSION *)&(ctx->session_cache_head);
-		ctx->session_cache_head = s;
+		s->prev = (SSL_SESSION *)&(shard->head);
+		shard->head = s;
 	}
 }
 
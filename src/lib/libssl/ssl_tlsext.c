@@ -1113,11 +1113,15 @@ tlsext_sessionticket_client_build(SSL *s, uint16_t msg_type, CBB *cbb)
 		return 1;
 
 	if (s->session->tlsext_tick != NULL) {
-		/* Attempt to resume with an existing session ticket */
-		if (!CBB_add_bytes(cbb, s->session->tlsext_tick,
-		    s->session->tlsext_ticklen))
-			return 0;
-
+		/*
+		 * Attempt to resume with an existing session ticket. TLSv1.3
+		 * tickets are only offered via the pre_shared_key extension.
+		 */
+		if (s->session->ssl_version != TLS1_3_VERSION) {
+			if (!CBB_add_bytes(cbb, s->session->tlsext_tick,
+			    s->session->tlsext_ticklen))
+				return 0;
+		}
 	} else if (s->tlsext_session_ticket != NULL) {
 		/*
 		 * Attempt to resume with a custom provided session ticket set
@@ -1789,8 +1793,12 @@ tlsext_cookie_client_parse(SSL *s, uint16_t msg_type, CBS *cbs, int *alert)
 static int
 tlsext_psk_kex_modes_client_needs(SSL *s, uint16_t msg_type)
 {
-	return (s->s3->hs.tls13.use_psk_dhe_ke &&
-	    s->s3->hs.our_max_tls_version >= TLS1_3_VERSION);
+	/*
+	 * Advertise psk_dhe_ke whenever TLSv1.3 is enabled, so that the
+	 * server will issue a ticket following a full handshake.
+	 */
+	return (s->s3->hs.our_max_tls_version >= TLS1_3_VERSION &&
+	    (SSL_get_options(s) & SSL_OP_NO_TICKET) == 0);
 }
 
 static int
@@ -1859,37 +1867,228 @@ tlsext_psk_kex_modes_client_parse(SSL *s, uint16_t msg_type, CBS *cbs,
 static int
 tlsext_psk_client_needs(SSL *s, uint16_t msg_type)
 {
-	return 0;
+	/* A PSK is only offered if we are attempting session resumption. */
+	return (s->s3->hs.tls13.psk_offered &&
+	    s->s3->hs.our_max_tls_version >= TLS1_3_VERSION &&
+	    s->session != NULL && s->session->tlsext_tick != NULL);
 }
 
 static int
 tlsext_psk_client_build(SSL *s, uint16_t msg_type, CBB *cbb)
 {
-	return 0;
+	CBB identities, identity, binders, binder;
+	SSL_SESSION *sess = s->session;
+	uint32_t ticket_age;
+	const EVP_MD *md;
+	uint8_t *data;
+
+	if ((md = tls13_cipher_hash(sess->cipher)) == NULL)
+		return 0;
+
+	/*
+	 * Obfuscated ticket age, in milliseconds - RFC 8446 section 4.2.11.1.
+	 */
+	ticket_age = (uint32_t)(time(NULL) - sess->time) * 1000;
+	ticket_age += sess->tlsext_tick_age_add;
+
+	if (!CBB_add_u16_length_prefixed(cbb, &identities))
+		return 0;
+	if (!CBB_add_u16_length_prefixed(&identities, &identity))
+		return 0;
+	if (!CBB_add_bytes(&identity, sess->tlsext_tick, sess->tlsext_ticklen))
+		return 0;
+	if (!CBB_add_u32(&identities, ticket_age))
+		return 0;
+
+	/*
+	 * The binder covers the ClientHello up to this point, hence it is
+	 * zeroed here and computed once the ClientHello has been built.
+	 */
+	if (!CBB_add_u16_length_prefixed(cbb, &binders))
+		return 0;
+	if (!CBB_add_u8_length_prefixed(&binders, &binder))
+		return 0;
+	if (!CBB_add_space(&binder, &data, EVP_MD_size(md)))
+		return 0;
+	memset(data, 0, EVP_MD_size(md));
+
+	if (!CBB_flush(cbb))
+		return 0;
+
+	return 1;
 }
 
 static int
 tlsext_psk_client_parse(SSL *s, uint16_t msg_type, CBS *cbs, int *alert)
 {
-	return CBS_skip(cbs, CBS_len(cbs));
+	uint16_t selected_identity;
+
+	if (!CBS_get_u16(cbs, &selected_identity))
+		return 0;
+
+	/* We only ever offer a single identity. */
+	if (!s->s3->hs.tls13.psk_offered || selected_identity != 0) {
+		*alert = SSL_AD_ILLEGAL_PARAMETER;
+		return 0;
+	}
+
+	s->hit = 1;
+
+	return 1;
 }
 
 static int
 tlsext_psk_server_needs(SSL *s, uint16_t msg_type)
 {
-	return 0;
+	return (s->s3->hs.negotiated_tls_version >= TLS1_3_VERSION &&
+	    msg_type == SSL_TLSEXT_MSG_SH && s->hit);
 }
 
 static int
 tlsext_psk_server_build(SSL *s, uint16_t msg_type, CBB *cbb)
 {
-	return 0;
+	return CBB_add_u16(cbb, s->s3->hs.tls13.psk_identity);
+}
+
+/*
+ * Determine if a session decrypted from a ticket may be used for resumption.
+ */
+static int
+tlsext_psk_server_session_usable(SSL *s, SSL_SESSION *sess)
+{
+	time_t age;
+
+	if (sess->ssl_version != TLS1_3_VERSION)
+		return 0;
+	if (sess->master_key_length == 0)
+		return 0;
+
+	if (sess->sid_ctx_length != s->sid_ctx_length ||
+	    timingsafe_memcmp(sess->sid_ctx, s->sid_ctx,
+	    sess->sid_ctx_length) != 0)
+		return 0;
+	/* As with session IDs, peer verification requires a context. */
+	if ((SSL_get_verify_mode(s) & SSL_VERIFY_PEER) != 0 &&
+	    s->sid_ctx_length == 0)
+		return 0;
+
+	if (sess->cipher == NULL) {
+		sess->cipher = ssl3_get_cipher_by_id(sess->cipher_id);
+		if (sess->cipher == NULL)
+			return 0;
+	}
+	if (tls13_cipher_hash(sess->cipher) == NULL)
+		return 0;
+
+	if ((age = time(NULL) - sess->time) < 0)
+		return 0;
+	if (age > sess->timeout || age > sess->tlsext_tick_lifetime_hint)
+		return 0;
+
+	return 1;
 }
 
 static int
 tlsext_psk_server_parse(SSL *s, uint16_t msg_type, CBS *cbs, int *alert)
 {
-	return CBS_skip(cbs, CBS_len(cbs));
+	CBS identities, identity, binders, binder;
+	SSL_SESSION *sess = NULL;
+	uint32_t obfuscated_ticket_age;
+	uint16_t identity_count = 0;
+	uint16_t binder_count = 0;
+	int ret = 0;
+
+	SSL_SESSION_free(s->s3->hs.tls13.psk_session);
+	s->s3->hs.tls13.psk_session = NULL;
+	s->s3->hs.tls13.psk_identity = 0;
+	s->s3->hs.tls13.psk_binder_len = 0;
+	s->s3->hs.tls13.psk_binders_len = 0;
+
+	/* Pre-shared keys are only used for TLSv1.3 session resumption. */
+	if (s->s3->hs.negotiated_tls_version < TLS1_3_VERSION)
+		return CBS_skip(cbs, CBS_len(cbs));
+
+	if (!CBS_get_u16_length_prefixed(cbs, &identities))
+		goto err;
+	if (CBS_len(&identities) == 0)
+		goto err;
+
+	while (CBS_len(&identities) > 0) {
+		if (!CBS_get_u16_length_prefixed(&identities, &identity))
+			goto err;
+		if (!CBS_get_u32(&identities, &obfuscated_ticket_age))
+			goto err;
+		if (CBS_len(&identity) == 0)
+			goto err;
+
+		/*
+		 * Use the first ticket that we can decrypt, provided that
+		 * the client supports PSK with (EC)DHE key establishment.
+		 */
+		if (s->s3->hs.tls13.psk_session == NULL &&
+		    s->s3->hs.tls13.use_psk_dhe_ke &&
+		    (SSL_get_options(s) & SSL_OP_NO_TICKET) == 0) {
+			switch (tls1_decrypt_ticket(s, &identity, alert, &sess)) {
+			case TLS1_TICKET_FATAL_ERROR:
+				goto err;
+			case TLS1_TICKET_DECRYPTED:
+				if (tlsext_psk_server_session_usable(s, sess)) {
+					s->s3->hs.tls13.psk_session = sess;
+					s->s3->hs.tls13.psk_identity =
+					    identity_count;
+					sess = NULL;
+				}
+				break;
+			}
+			SSL_SESSION_free(sess);
+			sess = NULL;
+		}
+
+		if (identity_count == UINT16_MAX)
+			goto err;
+		identity_count++;
+	}
+
+	/*
+	 * The binders list follows the identities and ends the ClientHello,
+	 * since this extension must be the last one present.
+	 */
+	s->s3->hs.tls13.psk_binders_len = CBS_len(cbs);
+
+	if (!CBS_get_u16_length_prefixed(cbs, &binders))
+		goto err;
+
+	while (CBS_len(&binders) > 0) {
+		if (!CBS_get_u8_length_prefixed(&binders, &binder))
+			goto err;
+		if (CBS_len(&binder) < 32)
+			goto err;
+
+		if (s->s3->hs.tls13.psk_session != NULL &&
+		    s->s3->hs.tls13.psk_identity == binder_count) {
+			if (!CBS_write_bytes(&binder,
+			    s->s3->hs.tls13.psk_binder,
+			    sizeof(s->s3->hs.tls13.psk_binder),
+			    &s->s3->hs.tls13.psk_binder_len))
+				goto err;
+		}
+
+		if (binder_count == UINT16_MAX)
+			goto err;
+		binder_count++;
+	}
+
+	if (binder_count != identity_count) {
+		*alert = SSL_AD_ILLEGAL_PARAMETER;
+		goto err;
+	}
+
+	ret = 1;
+
+ err:
+	SSL_SESSION_free(sess);
+
+	return ret;
 }
 
 /*
@@ -2373,6 +2572,14 @@ tlsext_parse(SSL *s, int is_server, uint16_t msg_type, CBS *cbs, int *alert)
 			goto err;
 		s->s3->hs.extensions_seen |= (1 << idx);
 
+		/* RFC 8446 section 4.2.11 - PSK must be the last extension. */
+		if (tls_version >= TLS1_3_VERSION && is_server &&
+		    type == TLSEXT_TYPE_pre_shared_key &&
+		    CBS_len(&extensions) != 0) {
+			alert_desc = SSL_AD_ILLEGAL_PARAMETER;
+			goto err;
+		}
+
 		ext = tlsext_funcs(tlsext, is_server);
 		if (!ext->parse(s, msg_type, &extension_data, &alert_desc))
 			goto err;
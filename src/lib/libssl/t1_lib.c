@@ -121,9 +121,6 @@
 #include "ssl_sigalgs.h"
 #include "ssl_tlsext.h"
 
-static int tls_decrypt_ticket(SSL *s, CBS *ticket, int *alert,
-    SSL_SESSION **psess);
-
 int
 tls1_new(SSL *s)
 {
@@ -961,12 +958,12 @@ tls1_process_ticket(SSL *s, CBS *ext_block, int *alert, SSL_SESSION **ret)
 		return TLS1_TICKET_NOT_DECRYPTED;
 	}
 
-	return tls_decrypt_ticket(s, &ext_data, alert, ret);
+	return tls1_decrypt_ticket(s, &ext_data, alert, ret);
 }
 
-/* tls_decrypt_ticket attempts to decrypt a session ticket.
+/* tls1_decrypt_ticket attempts to decrypt a session ticket.
  *
- *   ticket: a CBS containing the body of the session ticket extension.
+ *   ticket: a CBS containing the session ticket.
  *   psess: (output) on return, if a ticket was decrypted, then this is set to
  *       point to the resulting session.
  *
@@ -975,8 +972,8 @@ tls1_process_ticket(SSL *s, CBS *ext_block, int *alert, SSL_SESSION **ret)
  *    TLS1_TICKET_NOT_DECRYPTED: the ticket couldn't be decrypted.
  *    TLS1_TICKET_DECRYPTED: a ticket was decrypted and *psess was set.
  */
-static int
-tls_decrypt_ticket(SSL *s, CBS *ticket, int *alert, SSL_SESSION **psess)
+int
+tls1_decrypt_ticket(SSL *s, CBS *ticket, int *alert, SSL_SESSION **psess)
 {
 	CBS ticket_name, ticket_iv, ticket_encdata, ticket_hmac;
 	SSL_SESSION *sess = NULL;
@@ -1130,3 +1127,109 @@ tls_decrypt_ticket(SSL *s, CBS *ticket, int *alert, SSL_SESSION **psess)
 
 	return ret;
 }
+
+/*
+ * tls1_encrypt_ticket encodes and encrypts the given session, adding the
+ * resulting session ticket (key name, IV, encrypted state and HMAC) to cbb.
+ * The encryption and HMAC keys are obtained from the ticket key callback if
+ * one is set, otherwise the keys generated for the parent context are used.
+ */
+int
+tls1_encrypt_ticket(SSL *s, SSL_SESSION *sess, CBB *cbb)
+{
+	SSL_CTX *tctx = s->initial_ctx;
+	size_t enc_session_len, enc_session_max_len, hmac_len;
+	size_t session_len = 0;
+	unsigned char *enc_session = NULL, *session = NULL;
+	unsigned char iv[EVP_MAX_IV_LENGTH];
+	unsigned char key_name[16];
+	unsigned char *hmac;
+	unsigned int hlen;
+	EVP_CIPHER_CTX *ctx = NULL;
+	HMAC_CTX *hctx = NULL;
+	int len;
+	int ret = 0;
+
+	if ((ctx = EVP_CIPHER_CTX_new()) == NULL)
+		goto err;
+	if ((hctx = HMAC_CTX_new()) == NULL)
+		goto err;
+
+	if (!SSL_SESSION_ticket(sess, &session, &session_len))
+		goto err;
+	if (session_len > 0xffff)
+		goto err;
+
+	/*
+	 * Initialize HMAC and cipher contexts. If callback is present
+	 * it does all the work, otherwise use generated values from
+	 * parent context.
+	 */
+	if (tctx->tlsext_ticket_key_cb != NULL) {
+		if (tctx->tlsext_ticket_key_cb(s, key_name, iv, ctx, hctx,
+		    1) < 0)
+			goto err;
+	} else {
+		arc4random_buf(iv, 16);
+		if (!EVP_EncryptInit_ex(ctx, EVP_aes_128_cbc(), NULL,
+		    tctx->tlsext_tick_aes_key, iv))
+			goto err;
+		if (!HMAC_Init_ex(hctx, tctx->tlsext_tick_hmac_key,
+		    sizeof(tctx->tlsext_tick_hmac_key), EVP_sha256(), NULL))
+			goto err;
+		memcpy(key_name, tctx->tlsext_tick_key_name, 16);
+	}
+
+	/* Encrypt the session state. */
+	enc_session_max_len = session_len + EVP_MAX_BLOCK_LENGTH;
+	if ((enc_session = calloc(1, enc_session_max_len)) == NULL)
+		goto err;
+	enc_session_len = 0;
+	if (!EVP_EncryptUpdate(ctx, enc_session, &len, session, session_len))
+		goto err;
+	enc_session_len += len;
+	if (!EVP_EncryptFinal_ex(ctx, enc_session + enc_session_len, &len))
+		goto err;
+	enc_session_len += len;
+
+	if (enc_session_len > enc_session_max_len)
+		goto err;
+
+	/* Generate the HMAC. */
+	if (!HMAC_Update(hctx, key_name, sizeof(key_name)))
+		goto err;
+	if (!HMAC_Update(hctx, iv, EVP_CIPHER_CTX_iv_length(ctx)))
+		goto err;
+	if (!HMAC_Update(hctx, enc_session, enc_session_len))
+		goto err;
+
+	if ((hmac_len = HMAC_size(hctx)) <= 0)
+		goto err;
+
+	if (!CBB_add_bytes(cbb, key_name, sizeof(key_name)))
+		goto err;
+	if (!CBB_add_bytes(cbb, iv, EVP_CIPHER_CTX_iv_length(ctx)))
+		goto err;
+	if (!CBB_add_bytes(cbb, enc_session, enc_session_len))
+		goto err;
+	if (!CBB_add_space(cbb, &hmac, hmac_len))
+		goto err;
+
+	if (!HMAC_Final(hctx, hmac, &hlen))
+		goto err;
+	if (hlen != hmac_len)
+		goto err;
+
+	if (!CBB_flush(cbb))
+		goto err;
+
+	ret = 1;
+
+ err:
+	EVP_CIPHER_CTX_free(ctx);
+	HMAC_CTX_free(hctx);
+	freezero(session, session_len);
+	free(enc_session);
+
+	return ret;
+}
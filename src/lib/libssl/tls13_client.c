@@ -24,6 +24,50 @@
 #include "tls13_handshake.h"
 #include "tls13_internal.h"
 
+/*
+ * Determine if the current session may be resumed via a TLSv1.3 PSK.
+ */
+static int
+tls13_client_session_resumable(struct tls13_ctx *ctx)
+{
+	SSL_SESSION *sess = ctx->ssl->session;
+	const EVP_MD *md;
+	time_t age;
+	SSL *s = ctx->ssl;
+
+	if (sess == NULL)
+		return 0;
+	if (ctx->hs->our_max_tls_version < TLS1_3_VERSION)
+		return 0;
+	if ((SSL_get_options(s) & SSL_OP_NO_TICKET) != 0)
+		return 0;
+
+	if (sess->ssl_version != TLS1_3_VERSION || sess->not_resumable)
+		return 0;
+	if (sess->tlsext_tick == NULL || sess->tlsext_ticklen == 0 ||
+	    sess->tlsext_ticklen > 0xffff)
+		return 0;
+
+	if (sess->cipher == NULL) {
+		if ((sess->cipher = ssl3_get_cipher_by_id(sess->cipher_id)) ==
+		    NULL)
+			return 0;
+	}
+	if (!ssl_cipher_in_list(SSL_get_ciphers(s), sess->cipher))
+		return 0;
+	if ((md = tls13_cipher_hash(sess->cipher)) == NULL)
+		return 0;
+	if (sess->master_key_length != EVP_MD_size(md))
+		return 0;
+
+	if ((age = time(NULL) - sess->time) < 0)
+		return 0;
+	if (age > sess->tlsext_tick_lifetime_hint)
+		return 0;
+
+	return 1;
+}
+
 int
 tls13_client_init(struct tls13_ctx *ctx)
 {
@@ -41,7 +85,13 @@ tls13_client_init(struct tls13_ctx *ctx)
 	tls13_record_layer_set_retry_after_phh(ctx->rl,
 	    (s->mode & SSL_MODE_AUTO_RETRY) != 0);
 
-	if (!ssl_get_new_session(s, 0)) /* XXX */
+	/*
+	 * Offer the current session for resumption via a PSK, if possible,
+	 * otherwise start with a new session.
+	 */
+	if (tls13_client_session_resumable(ctx))
+		ctx->hs->tls13.psk_offered = 1;
+	else if (!ssl_get_new_session(s, 0)) /* XXX */
 		return 0;
 
 	if (!tls1_transcript_init(s))
@@ -85,7 +135,7 @@ tls13_client_connect(struct tls13_ctx *ctx)
 }
 
 static int
-tls13_client_hello_build(struct tls13_ctx *ctx, CBB *cbb)
+tls13_client_hello_build_body(struct tls13_ctx *ctx, CBB *cbb)
 {
 	CBB cipher_suites, compression_methods, session_id;
 	uint16_t client_version;
@@ -130,6 +180,115 @@ tls13_client_hello_build(struct tls13_ctx *ctx, CBB *cbb)
 	return 0;
 }
 
+/*
+ * Compute the PSK binder over the partial ClientHello, which is the transcript
+ * to date followed by the ClientHello up to, but excluding, the binders list
+ * (RFC 8446 section 4.2.11.2). The binder is written in place, at the end of
+ * the ClientHello body.
+ */
+static int
+tls13_client_hello_psk_binder(struct tls13_ctx *ctx, uint8_t *body,
+    size_t body_len)
+{
+	SSL_SESSION *sess = ctx->ssl->session;
+	struct tls13_secret binder, psk, transcript_hash;
+	uint8_t hash[EVP_MAX_MD_SIZE];
+	const unsigned char *data;
+	EVP_MD_CTX *mdctx = NULL;
+	size_t binders_len, data_len;
+	uint8_t header[4];
+	unsigned int hash_len;
+	const EVP_MD *md;
+	int ret = 0;
+
+	if ((md = tls13_cipher_hash(sess->cipher)) == NULL)
+		goto err;
+
+	/* A single binder, prefixed with its length and the list length. */
+	binders_len = 2 + 1 + EVP_MD_size(md);
+	if (body_len < binders_len || body_len > 0xffffff)
+		goto err;
+
+	header[0] = TLS13_MT_CLIENT_HELLO;
+	header[1] = (body_len >> 16) & 0xff;
+	header[2] = (body_len >> 8) & 0xff;
+	header[3] = body_len & 0xff;
+
+	if (!tls1_transcript_data(ctx->ssl, &data, &data_len))
+		goto err;
+
+	if ((mdctx = EVP_MD_CTX_new()) == NULL)
+		goto err;
+	if (!EVP_DigestInit_ex(mdctx, md, NULL))
+		goto err;
+	if (!EVP_DigestUpdate(mdctx, data, data_len))
+		goto err;
+	if (!EVP_DigestUpdate(mdctx, header, sizeof(header)))
+		goto err;
+	if (!EVP_DigestUpdate(mdctx, body, body_len - binders_len))
+		goto err;
+	if (!EVP_DigestFinal_ex(mdctx, hash, &hash_len))
+		goto err;
+
+	transcript_hash.data = hash;
+	transcript_hash.len = hash_len;
+
+	psk.data = sess->master_key;
+	psk.len = sess->master_key_length;
+
+	binder.data = &body[body_len - EVP_MD_size(md)];
+	binder.len = EVP_MD_size(md);
+
+	if (!tls13_derive_psk_binder(&binder, md, &psk, 1, &transcript_hash))
+		goto err;
+
+	ret = 1;
+
+ err:
+	EVP_MD_CTX_free(mdctx);
+
+	return ret;
+}
+
+static int
+tls13_client_hello_build(struct tls13_ctx *ctx, CBB *cbb)
+{
+	uint8_t *data = NULL;
+	size_t data_len = 0;
+	CBB client_hello;
+	int ret = 0;
+
+	if (!ctx->hs->tls13.psk_offered)
+		return tls13_client_hello_build_body(ctx, cbb);
+
+	/*
+	 * When offering a PSK the ClientHello is built separately, so that
+	 * the binder can be computed over the encoded message.
+	 */
+	if (!CBB_init(&client_hello, 0))
+		goto err;
+	if (!tls13_client_hello_build_body(ctx, &client_hello))
+		goto err;
+	if (!CBB_finish(&client_hello, &data, &data_len))
+		goto err;
+
+	if (!tls13_client_hello_psk_binder(ctx, data, data_len))
+		goto err;
+
+	if (!CBB_add_bytes(cbb, data, data_len))
+		goto err;
+	if (!CBB_flush(cbb))
+		goto err;
+
+	ret = 1;
+
+ err:
+	CBB_cleanup(&client_hello);
+	free(data);
+
+	return ret;
+}
+
 int
 tls13_client_hello_send(struct tls13_ctx *ctx, CBB *cbb)
 {
@@ -337,6 +496,8 @@ tls13_client_engage_record_protection(struct tls13_ctx *ctx)
 	unsigned char buf[EVP_MAX_MD_SIZE];
 	uint8_t *shared_key = NULL;
 	size_t shared_key_len = 0;
+	uint8_t *psk;
+	size_t psk_len;
 	size_t hash_len;
 	SSL *s = ctx->ssl;
 	int ret = 0;
@@ -355,7 +516,7 @@ tls13_client_engage_record_protection(struct tls13_ctx *ctx)
 	if ((ctx->hash = tls13_cipher_hash(ctx->hs->cipher)) == NULL)
 		goto err;
 
-	if ((secrets = tls13_secrets_create(ctx->hash, 0)) == NULL)
+	if ((secrets = tls13_secrets_create(ctx->hash, s->hit)) == NULL)
 		goto err;
 	ctx->hs->tls13.secrets = secrets;
 
@@ -368,9 +529,14 @@ tls13_client_engage_record_protection(struct tls13_ctx *ctx)
 	context.data = buf;
 	context.len = hash_len;
 
-	/* Early secrets. */
-	if (!tls13_derive_early_secrets(secrets, secrets->zeros.data,
-	    secrets->zeros.len, &context))
+	/* Early secrets, using the resumption PSK if the server accepted it. */
+	psk = secrets->zeros.data;
+	psk_len = secrets->zeros.len;
+	if (s->hit) {
+		psk = s->session->master_key;
+		psk_len = s->session->master_key_length;
+	}
+	if (!tls13_derive_early_secrets(secrets, psk, psk_len, &context))
 		goto err;
 
 	/* Handshake secrets. */
@@ -489,6 +655,23 @@ tls13_server_hello_recv(struct tls13_ctx *ctx, CBS *cbs)
 		return 0;
 	}
 
+	if (s->hit) {
+		/*
+		 * The server selected our PSK - the cipher suite must use the
+		 * same hash as the one associated with the PSK.
+		 */
+		if (tls13_cipher_hash(ctx->hs->cipher) !=
+		    tls13_cipher_hash(s->session->cipher)) {
+			ctx->alert = TLS13_ALERT_ILLEGAL_PARAMETER;
+			return 0;
+		}
+		ctx->handshake_stage.hs_type |= WITH_PSK;
+	} else if (ctx->hs->tls13.psk_offered) {
+		/* Our PSK was not accepted - continue with a new session. */
+		if (!ssl_get_new_session(s, 0))
+			return 0;
+	}
+
 	if (!tls13_client_engage_record_protection(ctx))
 		return 0;
 
@@ -865,6 +1048,7 @@ tls13_client_certificate_send(struct tls13_ctx *ctx, CBB *cbb)
 {
 	SSL *s = ctx->ssl;
 	CBB cert_request_context, cert_list;
+	CBS chain_der;
 	const struct ssl_sigalg *sigalg;
 	STACK_OF(X509) *chain;
 	SSL_CERT_PKEY *cpk;
@@ -886,12 +1070,16 @@ tls13_client_certificate_send(struct tls13_ctx *ctx, CBB *cbb)
 	if (cpk == NULL)
 		goto done;
 
-	if ((chain = cpk->chain) == NULL)
-	       chain = s->ctx->extra_certs;
-
-	if (!tls13_cert_add(ctx, &cert_list, cpk->x509, tlsext_client_build))
+	/* The certificate and any chain that it has are already encoded. */
+	ssl_cert_pkey_chain_der(cpk, &chain_der);
+	if (!tls13_cert_add_chain_der(ctx, &cert_list, &chain_der,
+	    tlsext_client_build, tlsext_client_build))
 		goto err;
 
+	chain = NULL;
+	if (cpk->chain == NULL)
+		chain = s->ctx->extra_certs;
+
 	for (i = 0; i < sk_X509_num(chain); i++) {
 		cert = sk_X509_value(chain, i);
 		if (!tls13_cert_add(ctx, &cert_list, cert, tlsext_client_build))
@@ -1056,6 +1244,23 @@ int
 tls13_client_finished_sent(struct tls13_ctx *ctx)
 {
 	struct tls13_secrets *secrets = ctx->hs->tls13.secrets;
+	uint8_t transcript_hash[EVP_MAX_MD_SIZE];
+	struct tls13_secret context;
+	size_t transcript_hash_len;
+
+	/*
+	 * Derive the resumption master secret, which is needed to process
+	 * any NewSessionTicket messages that the server sends.
+	 */
+	if (!tls1_transcript_hash_value(ctx->ssl, transcript_hash,
+	    sizeof(transcript_hash), &transcript_hash_len))
+		return 0;
+
+	context.data = transcript_hash;
+	context.len = transcript_hash_len;
+
+	if (!tls13_derive_resumption_master_secret(secrets, &context))
+		return 0;
 
 	/*
 	 * Any records following the client finished message must be encrypted
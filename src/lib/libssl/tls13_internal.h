@@ -42,6 +42,12 @@ __BEGIN_HIDDEN_DECLS
 #define TLS13_IO_RECORD_VERSION		-7
 #define TLS13_IO_RECORD_OVERFLOW	-8
 
+/*
+ * RFC 8446, section 4.6.1. Servers must not indicate a lifetime longer than
+ * 7 days and clients must not cache tickets for longer than 7 days.
+ */
+#define TLS13_MAX_TICKET_LIFETIME	(7 * 24 * 3600)
+
 #define TLS13_ERR_VERIFY_FAILED		16
 #define TLS13_ERR_HRR_FAILED		17
 #define TLS13_ERR_TRAILING_DATA		18
@@ -121,6 +127,7 @@ struct tls13_secrets {
 	int early_done;
 	int handshake_done;
 	int schedule_done;
+	int resumption_done;
 	int insecure; /* Set by tests */
 	struct tls13_secret zeros;
 	struct tls13_secret empty_hash;
@@ -166,6 +173,11 @@ int tls13_derive_handshake_secrets(struct tls13_secrets *secrets,
     const uint8_t *ecdhe, size_t ecdhe_len, const struct tls13_secret *context);
 int tls13_derive_application_secrets(struct tls13_secrets *secrets,
     const struct tls13_secret *context);
+int tls13_derive_resumption_master_secret(struct tls13_secrets *secrets,
+    const struct tls13_secret *context);
+int tls13_derive_psk_binder(struct tls13_secret *out, const EVP_MD *digest,
+    const struct tls13_secret *psk, int resumption,
+    const struct tls13_secret *transcript_hash);
 int tls13_update_client_traffic_secret(struct tls13_secrets *secrets);
 int tls13_update_server_traffic_secret(struct tls13_secrets *secrets);
 
@@ -209,6 +221,8 @@ void tls13_record_layer_set_hash(struct tls13_record_layer *rl,
 void tls13_record_layer_set_legacy_version(struct tls13_record_layer *rl,
     uint16_t version);
 void tls13_record_layer_set_retry_after_phh(struct tls13_record_layer *rl, int retry);
+void tls13_record_layer_set_coalesce_writes(struct tls13_record_layer *rl,
+    int coalesce);
 void tls13_record_layer_handshake_completed(struct tls13_record_layer *rl);
 int tls13_record_layer_set_read_traffic_key(struct tls13_record_layer *rl,
     struct tls13_secret *read_key, enum ssl_encryption_level_t read_level);
@@ -291,6 +305,9 @@ struct tls13_ctx {
 	int phh_count;
 	time_t phh_last_seen;
 
+	/* Number of tickets issued, used as the nonce for the next ticket. */
+	uint32_t tickets_sent;
+
 	tls13_handshake_message_cb handshake_message_sent_cb;
 	tls13_handshake_message_cb handshake_message_recv_cb;
 	tls13_info_cb info_cb;
@@ -405,6 +422,9 @@ int tls13_server_finished_sent(struct tls13_ctx *ctx);
 void tls13_error_clear(struct tls13_error *error);
 int tls13_cert_add(struct tls13_ctx *ctx, CBB *cbb, X509 *cert,
     int(*build_extensions)(SSL *s, uint16_t msg_type, CBB *cbb));
+int tls13_cert_add_chain_der(struct tls13_ctx *ctx, CBB *cbb, CBS *chain_der,
+    int(*build_leaf_extensions)(SSL *s, uint16_t msg_type, CBB *cbb),
+    int(*build_extensions)(SSL *s, uint16_t msg_type, CBB *cbb));
 
 int tls13_synthetic_handshake_message(struct tls13_ctx *ctx);
 int tls13_clienthello_hash_init(struct tls13_ctx *ctx);
@@ -19,6 +19,7 @@
 #include <stdlib.h>
 
 #include <openssl/hkdf.h>
+#include <openssl/hmac.h>
 
 #include "bytestring.h"
 #include "ssl_local.h"
@@ -344,6 +345,27 @@ tls13_derive_application_secrets(struct tls13_secrets *secrets,
 	    secrets->digest, &secrets->extracted_master, "exp master",
 	    context))
 		return 0;
+
+	/*
+	 * The master secret is retained until the resumption master secret
+	 * has been derived, since this requires the transcript through to the
+	 * client finished message.
+	 */
+
+	secrets->schedule_done = 1;
+
+	return 1;
+}
+
+int
+tls13_derive_resumption_master_secret(struct tls13_secrets *secrets,
+    const struct tls13_secret *context)
+{
+	if (!secrets->init_done || !secrets->early_done ||
+	    !secrets->handshake_done || !secrets->schedule_done ||
+	    secrets->resumption_done)
+		return 0;
+
 	if (!tls13_derive_secret(&secrets->resumption_master,
 	    secrets->digest, &secrets->extracted_master, "res master",
 	    context))
@@ -354,11 +376,58 @@ tls13_derive_application_secrets(struct tls13_secrets *secrets,
 		explicit_bzero(secrets->extracted_master.data,
 		    secrets->extracted_master.len);
 
-	secrets->schedule_done = 1;
+	secrets->resumption_done = 1;
 
 	return 1;
 }
 
+/*
+ * Compute a PSK binder value - RFC 8446 section 4.2.11.2. The binder is
+ * an HMAC over the transcript hash of the partial ClientHello, keyed with
+ * a finished key derived from the binder key of the early secret.
+ */
+int
+tls13_derive_psk_binder(struct tls13_secret *out, const EVP_MD *digest,
+    const struct tls13_secret *psk, int resumption,
+    const struct tls13_secret *transcript_hash)
+{
+	struct tls13_secret context = { .data = "", .len = 0 };
+	struct tls13_secret finished_key = { .data = NULL, .len = 0 };
+	struct tls13_secrets *secrets = NULL;
+	unsigned int hlen;
+	int ret = 0;
+
+	if (out->len != EVP_MD_size(digest))
+		goto err;
+
+	if ((secrets = tls13_secrets_create(digest, resumption)) == NULL)
+		goto err;
+	if (!tls13_derive_early_secrets(secrets, psk->data, psk->len,
+	    &secrets->empty_hash))
+		goto err;
+
+	if (!tls13_secret_init(&finished_key, EVP_MD_size(digest)))
+		goto err;
+	if (!tls13_hkdf_expand_label(&finished_key, digest,
+	    &secrets->binder_key, "finished", &context))
+		goto err;
+
+	if (HMAC(digest, finished_key.data, finished_key.len,
+	    transcript_hash->data, transcript_hash->len, out->data,
+	    &hlen) == NULL)
+		goto err;
+	if (hlen != out->len)
+		goto err;
+
+	ret = 1;
+
+ err:
+	tls13_secret_cleanup(&finished_key);
+	tls13_secrets_destroy(secrets);
+
+	return ret;
+}
+
 int
 tls13_update_client_traffic_secret(struct tls13_secrets *secrets)
 {
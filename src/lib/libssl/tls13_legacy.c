@@ -270,6 +270,9 @@ tls13_legacy_write_bytes(SSL *ssl, int type, const void *vbuf, int len)
 		return tls13_legacy_return_code(ssl, TLS13_IO_WANT_POLLOUT);
 	}
 
+	tls13_record_layer_set_coalesce_writes(ctx->rl,
+	    (ssl->mode & SSL_MODE_COALESCE_WRITES) != 0);
+
 	if (type != SSL3_RT_APPLICATION_DATA) {
 		SSLerror(ssl, ERR_R_SHOULD_NOT_HAVE_BEEN_CALLED);
 		return -1;
@@ -24,13 +24,6 @@
 #include "ssl_tlsext.h"
 #include "tls13_internal.h"
 
-/*
- * RFC 8446, section 4.6.1. Servers must not indicate a lifetime longer than
- * 7 days and clients must not cache tickets for longer than 7 days.
- */
-
-#define TLS13_MAX_TICKET_LIFETIME	(7 * 24 * 3600)
-
 /*
  * Downgrade sentinels - RFC 8446 section 4.1.3, magic values which must be set
  * by the server in server random if it is willing to downgrade but supports
@@ -340,7 +333,7 @@ static ssize_t
 tls13_new_session_ticket_recv(struct tls13_ctx *ctx, CBS *cbs)
 {
 	struct tls13_secrets *secrets = ctx->hs->tls13.secrets;
-	struct tls13_secret nonce;
+	struct tls13_secret nonce, psk;
 	uint32_t ticket_lifetime, ticket_age_add;
 	CBS ticket_nonce, ticket;
 	SSL_SESSION *sess = NULL;
@@ -385,6 +378,9 @@ tls13_new_session_ticket_recv(struct tls13_ctx *ctx, CBS *cbs)
 
 	alert = TLS13_ALERT_INTERNAL_ERROR;
 
+	if (!secrets->resumption_done)
+		goto err;
+
 	/*
 	 * Create new session instead of modifying the current session.
 	 * The current session could already be in the session cache.
@@ -409,13 +405,16 @@ tls13_new_session_ticket_recv(struct tls13_ctx *ctx, CBS *cbs)
 	if (!CBS_stow(&ticket_nonce, &nonce.data, &nonce.len))
 		goto err;
 
-	if (!tls13_secret_init(&sess->resumption_master_secret, 256))
+	/* The resumption PSK is stored as the session master key. */
+	psk.data = sess->master_key;
+	psk.len = EVP_MD_size(secrets->digest);
+	if (psk.len > sizeof(sess->master_key))
 		goto err;
 
-	if (!tls13_derive_secret(&sess->resumption_master_secret,
-	    secrets->digest, &secrets->resumption_master, "resumption",
-	    &nonce))
+	if (!tls13_derive_secret(&psk, secrets->digest,
+	    &secrets->resumption_master, "resumption", &nonce))
 		goto err;
+	sess->master_key_length = psk.len;
 
 	SSL_SESSION_free(ctx->ssl->session);
 	ctx->ssl->session = sess;
@@ -549,11 +548,28 @@ tls13_ctx_free(struct tls13_ctx *ctx)
 	freezero(ctx, sizeof(struct tls13_ctx));
 }
 
+static int
+tls13_cert_add_extensions(struct tls13_ctx *ctx, CBB *cbb,
+    int (*build_extensions)(SSL *s, uint16_t msg_type, CBB *cbb))
+{
+	CBB cert_exts;
+
+	if (build_extensions != NULL) {
+		if (!build_extensions(ctx->ssl, SSL_TLSEXT_MSG_CT, cbb))
+			return 0;
+	} else {
+		if (!CBB_add_u16_length_prefixed(cbb, &cert_exts))
+			return 0;
+	}
+
+	return CBB_flush(cbb);
+}
+
 int
 tls13_cert_add(struct tls13_ctx *ctx, CBB *cbb, X509 *cert,
     int (*build_extensions)(SSL *s, uint16_t msg_type, CBB *cbb))
 {
-	CBB cert_data, cert_exts;
+	CBB cert_data;
 	uint8_t *data;
 	int cert_len;
 
@@ -566,15 +582,41 @@ tls13_cert_add(struct tls13_ctx *ctx, CBB *cbb, X509 *cert,
 		return 0;
 	if (i2d_X509(cert, &data) != cert_len)
 		return 0;
-	if (build_extensions != NULL) {
-		if (!build_extensions(ctx->ssl, SSL_TLSEXT_MSG_CT, cbb))
+
+	return tls13_cert_add_extensions(ctx, cbb, build_extensions);
+}
+
+/*
+ * Add a certificate and chain that have already been encoded as a list of
+ * 24-bit length prefixed certificates, with extensions following each one.
+ */
+int
+tls13_cert_add_chain_der(struct tls13_ctx *ctx, CBB *cbb, CBS *chain_der,
+    int (*build_leaf_extensions)(SSL *s, uint16_t msg_type, CBB *cbb),
+    int (*build_extensions)(SSL *s, uint16_t msg_type, CBB *cbb))
+{
+	CBS cert_data;
+	CBB cert;
+	int leaf = 1;
+
+	if (CBS_len(chain_der) == 0)
+		return 0;
+
+	while (CBS_len(chain_der) > 0) {
+		if (!CBS_get_u24_length_prefixed(chain_der, &cert_data))
 			return 0;
-	} else {
-		if (!CBB_add_u16_length_prefixed(cbb, &cert_exts))
+
+		if (!CBB_add_u24_length_prefixed(cbb, &cert))
+			return 0;
+		if (!CBB_add_bytes(&cert, CBS_data(&cert_data),
+		    CBS_len(&cert_data)))
+			return 0;
+		if (!tls13_cert_add_extensions(ctx, cbb, leaf ?
+		    build_leaf_extensions : build_extensions))
 			return 0;
+
+		leaf = 0;
 	}
-	if (!CBB_flush(cbb))
-		return 0;
 
 	return 1;
 }
@@ -19,6 +19,12 @@
 #include "tls13_record.h"
 #include "tls_content.h"
 
+/*
+ * Maximum number of application data records that are sealed into the write
+ * buffer and pushed out via a single write.
+ */
+#define TLS13_RECORD_LAYER_MAX_COALESCED_RECORDS	16
+
 static ssize_t tls13_record_layer_write_chunk(struct tls13_record_layer *rl,
     uint8_t content_type, const uint8_t *buf, size_t n);
 static ssize_t tls13_record_layer_write_record(struct tls13_record_layer *rl,
@@ -69,6 +75,7 @@ struct tls13_record_layer {
 	int legacy_alerts_allowed;
 	int phh;
 	int phh_retry;
+	int coalesce_writes;
 
 	/*
 	 * Read and/or write channels are closed due to an alert being
@@ -81,7 +88,15 @@ struct tls13_record_layer {
 
 	struct tls13_record *rrec;
 
-	struct tls13_record *wrec;
+	/*
+	 * Records are sealed into a preallocated write buffer, with any data
+	 * that is yet to be written being tracked by wrec. The write buffer
+	 * is grown when application data is coalesced and shrunk again once
+	 * coalescing has been disabled.
+	 */
+	uint8_t *wbuf;
+	size_t wbuf_len;
+	CBS wrec;
 	uint8_t wrec_content_type;
 	size_t wrec_appdata_len;
 	size_t wrec_content_len;
@@ -121,11 +136,16 @@ tls13_record_layer_rrec_free(struct tls13_record_layer *rl)
 	rl->rrec = NULL;
 }
 
+static int
+tls13_record_layer_wrec_pending(struct tls13_record_layer *rl)
+{
+	return CBS_len(&rl->wrec) > 0;
+}
+
 static void
-tls13_record_layer_wrec_free(struct tls13_record_layer *rl)
+tls13_record_layer_wrec_clear(struct tls13_record_layer *rl)
 {
-	tls13_record_free(rl->wrec);
-	rl->wrec = NULL;
+	CBS_init(&rl->wrec, NULL, 0);
 }
 
 struct tls13_record_layer *
@@ -145,6 +165,11 @@ tls13_record_layer_new(const struct tls13_record_layer_callbacks *callbacks,
 	if ((rl->write = tls13_record_protection_new()) == NULL)
 		goto err;
 
+	if ((rl->wbuf = malloc(TLS13_RECORD_MAX_LEN)) == NULL)
+		goto err;
+	rl->wbuf_len = TLS13_RECORD_MAX_LEN;
+	tls13_record_layer_wrec_clear(rl);
+
 	rl->legacy_version = TLS1_2_VERSION;
 
 	tls13_record_layer_set_callbacks(rl, callbacks, cb_arg);
@@ -164,7 +189,8 @@ tls13_record_layer_free(struct tls13_record_layer *rl)
 		return;
 
 	tls13_record_layer_rrec_free(rl);
-	tls13_record_layer_wrec_free(rl);
+
+	freezero(rl->wbuf, rl->wbuf_len);
 
 	freezero(rl->alert_data, rl->alert_len);
 	freezero(rl->phh_data, rl->phh_len);
@@ -277,6 +303,13 @@ tls13_record_layer_set_retry_after_phh(struct tls13_record_layer *rl, int retry)
 	rl->phh_retry = retry;
 }
 
+void
+tls13_record_layer_set_coalesce_writes(struct tls13_record_layer *rl,
+    int coalesce)
+{
+	rl->coalesce_writes = coalesce;
+}
+
 static ssize_t
 tls13_record_layer_process_alert(struct tls13_record_layer *rl)
 {
@@ -631,10 +664,9 @@ tls13_record_layer_open_record(struct tls13_record_layer *rl)
 
 static int
 tls13_record_layer_seal_record_plaintext(struct tls13_record_layer *rl,
-    uint8_t content_type, const uint8_t *content, size_t content_len)
+    uint8_t content_type, const uint8_t *content, size_t content_len,
+    uint8_t *out, size_t max_out_len, size_t *out_len)
 {
-	uint8_t *data = NULL;
-	size_t data_len = 0;
 	CBB cbb, body;
 
 	/*
@@ -651,7 +683,7 @@ tls13_record_layer_seal_record_plaintext(struct tls13_record_layer *rl,
 	 * We're still operating in plaintext mode, so just copy the
 	 * content into the record.
 	 */
-	if (!CBB_init(&cbb, TLS13_RECORD_HEADER_LEN + content_len))
+	if (!CBB_init_fixed(&cbb, out, max_out_len))
 		goto err;
 
 	if (!CBB_add_u8(&cbb, content_type))
@@ -663,142 +695,186 @@ tls13_record_layer_seal_record_plaintext(struct tls13_record_layer *rl,
 	if (!CBB_add_bytes(&body, content, content_len))
 		goto err;
 
-	if (!CBB_finish(&cbb, &data, &data_len))
-		goto err;
-
-	if (!tls13_record_set_data(rl->wrec, data, data_len))
+	if (!CBB_finish(&cbb, NULL, out_len))
 		goto err;
 
-	rl->wrec_content_len = content_len;
-	rl->wrec_content_type = content_type;
-
 	return 1;
 
  err:
 	CBB_cleanup(&cbb);
-	freezero(data, data_len);
 
 	return 0;
 }
 
 static int
 tls13_record_layer_seal_record_protected(struct tls13_record_layer *rl,
-    uint8_t content_type, const uint8_t *content, size_t content_len)
+    uint8_t content_type, const uint8_t *content, size_t content_len,
+    uint8_t *out, size_t max_out_len, size_t *out_len)
 {
-	uint8_t *data = NULL, *header = NULL, *inner = NULL;
-	size_t data_len = 0, header_len = 0, inner_len = 0;
-	uint8_t *enc_record;
-	size_t enc_record_len;
-	ssize_t ret = 0;
-	size_t out_len;
-	CBB cbb;
+	uint8_t *header, *enc_record;
+	size_t enc_record_len, inner_len, out_tag_len, tag_len;
 
 	if (rl->aead == NULL)
 		return 0;
 
-	memset(&cbb, 0, sizeof(cbb));
-
-	/* Build inner plaintext. */
-	if (!CBB_init(&cbb, content_len + 1))
-		goto err;
-	if (!CBB_add_bytes(&cbb, content, content_len))
-		goto err;
-	if (!CBB_add_u8(&cbb, content_type))
-		goto err;
+	/* Inner plaintext is the content followed by the content type. */
 	/* XXX - padding? */
-	if (!CBB_finish(&cbb, &inner, &inner_len))
-		goto err;
-
+	inner_len = content_len + 1;
 	if (inner_len > TLS13_RECORD_MAX_INNER_PLAINTEXT_LEN)
 		goto err;
 
 	/* XXX EVP_AEAD_max_tag_len vs EVP_AEAD_CTX_tag_len. */
-	enc_record_len = inner_len + EVP_AEAD_max_tag_len(rl->aead);
+	tag_len = EVP_AEAD_max_tag_len(rl->aead);
+	enc_record_len = inner_len + tag_len;
 	if (enc_record_len > TLS13_RECORD_MAX_CIPHERTEXT_LEN)
 		goto err;
-
-	/* Build the record header. */
-	if (!CBB_init(&cbb, TLS13_RECORD_HEADER_LEN))
-		goto err;
-	if (!CBB_add_u8(&cbb, SSL3_RT_APPLICATION_DATA))
-		goto err;
-	if (!CBB_add_u16(&cbb, TLS1_2_VERSION))
-		goto err;
-	if (!CBB_add_u16(&cbb, enc_record_len))
-		goto err;
-	if (!CBB_finish(&cbb, &header, &header_len))
+	if (TLS13_RECORD_HEADER_LEN + enc_record_len > max_out_len)
 		goto err;
 
-	/* Build the actual record. */
-	if (!CBB_init(&cbb, TLS13_RECORD_HEADER_LEN + enc_record_len))
-		goto err;
-	if (!CBB_add_bytes(&cbb, header, header_len))
-		goto err;
-	if (!CBB_add_space(&cbb, &enc_record, enc_record_len))
-		goto err;
-	if (!CBB_finish(&cbb, &data, &data_len))
-		goto err;
+	/*
+	 * Build the record header directly in the output buffer - this is
+	 * done by hand since a CBB would require an allocation per record.
+	 */
+	header = out;
+	enc_record = out + TLS13_RECORD_HEADER_LEN;
+
+	header[0] = SSL3_RT_APPLICATION_DATA;
+	header[1] = TLS1_2_VERSION >> 8;
+	header[2] = TLS1_2_VERSION & 0xff;
+	header[3] = enc_record_len >> 8;
+	header[4] = enc_record_len & 0xff;
 
 	if (!tls13_record_layer_update_nonce(&rl->write->nonce,
 	    &rl->write->iv, rl->write->seq_num))
 		goto err;
 
 	/*
-	 * XXX - consider a EVP_AEAD_CTX_seal_iov() that takes an iovec...
-	 * this would avoid a copy since the inner would be passed as two
-	 * separate pieces.
+	 * Encrypt the content directly from the caller's buffer, with the
+	 * content type being gathered as extra input. The encrypted content
+	 * type and tag follow the encrypted content in the output buffer.
 	 */
-	if (!EVP_AEAD_CTX_seal(rl->write->aead_ctx,
-	    enc_record, &out_len, enc_record_len,
+	if (!EVP_AEAD_CTX_seal_scatter(rl->write->aead_ctx,
+	    enc_record, enc_record + content_len, &out_tag_len,
+	    enc_record_len - content_len,
 	    rl->write->nonce.data, rl->write->nonce.len,
-	    inner, inner_len, header, header_len))
+	    content, content_len, &content_type, 1,
+	    header, TLS13_RECORD_HEADER_LEN))
 		goto err;
 
-	if (out_len != enc_record_len)
+	if (out_tag_len != 1 + tag_len)
 		goto err;
 
 	if (!tls13_record_layer_inc_seq_num(rl->write->seq_num))
 		goto err;
 
-	if (!tls13_record_set_data(rl->wrec, data, data_len))
-		goto err;
-
-	rl->wrec_content_len = content_len;
-	rl->wrec_content_type = content_type;
-
-	data = NULL;
-	data_len = 0;
+	*out_len = TLS13_RECORD_HEADER_LEN + enc_record_len;
 
-	ret = 1;
+	return 1;
 
  err:
-	CBB_cleanup(&cbb);
-
-	freezero(data, data_len);
-	freezero(header, header_len);
-	freezero(inner, inner_len);
-
-	return ret;
+	return 0;
 }
 
 static int
 tls13_record_layer_seal_record(struct tls13_record_layer *rl,
     uint8_t content_type, const uint8_t *content, size_t content_len)
 {
+	size_t out_len;
+
 	if (rl->handshake_completed && rl->aead == NULL)
 		return 0;
 
-	tls13_record_layer_wrec_free(rl);
+	if (tls13_record_layer_wrec_pending(rl))
+		return 0;
 
-	if ((rl->wrec = tls13_record_new()) == NULL)
+	/*
+	 * Release a write buffer that was grown for coalesced writes, now
+	 * that it is no longer in use.
+	 */
+	if (!rl->coalesce_writes && rl->wbuf_len > TLS13_RECORD_MAX_LEN) {
+		freezero(rl->wbuf, rl->wbuf_len);
+		rl->wbuf_len = 0;
+		if ((rl->wbuf = malloc(TLS13_RECORD_MAX_LEN)) == NULL)
+			return 0;
+		rl->wbuf_len = TLS13_RECORD_MAX_LEN;
+	}
+
+	if (rl->aead == NULL || content_type == SSL3_RT_CHANGE_CIPHER_SPEC) {
+		if (!tls13_record_layer_seal_record_plaintext(rl, content_type,
+		    content, content_len, rl->wbuf, rl->wbuf_len, &out_len))
+			return 0;
+	} else {
+		if (!tls13_record_layer_seal_record_protected(rl, content_type,
+		    content, content_len, rl->wbuf, rl->wbuf_len, &out_len))
+			return 0;
+	}
+
+	CBS_init(&rl->wrec, rl->wbuf, out_len);
+
+	rl->wrec_content_len = content_len;
+	rl->wrec_content_type = content_type;
+
+	return 1;
+}
+
+/*
+ * Seal application data into as many protected records as are needed, back
+ * to back in the write buffer, so that they can be written out together.
+ */
+static int
+tls13_record_layer_seal_records(struct tls13_record_layer *rl,
+    const uint8_t *content, size_t content_len)
+{
+	size_t max_records, record_len, wbuf_len, n;
+	size_t sealed_len = 0, total_len = content_len;
+
+	if (!rl->coalesce_writes)
+		return 0;
+
+	if (!rl->handshake_completed || rl->aead == NULL)
+		return 0;
+
+	if (tls13_record_layer_wrec_pending(rl))
 		return 0;
 
-	if (rl->aead == NULL || content_type == SSL3_RT_CHANGE_CIPHER_SPEC)
-		return tls13_record_layer_seal_record_plaintext(rl,
-		    content_type, content, content_len);
+	max_records = TLS13_RECORD_LAYER_MAX_COALESCED_RECORDS;
+	if (content_len > max_records * TLS13_RECORD_MAX_PLAINTEXT_LEN)
+		return 0;
 
-	return tls13_record_layer_seal_record_protected(rl, content_type,
-	    content, content_len);
+	/*
+	 * Grow the write buffer straight to its maximum size, rather than
+	 * reallocating each time a larger write is made.
+	 */
+	wbuf_len = max_records * TLS13_RECORD_MAX_LEN;
+	if (rl->wbuf_len < wbuf_len) {
+		freezero(rl->wbuf, rl->wbuf_len);
+		rl->wbuf_len = 0;
+		if ((rl->wbuf = malloc(wbuf_len)) == NULL)
+			return 0;
+		rl->wbuf_len = wbuf_len;
+	}
+
+	while (content_len > 0) {
+		if ((n = content_len) > TLS13_RECORD_MAX_PLAINTEXT_LEN)
+			n = TLS13_RECORD_MAX_PLAINTEXT_LEN;
+
+		if (!tls13_record_layer_seal_record_protected(rl,
+		    SSL3_RT_APPLICATION_DATA, content, n,
+		    rl->wbuf + sealed_len, rl->wbuf_len - sealed_len,
+		    &record_len))
+			return 0;
+
+		sealed_len += record_len;
+		content += n;
+		content_len -= n;
+	}
+
+	CBS_init(&rl->wrec, rl->wbuf, sealed_len);
+
+	rl->wrec_content_len = total_len;
+	rl->wrec_content_type = SSL3_RT_APPLICATION_DATA;
+
+	return 1;
 }
 
 static ssize_t
@@ -1030,6 +1106,23 @@ tls13_record_layer_read(struct tls13_record_layer *rl, uint8_t content_type,
 	return ret;
 }
 
+static ssize_t
+tls13_record_layer_send_wrec(struct tls13_record_layer *rl)
+{
+	ssize_t ret;
+
+	while (CBS_len(&rl->wrec) > 0) {
+		if ((ret = rl->cb.wire_write(CBS_data(&rl->wrec),
+		    CBS_len(&rl->wrec), rl->cb_arg)) <= 0)
+			return ret;
+
+		if (!CBS_skip(&rl->wrec, ret))
+			return TLS13_IO_FAILURE;
+	}
+
+	return TLS13_IO_SUCCESS;
+}
+
 static ssize_t
 tls13_record_layer_write_record(struct tls13_record_layer *rl,
     uint8_t content_type, const uint8_t *content, size_t content_len)
@@ -1051,11 +1144,9 @@ tls13_record_layer_write_record(struct tls13_record_layer *rl,
 	}
 
 	/* See if there is an existing record and attempt to push it out... */
-	if (rl->wrec != NULL) {
-		if ((ret = tls13_record_send(rl->wrec, rl->cb.wire_write,
-		    rl->cb_arg)) <= 0)
+	if (tls13_record_layer_wrec_pending(rl)) {
+		if ((ret = tls13_record_layer_send_wrec(rl)) <= 0)
 			return ret;
-		tls13_record_layer_wrec_free(rl);
 
 		if (rl->wrec_content_type == content_type) {
 			ret = rl->wrec_content_len;
@@ -1073,17 +1164,20 @@ tls13_record_layer_write_record(struct tls13_record_layer *rl,
 		rl->wrec_appdata_len = rl->wrec_content_len;
 	}
 
-	if (content_len > TLS13_RECORD_MAX_PLAINTEXT_LEN)
-		goto err;
-
-	if (!tls13_record_layer_seal_record(rl, content_type, content, content_len))
-		goto err;
+	if (content_len > TLS13_RECORD_MAX_PLAINTEXT_LEN) {
+		if (content_type != SSL3_RT_APPLICATION_DATA)
+			goto err;
+		if (!tls13_record_layer_seal_records(rl, content, content_len))
+			goto err;
+	} else {
+		if (!tls13_record_layer_seal_record(rl, content_type, content,
+		    content_len))
+			goto err;
+	}
 
-	if ((ret = tls13_record_send(rl->wrec, rl->cb.wire_write, rl->cb_arg)) <= 0)
+	if ((ret = tls13_record_layer_send_wrec(rl)) <= 0)
 		return ret;
 
-	tls13_record_layer_wrec_free(rl);
-
 	return content_len;
 
  err:
@@ -1094,8 +1188,19 @@ static ssize_t
 tls13_record_layer_write_chunk(struct tls13_record_layer *rl,
     uint8_t content_type, const uint8_t *buf, size_t n)
 {
-	if (n > TLS13_RECORD_MAX_PLAINTEXT_LEN)
-		n = TLS13_RECORD_MAX_PLAINTEXT_LEN;
+	size_t max_len = TLS13_RECORD_MAX_PLAINTEXT_LEN;
+
+	/*
+	 * If enabled, once the handshake has completed, large application
+	 * data writes are sealed into multiple records that are written out
+	 * together, rather than making a separate write for each record.
+	 */
+	if (rl->coalesce_writes && content_type == SSL3_RT_APPLICATION_DATA &&
+	    rl->handshake_completed && rl->aead != NULL)
+		max_len *= TLS13_RECORD_LAYER_MAX_COALESCED_RECORDS;
+
+	if (n > max_len)
+		n = max_len;
 
 	return tls13_record_layer_write_record(rl, content_type, buf, n);
 }
@@ -139,6 +139,99 @@ tls13_client_hello_required_extensions(struct tls13_ctx *ctx)
 	return 1;
 }
 
+/*
+ * Select the pre-shared key offered by the client, if any. The binder is
+ * verified over the ClientHello that has already been added to the transcript,
+ * truncated so as to exclude the binders list (RFC 8446 section 4.2.11.2).
+ */
+static int
+tls13_client_hello_select_psk(struct tls13_ctx *ctx)
+{
+	struct tls13_secret binder, psk, transcript_hash;
+	uint8_t binder_buf[EVP_MAX_MD_SIZE];
+	uint8_t hash[EVP_MAX_MD_SIZE];
+	const unsigned char *data;
+	unsigned int hash_len;
+	SSL_SESSION *sess;
+	const EVP_MD *md;
+	size_t data_len;
+	SSL *s = ctx->ssl;
+	int ret = 0;
+
+	sess = ctx->hs->tls13.psk_session;
+	ctx->hs->tls13.psk_session = NULL;
+
+	s->hit = 0;
+
+	if (sess == NULL)
+		return 1;
+
+	/*
+	 * If a HelloRetryRequest is going to be sent, the client will offer
+	 * the pre-shared key again in its second ClientHello.
+	 */
+	if (ctx->hs->key_share == NULL)
+		goto done;
+
+	/* The cipher suite hash must match that associated with the PSK. */
+	if ((md = tls13_cipher_hash(ctx->hs->cipher)) == NULL)
+		goto err;
+	if (md != tls13_cipher_hash(sess->cipher))
+		goto done;
+	if (sess->master_key_length != EVP_MD_size(md))
+		goto done;
+
+	if (ctx->hs->tls13.psk_binder_len != EVP_MD_size(md)) {
+		ctx->alert = TLS13_ALERT_DECRYPT_ERROR;
+		goto err;
+	}
+
+	if (!tls1_transcript_data(s, &data, &data_len))
+		goto err;
+	if (data_len < ctx->hs->tls13.psk_binders_len)
+		goto err;
+	if (!EVP_Digest(data, data_len - ctx->hs->tls13.psk_binders_len,
+	    hash, &hash_len, md, NULL))
+		goto err;
+
+	transcript_hash.data = hash;
+	transcript_hash.len = hash_len;
+
+	psk.data = sess->master_key;
+	psk.len = sess->master_key_length;
+
+	binder.data = binder_buf;
+	binder.len = EVP_MD_size(md);
+
+	if (!tls13_derive_psk_binder(&binder, md, &psk, 1, &transcript_hash))
+		goto err;
+
+	if (timingsafe_memcmp(binder.data, ctx->hs->tls13.psk_binder,
+	    binder.len) != 0) {
+		ctx->alert = TLS13_ALERT_DECRYPT_ERROR;
+		goto err;
+	}
+
+	/* Resume the session from the ticket. */
+	sess->ciphers = s->session->ciphers;
+	s->session->ciphers = NULL;
+	SSL_SESSION_free(s->session);
+	s->session = sess;
+	sess = NULL;
+
+	s->verify_result = s->session->verify_result;
+	s->hit = 1;
+
+ done:
+	ret = 1;
+
+ err:
+	explicit_bzero(binder_buf, sizeof(binder_buf));
+	SSL_SESSION_free(sess);
+
+	return ret;
+}
+
 static const uint8_t tls13_compression_null_only[] = { 0 };
 
 static int
@@ -279,6 +372,12 @@ tls13_client_hello_process(struct tls13_ctx *ctx, CBS *cbs)
 	s->session->ciphers = ciphers;
 	ciphers = NULL;
 
+	if (!tls13_client_hello_select_psk(ctx)) {
+		if (ctx->alert == 0)
+			ctx->alert = TLS13_ALERT_INTERNAL_ERROR;
+		goto err;
+	}
+
 	/* Ensure only the NULL compression method is advertised. */
 	if (!CBS_mem_equal(&compression_methods, tls13_compression_null_only,
 	    sizeof(tls13_compression_null_only))) {
@@ -375,6 +474,8 @@ tls13_server_engage_record_protection(struct tls13_ctx *ctx)
 	unsigned char buf[EVP_MAX_MD_SIZE];
 	uint8_t *shared_key = NULL;
 	size_t shared_key_len = 0;
+	uint8_t *psk;
+	size_t psk_len;
 	size_t hash_len;
 	SSL *s = ctx->ssl;
 	int ret = 0;
@@ -390,7 +491,7 @@ tls13_server_engage_record_protection(struct tls13_ctx *ctx)
 	if ((ctx->hash = tls13_cipher_hash(ctx->hs->cipher)) == NULL)
 		goto err;
 
-	if ((secrets = tls13_secrets_create(ctx->hash, 0)) == NULL)
+	if ((secrets = tls13_secrets_create(ctx->hash, s->hit)) == NULL)
 		goto err;
 	ctx->hs->tls13.secrets = secrets;
 
@@ -403,9 +504,14 @@ tls13_server_engage_record_protection(struct tls13_ctx *ctx)
 	context.data = buf;
 	context.len = hash_len;
 
-	/* Early secrets. */
-	if (!tls13_derive_early_secrets(secrets, secrets->zeros.data,
-	    secrets->zeros.len, &context))
+	/* Early secrets, using the resumption PSK if one was selected. */
+	psk = secrets->zeros.data;
+	psk_len = secrets->zeros.len;
+	if (s->hit) {
+		psk = s->session->master_key;
+		psk_len = s->session->master_key_length;
+	}
+	if (!tls13_derive_early_secrets(secrets, psk, psk_len, &context))
 		goto err;
 
 	/* Handshake secrets. */
@@ -424,7 +530,9 @@ tls13_server_engage_record_protection(struct tls13_ctx *ctx)
 		goto err;
 
 	ctx->handshake_stage.hs_type |= NEGOTIATED;
-	if (!(SSL_get_verify_mode(s) & SSL_VERIFY_PEER))
+	if (s->hit)
+		ctx->handshake_stage.hs_type |= WITH_PSK;
+	else if (!(SSL_get_verify_mode(s) & SSL_VERIFY_PEER))
 		ctx->handshake_stage.hs_type |= WITHOUT_CR;
 
 	ret = 1;
@@ -632,6 +740,7 @@ tls13_server_certificate_send(struct tls13_ctx *ctx, CBB *cbb)
 {
 	SSL *s = ctx->ssl;
 	CBB cert_request_context, cert_list;
+	CBS chain_der;
 	const struct ssl_sigalg *sigalg;
 	X509_STORE_CTX *xsc = NULL;
 	STACK_OF(X509) *chain;
@@ -653,10 +762,21 @@ tls13_server_certificate_send(struct tls13_ctx *ctx, CBB *cbb)
 	ctx->hs->tls13.cpk = cpk;
 	ctx->hs->our_sigalg = sigalg;
 
-	if ((chain = cpk->chain) == NULL)
-		chain = s->ctx->extra_certs;
+	if (!CBB_add_u8_length_prefixed(cbb, &cert_request_context))
+		goto err;
+	if (!CBB_add_u24_length_prefixed(cbb, &cert_list))
+		goto err;
+
+	/* The certificate and any chain that it has are already encoded. */
+	ssl_cert_pkey_chain_der(cpk, &chain_der);
+	if (!tls13_cert_add_chain_der(ctx, &cert_list, &chain_der,
+	    tlsext_server_build, NULL))
+		goto err;
+	if (cpk->chain != NULL)
+		goto done;
 
-	if (chain == NULL && !(s->mode & SSL_MODE_NO_AUTO_CHAIN)) {
+	if ((chain = s->ctx->extra_certs) == NULL &&
+	    !(s->mode & SSL_MODE_NO_AUTO_CHAIN)) {
 		if ((xsc = X509_STORE_CTX_new()) == NULL)
 			goto err;
 		if (!X509_STORE_CTX_init(xsc, s->ctx->cert_store, cpk->x509, NULL))
@@ -668,14 +788,6 @@ tls13_server_certificate_send(struct tls13_ctx *ctx, CBB *cbb)
 		chain = X509_STORE_CTX_get0_chain(xsc);
 	}
 
-	if (!CBB_add_u8_length_prefixed(cbb, &cert_request_context))
-		goto err;
-	if (!CBB_add_u24_length_prefixed(cbb, &cert_list))
-		goto err;
-
-	if (!tls13_cert_add(ctx, &cert_list, cpk->x509, tlsext_server_build))
-		goto err;
-
 	for (i = 0; i < sk_X509_num(chain); i++) {
 		cert = sk_X509_value(chain, i);
 
@@ -696,6 +808,7 @@ tls13_server_certificate_send(struct tls13_ctx *ctx, CBB *cbb)
 			goto err;
 	}
 
+ done:
 	if (!CBB_flush(cbb))
 		goto err;
 
@@ -1022,6 +1135,110 @@ tls13_client_certificate_verify_recv(struct tls13_ctx *ctx, CBS *cbs)
 	return ret;
 }
 
+/*
+ * Send a NewSessionTicket, which allows the client to resume the current
+ * session using a pre-shared key (RFC 8446 section 4.6.1). The ticket is
+ * stateless and contains the session, encrypted using the ticket keys.
+ */
+static int
+tls13_server_new_session_ticket_send(struct tls13_ctx *ctx)
+{
+	struct tls13_secrets *secrets = ctx->hs->tls13.secrets;
+	struct tls13_handshake_msg *hs_msg = NULL;
+	struct tls13_secret nonce, psk;
+	CBB cbb, nonce_cbb, ticket_nonce, ticket;
+	uint8_t nonce_buf[4];
+	SSL_SESSION *sess = NULL;
+	uint32_t lifetime;
+	SSL *s = ctx->ssl;
+	ssize_t ret;
+	CBS cbs;
+
+	memset(&nonce_cbb, 0, sizeof(nonce_cbb));
+
+	if ((SSL_get_options(s) & SSL_OP_NO_TICKET) != 0)
+		return 1;
+	if (SSL_is_quic(s) || s->session->not_resumable)
+		return 1;
+
+	/* A ticket is of no use unless the client supports psk_dhe_ke. */
+	if (!ctx->hs->tls13.use_psk_dhe_ke)
+		return 1;
+
+	/* Each ticket issued on a connection must have a unique nonce. */
+	if (!CBB_init_fixed(&nonce_cbb, nonce_buf, sizeof(nonce_buf)))
+		goto err;
+	if (!CBB_add_u32(&nonce_cbb, ctx->tickets_sent))
+		goto err;
+	if (!CBB_finish(&nonce_cbb, NULL, NULL))
+		goto err;
+	nonce.data = nonce_buf;
+	nonce.len = sizeof(nonce_buf);
+
+	if ((sess = ssl_session_dup(s->session, 0)) == NULL)
+		goto err;
+
+	sess->time = time(NULL);
+	sess->ssl_version = TLS1_3_VERSION;
+
+	lifetime = TLS13_MAX_TICKET_LIFETIME;
+	if (sess->timeout > 0 && sess->timeout < lifetime)
+		lifetime = sess->timeout;
+	sess->tlsext_tick_lifetime_hint = lifetime;
+	sess->tlsext_tick_age_add = arc4random();
+
+	/* The resumption PSK is stored as the session master key. */
+	psk.data = sess->master_key;
+	psk.len = EVP_MD_size(secrets->digest);
+	if (psk.len > sizeof(sess->master_key))
+		goto err;
+	if (!tls13_derive_secret(&psk, secrets->digest,
+	    &secrets->resumption_master, "resumption", &nonce))
+		goto err;
+	sess->master_key_length = psk.len;
+
+	if ((hs_msg = tls13_handshake_msg_new()) == NULL)
+		goto err;
+	if (!tls13_handshake_msg_start(hs_msg, &cbb,
+	    TLS13_MT_NEW_SESSION_TICKET))
+		goto err;
+	if (!CBB_add_u32(&cbb, lifetime))
+		goto err;
+	if (!CBB_add_u32(&cbb, sess->tlsext_tick_age_add))
+		goto err;
+	if (!CBB_add_u8_length_prefixed(&cbb, &ticket_nonce))
+		goto err;
+	if (!CBB_add_bytes(&ticket_nonce, nonce.data, nonce.len))
+		goto err;
+	if (!CBB_add_u16_length_prefixed(&cbb, &ticket))
+		goto err;
+	if (!tls1_encrypt_ticket(s, sess, &ticket))
+		goto err;
+	if (!tlsext_server_build(s, SSL_TLSEXT_MSG_NST, &cbb))
+		goto err;
+	if (!tls13_handshake_msg_finish(hs_msg))
+		goto err;
+
+	tls13_handshake_msg_data(hs_msg, &cbs);
+	ret = tls13_record_layer_phh(ctx->rl, &cbs);
+
+	ctx->tickets_sent++;
+
+	tls13_handshake_msg_free(hs_msg);
+	SSL_SESSION_free(sess);
+
+	/* The ticket is flushed with the next write, if it cannot be sent. */
+	return ret == TLS13_IO_SUCCESS || ret == TLS13_IO_WANT_POLLOUT ||
+	    ret == TLS13_IO_WANT_RETRY;
+
+ err:
+	CBB_cleanup(&nonce_cbb);
+	tls13_handshake_msg_free(hs_msg);
+	SSL_SESSION_free(sess);
+
+	return 0;
+}
+
 int
 tls13_client_end_of_early_data_recv(struct tls13_ctx *ctx, CBS *cbs)
 {
@@ -1037,6 +1254,8 @@ tls13_client_finished_recv(struct tls13_ctx *ctx, CBS *cbs)
 	uint8_t *verify_data = NULL;
 	size_t verify_data_len;
 	uint8_t key[EVP_MAX_MD_SIZE];
+	uint8_t transcript_hash[EVP_MAX_MD_SIZE];
+	size_t transcript_hash_len;
 	HMAC_CTX *hmac_ctx = NULL;
 	unsigned int hlen;
 	int ret = 0;
@@ -1091,6 +1310,27 @@ tls13_client_finished_recv(struct tls13_ctx *ctx, CBS *cbs)
 
 	tls13_record_layer_allow_ccs(ctx->rl, 0);
 
+	/*
+	 * The transcript now includes the client finished message, which
+	 * completes the context for the resumption master secret.
+	 */
+	if (!tls1_transcript_hash_value(ctx->ssl, transcript_hash,
+	    sizeof(transcript_hash), &transcript_hash_len))
+		goto err;
+	context.data = transcript_hash;
+	context.len = transcript_hash_len;
+	if (!tls13_derive_resumption_master_secret(secrets, &context))
+		goto err;
+
+	/*
+	 * A ticket is optional - failing to issue one must not fail a
+	 * handshake that has otherwise completed. Any errors are dropped
+	 * from the queue, so that a later SSL_get_error() is not affected.
+	 */
+	ERR_set_mark();
+	(void)tls13_server_new_session_ticket_send(ctx);
+	ERR_pop_to_mark();
+
 	ret = 1;
 
  err:
@@ -187,6 +187,81 @@ run_aead_test(const EVP_AEAD *aead, unsigned char bufs[NUM_TYPES][BUF_MAX],
 	return ret;
 }
 
+/*
+ * Seal with the input split at every possible point between the input and the
+ * extra input, ensuring that the result matches the test vector.
+ */
+static int
+run_aead_seal_scatter_test(const EVP_AEAD *aead,
+    unsigned char bufs[NUM_TYPES][BUF_MAX],
+    const unsigned int lengths[NUM_TYPES], unsigned int line_no)
+{
+	EVP_AEAD_CTX *ctx;
+	unsigned char out[BUF_MAX], out_tag[BUF_MAX + EVP_AEAD_MAX_TAG_LENGTH];
+	size_t extra_in_len, in_len, out_tag_len;
+	int ret = 0;
+
+	if ((ctx = EVP_AEAD_CTX_new()) == NULL) {
+		fprintf(stderr, "Failed to allocate AEAD context on line %u\n",
+		    line_no);
+		goto err;
+	}
+
+	if (!EVP_AEAD_CTX_init(ctx, aead, bufs[KEY], lengths[KEY],
+	    lengths[TAG], NULL)) {
+		fprintf(stderr, "Failed to init AEAD on line %u\n", line_no);
+		goto err;
+	}
+
+	for (in_len = 0; in_len <= lengths[IN]; in_len++) {
+		extra_in_len = lengths[IN] - in_len;
+
+		if (!EVP_AEAD_CTX_seal_scatter(ctx, out, out_tag, &out_tag_len,
+		    sizeof(out_tag), bufs[NONCE], lengths[NONCE], bufs[IN],
+		    in_len, bufs[IN] + in_len, extra_in_len, bufs[AD],
+		    lengths[AD])) {
+			fprintf(stderr, "Failed to run scatter AEAD on line %u "
+			    "(split %zu)\n", line_no, in_len);
+			goto err;
+		}
+
+		if (out_tag_len != extra_in_len + lengths[TAG]) {
+			fprintf(stderr, "Bad scatter output length on line %u "
+			    "(split %zu): %zu\n", line_no, in_len, out_tag_len);
+			goto err;
+		}
+
+		if (memcmp(out, bufs[CT], in_len) != 0 ||
+		    memcmp(out_tag, bufs[CT] + in_len, extra_in_len) != 0) {
+			fprintf(stderr, "Bad scatter output on line %u "
+			    "(split %zu)\n", line_no, in_len);
+			goto err;
+		}
+
+		if (memcmp(out_tag + extra_in_len, bufs[TAG],
+		    lengths[TAG]) != 0) {
+			fprintf(stderr, "Bad scatter tag on line %u "
+			    "(split %zu)\n", line_no, in_len);
+			goto err;
+		}
+	}
+
+	if (EVP_AEAD_CTX_seal_scatter(ctx, out, out_tag, &out_tag_len,
+	    lengths[TAG] - 1, bufs[NONCE], lengths[NONCE], bufs[IN],
+	    lengths[IN], NULL, 0, bufs[AD], lengths[AD])) {
+		fprintf(stderr, "Scatter AEAD succeeded with a short tag buffer "
+		    "on line %u\n", line_no);
+		goto err;
+	}
+
+	ret = 1;
+
+ err:
+	EVP_AEAD_CTX_free(ctx);
+
+	return ret;
+}
+
 static int
 run_cipher_aead_encrypt_test(const EVP_CIPHER *cipher,
     unsigned char bufs[NUM_TYPES][BUF_MAX],
@@ -451,6 +526,9 @@ main(int argc, char **argv)
 				if (!run_aead_test(aead, bufs, lengths,
 				    line_no))
 					return 4;
+				if (!run_aead_seal_scatter_test(aead, bufs,
+				    lengths, line_no))
+					return 4;
 			}
 			if (cipher != NULL) {
 				if (!run_cipher_aead_test(cipher, bufs, lengths,
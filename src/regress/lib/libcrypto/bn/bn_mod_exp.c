@@ -139,16 +139,13 @@ test_mod_exp(const BIGNUM *result_simple, const BIGNUM *a, const BIGNUM *b,
 	return ret;
 }
 
-int
-main(int argc, char *argv[])
+static int
+test_mod_exp_bits(BN_CTX *ctx, int num_bits, int iterations)
 {
 	BIGNUM *result_simple, *a, *b, *m;
-	BN_CTX *ctx;
 	int c, i;
 	size_t j;
-
-	if ((ctx = BN_CTX_new()) == NULL)
-		goto err;
+	int ret = 0;
 
 	BN_CTX_start(ctx);
 
@@ -161,17 +158,17 @@ main(int argc, char *argv[])
 	if ((result_simple = BN_CTX_get(ctx)) == NULL)
 		goto err;
 
-	for (i = 0; i < 200; i++) {
+	for (i = 0; i < iterations; i++) {
 		c = arc4random() % BN_BITS - BN_BITS2;
-		if (!BN_rand(a, NUM_BITS + c, 0, 0))
+		if (!BN_rand(a, num_bits + c, 0, 0))
 			goto err;
 
 		c = arc4random() % BN_BITS - BN_BITS2;
-		if (!BN_rand(b, NUM_BITS + c, 0, 0))
+		if (!BN_rand(b, num_bits + c, 0, 0))
 			goto err;
 
 		c = arc4random() % BN_BITS - BN_BITS2;
-		if (!BN_rand(m, NUM_BITS + c, 0, 1))
+		if (!BN_rand(m, num_bits + c, 0, 1))
 			goto err;
 
 		if (!BN_mod(a, a, m, ctx))
@@ -192,15 +189,43 @@ main(int argc, char *argv[])
 		}
 	}
 
+	ret = 1;
+
+ err:
 	BN_CTX_end(ctx);
-	BN_CTX_free(ctx);
 
-	return 0;
+	return ret;
+}
+
+int
+main(int argc, char *argv[])
+{
+	BN_CTX *ctx;
+	int failed = 1;
+
+	if ((ctx = BN_CTX_new()) == NULL)
+		goto err;
+
+	if (!test_mod_exp_bits(ctx, NUM_BITS, 200))
+		goto err;
+
+	/*
+	 * Moduli of RSA key sizes, which use the word-unrolled (and where
+	 * available MULX/ADX) Montgomery multiplication and squaring.
+	 */
+	if (!test_mod_exp_bits(ctx, 512, 20))
+		goto err;
+	if (!test_mod_exp_bits(ctx, 1024, 10))
+		goto err;
+	if (!test_mod_exp_bits(ctx, 1536, 5))
+		goto err;
+
+	failed = 0;
 
  err:
-	BN_CTX_end(ctx);
 	BN_CTX_free(ctx);
-	ERR_print_errors_fp(stdout);
+	if (failed)
+		ERR_print_errors_fp(stdout);
 
-	return 1;
+	return failed;
 }
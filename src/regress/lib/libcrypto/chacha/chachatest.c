@@ -456,6 +456,80 @@ crypto_xchacha_20_test(void)
 	return (failed);
 }
 
+/*
+ * Compare bulk encryption, which may process several blocks at a time,
+ * against single byte writes, which always use the one block code. Block
+ * counters are chosen to cross the 32-bit boundary inside a bulk call.
+ */
+static int
+chacha_multiblock_test(void)
+{
+	static const size_t lens[] = {
+		255, 256, 257, 511, 512, 513, 1000, 4096 + 7,
+	};
+	static const uint64_t counters[] = {
+		0, 0xfffffffbULL, 0x1fffffff9ULL,
+	};
+	unsigned char key[32], iv[8], ctr[8];
+	unsigned char *in, *bulk, *single;
+	ChaCha_ctx ctx;
+	size_t i, j, k;
+	int failed = 0;
+
+	if ((in = calloc(1, 8192)) == NULL)
+		errx(1, "calloc in");
+	if ((bulk = calloc(1, 8192)) == NULL)
+		errx(1, "calloc bulk");
+	if ((single = calloc(1, 8192)) == NULL)
+		errx(1, "calloc single");
+
+	arc4random_buf(key, sizeof(key));
+	arc4random_buf(iv, sizeof(iv));
+	arc4random_buf(in, 8192);
+
+	for (i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+		for (j = 0; j < sizeof(counters) / sizeof(counters[0]); j++) {
+			for (k = 0; k < sizeof(ctr); k++)
+				ctr[k] = counters[j] >> (8 * k);
+
+			CRYPTO_chacha_20(bulk, in, lens[i], key, iv,
+			    counters[j]);
+
+			ChaCha_set_key(&ctx, key, 256);
+			ChaCha_set_iv(&ctx, iv, ctr);
+			for (k = 0; k < lens[i]; k++)
+				ChaCha(&ctx, single + k, in + k, 1);
+
+			if (memcmp(bulk, single, lens[i]) != 0) {
+				printf("ChaCha multi-block failed for length "
+				    "%zu, counter %llx\n", lens[i],
+				    (unsigned long long)counters[j]);
+				failed = 1;
+			}
+
+			/* In place, continuing after a partial block. */
+			memcpy(bulk, in, lens[i]);
+			ChaCha_set_key(&ctx, key, 256);
+			ChaCha_set_iv(&ctx, iv, ctr);
+			ChaCha(&ctx, bulk, bulk, 3);
+			ChaCha(&ctx, bulk + 3, bulk + 3, lens[i] - 3);
+
+			if (memcmp(bulk, single, lens[i]) != 0) {
+				printf("ChaCha multi-block in place failed for "
+				    "length %zu, counter %llx\n", lens[i],
+				    (unsigned long long)counters[j]);
+				failed = 1;
+			}
+		}
+	}
+
+	free(in);
+	free(bulk);
+	free(single);
+
+	return failed;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -505,5 +579,8 @@ main(int argc, char **argv)
 	if (crypto_xchacha_20_test() != 0)
 		failed = 1;
 
+	if (chacha_multiblock_test() != 0)
+		failed = 1;
+
 	return failed;
 }
@@ -387,6 +387,275 @@ dump_info(const uint8_t *message, size_t message_len, const uint8_t *public_key,
 	}
 }
 
+/*
+ * Sign the previous signature 1000 times with the key from the first RFC 8032
+ * test vector, verifying each signature along the way. The final signature
+ * was computed with the ten limb field implementation.
+ */
+static int
+test_ED25519_iterated(void)
+{
+	static const uint8_t kExpected[ED25519_SIGNATURE_LENGTH] = {
+		0x63, 0x87, 0x62, 0xf5, 0x88, 0x3f, 0x27, 0x11,
+		0x41, 0xfc, 0xb4, 0x24, 0xab, 0x8d, 0x9b, 0x93,
+		0x65, 0xb7, 0x67, 0x4e, 0x93, 0xe4, 0x0c, 0xf1,
+		0x03, 0xe9, 0x38, 0xca, 0x35, 0x1c, 0xb7, 0x31,
+		0xc9, 0x5a, 0xd2, 0xd4, 0xf5, 0x84, 0x6b, 0x34,
+		0x0a, 0x8b, 0xd1, 0x38, 0x92, 0xf7, 0x80, 0xb4,
+		0x6b, 0x8a, 0x9f, 0xa1, 0x22, 0x85, 0x63, 0x47,
+		0x05, 0x77, 0xd9, 0x05, 0xaa, 0x71, 0x82, 0x0c,
+	};
+	const struct testvector *tc = &testvectors[0];
+	uint8_t signature[ED25519_SIGNATURE_LENGTH];
+	uint8_t message[ED25519_SIGNATURE_LENGTH];
+	int i;
+
+	memset(message, 0, sizeof(message));
+
+	for (i = 0; i < 1000; i++) {
+		if (!ED25519_sign(signature, message, sizeof(message),
+		    tc->pub_key, tc->sec_key)) {
+			warnx("failed signature in iteration %d", i);
+			return 1;
+		}
+		if (!ED25519_verify(message, sizeof(message), signature,
+		    tc->pub_key)) {
+			warnx("failed verification in iteration %d", i);
+			return 1;
+		}
+		memcpy(message, signature, sizeof(message));
+	}
+
+	if (memcmp(kExpected, signature, sizeof(signature)) != 0) {
+		warnx("iterated signature mismatch");
+		fprintf(stderr, "got:\n");
+		hexdump(signature, sizeof(signature));
+		fprintf(stderr, "want:\n");
+		hexdump(kExpected, sizeof(kExpected));
+		return 1;
+	}
+
+	return 0;
+}
+
+#define BATCH_MAX	1100
+
+struct batch {
+	uint8_t public_keys[BATCH_MAX][ED25519_PUBLIC_KEY_LENGTH];
+	uint8_t signatures[BATCH_MAX][ED25519_SIGNATURE_LENGTH];
+	uint8_t messages[BATCH_MAX][32];
+	const uint8_t *public_key_ptrs[BATCH_MAX];
+	const uint8_t *signature_ptrs[BATCH_MAX];
+	const uint8_t *message_ptrs[BATCH_MAX];
+	size_t message_lens[BATCH_MAX];
+	int valid[BATCH_MAX];
+};
+
+static int
+batch_check(struct batch *b, size_t num, const char *desc)
+{
+	size_t i;
+	int want = 1;
+
+	for (i = 0; i < num; i++) {
+		b->valid[i] = -1;
+		if (!ED25519_verify(b->message_ptrs[i], b->message_lens[i],
+		    b->signature_ptrs[i], b->public_key_ptrs[i]))
+			want = 0;
+	}
+
+	if (ED25519_verify_batch(b->message_ptrs, b->message_lens,
+	    b->signature_ptrs, b->public_key_ptrs, num, NULL) != want) {
+		warnx("%s: batch of %zu without results: want %d", desc,
+		    num, want);
+		return 1;
+	}
+	if (ED25519_verify_batch(b->message_ptrs, b->message_lens,
+	    b->signature_ptrs, b->public_key_ptrs, num, b->valid) != want) {
+		warnx("%s: batch of %zu: want %d", desc, num, want);
+		return 1;
+	}
+	for (i = 0; i < num; i++) {
+		if (b->valid[i] != ED25519_verify(b->message_ptrs[i],
+		    b->message_lens[i], b->signature_ptrs[i],
+		    b->public_key_ptrs[i])) {
+			warnx("%s: batch of %zu: wrong result %d for entry %zu",
+			    desc, num, b->valid[i], i);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int
+test_ED25519_verify_batch(void)
+{
+	static const size_t sizes[] = { 0, 1, 15, 16, 17, 64, 257, BATCH_MAX };
+	uint8_t private_key[ED25519_PRIVATE_KEY_LENGTH];
+	struct batch *b;
+	size_t i, j, num;
+	int failed = 1;
+
+	if ((b = calloc(1, sizeof(*b))) == NULL)
+		errx(1, "calloc");
+
+	for (i = 0; i < BATCH_MAX; i++) {
+		/* Reuse a few keys so that keys repeat within a batch. */
+		if (i % 3 != 2)
+			ED25519_keypair(b->public_keys[i], private_key);
+		else
+			memcpy(b->public_keys[i], b->public_keys[i - 1],
+			    ED25519_PUBLIC_KEY_LENGTH);
+		arc4random_buf(b->messages[i], sizeof(b->messages[i]));
+		b->message_lens[i] = i % sizeof(b->messages[i]);
+		if (!ED25519_sign(b->signatures[i], b->messages[i],
+		    b->message_lens[i], b->public_keys[i], private_key)) {
+			warnx("failed signature in batch entry %zu", i);
+			goto err;
+		}
+		b->public_key_ptrs[i] = b->public_keys[i];
+		b->signature_ptrs[i] = b->signatures[i];
+		b->message_ptrs[i] = b->messages[i];
+	}
+
+	/* The RFC 8032 test vectors go first. */
+	for (i = 0; i < num_testvectors; i++) {
+		const struct testvector *tc = &testvectors[i];
+
+		b->public_key_ptrs[i] = tc->pub_key;
+		b->signature_ptrs[i] = tc->signature;
+		b->message_ptrs[i] = tc->message;
+		b->message_lens[i] = tc->message_len;
+	}
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		if (batch_check(b, sizes[i], "valid"))
+			goto err;
+	}
+
+	/* Corrupt one entry, then several, in different ways. */
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		if ((num = sizes[i]) == 0)
+			continue;
+
+		j = arc4random_uniform(num);
+		b->signatures[j][arc4random_uniform(64)] ^= 0x10;
+		b->signature_ptrs[j] = b->signatures[j];
+		if (batch_check(b, num, "bad signature"))
+			goto err;
+
+		j = arc4random_uniform(num);
+		b->messages[j][0] ^= 1;
+		b->message_ptrs[j] = b->messages[j];
+		b->message_lens[j] = sizeof(b->messages[j]);
+		if (batch_check(b, num, "bad message"))
+			goto err;
+
+		j = arc4random_uniform(num);
+		b->public_key_ptrs[j] = b->public_keys[(j + 1) % BATCH_MAX];
+		if (batch_check(b, num, "wrong key"))
+			goto err;
+
+		/* An s that is not reduced must be rejected. */
+		j = arc4random_uniform(num);
+		memcpy(b->signatures[j], b->signature_ptrs[j],
+		    ED25519_SIGNATURE_LENGTH);
+		memset(b->signatures[j] + 32, 0xff, 31);
+		b->signatures[j][63] = 0x1f;
+		b->signature_ptrs[j] = b->signatures[j];
+		if (batch_check(b, num, "unreduced s"))
+			goto err;
+	}
+
+	failed = 0;
+
+ err:
+	free(b);
+
+	return failed;
+}
+
+/*
+ * The public key from the first RFC 8032 test vector with a point of order 8
+ * added to it. Signatures made with the matching private key satisfy the
+ * cofactored verification equation, but only satisfy the cofactorless one
+ * checked by ED25519_verify() if the hash is a multiple of 8.
+ */
+static const uint8_t torsion_pub_key[ED25519_PUBLIC_KEY_LENGTH] = {
+	0x91, 0x58, 0x31, 0x2a, 0x9a, 0x8d, 0x6e, 0x3b,
+	0x34, 0xc8, 0x91, 0xd6, 0xd6, 0x14, 0x44, 0xf8,
+	0xb8, 0x21, 0x1c, 0x51, 0x17, 0xeb, 0xad, 0x15,
+	0xbd, 0xb0, 0xbd, 0x68, 0xb0, 0x7e, 0x02, 0x45,
+};
+
+#define TORSION_BATCH_MAX	20
+
+/*
+ * A signature by a key with a small order component must get the same result
+ * whether it is checked in a batch that is small enough to be verified one
+ * signature at a time or in one that is large enough to be combined.
+ */
+static int
+test_ED25519_verify_batch_torsion(void)
+{
+	static const size_t sizes[] = { 1, 10, TORSION_BATCH_MAX };
+	uint8_t public_keys[TORSION_BATCH_MAX][ED25519_PUBLIC_KEY_LENGTH];
+	uint8_t signatures[TORSION_BATCH_MAX][ED25519_SIGNATURE_LENGTH];
+	uint8_t messages[TORSION_BATCH_MAX][32];
+	uint8_t private_key[ED25519_PRIVATE_KEY_LENGTH];
+	const uint8_t *public_key_ptrs[TORSION_BATCH_MAX];
+	const uint8_t *signature_ptrs[TORSION_BATCH_MAX];
+	const uint8_t *message_ptrs[TORSION_BATCH_MAX];
+	size_t message_lens[TORSION_BATCH_MAX];
+	int valid[TORSION_BATCH_MAX];
+	size_t i;
+	int ret;
+
+	for (i = 0; i < TORSION_BATCH_MAX; i++) {
+		ED25519_keypair(public_keys[i], private_key);
+		arc4random_buf(messages[i], sizeof(messages[i]));
+		if (!ED25519_sign(signatures[i], messages[i],
+		    sizeof(messages[i]), public_keys[i], private_key))
+			errx(1, "failed signature in batch entry %zu", i);
+		public_key_ptrs[i] = public_keys[i];
+		signature_ptrs[i] = signatures[i];
+		message_ptrs[i] = messages[i];
+		message_lens[i] = sizeof(messages[i]);
+	}
+
+	/* Find a message for which ED25519_verify() rejects the signature. */
+	memcpy(public_keys[0], torsion_pub_key, sizeof(torsion_pub_key));
+	memset(messages[0], 0, sizeof(messages[0]));
+	for (i = 0; i < 256; i++) {
+		messages[0][0] = i;
+		if (!ED25519_sign(signatures[0], messages[0],
+		    sizeof(messages[0]), public_keys[0],
+		    testvectors[0].sec_key))
+			errx(1, "failed torsion signature");
+		if (!ED25519_verify(messages[0], sizeof(messages[0]),
+		    signatures[0], public_keys[0]))
+			break;
+	}
+	if (i == 256) {
+		warnx("torsion signature always verifies");
+		return 1;
+	}
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		memset(valid, 0xff, sizeof(valid));
+		ret = ED25519_verify_batch(message_ptrs, message_lens,
+		    signature_ptrs, public_key_ptrs, sizes[i], valid);
+		if (valid[0] != 1 || ret != 1) {
+			warnx("torsion batch of %zu: got %d, returned %d, "
+			    "want 1", sizes[i], valid[0], ret);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
 /*
  * Little-endian representation of the order of edwards25519,
  * see https://www.rfc-editor.org/rfc/rfc7748#section-4.1
@@ -468,6 +737,9 @@ main(int argc, char *argv[])
 
 	failed |= test_ED25519_verify();
 	failed |= test_ED25519_sign();
+	failed |= test_ED25519_iterated();
+	failed |= test_ED25519_verify_batch();
+	failed |= test_ED25519_verify_batch_torsion();
 	failed |= test_ED25519_signature_malleability();
 
 	return failed;
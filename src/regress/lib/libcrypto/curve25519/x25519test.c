@@ -128,6 +128,73 @@ x25519_small_order_test(void)
 	return 0;
 }
 
+/*
+ * Points given with the top bit set or with a non-canonical u-coordinate
+ * (u + p < 2^255) must give the same result as the canonical encoding.
+ */
+static int
+x25519_noncanonical_test(void)
+{
+	static const uint8_t kPoint[32] = {
+		0xe6, 0xdb, 0x68, 0x67, 0x58, 0x30, 0x30, 0xdb,
+		0x35, 0x94, 0xc1, 0xa4, 0x24, 0xb1, 0x5f, 0x7c,
+		0x72, 0x66, 0x24, 0xec, 0x26, 0xb3, 0x35, 0x3b,
+		0x10, 0xa9, 0x03, 0xa6, 0xd0, 0xab, 0x1c, 0x4c,
+	};
+	uint8_t scalar[32], point[32], out[32], expected[32];
+	unsigned i, u;
+
+	memset(scalar, 0x5a, sizeof(scalar));
+
+	memcpy(point, kPoint, sizeof(point));
+	if (!X25519(expected, scalar, point)) {
+		fprintf(stderr, "X25519 failed\n");
+		return 1;
+	}
+	point[31] |= 0x80;
+	if (!X25519(out, scalar, point) ||
+	    memcmp(expected, out, sizeof(out)) != 0) {
+		fprintf(stderr, "X25519 did not ignore the top bit\n");
+		return 1;
+	}
+
+	for (u = 2; u < 19; u++) {
+		memset(point, 0, sizeof(point));
+		point[0] = u;
+		if (!X25519(expected, scalar, point))
+			continue;
+
+		/* p + u, with p = 2^255 - 19. */
+		memset(point, 0xff, sizeof(point));
+		point[0] = 0xed + u;
+		point[31] = 0x7f;
+		if (!X25519(out, scalar, point) ||
+		    memcmp(expected, out, sizeof(out)) != 0) {
+			fprintf(stderr, "X25519 non-canonical test failed "
+			    "for u = p + %u\n", u);
+			return 1;
+		}
+	}
+
+	for (i = 0; i < sizeof(scalar); i++)
+		scalar[i] = i * 13 + 7;
+	memset(point, 0xff, sizeof(point));
+	if (!X25519(expected, scalar, point)) {
+		fprintf(stderr, "X25519 failed for u = 2^256 - 1\n");
+		return 1;
+	}
+	memset(point, 0, sizeof(point));
+	point[0] = 18;
+	if (!X25519(out, scalar, point) ||
+	    memcmp(expected, out, sizeof(out)) != 0) {
+		fprintf(stderr, "X25519 non-canonical test failed "
+		    "for u = 2^256 - 1\n");
+		return 1;
+	}
+
+	return 0;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -136,6 +203,7 @@ main(int argc, char **argv)
 	failed |= x25519_test();
 	failed |= x25519_iterated_test();
 	failed |= x25519_small_order_test();
+	failed |= x25519_noncanonical_test();
 
 	return failed;
 }
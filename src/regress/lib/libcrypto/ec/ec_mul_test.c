@@ -0,0 +1,502 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sys/time.h>
+
+#include <err.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/objects.h>
+
+#define EC_MUL_TEST_RANDOM	100
+
+static const int ec_mul_test_nids[] = {
+	NID_secp224r1,
+	NID_X9_62_prime256v1,
+	NID_secp384r1,
+	NID_secp521r1,
+};
+
+#define N_EC_MUL_TEST_NIDS \
+    (sizeof(ec_mul_test_nids) / sizeof(ec_mul_test_nids[0]))
+
+/*
+ * Compare scalar * G, which may use a precomputed generator table, against
+ * scalar * P with P = G, which always uses the generic ladder.
+ */
+static int
+ec_mul_compare(const char *name, const EC_GROUP *group, const BIGNUM *scalar,
+    BN_CTX *ctx)
+{
+	const EC_POINT *generator;
+	EC_POINT *fixed = NULL, *variable = NULL;
+	char *hex = NULL;
+	int failed = 1;
+
+	if ((generator = EC_GROUP_get0_generator(group)) == NULL)
+		errx(1, "EC_GROUP_get0_generator");
+	if ((fixed = EC_POINT_new(group)) == NULL)
+		errx(1, "EC_POINT_new");
+	if ((variable = EC_POINT_new(group)) == NULL)
+		errx(1, "EC_POINT_new");
+
+	if (!EC_POINT_mul(group, fixed, scalar, NULL, NULL, ctx)) {
+		fprintf(stderr, "FAIL: %s: EC_POINT_mul with generator\n", name);
+		goto failure;
+	}
+	if (!EC_POINT_mul(group, variable, NULL, generator, scalar, ctx)) {
+		fprintf(stderr, "FAIL: %s: EC_POINT_mul with point\n", name);
+		goto failure;
+	}
+	if (EC_POINT_cmp(group, fixed, variable, ctx) != 0) {
+		hex = BN_bn2hex(scalar);
+		fprintf(stderr, "FAIL: %s: results differ for scalar %s\n",
+		    name, hex != NULL ? hex : "?");
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	EC_POINT_free(fixed);
+	EC_POINT_free(variable);
+	free(hex);
+
+	return failed;
+}
+
+static int
+ec_mul_generator_test(int nid)
+{
+	const char *name = OBJ_nid2sn(nid);
+	EC_GROUP *group;
+	BN_CTX *ctx;
+	BIGNUM *order, *scalar;
+	int i, failed = 0;
+
+	if ((ctx = BN_CTX_new()) == NULL)
+		errx(1, "BN_CTX_new");
+	if ((group = EC_GROUP_new_by_curve_name(nid)) == NULL)
+		errx(1, "EC_GROUP_new_by_curve_name");
+	if ((order = BN_new()) == NULL)
+		errx(1, "BN_new");
+	if (!EC_GROUP_get_order(group, order, ctx))
+		errx(1, "EC_GROUP_get_order");
+	if ((scalar = BN_new()) == NULL)
+		errx(1, "BN_new");
+
+	/* Small scalars. */
+	for (i = 0; i < 64; i++) {
+		if (!BN_set_word(scalar, i))
+			errx(1, "BN_set_word");
+		failed |= ec_mul_compare(name, group, scalar, ctx);
+	}
+
+	/* Scalars just below the order. */
+	for (i = 1; i < 64; i++) {
+		if (!BN_set_word(scalar, i))
+			errx(1, "BN_set_word");
+		if (!BN_sub(scalar, order, scalar))
+			errx(1, "BN_sub");
+		failed |= ec_mul_compare(name, group, scalar, ctx);
+	}
+
+	/* Powers of two and their neighbours. */
+	for (i = 0; i < BN_num_bits(order); i++) {
+		BN_zero(scalar);
+		if (!BN_set_bit(scalar, i))
+			errx(1, "BN_set_bit");
+		failed |= ec_mul_compare(name, group, scalar, ctx);
+		if (!BN_sub_word(scalar, 1))
+			errx(1, "BN_sub_word");
+		failed |= ec_mul_compare(name, group, scalar, ctx);
+	}
+
+	/* Random scalars. */
+	for (i = 0; i < EC_MUL_TEST_RANDOM; i++) {
+		if (!BN_rand_range(scalar, order))
+			errx(1, "BN_rand_range");
+		failed |= ec_mul_compare(name, group, scalar, ctx);
+	}
+
+	/* Scalars outside of [0, order). */
+	if (!BN_add_word(scalar, 5) || !BN_add(scalar, scalar, order))
+		errx(1, "BN_add");
+	failed |= ec_mul_compare(name, group, scalar, ctx);
+	BN_set_negative(scalar, 1);
+	failed |= ec_mul_compare(name, group, scalar, ctx);
+
+	BN_free(order);
+	BN_free(scalar);
+	EC_GROUP_free(group);
+	BN_CTX_free(ctx);
+
+	return failed;
+}
+
+/*
+ * A group that keeps the curve name but has a different generator must not
+ * use the table for the named curve.
+ */
+static int
+ec_mul_generator_changed_test(int nid)
+{
+	const char *name = OBJ_nid2sn(nid);
+	EC_GROUP *group, *group2;
+	EC_POINT *generator2, *expected, *result;
+	BN_CTX *ctx;
+	BIGNUM *order, *scalar;
+	int failed = 1;
+
+	if ((ctx = BN_CTX_new()) == NULL)
+		errx(1, "BN_CTX_new");
+	if ((group = EC_GROUP_new_by_curve_name(nid)) == NULL)
+		errx(1, "EC_GROUP_new_by_curve_name");
+	if ((group2 = EC_GROUP_dup(group)) == NULL)
+		errx(1, "EC_GROUP_dup");
+	if ((generator2 = EC_POINT_new(group)) == NULL)
+		errx(1, "EC_POINT_new");
+	if ((expected = EC_POINT_new(group)) == NULL)
+		errx(1, "EC_POINT_new");
+	if ((result = EC_POINT_new(group)) == NULL)
+		errx(1, "EC_POINT_new");
+	if ((order = BN_new()) == NULL)
+		errx(1, "BN_new");
+	if (!EC_GROUP_get_order(group, order, ctx))
+		errx(1, "EC_GROUP_get_order");
+	if ((scalar = BN_new()) == NULL)
+		errx(1, "BN_new");
+
+	if (!EC_POINT_dbl(group, generator2, EC_GROUP_get0_generator(group),
+	    ctx))
+		errx(1, "EC_POINT_dbl");
+	if (!EC_POINT_make_affine(group, generator2, ctx))
+		errx(1, "EC_POINT_make_affine");
+	if (!EC_GROUP_set_generator(group2, generator2, order,
+	    BN_value_one()))
+		errx(1, "EC_GROUP_set_generator");
+	if (EC_GROUP_get_curve_name(group2) != nid)
+		errx(1, "EC_GROUP_get_curve_name");
+
+	if (!BN_rand_range(scalar, order))
+		errx(1, "BN_rand_range");
+	if (!EC_POINT_mul(group, expected, NULL, generator2, scalar, ctx))
+		errx(1, "EC_POINT_mul");
+	if (!EC_POINT_mul(group2, result, scalar, NULL, NULL, ctx))
+		errx(1, "EC_POINT_mul");
+
+	if (EC_POINT_cmp(group, expected, result, ctx) != 0) {
+		fprintf(stderr, "FAIL: %s: wrong result with changed "
+		    "generator\n", name);
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	BN_free(order);
+	BN_free(scalar);
+	EC_POINT_free(generator2);
+	EC_POINT_free(expected);
+	EC_POINT_free(result);
+	EC_GROUP_free(group);
+	EC_GROUP_free(group2);
+	BN_CTX_free(ctx);
+
+	return failed;
+}
+
+/*
+ * Build a group with the same parameters as the named curve that does not
+ * carry the curve name and hence uses the generic GFp method.
+ */
+static EC_GROUP *
+ec_mul_generic_group(const EC_GROUP *group, BN_CTX *ctx)
+{
+	EC_GROUP *generic;
+	EC_POINT *generator;
+	BIGNUM *p, *a, *b, *x, *y, *order;
+
+	if ((p = BN_new()) == NULL || (a = BN_new()) == NULL ||
+	    (b = BN_new()) == NULL || (x = BN_new()) == NULL ||
+	    (y = BN_new()) == NULL || (order = BN_new()) == NULL)
+		errx(1, "BN_new");
+
+	if (!EC_GROUP_get_curve(group, p, a, b, ctx))
+		errx(1, "EC_GROUP_get_curve");
+	if (!EC_GROUP_get_order(group, order, ctx))
+		errx(1, "EC_GROUP_get_order");
+	if (!EC_POINT_get_affine_coordinates(group,
+	    EC_GROUP_get0_generator(group), x, y, ctx))
+		errx(1, "EC_POINT_get_affine_coordinates");
+
+	if ((generic = EC_GROUP_new_curve_GFp(p, a, b, ctx)) == NULL)
+		errx(1, "EC_GROUP_new_curve_GFp");
+	if ((generator = EC_POINT_new(generic)) == NULL)
+		errx(1, "EC_POINT_new");
+	if (!EC_POINT_set_affine_coordinates(generic, generator, x, y, ctx))
+		errx(1, "EC_POINT_set_affine_coordinates");
+	if (!EC_GROUP_set_generator(generic, generator, order,
+	    BN_value_one()))
+		errx(1, "EC_GROUP_set_generator");
+
+	EC_POINT_free(generator);
+	BN_free(p);
+	BN_free(a);
+	BN_free(b);
+	BN_free(x);
+	BN_free(y);
+	BN_free(order);
+
+	return generic;
+}
+
+/* Compare the affine coordinates of points on two groups. */
+static int
+ec_mul_points_equal(const EC_GROUP *group1, const EC_POINT *point1,
+    const EC_GROUP *group2, const EC_POINT *point2, BN_CTX *ctx)
+{
+	BIGNUM *x1, *y1, *x2, *y2;
+	int inf1, inf2, equal;
+
+	inf1 = EC_POINT_is_at_infinity(group1, point1);
+	inf2 = EC_POINT_is_at_infinity(group2, point2);
+	if (inf1 || inf2)
+		return inf1 == inf2;
+
+	if ((x1 = BN_new()) == NULL || (y1 = BN_new()) == NULL ||
+	    (x2 = BN_new()) == NULL || (y2 = BN_new()) == NULL)
+		errx(1, "BN_new");
+
+	if (!EC_POINT_get_affine_coordinates(group1, point1, x1, y1, ctx))
+		errx(1, "EC_POINT_get_affine_coordinates");
+	if (!EC_POINT_get_affine_coordinates(group2, point2, x2, y2, ctx))
+		errx(1, "EC_POINT_get_affine_coordinates");
+
+	equal = BN_cmp(x1, x2) == 0 && BN_cmp(y1, y2) == 0;
+
+	BN_free(x1);
+	BN_free(y1);
+	BN_free(x2);
+	BN_free(y2);
+
+	return equal;
+}
+
+/*
+ * Cross check point arithmetic of the method used for the named curve
+ * against the generic method on the same curve.
+ */
+static int
+ec_mul_method_test(int nid)
+{
+	const char *name = OBJ_nid2sn(nid);
+	EC_GROUP *group, *generic;
+	EC_POINT *p1, *p2, *r1, *g1, *g2, *s1, *s2;
+	BN_CTX *ctx;
+	BIGNUM *order, *k, *m;
+	int i, failed = 0;
+
+	if ((ctx = BN_CTX_new()) == NULL)
+		errx(1, "BN_CTX_new");
+	if ((group = EC_GROUP_new_by_curve_name(nid)) == NULL)
+		errx(1, "EC_GROUP_new_by_curve_name");
+	generic = ec_mul_generic_group(group, ctx);
+
+	if ((p1 = EC_POINT_new(group)) == NULL ||
+	    (r1 = EC_POINT_new(group)) == NULL ||
+	    (s1 = EC_POINT_new(group)) == NULL ||
+	    (p2 = EC_POINT_new(generic)) == NULL ||
+	    (g1 = EC_POINT_new(generic)) == NULL ||
+	    (g2 = EC_POINT_new(generic)) == NULL ||
+	    (s2 = EC_POINT_new(generic)) == NULL)
+		errx(1, "EC_POINT_new");
+	if ((order = BN_new()) == NULL || (k = BN_new()) == NULL ||
+	    (m = BN_new()) == NULL)
+		errx(1, "BN_new");
+	if (!EC_GROUP_get_order(group, order, ctx))
+		errx(1, "EC_GROUP_get_order");
+
+	for (i = 0; i < EC_MUL_TEST_RANDOM; i++) {
+		if (!BN_rand_range(k, order) || !BN_rand_range(m, order))
+			errx(1, "BN_rand_range");
+
+		/* Random points P = k * G on both groups. */
+		if (!EC_POINT_mul(group, p1, k, NULL, NULL, ctx))
+			errx(1, "EC_POINT_mul");
+		if (!EC_POINT_mul(generic, p2, k, NULL, NULL, ctx))
+			errx(1, "EC_POINT_mul");
+		if (!ec_mul_points_equal(group, p1, generic, p2, ctx)) {
+			fprintf(stderr, "FAIL: %s: generator multiplication "
+			    "differs from generic method\n", name);
+			failed = 1;
+		}
+
+		/* m * P and k * G + m * P. */
+		if (!EC_POINT_mul(group, r1, NULL, p1, m, ctx))
+			errx(1, "EC_POINT_mul");
+		if (!EC_POINT_mul(generic, g1, NULL, p2, m, ctx))
+			errx(1, "EC_POINT_mul");
+		if (!ec_mul_points_equal(group, r1, generic, g1, ctx)) {
+			fprintf(stderr, "FAIL: %s: point multiplication "
+			    "differs from generic method\n", name);
+			failed = 1;
+		}
+		if (!EC_POINT_mul(group, r1, k, p1, m, ctx))
+			errx(1, "EC_POINT_mul");
+		if (!EC_POINT_mul(generic, g2, k, p2, m, ctx))
+			errx(1, "EC_POINT_mul");
+		if (!ec_mul_points_equal(group, r1, generic, g2, ctx)) {
+			fprintf(stderr, "FAIL: %s: double multiplication "
+			    "differs from generic method\n", name);
+			failed = 1;
+		}
+
+		/* Addition, including P + P, P + (-P) and P + infinity. */
+		if (!EC_POINT_add(group, s1, p1, r1, ctx))
+			errx(1, "EC_POINT_add");
+		if (!EC_POINT_add(generic, s2, p2, g2, ctx))
+			errx(1, "EC_POINT_add");
+		if (!ec_mul_points_equal(group, s1, generic, s2, ctx)) {
+			fprintf(stderr, "FAIL: %s: EC_POINT_add differs from "
+			    "generic method\n", name);
+			failed = 1;
+		}
+		if (!EC_POINT_add(group, s1, p1, p1, ctx))
+			errx(1, "EC_POINT_add");
+		if (!EC_POINT_dbl(generic, s2, p2, ctx))
+			errx(1, "EC_POINT_dbl");
+		if (!ec_mul_points_equal(group, s1, generic, s2, ctx)) {
+			fprintf(stderr, "FAIL: %s: P + P differs from 2P\n",
+			    name);
+			failed = 1;
+		}
+		if (!EC_POINT_dbl(group, s1, p1, ctx))
+			errx(1, "EC_POINT_dbl");
+		if (!ec_mul_points_equal(group, s1, generic, s2, ctx)) {
+			fprintf(stderr, "FAIL: %s: EC_POINT_dbl differs from "
+			    "generic method\n", name);
+			failed = 1;
+		}
+		if (!EC_POINT_copy(s1, p1) || !EC_POINT_invert(group, s1, ctx))
+			errx(1, "EC_POINT_invert");
+		if (!EC_POINT_add(group, s1, p1, s1, ctx))
+			errx(1, "EC_POINT_add");
+		if (!EC_POINT_is_at_infinity(group, s1)) {
+			fprintf(stderr, "FAIL: %s: P + (-P) is not infinity\n",
+			    name);
+			failed = 1;
+		}
+		if (!EC_POINT_add(group, s1, s1, p1, ctx))
+			errx(1, "EC_POINT_add");
+		if (EC_POINT_cmp(group, s1, p1, ctx) != 0) {
+			fprintf(stderr, "FAIL: %s: infinity + P is not P\n",
+			    name);
+			failed = 1;
+		}
+	}
+
+	BN_free(order);
+	BN_free(k);
+	BN_free(m);
+	EC_POINT_free(p1);
+	EC_POINT_free(r1);
+	EC_POINT_free(s1);
+	EC_POINT_free(p2);
+	EC_POINT_free(g1);
+	EC_POINT_free(g2);
+	EC_POINT_free(s2);
+	EC_GROUP_free(group);
+	EC_GROUP_free(generic);
+	BN_CTX_free(ctx);
+
+	return failed;
+}
+
+static void
+ec_mul_benchmark(int nid)
+{
+	struct timespec start, end, duration;
+	EC_GROUP *group;
+	EC_POINT *point;
+	BN_CTX *ctx;
+	BIGNUM *order, *scalar;
+	double seconds;
+	int i, iterations = 1000;
+
+	if ((ctx = BN_CTX_new()) == NULL)
+		errx(1, "BN_CTX_new");
+	if ((group = EC_GROUP_new_by_curve_name(nid)) == NULL)
+		errx(1, "EC_GROUP_new_by_curve_name");
+	if ((point = EC_POINT_new(group)) == NULL)
+		errx(1, "EC_POINT_new");
+	if ((order = BN_new()) == NULL)
+		errx(1, "BN_new");
+	if (!EC_GROUP_get_order(group, order, ctx))
+		errx(1, "EC_GROUP_get_order");
+	if ((scalar = BN_new()) == NULL)
+		errx(1, "BN_new");
+	if (!BN_rand_range(scalar, order))
+		errx(1, "BN_rand_range");
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < iterations; i++) {
+		if (!EC_POINT_mul(group, point, scalar, NULL, NULL, ctx))
+			errx(1, "EC_POINT_mul");
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	timespecsub(&end, &start, &duration);
+	seconds = duration.tv_sec + duration.tv_nsec / 1000000000.0;
+
+	fprintf(stderr, "Benchmarking %s generator multiplication: %d "
+	    "iterations in %f seconds (%.0f/s)\n", OBJ_nid2sn(nid),
+	    iterations, seconds, iterations / seconds);
+
+	BN_free(order);
+	BN_free(scalar);
+	EC_POINT_free(point);
+	EC_GROUP_free(group);
+	BN_CTX_free(ctx);
+}
+
+int
+main(int argc, char **argv)
+{
+	int benchmark = 0, failed = 0;
+	size_t i;
+
+	if (argc == 2 && strcmp(argv[1], "--benchmark") == 0)
+		benchmark = 1;
+
+	for (i = 0; i < N_EC_MUL_TEST_NIDS; i++) {
+		failed |= ec_mul_generator_test(ec_mul_test_nids[i]);
+		failed |= ec_mul_generator_changed_test(ec_mul_test_nids[i]);
+		failed |= ec_mul_method_test(ec_mul_test_nids[i]);
+	}
+
+	if (benchmark && !failed) {
+		for (i = 0; i < N_EC_MUL_TEST_NIDS; i++)
+			ec_mul_benchmark(ec_mul_test_nids[i]);
+	}
+
+	return failed;
+}
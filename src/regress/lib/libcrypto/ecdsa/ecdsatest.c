@@ -86,6 +86,7 @@
 /* declaration of the test functions */
 int x9_62_test_internal(int nid, const char *r, const char *s);
 int test_builtin(void);
+int test_precompute_public(void);
 
 /* some tests from the X9.62 draft */
 int
@@ -392,6 +393,147 @@ test_builtin(void)
 	return failed;
 }
 
+/*
+ * Verify signatures with a precomputed table of multiples of the public key
+ * and make sure that the table does not outlive a change of the public key.
+ */
+int
+test_precompute_public(void)
+{
+	unsigned char digest[8][20], wrong_digest[20];
+	ECDSA_SIG *sigs[8] = { NULL };
+	EC_builtin_curve *curves = NULL;
+	size_t num_curves = 0, n;
+	EC_KEY *eckey = NULL, *wrong_eckey = NULL, *dup = NULL;
+	int i, nid;
+	int failed = 1;
+
+	printf("\ntesting EC_KEY_precompute_public_mult() "
+	    "with some internal curves:\n");
+
+	arc4random_buf(digest, sizeof(digest));
+	arc4random_buf(wrong_digest, sizeof(wrong_digest));
+
+	num_curves = EC_get_builtin_curves(NULL, 0);
+	curves = reallocarray(NULL, sizeof(EC_builtin_curve), num_curves);
+	if (curves == NULL) {
+		printf("reallocarray error\n");
+		goto err;
+	}
+	if (!EC_get_builtin_curves(curves, num_curves)) {
+		printf("unable to get internal curves\n");
+		goto err;
+	}
+
+	for (n = 0; n < num_curves; n++) {
+		nid = curves[n].nid;
+		if (nid == NID_ipsec4)
+			continue;
+
+		if ((eckey = EC_KEY_new_by_curve_name(nid)) == NULL)
+			goto err;
+		if (EC_GROUP_get_degree(EC_KEY_get0_group(eckey)) < 160) {
+			EC_KEY_free(eckey);
+			eckey = NULL;
+			continue;
+		}
+		printf("%s: ", OBJ_nid2sn(nid));
+
+		if ((wrong_eckey = EC_KEY_new_by_curve_name(nid)) == NULL)
+			goto err;
+		if (!EC_KEY_generate_key(eckey) ||
+		    !EC_KEY_generate_key(wrong_eckey))
+			goto err;
+
+		for (i = 0; i < 8; i++) {
+			if ((sigs[i] = ECDSA_do_sign(digest[i], 20,
+			    eckey)) == NULL)
+				goto err;
+		}
+
+		if (!EC_KEY_precompute_public_mult(eckey, NULL))
+			goto err;
+		if (!EC_KEY_precompute_public_mult(wrong_eckey, NULL))
+			goto err;
+
+		printf(".");
+		fflush(stdout);
+
+		for (i = 0; i < 8; i++) {
+			if (ECDSA_do_verify(digest[i], 20, sigs[i],
+			    eckey) != 1)
+				goto err;
+			if (ECDSA_do_verify(wrong_digest, 20, sigs[i],
+			    eckey) == 1)
+				goto err;
+			if (ECDSA_do_verify(digest[i], 20, sigs[i],
+			    wrong_eckey) == 1)
+				goto err;
+		}
+
+		printf(".");
+		fflush(stdout);
+
+		/* A copy shares the table and must still verify. */
+		if ((dup = EC_KEY_dup(eckey)) == NULL)
+			goto err;
+		if (ECDSA_do_verify(digest[0], 20, sigs[0], dup) != 1)
+			goto err;
+
+		/* Replacing the public key must not reuse the old table. */
+		if (!EC_KEY_set_public_key(dup,
+		    EC_KEY_get0_public_key(wrong_eckey)))
+			goto err;
+		if (ECDSA_do_verify(digest[0], 20, sigs[0], dup) == 1)
+			goto err;
+		if (!EC_KEY_set_public_key(wrong_eckey,
+		    EC_KEY_get0_public_key(eckey)))
+			goto err;
+		if (ECDSA_do_verify(digest[0], 20, sigs[0], wrong_eckey) != 1)
+			goto err;
+		if (ECDSA_do_verify(digest[0], 20, sigs[0], eckey) != 1)
+			goto err;
+
+		printf(".");
+		fflush(stdout);
+
+		/* Neither may generating a new key. */
+		if (!EC_KEY_generate_key(eckey))
+			goto err;
+		if (ECDSA_do_verify(digest[0], 20, sigs[0], eckey) == 1)
+			goto err;
+
+		printf(". ok\n");
+
+		ERR_clear_error();
+		for (i = 0; i < 8; i++) {
+			ECDSA_SIG_free(sigs[i]);
+			sigs[i] = NULL;
+		}
+		EC_KEY_free(eckey);
+		eckey = NULL;
+		EC_KEY_free(wrong_eckey);
+		wrong_eckey = NULL;
+		EC_KEY_free(dup);
+		dup = NULL;
+	}
+
+	failed = 0;
+
+ err:
+	if (failed)
+		printf(" failed\n");
+
+	for (i = 0; i < 8; i++)
+		ECDSA_SIG_free(sigs[i]);
+	EC_KEY_free(eckey);
+	EC_KEY_free(wrong_eckey);
+	EC_KEY_free(dup);
+	free(curves);
+
+	return failed;
+}
+
 int
 main(void)
 {
@@ -400,6 +542,8 @@ main(void)
 	/* the tests */
 	if (test_builtin())
 		goto err;
+	if (test_precompute_public())
+		goto err;
 
 	printf("\nECDSA test passed\n");
 	failed = 0;
@@ -0,0 +1,202 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sys/time.h>
+
+#include <err.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+
+#define ERR_TEST_THREADS	8
+#define ERR_TEST_ITERATIONS	10000
+
+struct err_test_ctx {
+	int lib;
+	int iterations;
+	int failed;
+};
+
+static void *
+err_thread(void *arg)
+{
+	struct err_test_ctx *ctx = arg;
+	const char *data;
+	unsigned long e;
+	int flags, i, j;
+
+	for (i = 0; i < ctx->iterations; i++) {
+		for (j = 1; j <= 3; j++)
+			ERR_put_error(ctx->lib, 0, j, __FILE__, __LINE__);
+		ERR_asprintf_error_data("lib %d iteration %d", ctx->lib, i);
+
+		if (ERR_GET_REASON(ERR_peek_last_error()) != 3)
+			ctx->failed = 1;
+
+		for (j = 1; j <= 3; j++) {
+			e = ERR_get_error_line_data(NULL, NULL, &data, &flags);
+			if (ERR_GET_LIB(e) != ctx->lib ||
+			    ERR_GET_REASON(e) != j)
+				ctx->failed = 1;
+		}
+		if (ERR_peek_error() != 0)
+			ctx->failed = 1;
+
+		ERR_put_error(ctx->lib, 0, 1, __FILE__, __LINE__);
+		ERR_clear_error();
+		if (ERR_peek_error() != 0)
+			ctx->failed = 1;
+	}
+
+	return NULL;
+}
+
+static void *
+err_remove_thread(void *arg)
+{
+	struct err_test_ctx *ctx = arg;
+
+	ERR_put_error(ctx->lib, 0, 1, __FILE__, __LINE__);
+	ERR_remove_thread_state(NULL);
+	if (ERR_peek_error() != 0)
+		ctx->failed = 1;
+
+	/* Leave an error queued, which is freed when the thread exits. */
+	ERR_put_error(ctx->lib, 0, 2, __FILE__, __LINE__);
+	ERR_asprintf_error_data("freed on thread exit");
+
+	return NULL;
+}
+
+static void
+run_threads(int nthreads, void *(*func)(void *), struct err_test_ctx *ctx)
+{
+	pthread_t threads[64];
+	int i;
+
+	if (nthreads > 64)
+		errx(1, "too many threads");
+
+	for (i = 0; i < nthreads; i++) {
+		if (pthread_create(&threads[i], NULL, func, &ctx[i]) != 0)
+			errx(1, "pthread_create");
+	}
+	for (i = 0; i < nthreads; i++) {
+		if (pthread_join(threads[i], NULL) != 0)
+			errx(1, "pthread_join");
+	}
+}
+
+static int
+test_err_threads(void)
+{
+	struct err_test_ctx ctx[ERR_TEST_THREADS];
+	int i;
+	int failed = 0;
+
+	/* An error queued in this thread must not be visible elsewhere. */
+	ERR_put_error(ERR_LIB_USER, 0, 42, __FILE__, __LINE__);
+
+	memset(ctx, 0, sizeof(ctx));
+	for (i = 0; i < ERR_TEST_THREADS; i++) {
+		ctx[i].lib = ERR_LIB_USER + 1 + i;
+		ctx[i].iterations = ERR_TEST_ITERATIONS;
+	}
+	run_threads(ERR_TEST_THREADS, err_thread, ctx);
+
+	for (i = 0; i < ERR_TEST_THREADS; i++) {
+		if (ctx[i].failed) {
+			fprintf(stderr, "FAIL: thread %d saw wrong errors\n", i);
+			failed = 1;
+		}
+	}
+
+	memset(ctx, 0, sizeof(ctx));
+	for (i = 0; i < ERR_TEST_THREADS; i++)
+		ctx[i].lib = ERR_LIB_USER + 1 + i;
+	run_threads(ERR_TEST_THREADS, err_remove_thread, ctx);
+
+	for (i = 0; i < ERR_TEST_THREADS; i++) {
+		if (ctx[i].failed) {
+			fprintf(stderr, "FAIL: thread %d error state was not "
+			    "removed\n", i);
+			failed = 1;
+		}
+	}
+
+	if (ERR_GET_REASON(ERR_get_error()) != 42 || ERR_get_error() != 0) {
+		fprintf(stderr, "FAIL: main thread error queue changed\n");
+		failed = 1;
+	}
+
+	return failed;
+}
+
+static void
+benchmark_err(void)
+{
+	struct err_test_ctx ctx[64];
+	struct timespec start, end, duration;
+	double seconds;
+	int i, ncpu, nthreads;
+
+	if ((ncpu = sysconf(_SC_NPROCESSORS_ONLN)) < 1)
+		ncpu = 1;
+	if (ncpu > 64)
+		ncpu = 64;
+
+	for (nthreads = 1; nthreads <= ncpu; nthreads *= 2) {
+		memset(ctx, 0, sizeof(ctx));
+		for (i = 0; i < nthreads; i++) {
+			ctx[i].lib = ERR_LIB_USER + 1 + i;
+			ctx[i].iterations = 100000;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		run_threads(nthreads, err_thread, ctx);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		timespecsub(&end, &start, &duration);
+		seconds = duration.tv_sec + duration.tv_nsec / 1000000000.0;
+
+		fprintf(stderr, "Benchmarking error queue with %d threads: "
+		    "%d iterations in %f seconds (%.0f/s)\n", nthreads,
+		    nthreads * ctx[0].iterations, seconds,
+		    nthreads * ctx[0].iterations / seconds);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	int benchmark = 0, failed = 0;
+
+	if (argc == 2 && strcmp(argv[1], "--benchmark") == 0)
+		benchmark = 1;
+
+	failed |= test_err_threads();
+
+	if (benchmark && !failed)
+		benchmark_err();
+
+	return failed;
+}
@@ -55,6 +55,7 @@
 #include <string.h>
 
 #include <openssl/aes.h>
+#include <openssl/evp.h>
 #include <openssl/modes.h>
 
 /* XXX - something like this should be in the public headers. */
@@ -913,6 +914,98 @@ fail:
 	return (ret);
 }
 
+/*
+ * Seal and open messages long enough for the bulk code paths with the AES-GCM
+ * AEADs, and compare against the block at a time CRYPTO_gcm128 functions.
+ */
+static int
+do_gcm128_long_test(const EVP_AEAD *aead, size_t key_len)
+{
+	EVP_AEAD_CTX *aead_ctx = NULL;
+	GCM128_CONTEXT ctx;
+	AES_KEY key;
+	uint8_t key_bytes[32], nonce[12], ad[13], tag[16];
+	uint8_t *in = NULL, *out = NULL, *sealed = NULL;
+	size_t max_len = 4200;
+	size_t i, len, out_len;
+	int ret = 1;
+
+	if ((in = malloc(max_len)) == NULL)
+		err(1, "malloc");
+	if ((out = malloc(max_len)) == NULL)
+		err(1, "malloc");
+	if ((sealed = malloc(max_len + sizeof(tag))) == NULL)
+		err(1, "malloc");
+
+	for (i = 0; i < sizeof(key_bytes); i++)
+		key_bytes[i] = i * 7 + 1;
+	for (i = 0; i < sizeof(nonce); i++)
+		nonce[i] = 0xf0 + i;
+	for (i = 0; i < sizeof(ad); i++)
+		ad[i] = i;
+	for (i = 0; i < max_len; i++)
+		in[i] = i * 13 + 5;
+
+	if ((aead_ctx = EVP_AEAD_CTX_new()) == NULL)
+		errx(1, "EVP_AEAD_CTX_new");
+	if (!EVP_AEAD_CTX_init(aead_ctx, aead, key_bytes, key_len,
+	    EVP_AEAD_DEFAULT_TAG_LENGTH, NULL)) {
+		fprintf(stderr, "FAIL: EVP_AEAD_CTX_init\n");
+		goto fail;
+	}
+	AES_set_encrypt_key(key_bytes, key_len * 8, &key);
+
+	for (len = 0; len <= max_len; len += 37) {
+		CRYPTO_gcm128_init(&ctx, &key, (block128_f)AES_encrypt);
+		CRYPTO_gcm128_setiv(&ctx, nonce, sizeof(nonce));
+		CRYPTO_gcm128_aad(&ctx, ad, sizeof(ad));
+		CRYPTO_gcm128_encrypt(&ctx, in, out, len);
+		CRYPTO_gcm128_tag(&ctx, tag, sizeof(tag));
+
+		if (!EVP_AEAD_CTX_seal(aead_ctx, sealed, &out_len,
+		    len + sizeof(tag), nonce, sizeof(nonce), in, len, ad,
+		    sizeof(ad))) {
+			fprintf(stderr, "FAIL: seal %zu bytes\n", len);
+			goto fail;
+		}
+		if (out_len != len + sizeof(tag) ||
+		    memcmp(sealed, out, len) != 0 ||
+		    memcmp(sealed + len, tag, sizeof(tag)) != 0) {
+			fprintf(stderr, "FAIL: seal %zu bytes mismatch\n", len);
+			goto fail;
+		}
+
+		if (!EVP_AEAD_CTX_open(aead_ctx, out, &out_len, len, nonce,
+		    sizeof(nonce), sealed, len + sizeof(tag), ad, sizeof(ad))) {
+			fprintf(stderr, "FAIL: open %zu bytes\n", len);
+			goto fail;
+		}
+		if (out_len != len || memcmp(out, in, len) != 0) {
+			fprintf(stderr, "FAIL: open %zu bytes mismatch\n", len);
+			goto fail;
+		}
+
+		if (len == 0)
+			continue;
+		sealed[len / 2] ^= 1;
+		if (EVP_AEAD_CTX_open(aead_ctx, out, &out_len, len, nonce,
+		    sizeof(nonce), sealed, len + sizeof(tag), ad, sizeof(ad))) {
+			fprintf(stderr, "FAIL: open %zu corrupted bytes\n", len);
+			goto fail;
+		}
+	}
+
+	ret = 0;
+
+fail:
+	EVP_AEAD_CTX_free(aead_ctx);
+	free(in);
+	free(out);
+	free(sealed);
+
+	return ret;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -922,5 +1015,8 @@ main(int argc, char **argv)
 	for (i = 0; i < N_TESTS; i++)
 		ret |= do_gcm128_test(i + 1, &gcm128_tests[i]);
 
+	ret |= do_gcm128_long_test(EVP_aead_aes_128_gcm(), 16);
+	ret |= do_gcm128_long_test(EVP_aead_aes_256_gcm(), 32);
+
 	return ret;
 }
@@ -0,0 +1,679 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sys/time.h>
+
+#include <err.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <openssl/crypto.h>
+#include <openssl/bn.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+
+#define LOCK_TEST_THREADS	8
+#define LOCK_TEST_ITERATIONS	100000
+
+struct lock_test {
+	const char *desc;
+	int type;
+};
+
+static const struct lock_test lock_tests[] = {
+	{
+		.desc = "CRYPTO_LOCK_EVP_PKEY",
+		.type = CRYPTO_LOCK_EVP_PKEY,
+	},
+	{
+		.desc = "CRYPTO_LOCK_SSL_CTX",
+		.type = CRYPTO_LOCK_SSL_CTX,
+	},
+	{
+		.desc = "CRYPTO_LOCK_SSL_SESSION",
+		.type = CRYPTO_LOCK_SSL_SESSION,
+	},
+	{
+		.desc = "CRYPTO_LOCK_X509",
+		.type = CRYPTO_LOCK_X509,
+	},
+	{
+		.desc = "CRYPTO_LOCK_X509_STORE",
+		.type = CRYPTO_LOCK_X509_STORE,
+	},
+	{
+		.desc = "CRYPTO_LOCK_BIO",
+		.type = CRYPTO_LOCK_BIO,
+	},
+};
+
+#define N_LOCK_TESTS (sizeof(lock_tests) / sizeof(lock_tests[0]))
+
+struct lock_test_ctx {
+	const struct lock_test *lt;
+	int iterations;
+	int count;
+	EVP_PKEY *pkey;
+	X509 *x509;
+	X509_STORE *store;
+	X509_NAME *name;
+	RSA *rsa;
+	int shared[2];
+	int write_interval;
+	int mismatches;
+};
+
+static void *
+crypto_add_thread(void *arg)
+{
+	struct lock_test_ctx *ctx = arg;
+	int i;
+
+	for (i = 0; i < ctx->iterations; i++) {
+		CRYPTO_add(&ctx->count, 2, ctx->lt->type);
+		CRYPTO_add(&ctx->count, -1, ctx->lt->type);
+	}
+
+	return NULL;
+}
+
+static void *
+up_ref_thread(void *arg)
+{
+	struct lock_test_ctx *ctx = arg;
+	int i;
+
+	for (i = 0; i < ctx->iterations; i++) {
+		if (!EVP_PKEY_up_ref(ctx->pkey))
+			errx(1, "EVP_PKEY_up_ref");
+		EVP_PKEY_free(ctx->pkey);
+
+		if (!X509_up_ref(ctx->x509))
+			errx(1, "X509_up_ref");
+		X509_free(ctx->x509);
+
+		if (!X509_STORE_up_ref(ctx->store))
+			errx(1, "X509_STORE_up_ref");
+		X509_STORE_free(ctx->store);
+	}
+
+	return NULL;
+}
+
+static void *
+rw_lock_thread(void *arg)
+{
+	struct lock_test_ctx *ctx = arg;
+	int i;
+
+	for (i = 0; i < ctx->iterations; i++) {
+		if (ctx->write_interval > 0 && i % ctx->write_interval == 0) {
+			CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
+			ctx->shared[0]++;
+			ctx->shared[1]++;
+			CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+			continue;
+		}
+		CRYPTO_r_lock(CRYPTO_LOCK_X509_STORE);
+		if (ctx->shared[0] != ctx->shared[1])
+			__atomic_add_fetch(&ctx->mismatches, 1,
+			    __ATOMIC_RELAXED);
+		CRYPTO_r_unlock(CRYPTO_LOCK_X509_STORE);
+	}
+
+	return NULL;
+}
+
+static void *
+store_lookup_thread(void *arg)
+{
+	struct lock_test_ctx *ctx = arg;
+	X509_STORE_CTX *xsc;
+	STACK_OF(X509) *certs;
+	int i;
+
+	if ((xsc = X509_STORE_CTX_new()) == NULL)
+		errx(1, "X509_STORE_CTX_new");
+	if (!X509_STORE_CTX_init(xsc, ctx->store, NULL, NULL))
+		errx(1, "X509_STORE_CTX_init");
+
+	for (i = 0; i < ctx->iterations; i++) {
+		if ((certs = X509_STORE_get1_certs(xsc, ctx->name)) == NULL)
+			errx(1, "X509_STORE_get1_certs");
+		if (sk_X509_num(certs) != 1)
+			__atomic_add_fetch(&ctx->mismatches, 1,
+			    __ATOMIC_RELAXED);
+		sk_X509_pop_free(certs, X509_free);
+	}
+
+	X509_STORE_CTX_free(xsc);
+
+	return NULL;
+}
+
+static X509 *
+store_cert_new(const char *fmt, int n, X509_NAME **out_name)
+{
+	X509_NAME *name;
+	X509 *x509;
+	char cn[32];
+
+	if ((x509 = X509_new()) == NULL)
+		errx(1, "X509_new");
+	if ((name = X509_NAME_new()) == NULL)
+		errx(1, "X509_NAME_new");
+	snprintf(cn, sizeof(cn), fmt, n);
+	if (!X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+	    (const unsigned char *)cn, -1, -1, 0))
+		errx(1, "X509_NAME_add_entry_by_txt");
+	if (!X509_set_subject_name(x509, name))
+		errx(1, "X509_set_subject_name");
+
+	if (out_name != NULL)
+		*out_name = name;
+	else
+		X509_NAME_free(name);
+
+	return x509;
+}
+
+/*
+ * Add certificates to the store and look each one up straight away, which is
+ * what lazy loading through a lookup method does.
+ */
+static void *
+store_add_thread(void *arg)
+{
+	struct lock_test_ctx *ctx = arg;
+	X509_STORE_CTX *xsc;
+	STACK_OF(X509) *certs;
+	X509_NAME *name;
+	X509 *x509;
+	int i, id;
+
+	id = __atomic_fetch_add(&ctx->count, 1, __ATOMIC_RELAXED);
+
+	if ((xsc = X509_STORE_CTX_new()) == NULL)
+		errx(1, "X509_STORE_CTX_new");
+	if (!X509_STORE_CTX_init(xsc, ctx->store, NULL, NULL))
+		errx(1, "X509_STORE_CTX_init");
+
+	for (i = 0; i < ctx->iterations; i++) {
+		x509 = store_cert_new("store add %d", id * ctx->iterations + i,
+		    &name);
+		if (!X509_STORE_add_cert(ctx->store, x509))
+			errx(1, "X509_STORE_add_cert");
+		X509_free(x509);
+
+		/* Every thread also adds its own copy under a shared name. */
+		if (i % 10 == 0) {
+			x509 = store_cert_new("store add shared %d", i, NULL);
+			if (!X509_STORE_add_cert(ctx->store, x509))
+				errx(1, "X509_STORE_add_cert");
+			X509_free(x509);
+		}
+
+		if ((certs = X509_STORE_get1_certs(xsc, name)) == NULL ||
+		    sk_X509_num(certs) != 1)
+			__atomic_add_fetch(&ctx->mismatches, 1,
+			    __ATOMIC_RELAXED);
+		sk_X509_pop_free(certs, X509_free);
+		X509_NAME_free(name);
+	}
+
+	X509_STORE_CTX_free(xsc);
+
+	return NULL;
+}
+
+static void *
+rsa_sign_thread(void *arg)
+{
+	struct lock_test_ctx *ctx = arg;
+	unsigned char digest[32], sig[512];
+	unsigned int sig_len;
+	int i;
+
+	if (RSA_size(ctx->rsa) > (int)sizeof(sig))
+		errx(1, "RSA key too large");
+
+	for (i = 0; i < ctx->iterations; i++) {
+		memset(digest, i & 0xff, sizeof(digest));
+		if (!RSA_sign(NID_sha256, digest, sizeof(digest), sig, &sig_len,
+		    ctx->rsa))
+			errx(1, "RSA_sign");
+		if (RSA_verify(NID_sha256, digest, sizeof(digest), sig, sig_len,
+		    ctx->rsa) != 1)
+			__atomic_add_fetch(&ctx->mismatches, 1,
+			    __ATOMIC_RELAXED);
+	}
+
+	return NULL;
+}
+
+static void
+run_threads(int nthreads, void *(*func)(void *), void *arg)
+{
+	pthread_t threads[64];
+	int i;
+
+	if (nthreads > 64)
+		errx(1, "too many threads");
+
+	for (i = 0; i < nthreads; i++) {
+		if (pthread_create(&threads[i], NULL, func, arg) != 0)
+			errx(1, "pthread_create");
+	}
+	for (i = 0; i < nthreads; i++) {
+		if (pthread_join(threads[i], NULL) != 0)
+			errx(1, "pthread_join");
+	}
+}
+
+static int
+test_crypto_add(void)
+{
+	struct lock_test_ctx ctx;
+	int want;
+	size_t i;
+	int failed = 0;
+
+	want = LOCK_TEST_THREADS * LOCK_TEST_ITERATIONS;
+
+	for (i = 0; i < N_LOCK_TESTS; i++) {
+		memset(&ctx, 0, sizeof(ctx));
+		ctx.lt = &lock_tests[i];
+		ctx.iterations = LOCK_TEST_ITERATIONS;
+
+		run_threads(LOCK_TEST_THREADS, crypto_add_thread, &ctx);
+
+		if (ctx.count != want) {
+			fprintf(stderr, "FAIL: %s: CRYPTO_add() gave count %d, "
+			    "want %d\n", ctx.lt->desc, ctx.count, want);
+			failed = 1;
+		}
+	}
+
+	return failed;
+}
+
+static int
+test_up_ref(void)
+{
+	struct lock_test_ctx ctx;
+	int failed = 1;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.iterations = LOCK_TEST_ITERATIONS;
+
+	if ((ctx.pkey = EVP_PKEY_new()) == NULL)
+		errx(1, "EVP_PKEY_new");
+	if ((ctx.x509 = X509_new()) == NULL)
+		errx(1, "X509_new");
+	if ((ctx.store = X509_STORE_new()) == NULL)
+		errx(1, "X509_STORE_new");
+
+	run_threads(LOCK_TEST_THREADS, up_ref_thread, &ctx);
+
+	/* Each object should now hold exactly one reference. */
+	if (!EVP_PKEY_up_ref(ctx.pkey) || !X509_up_ref(ctx.x509) ||
+	    !X509_STORE_up_ref(ctx.store)) {
+		fprintf(stderr, "FAIL: up ref failed\n");
+		goto failure;
+	}
+	EVP_PKEY_free(ctx.pkey);
+	X509_free(ctx.x509);
+	X509_STORE_free(ctx.store);
+
+	failed = 0;
+
+ failure:
+	EVP_PKEY_free(ctx.pkey);
+	X509_free(ctx.x509);
+	X509_STORE_free(ctx.store);
+
+	return failed;
+}
+
+static int
+test_rw_lock(void)
+{
+	struct lock_test_ctx ctx;
+	int want;
+	int failed = 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.iterations = LOCK_TEST_ITERATIONS;
+	ctx.write_interval = 100;
+
+	run_threads(LOCK_TEST_THREADS, rw_lock_thread, &ctx);
+
+	want = LOCK_TEST_THREADS * LOCK_TEST_ITERATIONS / ctx.write_interval;
+	if (ctx.shared[0] != want || ctx.shared[1] != want) {
+		fprintf(stderr, "FAIL: write lock gave counts %d/%d, want %d\n",
+		    ctx.shared[0], ctx.shared[1], want);
+		failed = 1;
+	}
+	if (ctx.mismatches != 0) {
+		fprintf(stderr, "FAIL: read lock saw %d partial writes\n",
+		    ctx.mismatches);
+		failed = 1;
+	}
+
+	return failed;
+}
+
+static void
+store_setup(struct lock_test_ctx *ctx)
+{
+	X509_NAME *name;
+	X509 *x509;
+	int i;
+
+	if ((ctx->store = X509_STORE_new()) == NULL)
+		errx(1, "X509_STORE_new");
+
+	for (i = 0; i < 100; i++) {
+		x509 = store_cert_new("lock test %d", i, &name);
+		if (!X509_STORE_add_cert(ctx->store, x509))
+			errx(1, "X509_STORE_add_cert");
+		if (i == 50)
+			ctx->name = name;
+		else
+			X509_NAME_free(name);
+		X509_free(x509);
+	}
+
+	/* Encode the lookup name up front, rather than from every thread. */
+	if (X509_NAME_cmp(ctx->name, ctx->name) != 0)
+		errx(1, "X509_NAME_cmp");
+}
+
+static int
+test_store_lookup(void)
+{
+	struct lock_test_ctx ctx;
+	int failed = 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.iterations = LOCK_TEST_ITERATIONS / 10;
+	store_setup(&ctx);
+
+	run_threads(LOCK_TEST_THREADS, store_lookup_thread, &ctx);
+
+	if (ctx.mismatches != 0) {
+		fprintf(stderr, "FAIL: X509_STORE_get1_certs() failed to find "
+		    "certificate %d times\n", ctx.mismatches);
+		failed = 1;
+	}
+
+	X509_NAME_free(ctx.name);
+	X509_STORE_free(ctx.store);
+
+	return failed;
+}
+
+static int
+test_store_add(void)
+{
+	struct lock_test_ctx ctx;
+	STACK_OF(X509_OBJECT) *objs;
+	STACK_OF(X509) *certs;
+	X509_STORE_CTX *xsc;
+	X509_NAME *name;
+	X509 *x509;
+	int want;
+	int failed = 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.iterations = 1000;
+	if ((ctx.store = X509_STORE_new()) == NULL)
+		errx(1, "X509_STORE_new");
+
+	run_threads(LOCK_TEST_THREADS, store_add_thread, &ctx);
+
+	if (ctx.mismatches != 0) {
+		fprintf(stderr, "FAIL: X509_STORE_get1_certs() failed to find "
+		    "an added certificate %d times\n", ctx.mismatches);
+		failed = 1;
+	}
+
+	/*
+	 * The shared names were added once by each thread, but the copies
+	 * are identical, so the store should only hold one of them.
+	 */
+	objs = X509_STORE_get0_objects(ctx.store);
+	want = LOCK_TEST_THREADS * ctx.iterations + ctx.iterations / 10;
+	if (sk_X509_OBJECT_num(objs) != want) {
+		fprintf(stderr, "FAIL: store has %d objects, want %d\n",
+		    sk_X509_OBJECT_num(objs), want);
+		failed = 1;
+	}
+	if (!sk_X509_OBJECT_is_sorted(objs)) {
+		fprintf(stderr, "FAIL: store objects are not sorted\n");
+		failed = 1;
+	}
+
+	if ((xsc = X509_STORE_CTX_new()) == NULL)
+		errx(1, "X509_STORE_CTX_new");
+	if (!X509_STORE_CTX_init(xsc, ctx.store, NULL, NULL))
+		errx(1, "X509_STORE_CTX_init");
+	x509 = store_cert_new("store add shared %d", 0, &name);
+	if ((certs = X509_STORE_get1_certs(xsc, name)) == NULL ||
+	    sk_X509_num(certs) != 1) {
+		fprintf(stderr, "FAIL: X509_STORE_get1_certs() failed to find "
+		    "the shared certificate\n");
+		failed = 1;
+	}
+	sk_X509_pop_free(certs, X509_free);
+	X509_STORE_CTX_free(xsc);
+	X509_NAME_free(name);
+	X509_free(x509);
+
+	X509_STORE_free(ctx.store);
+
+	return failed;
+}
+
+static void
+rsa_setup(struct lock_test_ctx *ctx)
+{
+	BIGNUM *e;
+
+	if ((e = BN_new()) == NULL)
+		errx(1, "BN_new");
+	if (!BN_set_word(e, RSA_F4))
+		errx(1, "BN_set_word");
+	if ((ctx->rsa = RSA_new()) == NULL)
+		errx(1, "RSA_new");
+	if (!RSA_generate_key_ex(ctx->rsa, 2048, e, NULL))
+		errx(1, "RSA_generate_key_ex");
+	BN_free(e);
+}
+
+static int
+test_rsa_sign(void)
+{
+	struct lock_test_ctx ctx;
+	int failed = 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.iterations = 20;
+	rsa_setup(&ctx);
+
+	/* Private key operations on a shared key share its blindings. */
+	run_threads(LOCK_TEST_THREADS, rsa_sign_thread, &ctx);
+
+	if (ctx.mismatches != 0) {
+		fprintf(stderr, "FAIL: %d RSA signatures failed to verify\n",
+		    ctx.mismatches);
+		failed = 1;
+	}
+
+	/* Same again without blinding, then with it turned back on. */
+	RSA_blinding_off(ctx.rsa);
+	run_threads(LOCK_TEST_THREADS, rsa_sign_thread, &ctx);
+	if (!RSA_blinding_on(ctx.rsa, NULL))
+		errx(1, "RSA_blinding_on");
+	run_threads(LOCK_TEST_THREADS, rsa_sign_thread, &ctx);
+
+	if (ctx.mismatches != 0) {
+		fprintf(stderr, "FAIL: %d RSA signatures failed to verify "
+		    "after toggling blinding\n", ctx.mismatches);
+		failed = 1;
+	}
+
+	RSA_free(ctx.rsa);
+
+	return failed;
+}
+
+static void
+benchmark_run(const char *desc, int nthreads, void *(*func)(void *),
+    struct lock_test_ctx *ctx)
+{
+	struct timespec start, end, duration;
+	double seconds;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	run_threads(nthreads, func, ctx);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	timespecsub(&end, &start, &duration);
+	seconds = duration.tv_sec + duration.tv_nsec / 1000000000.0;
+
+	fprintf(stderr, "Benchmarking %s with %d threads: %d iterations in "
+	    "%f seconds (%.0f/s)\n", desc, nthreads,
+	    nthreads * ctx->iterations, seconds,
+	    nthreads * ctx->iterations / seconds);
+}
+
+static void
+benchmark_lock(void)
+{
+	struct lock_test_ctx ctx;
+	int ncpu, nthreads;
+	size_t i;
+
+	if ((ncpu = sysconf(_SC_NPROCESSORS_ONLN)) < 1)
+		ncpu = 1;
+	if (ncpu > 64)
+		ncpu = 64;
+
+	/*
+	 * CRYPTO_LOCK_BIO is still serialised on a mutex, which gives a
+	 * baseline to compare the atomic reference counts against.
+	 */
+	for (i = 0; i < N_LOCK_TESTS; i++) {
+		for (nthreads = 1; nthreads <= ncpu; nthreads *= 2) {
+			memset(&ctx, 0, sizeof(ctx));
+			ctx.lt = &lock_tests[i];
+			ctx.iterations = 1000000;
+			benchmark_run(ctx.lt->desc, nthreads,
+			    crypto_add_thread, &ctx);
+		}
+	}
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.iterations = 1000000;
+	if ((ctx.pkey = EVP_PKEY_new()) == NULL)
+		errx(1, "EVP_PKEY_new");
+	if ((ctx.x509 = X509_new()) == NULL)
+		errx(1, "X509_new");
+	if ((ctx.store = X509_STORE_new()) == NULL)
+		errx(1, "X509_STORE_new");
+
+	for (nthreads = 1; nthreads <= ncpu; nthreads *= 2)
+		benchmark_run("up ref/free", nthreads, up_ref_thread, &ctx);
+
+	EVP_PKEY_free(ctx.pkey);
+	X509_free(ctx.x509);
+	X509_STORE_free(ctx.store);
+
+	/*
+	 * Readers only contend with each other if there is an occasional
+	 * writer - with reader/writer locks they should scale with threads.
+	 */
+	for (nthreads = 1; nthreads <= ncpu; nthreads *= 2) {
+		memset(&ctx, 0, sizeof(ctx));
+		ctx.iterations = 1000000;
+		benchmark_run("read lock", nthreads, rw_lock_thread, &ctx);
+	}
+	for (nthreads = 1; nthreads <= ncpu; nthreads *= 2) {
+		memset(&ctx, 0, sizeof(ctx));
+		ctx.iterations = 1000000;
+		ctx.write_interval = 1;
+		benchmark_run("write lock", nthreads, rw_lock_thread, &ctx);
+	}
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.iterations = 100000;
+	store_setup(&ctx);
+	for (nthreads = 1; nthreads <= ncpu; nthreads *= 2)
+		benchmark_run("X509_STORE_get1_certs", nthreads,
+		    store_lookup_thread, &ctx);
+	X509_NAME_free(ctx.name);
+	X509_STORE_free(ctx.store);
+
+	/*
+	 * Warming a store interleaves adds and lookups - this should not
+	 * slow down as the store grows.
+	 */
+	for (nthreads = 1; nthreads <= ncpu; nthreads *= 2) {
+		memset(&ctx, 0, sizeof(ctx));
+		ctx.iterations = 100000 / nthreads;
+		if ((ctx.store = X509_STORE_new()) == NULL)
+			errx(1, "X509_STORE_new");
+		benchmark_run("X509_STORE_add_cert/get1_certs", nthreads,
+		    store_add_thread, &ctx);
+		X509_STORE_free(ctx.store);
+	}
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.iterations = 1000;
+	rsa_setup(&ctx);
+	for (nthreads = 1; nthreads <= ncpu; nthreads *= 2)
+		benchmark_run("RSA_sign/RSA_verify", nthreads,
+		    rsa_sign_thread, &ctx);
+	RSA_free(ctx.rsa);
+}
+
+int
+main(int argc, char **argv)
+{
+	int benchmark = 0, failed = 0;
+
+	if (argc == 2 && strcmp(argv[1], "--benchmark") == 0)
+		benchmark = 1;
+
+	failed |= test_crypto_add();
+	failed |= test_up_ref();
+	failed |= test_rw_lock();
+	failed |= test_store_lookup();
+	failed |= test_store_add();
+	failed |= test_rsa_sign();
+
+	if (benchmark && !failed)
+		benchmark_lock();
+
+	return failed;
+}
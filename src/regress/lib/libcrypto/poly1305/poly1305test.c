@@ -14,6 +14,7 @@ void poly1305_auth(unsigned char mac[16], const unsigned char *m, size_t bytes,
 
 int poly1305_verify(const unsigned char mac1[16], const unsigned char mac2[16]);
 int poly1305_power_on_self_test(void);
+int poly1305_long_test(void);
 
 void
 poly1305_auth(unsigned char mac[16], const unsigned char *m, size_t bytes,
@@ -157,6 +158,60 @@ poly1305_power_on_self_test(void)
 	return result;
 }
 
+/*
+ * mac of the macs of messages of length 0 to 1087, where the key and messages
+ * have all their values set to the length, with each message processed in one
+ * call so that long runs of blocks may take a multi-block path, and again one
+ * byte at a time, which must give the same mac.
+ */
+int
+poly1305_long_test(void)
+{
+	static const unsigned char total_key[32] = {
+		0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+		0xff, 0xfe, 0xfd, 0xfc, 0xfb, 0xfa, 0xf9,
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+	};
+
+	static const unsigned char total_mac[16] = {
+		0x61, 0xe7, 0x91, 0x5b, 0x6f, 0x93, 0xa7, 0xa8,
+		0xa0, 0x3e, 0x62, 0x9d, 0x7d, 0x67, 0x31, 0x35
+	};
+
+	poly1305_context ctx;
+	poly1305_context total_ctx;
+	unsigned char all_key[32];
+	unsigned char all_msg[1088];
+	unsigned char mac[16], mac2[16];
+	size_t i, j;
+	int result = 1;
+
+	CRYPTO_poly1305_init(&total_ctx, total_key);
+	for (i = 0; i < sizeof(all_msg); i++) {
+		for (j = 0; j < sizeof(all_key); j++)
+			all_key[j] = i;
+		for (j = 0; j < i; j++)
+			all_msg[j] = i;
+		poly1305_auth(mac, all_msg, i, all_key);
+		CRYPTO_poly1305_update(&total_ctx, mac, 16);
+
+		CRYPTO_poly1305_init(&ctx, all_key);
+		for (j = 0; j < i; j++)
+			CRYPTO_poly1305_update(&ctx, all_msg + j, 1);
+		CRYPTO_poly1305_finish(&ctx, mac2);
+		if (!poly1305_verify(mac, mac2)) {
+			fprintf(stderr, "FAIL: bulk and bytewise mac differ "
+			    "for length %zu\n", i);
+			result = 0;
+		}
+	}
+	CRYPTO_poly1305_finish(&total_ctx, mac);
+	result &= poly1305_verify(total_mac, mac);
+
+	return result;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -164,6 +219,10 @@ main(int argc, char **argv)
 		fprintf(stderr, "One or more self tests failed!\n");
 		return 1;
 	}
+	if (!poly1305_long_test()) {
+		fprintf(stderr, "Long message tests failed!\n");
+		return 1;
+	}
 
 	return 0;
 }
@@ -177,6 +177,119 @@ static const struct sha_test sha_tests[] = {
 			0xaf, 0xac, 0x45, 0x03, 0x7a, 0xfe, 0xe9, 0xd1,
 		}
 	},
+	/*
+	 * Lengths either side of where the padding no longer fits in the
+	 * final block (55 and 119 bytes) and of the one and two block
+	 * boundaries, which the block functions must handle alike.
+	 */
+	{
+		.algorithm = NID_sha256,
+		.in =
+		    "abcdefghbcdefghicdefghijdefghijkefghijklfghijklm"
+		    "ghijklm",
+		.in_len = 55,
+		.out = {
+			0x42, 0x43, 0x97, 0x4b, 0x4d, 0xd5, 0xdc, 0xbe,
+			0x99, 0x52, 0xdb, 0x21, 0x6e, 0x4e, 0x39, 0x9d,
+			0x1d, 0x1a, 0x21, 0xd0, 0xbc, 0x15, 0xd6, 0x19,
+			0x7a, 0xa9, 0x3a, 0x12, 0x13, 0x6c, 0xef, 0x55,
+		}
+	},
+	{
+		.algorithm = NID_sha256,
+		.in =
+		    "abcdefghbcdefghicdefghijdefghijkefghijklfghijklm"
+		    "ghijklmnhijklmn",
+		.in_len = 63,
+		.out = {
+			0x6e, 0x40, 0x6c, 0x47, 0x96, 0x59, 0x1b, 0xa9,
+			0x86, 0x8f, 0xe9, 0x8f, 0x1c, 0x82, 0x01, 0xe0,
+			0x6c, 0x6d, 0x8b, 0x55, 0xd2, 0x73, 0xf1, 0x7f,
+			0xdd, 0x95, 0x7d, 0x12, 0x88, 0xa3, 0x1d, 0x85,
+		}
+	},
+	{
+		.algorithm = NID_sha256,
+		.in =
+		    "abcdefghbcdefghicdefghijdefghijkefghijklfghijklm"
+		    "ghijklmnhijklmno",
+		.in_len = 64,
+		.out = {
+			0x2f, 0xf1, 0x00, 0xb3, 0x6c, 0x38, 0x6c, 0x65,
+			0xa1, 0xaf, 0xc4, 0x62, 0xad, 0x53, 0xe2, 0x54,
+			0x79, 0xbe, 0xc9, 0x49, 0x8e, 0xd0, 0x0a, 0xa5,
+			0xa0, 0x4d, 0xe5, 0x84, 0xbc, 0x25, 0x30, 0x1b,
+		}
+	},
+	{
+		.algorithm = NID_sha256,
+		.in =
+		    "abcdefghbcdefghicdefghijdefghijkefghijklfghijklm"
+		    "ghijklmnhijklmnoi",
+		.in_len = 65,
+		.out = {
+			0xc9, 0x92, 0x1c, 0x36, 0x98, 0xec, 0x01, 0xdd,
+			0xbe, 0xff, 0x79, 0x4e, 0x96, 0xe2, 0x8e, 0x9d,
+			0x47, 0xef, 0x23, 0xc0, 0x86, 0x18, 0x55, 0x3c,
+			0x9b, 0x34, 0x5f, 0xe6, 0xc5, 0x5d, 0x35, 0x62,
+		}
+	},
+	{
+		.algorithm = NID_sha256,
+		.in =
+		    "abcdefghbcdefghicdefghijdefghijkefghijklfghijklm"
+		    "ghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrs"
+		    "mnopqrstnopqrstuopqrstu",
+		.in_len = 119,
+		.out = {
+			0xa4, 0xd2, 0x9f, 0x2e, 0x64, 0x1a, 0x7a, 0x39,
+			0x9e, 0x3c, 0xf0, 0xcf, 0xc8, 0xc0, 0x7f, 0xd7,
+			0xa3, 0xf2, 0xaa, 0xb2, 0x32, 0x9d, 0x46, 0x5e,
+			0xf1, 0xdf, 0xce, 0x9e, 0x34, 0xd5, 0x2f, 0xc6,
+		}
+	},
+	{
+		.algorithm = NID_sha256,
+		.in =
+		    "abcdefghbcdefghicdefghijdefghijkefghijklfghijklm"
+		    "ghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrs"
+		    "mnopqrstnopqrstuopqrstuv",
+		.in_len = 120,
+		.out = {
+			0x0d, 0x6b, 0xd4, 0x33, 0x46, 0x8e, 0x8b, 0x1d,
+			0xe6, 0xad, 0x99, 0xd6, 0x7b, 0x1b, 0x05, 0xa8,
+			0x58, 0x6c, 0x7f, 0x83, 0xcd, 0x40, 0x1e, 0x0e,
+			0x38, 0xad, 0xdc, 0x09, 0x4d, 0x03, 0xf9, 0x93,
+		}
+	},
+	{
+		.algorithm = NID_sha256,
+		.in =
+		    "abcdefghbcdefghicdefghijdefghijkefghijklfghijklm"
+		    "ghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrs"
+		    "mnopqrstnopqrstuopqrstuvpqrstuv",
+		.in_len = 127,
+		.out = {
+			0x48, 0x02, 0x37, 0x8c, 0x15, 0x83, 0x69, 0x3b,
+			0xfb, 0x66, 0x81, 0x71, 0x57, 0xee, 0x87, 0x2c,
+			0xeb, 0x85, 0xa3, 0x15, 0xf8, 0x04, 0xf8, 0xda,
+			0x41, 0x01, 0xb9, 0xb5, 0x5f, 0x35, 0x64, 0x95,
+		}
+	},
+	{
+		.algorithm = NID_sha256,
+		.in =
+		    "abcdefghbcdefghicdefghijdefghijkefghijklfghijklm"
+		    "ghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrs"
+		    "mnopqrstnopqrstuopqrstuvpqrstuvw",
+		.in_len = 128,
+		.out = {
+			0xbe, 0xff, 0xb7, 0x82, 0x0a, 0x29, 0x21, 0xf3,
+			0x08, 0x9b, 0xc0, 0x84, 0x6b, 0x75, 0x18, 0xef,
+			0x11, 0x35, 0x26, 0xc6, 0x48, 0x27, 0x54, 0x59,
+			0xb8, 0x43, 0xd5, 0xef, 0x3d, 0xdc, 0x85, 0xa8,
+		}
+	},
 
 	/* SHA-384 */
 	{
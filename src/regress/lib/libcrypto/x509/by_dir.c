@@ -0,0 +1,332 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include <err.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/x509_vfy.h>
+
+static X509 *
+make_cert(const char *cn, long serial)
+{
+	EVP_PKEY *pkey;
+	EC_KEY *ec_key;
+	X509_NAME *name;
+	X509 *x509;
+
+	if ((ec_key = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1)) == NULL)
+		errx(1, "EC_KEY_new_by_curve_name");
+	if (!EC_KEY_generate_key(ec_key))
+		errx(1, "EC_KEY_generate_key");
+	if ((pkey = EVP_PKEY_new()) == NULL)
+		errx(1, "EVP_PKEY_new");
+	if (!EVP_PKEY_assign_EC_KEY(pkey, ec_key))
+		errx(1, "EVP_PKEY_assign_EC_KEY");
+
+	if ((name = X509_NAME_new()) == NULL)
+		errx(1, "X509_NAME_new");
+	if (!X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+	    (const unsigned char *)cn, -1, -1, 0))
+		errx(1, "X509_NAME_add_entry_by_txt");
+
+	if ((x509 = X509_new()) == NULL)
+		errx(1, "X509_new");
+	if (!X509_set_version(x509, 2))
+		errx(1, "X509_set_version");
+	if (!ASN1_INTEGER_set(X509_get_serialNumber(x509), serial))
+		errx(1, "ASN1_INTEGER_set");
+	if (!X509_set_subject_name(x509, name))
+		errx(1, "X509_set_subject_name");
+	if (!X509_set_issuer_name(x509, name))
+		errx(1, "X509_set_issuer_name");
+	if (X509_gmtime_adj(X509_getm_notBefore(x509), 0) == NULL)
+		errx(1, "X509_gmtime_adj");
+	if (X509_gmtime_adj(X509_getm_notAfter(x509), 3600) == NULL)
+		errx(1, "X509_gmtime_adj");
+	if (!X509_set_pubkey(x509, pkey))
+		errx(1, "X509_set_pubkey");
+	if (!X509_sign(x509, pkey, EVP_sha256()))
+		errx(1, "X509_sign");
+
+	X509_NAME_free(name);
+	EVP_PKEY_free(pkey);
+
+	return x509;
+}
+
+static void
+write_file(const char *dir, const char *file, X509 *x509)
+{
+	char path[PATH_MAX];
+	FILE *fp;
+	int ret;
+
+	ret = snprintf(path, sizeof(path), "%s/%s", dir, file);
+	if (ret < 0 || (size_t)ret >= sizeof(path))
+		errx(1, "snprintf");
+	if ((fp = fopen(path, "w")) == NULL)
+		err(1, "fopen %s", path);
+	if (x509 != NULL && !PEM_write_X509(fp, x509))
+		errx(1, "PEM_write_X509");
+	if (fclose(fp) != 0)
+		err(1, "fclose %s", path);
+}
+
+static void
+write_cert(const char *dir, X509 *x509, int suffix)
+{
+	char file[32];
+
+	snprintf(file, sizeof(file), "%08lx.%d", X509_subject_name_hash(x509),
+	    suffix);
+	write_file(dir, file, x509);
+}
+
+static void
+remove_file(const char *dir, const char *file)
+{
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/%s", dir, file);
+	if (unlink(path) == -1)
+		err(1, "unlink %s", path);
+}
+
+static void
+remove_cert(const char *dir, X509 *x509, int suffix)
+{
+	char file[32];
+
+	snprintf(file, sizeof(file), "%08lx.%d", X509_subject_name_hash(x509),
+	    suffix);
+	remove_file(dir, file);
+}
+
+static int
+lookup_certs(X509_STORE *store, X509 *x509)
+{
+	X509_STORE_CTX *xsc;
+	STACK_OF(X509) *certs;
+	int num = 0;
+
+	if ((xsc = X509_STORE_CTX_new()) == NULL)
+		errx(1, "X509_STORE_CTX_new");
+	if (!X509_STORE_CTX_init(xsc, store, NULL, NULL))
+		errx(1, "X509_STORE_CTX_init");
+	if ((certs = X509_STORE_get1_certs(xsc, X509_get_subject_name(x509)))
+	    != NULL)
+		num = sk_X509_num(certs);
+	sk_X509_pop_free(certs, X509_free);
+	X509_STORE_CTX_free(xsc);
+
+	return num;
+}
+
+/*
+ * Changes to the directory are only noticed once it has not been checked for
+ * a second, and not modified in the second it is checked.
+ */
+static void
+wait_for_dir(void)
+{
+	sleep(2);
+}
+
+static int
+test_by_dir(int snapshot)
+{
+	const char *desc = snapshot ? "snapshot" : "negative cache";
+	char dir[] = "/tmp/by_dir.XXXXXXXXXX";
+	char dirs[sizeof(dir) + 32];
+	X509_STORE *store;
+	X509_LOOKUP *lookup;
+	X509 *a, *b0, *b1;
+	int i, num;
+	int failed = 1;
+
+	if (mkdtemp(dir) == NULL)
+		err(1, "mkdtemp");
+	snprintf(dirs, sizeof(dirs), "%s:%s/missing", dir, dir);
+
+	a = make_cert("by_dir a", 1);
+	b0 = make_cert("by_dir b", 1);
+	b1 = make_cert("by_dir b", 2);
+
+	if ((store = X509_STORE_new()) == NULL)
+		errx(1, "X509_STORE_new");
+	if ((lookup = X509_STORE_add_lookup(store, X509_LOOKUP_hash_dir()))
+	    == NULL)
+		errx(1, "X509_STORE_add_lookup");
+	if (!X509_LOOKUP_add_dir(lookup, dirs, X509_FILETYPE_PEM))
+		errx(1, "X509_LOOKUP_add_dir");
+	if (!X509_LOOKUP_set_dir_snapshot(lookup, snapshot))
+		errx(1, "X509_LOOKUP_set_dir_snapshot");
+
+	write_cert(dir, a, 0);
+	write_file(dir, "README", NULL);
+	write_file(dir, "0000000g.0", NULL);
+	wait_for_dir();
+
+	if ((num = lookup_certs(store, a)) != 1) {
+		fprintf(stderr, "FAIL: %s: found %d certificates for a, "
+		    "want 1\n", desc, num);
+		goto fail;
+	}
+	for (i = 0; i < 3; i++) {
+		if ((num = lookup_certs(store, b0)) != 0) {
+			fprintf(stderr, "FAIL: %s: found %d certificates for "
+			    "b before adding it, want 0\n", desc, num);
+			goto fail;
+		}
+	}
+
+	write_cert(dir, b0, 0);
+	write_cert(dir, b1, 1);
+	wait_for_dir();
+
+	if ((num = lookup_certs(store, b0)) != 2) {
+		fprintf(stderr, "FAIL: %s: found %d certificates for b, "
+		    "want 2\n", desc, num);
+		goto fail;
+	}
+
+	failed = 0;
+
+ fail:
+	remove_cert(dir, a, 0);
+	remove_cert(dir, b0, 0);
+	remove_cert(dir, b1, 1);
+	remove_file(dir, "README");
+	remove_file(dir, "0000000g.0");
+	if (rmdir(dir) == -1)
+		err(1, "rmdir %s", dir);
+
+	X509_STORE_free(store);
+	X509_free(a);
+	X509_free(b0);
+	X509_free(b1);
+
+	return failed;
+}
+
+/*
+ * Switching the mode must drop what was cached in the previous mode. A file
+ * is added without the mtime of the directory changing, so that it is only
+ * found if the directory is searched again.
+ */
+static int
+test_by_dir_switch(int snapshot)
+{
+	const char *desc = snapshot ? "snapshot to negative cache" :
+	    "negative cache to snapshot";
+	char dir[] = "/tmp/by_dir.XXXXXXXXXX";
+	struct timeval tv[2];
+	struct stat st;
+	X509_STORE *store;
+	X509_LOOKUP *lookup;
+	X509 *a, *b;
+	int num;
+	int failed = 1;
+
+	if (mkdtemp(dir) == NULL)
+		err(1, "mkdtemp");
+
+	a = make_cert("by_dir a", 1);
+	b = make_cert("by_dir b", 1);
+
+	if ((store = X509_STORE_new()) == NULL)
+		errx(1, "X509_STORE_new");
+	if ((lookup = X509_STORE_add_lookup(store, X509_LOOKUP_hash_dir()))
+	    == NULL)
+		errx(1, "X509_STORE_add_lookup");
+	if (!X509_LOOKUP_add_dir(lookup, dir, X509_FILETYPE_PEM))
+		errx(1, "X509_LOOKUP_add_dir");
+	if (!X509_LOOKUP_set_dir_snapshot(lookup, snapshot))
+		errx(1, "X509_LOOKUP_set_dir_snapshot");
+
+	write_cert(dir, a, 0);
+	wait_for_dir();
+
+	if ((num = lookup_certs(store, b)) != 0) {
+		fprintf(stderr, "FAIL: %s: found %d certificates for b before "
+		    "adding it, want 0\n", desc, num);
+		goto fail;
+	}
+
+	if (stat(dir, &st) == -1)
+		err(1, "stat %s", dir);
+	write_cert(dir, b, 0);
+	TIMESPEC_TO_TIMEVAL(&tv[0], &st.st_atim);
+	TIMESPEC_TO_TIMEVAL(&tv[1], &st.st_mtim);
+	if (utimes(dir, tv) == -1)
+		err(1, "utimes %s", dir);
+	wait_for_dir();
+
+	if ((num = lookup_certs(store, b)) != 0) {
+		fprintf(stderr, "FAIL: %s: found %d certificates for b with "
+		    "the directory unchanged, want 0\n", desc, num);
+		goto fail;
+	}
+
+	if (!X509_LOOKUP_set_dir_snapshot(lookup, !snapshot))
+		errx(1, "X509_LOOKUP_set_dir_snapshot");
+
+	if ((num = lookup_certs(store, b)) != 1) {
+		fprintf(stderr, "FAIL: %s: found %d certificates for b after "
+		    "switching, want 1\n", desc, num);
+		goto fail;
+	}
+
+	failed = 0;
+
+ fail:
+	remove_cert(dir, a, 0);
+	remove_cert(dir, b, 0);
+	if (rmdir(dir) == -1)
+		err(1, "rmdir %s", dir);
+
+	X509_STORE_free(store);
+	X509_free(a);
+	X509_free(b);
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	int failed = 0;
+
+	failed |= test_by_dir(0);
+	failed |= test_by_dir(1);
+	failed |= test_by_dir_switch(0);
+	failed |= test_by_dir_switch(1);
+
+	return failed;
+}
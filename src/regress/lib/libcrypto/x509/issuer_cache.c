@@ -0,0 +1,242 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <err.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "x509_issuer_cache.h"
+
+#define N_THREADS	8
+#define N_ITERATIONS	20000
+
+static unsigned char parent_md[EVP_MAX_MD_SIZE];
+
+/*
+ * Child digests select their shard with the first byte, so that the test
+ * knows where each entry goes. The remaining bytes tell entries apart.
+ */
+static void
+child(unsigned char *md, int shard, uint32_t n)
+{
+	memset(md, 0, EVP_MAX_MD_SIZE);
+	md[0] = shard;
+	memcpy(&md[1], &n, sizeof(n));
+}
+
+static int
+find(int shard, uint32_t n)
+{
+	unsigned char md[EVP_MAX_MD_SIZE];
+
+	child(md, shard, n);
+	return x509_issuer_cache_find(parent_md, md);
+}
+
+static void
+add(int shard, uint32_t n, int valid)
+{
+	unsigned char md[EVP_MAX_MD_SIZE];
+
+	child(md, shard, n);
+	x509_issuer_cache_add(parent_md, md, valid);
+}
+
+static int
+test_issuer_cache_clock(void)
+{
+	int failed = 1;
+
+	x509_issuer_cache_free();
+	if (!x509_issuer_cache_set_max(2 * X509_ISSUER_CACHE_SHARDS))
+		errx(1, "x509_issuer_cache_set_max");
+
+	add(0, 1, 1);
+	add(0, 2, 0);
+	add(0, 2, 1);	/* Not replaced. */
+
+	if (find(0, 1) != 1) {
+		fprintf(stderr, "FAIL: entry 1 not found\n");
+		goto fail;
+	}
+	if (find(1, 1) != -1) {
+		fprintf(stderr, "FAIL: found entry 1 in the wrong shard\n");
+		goto fail;
+	}
+
+	/*
+	 * The shard is full. Entry 1 has been used since it was added and
+	 * entry 2 has not, so adding entry 3 must evict entry 2.
+	 */
+	add(0, 3, 1);
+	add(0, 1, 0);	/* Already cached, must not evict. */
+
+	if (find(0, 2) != -1) {
+		fprintf(stderr, "FAIL: unreferenced entry 2 not evicted\n");
+		goto fail;
+	}
+	if (find(0, 1) != 1) {
+		fprintf(stderr, "FAIL: referenced entry 1 evicted\n");
+		goto fail;
+	}
+	if (find(0, 3) != 1) {
+		fprintf(stderr, "FAIL: entry 3 not found\n");
+		goto fail;
+	}
+
+	failed = 0;
+
+ fail:
+	return failed;
+}
+
+static int
+test_issuer_cache_max(void)
+{
+	uint32_t i;
+	int failed = 1;
+
+	x509_issuer_cache_free();
+	if (!x509_issuer_cache_set_max(4 * X509_ISSUER_CACHE_SHARDS))
+		errx(1, "x509_issuer_cache_set_max");
+
+	for (i = 0; i < 8 * X509_ISSUER_CACHE_SHARDS; i++)
+		add(i % X509_ISSUER_CACHE_SHARDS, i, i & 1);
+
+	/* The earliest additions have been evicted... */
+	for (i = 0; i < 4 * X509_ISSUER_CACHE_SHARDS; i++) {
+		if (find(i % X509_ISSUER_CACHE_SHARDS, i) != -1) {
+			fprintf(stderr, "FAIL: entry %u not evicted\n", i);
+			goto fail;
+		}
+	}
+
+	/* ...and the most recent additions remain. */
+	for (i = 4 * X509_ISSUER_CACHE_SHARDS; i < 8 * X509_ISSUER_CACHE_SHARDS;
+	    i++) {
+		if (find(i % X509_ISSUER_CACHE_SHARDS, i) != (int)(i & 1)) {
+			fprintf(stderr, "FAIL: entry %u not found\n", i);
+			goto fail;
+		}
+	}
+
+	/*
+	 * Lowering the maximum takes effect on the next addition to a shard,
+	 * which is then trimmed to its share of the new maximum.
+	 */
+	if (!x509_issuer_cache_set_max(X509_ISSUER_CACHE_SHARDS))
+		errx(1, "x509_issuer_cache_set_max");
+	add(0, 1000, 1);
+	for (i = 4 * X509_ISSUER_CACHE_SHARDS; i < 8 * X509_ISSUER_CACHE_SHARDS;
+	    i += X509_ISSUER_CACHE_SHARDS) {
+		if (find(0, i) != -1) {
+			fprintf(stderr, "FAIL: entry %u not evicted on "
+			    "shrink\n", i);
+			goto fail;
+		}
+	}
+	if (find(0, 1000) != 1) {
+		fprintf(stderr, "FAIL: entry 1000 not found\n");
+		goto fail;
+	}
+	if (find(1, 4 * X509_ISSUER_CACHE_SHARDS + 1) != 1) {
+		fprintf(stderr, "FAIL: untouched shard trimmed\n");
+		goto fail;
+	}
+
+	/* A maximum of 0 disables the cache. */
+	if (!x509_issuer_cache_set_max(0))
+		errx(1, "x509_issuer_cache_set_max");
+	add(1, 1001, 1);
+	if (find(0, 1000) != -1 || find(1, 1001) != -1) {
+		fprintf(stderr, "FAIL: disabled cache found an entry\n");
+		goto fail;
+	}
+
+	failed = 0;
+
+ fail:
+	return failed;
+}
+
+static void *
+issuer_cache_thread(void *arg)
+{
+	uintptr_t id = (uintptr_t)arg;
+	uint32_t i, n;
+	int ret;
+
+	for (i = 0; i < N_ITERATIONS; i++) {
+		n = (i * 7 + id) % 1024;
+		if ((ret = find(n % 251, n)) == -1) {
+			add(n % 251, n, n & 1);
+			continue;
+		}
+		if (ret != (int)(n & 1))
+			return (void *)1;
+	}
+
+	return NULL;
+}
+
+static int
+test_issuer_cache_threads(void)
+{
+	pthread_t threads[N_THREADS];
+	void *ret;
+	uintptr_t i;
+	int failed = 0;
+
+	x509_issuer_cache_free();
+	if (!x509_issuer_cache_set_max(256))
+		errx(1, "x509_issuer_cache_set_max");
+
+	for (i = 0; i < N_THREADS; i++) {
+		if (pthread_create(&threads[i], NULL, issuer_cache_thread,
+		    (void *)i) != 0)
+			errx(1, "pthread_create");
+	}
+	for (i = 0; i < N_THREADS; i++) {
+		if (pthread_join(threads[i], &ret) != 0)
+			errx(1, "pthread_join");
+		if (ret != NULL) {
+			fprintf(stderr, "FAIL: thread %lu found a wrong "
+			    "result\n", (unsigned long)i);
+			failed = 1;
+		}
+	}
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	int failed = 0;
+
+	memset(parent_md, 0xaa, sizeof(parent_md));
+
+	failed |= test_issuer_cache_clock();
+	failed |= test_issuer_cache_max();
+	failed |= test_issuer_cache_threads();
+
+	x509_issuer_cache_free();
+
+	return failed;
+}
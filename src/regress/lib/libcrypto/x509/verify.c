@@ -18,10 +18,13 @@
 
 #include <err.h>
 #include <string.h>
+#include <time.h>
 
 #include <openssl/bio.h>
 #include <openssl/crypto.h>
+#include <openssl/ec.h>
 #include <openssl/err.h>
+#include <openssl/evp.h>
 #include <openssl/pem.h>
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
@@ -32,9 +35,14 @@
 #define MODE_MODERN_VFY_DIR	1
 #define MODE_LEGACY_VFY		2
 #define MODE_VERIFY		3
+#define MODE_VERIFY_INDEXED	4
+#define MODE_MODERN_VFY_CACHED	5
 
 static int verbose = 1;
 
+/* Leaf certs of all tests, used to pad roots and intermediates. */
+static STACK_OF(X509) *padding;
+
 static int
 passwd_cb(char *buf, int size, int rwflag, void *u)
 {
@@ -175,8 +183,140 @@ verify_cert(const char *roots_dir, const char *roots_file,
 	X509_free(leaf);
 }
 
+static int
+verify_cert_store(X509_STORE *store, X509 *leaf, STACK_OF(X509) *bundle,
+    int *error, int *error_depth, int *chain_len)
+{
+	X509_STORE_CTX *xsc;
+	int ret;
+
+	if ((xsc = X509_STORE_CTX_new()) == NULL)
+		errx(1, "X509_STORE_CTX");
+	if (!X509_STORE_CTX_init(xsc, store, leaf, bundle)) {
+		ERR_print_errors_fp(stderr);
+		errx(1, "failed to init store context");
+	}
+	X509_VERIFY_PARAM_clear_flags(X509_STORE_CTX_get0_param(xsc),
+	    X509_V_FLAG_LEGACY_VERIFY);
+
+	ret = X509_verify_cert(xsc);
+
+	*error = X509_STORE_CTX_get_error(xsc);
+	*error_depth = X509_STORE_CTX_get_error_depth(xsc);
+	*chain_len = sk_X509_num(X509_STORE_CTX_get0_chain(xsc));
+
+	X509_STORE_CTX_free(xsc);
+
+	return ret;
+}
+
+/*
+ * Verify against a store with a verification cache. The second
+ * verification must be answered from the cache with the same result.
+ * Changes made through X509_STORE_get0_objects() are not noticed, so
+ * removing the roots that way must not change the result either, while
+ * adding a cert to the store must cause the chain to be verified again.
+ */
+static void
+verify_cert_cached(const char *roots_file, const char *bundle_file,
+    int *chains, int *error, int *error_depth)
+{
+	STACK_OF(X509) *roots = NULL, *bundle = NULL;
+	STACK_OF(X509_OBJECT) *objs;
+	X509_STORE *store = NULL;
+	X509 *leaf = NULL;
+	int cached_error, cached_error_depth;
+	int chain_len, cached_chain_len;
+	int i, ret;
+
+	*chains = 0;
+	*error = 0;
+	*error_depth = 0;
+
+	if (!certs_from_file(roots_file, &roots))
+		errx(1, "failed to load roots from '%s'", roots_file);
+	if (!certs_from_file(bundle_file, &bundle))
+		errx(1, "failed to load bundle from '%s'", bundle_file);
+	if (sk_X509_num(bundle) < 1)
+		errx(1, "not enough certs in bundle");
+	leaf = sk_X509_shift(bundle);
+
+	if ((store = X509_STORE_new()) == NULL)
+		errx(1, "X509_STORE");
+	if (!X509_STORE_set_verify_cache(store, 16))
+		errx(1, "failed to enable verify cache");
+	for (i = 0; i < sk_X509_num(roots); i++) {
+		if (!X509_STORE_add_cert(store, sk_X509_value(roots, i)))
+			errx(1, "failed to add root");
+	}
+
+	ret = verify_cert_store(store, leaf, bundle, error, error_depth,
+	    &chain_len);
+	if (ret == 1)
+		*chains = 1;
+	else if (ret != 0)
+		*chains = -1;
+
+	if (verify_cert_store(store, leaf, bundle, &cached_error,
+	    &cached_error_depth, &cached_chain_len) != ret ||
+	    cached_error != *error || cached_error_depth != *error_depth ||
+	    cached_chain_len != chain_len) {
+		fprintf(stderr, "FAIL: cached result differs\n");
+		*chains = -1;
+	}
+
+	objs = X509_STORE_get0_objects(store);
+	while (sk_X509_OBJECT_num(objs) > 0)
+		X509_OBJECT_free(sk_X509_OBJECT_pop(objs));
+
+	if (verify_cert_store(store, leaf, bundle, &cached_error,
+	    &cached_error_depth, &cached_chain_len) != ret ||
+	    cached_error != *error || cached_chain_len != chain_len) {
+		fprintf(stderr, "FAIL: result not from cache\n");
+		*chains = -1;
+	}
+
+	if (!X509_STORE_add_cert(store, leaf))
+		errx(1, "failed to add leaf");
+	if (verify_cert_store(store, leaf, bundle, &cached_error,
+	    &cached_error_depth, &cached_chain_len) != 0) {
+		fprintf(stderr, "FAIL: cached result not invalidated\n");
+		*chains = -1;
+	}
+
+	if (ret != 1)
+		fprintf(stderr, "failed to verify at %d: %s\n",
+		    *error_depth, X509_verify_cert_error_string(*error));
+
+	sk_X509_pop_free(roots, X509_free);
+	sk_X509_pop_free(bundle, X509_free);
+	X509_STORE_free(store);
+	X509_free(leaf);
+}
+
+/*
+ * Put the padding certs in front of certs, so that the roots and
+ * intermediates are large enough to be indexed and their positions move.
+ */
+static void
+pad_certs(STACK_OF(X509) *certs, X509 *leaf)
+{
+	X509 *x;
+	int i;
+
+	for (i = 0; i < sk_X509_num(padding); i++) {
+		x = sk_X509_value(padding, i);
+		if (X509_cmp(x, leaf) == 0)
+			continue;
+		if (!sk_X509_unshift(certs, x))
+			errx(1, "failed to unshift X509");
+		X509_up_ref(x);
+	}
+}
+
 static void
-verify_cert_new(const char *roots_file, const char *bundle_file, int *chains)
+verify_cert_new(const char *roots_file, const char *bundle_file, int *chains,
+    int mode)
 {
 	STACK_OF(X509) *roots = NULL, *bundle = NULL;
 	X509_STORE_CTX *xsc = NULL;
@@ -193,6 +333,11 @@ verify_cert_new(const char *roots_file, const char *bundle_file, int *chains)
 		errx(1, "not enough certs in bundle");
 	leaf = sk_X509_shift(bundle);
 
+	if (mode == MODE_VERIFY_INDEXED) {
+		pad_certs(roots, leaf);
+		pad_certs(bundle, leaf);
+	}
+
         if ((xsc = X509_STORE_CTX_new()) == NULL)
 		errx(1, "X509_STORE_CTX");
 	if (!X509_STORE_CTX_init(xsc, NULL, leaf, bundle)) {
@@ -465,6 +610,31 @@ struct verify_cert_test verify_cert_tests[] = {
 #define N_VERIFY_CERT_TESTS \
     (sizeof(verify_cert_tests) / sizeof(*verify_cert_tests))
 
+static void
+load_padding(const char *certs_path)
+{
+	STACK_OF(X509) *bundle;
+	char *bundle_file;
+	size_t i;
+
+	if ((padding = sk_X509_new_null()) == NULL)
+		errx(1, "failed to create X509 stack");
+
+	for (i = 0; i < N_VERIFY_CERT_TESTS; i++) {
+		if (asprintf(&bundle_file, "%s/%s/bundle.pem", certs_path,
+		    verify_cert_tests[i].id) == -1)
+			errx(1, "asprintf");
+		if (!certs_from_file(bundle_file, &bundle))
+			errx(1, "failed to load bundle from '%s'", bundle_file);
+		if (sk_X509_num(bundle) < 1)
+			errx(1, "not enough certs in bundle");
+		if (!sk_X509_push(padding, sk_X509_shift(bundle)))
+			errx(1, "failed to push X509");
+		sk_X509_pop_free(bundle, X509_free);
+		free(bundle_file);
+	}
+}
+
 static int
 verify_cert_test(const char *certs_path, int mode)
 {
@@ -490,13 +660,18 @@ verify_cert_test(const char *certs_path, int mode)
 		error_depth = 0;
 
 		fprintf(stderr, "== Test %zu (%s)\n", i, vct->id);
-		if (mode == MODE_VERIFY)
-			verify_cert_new(roots_file, bundle_file, &chains);
+		if (mode == MODE_VERIFY || mode == MODE_VERIFY_INDEXED)
+			verify_cert_new(roots_file, bundle_file, &chains,
+			    mode);
+		else if (mode == MODE_MODERN_VFY_CACHED)
+			verify_cert_cached(roots_file, bundle_file, &chains,
+			    &error, &error_depth);
 		else
 			verify_cert(roots_dir, roots_file, bundle_file, &chains,
 			    &error, &error_depth, mode);
 
-		if ((mode == MODE_VERIFY && chains == vct->want_chains) ||
+		if (((mode == MODE_VERIFY || mode == MODE_VERIFY_INDEXED) &&
+		    chains == vct->want_chains) ||
 		    (chains == 0 && vct->want_chains == 0) ||
 		    (chains == 1 && vct->want_chains > 0)) {
 			fprintf(stderr, "INFO: Succeeded with %d chains%s\n",
@@ -522,7 +697,9 @@ verify_cert_test(const char *certs_path, int mode)
 				    vct->want_legacy_error_depth);
 				failed |= 1;
 			}
-		} else if (mode == MODE_MODERN_VFY || mode == MODE_MODERN_VFY_DIR) {
+		} else if (mode == MODE_MODERN_VFY ||
+		    mode == MODE_MODERN_VFY_DIR ||
+		    mode == MODE_MODERN_VFY_CACHED) {
 			if (error != vct->want_error) {
 				fprintf(stderr, "FAIL: Got error %d, want %d\n",
 				    error, vct->want_error);
@@ -545,6 +722,203 @@ verify_cert_test(const char *certs_path, int mode)
 	return failed;
 }
 
+static EVP_PKEY *
+crl_test_key(void)
+{
+	EVP_PKEY *pkey;
+	EC_KEY *ec_key;
+
+	if ((ec_key = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1)) == NULL)
+		errx(1, "EC_KEY_new_by_curve_name");
+	if (!EC_KEY_generate_key(ec_key))
+		errx(1, "EC_KEY_generate_key");
+	if ((pkey = EVP_PKEY_new()) == NULL)
+		errx(1, "EVP_PKEY_new");
+	if (!EVP_PKEY_assign_EC_KEY(pkey, ec_key))
+		errx(1, "EVP_PKEY_assign_EC_KEY");
+
+	return pkey;
+}
+
+static X509 *
+crl_test_cert(const char *cn, long serial, EVP_PKEY *pkey, X509 *ca,
+    EVP_PKEY *ca_pkey)
+{
+	BASIC_CONSTRAINTS *bc;
+	X509_NAME *name;
+	X509 *x509;
+
+	if ((name = X509_NAME_new()) == NULL)
+		errx(1, "X509_NAME_new");
+	if (!X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+	    (const unsigned char *)cn, -1, -1, 0))
+		errx(1, "X509_NAME_add_entry_by_txt");
+
+	if ((x509 = X509_new()) == NULL)
+		errx(1, "X509_new");
+	if (!X509_set_version(x509, 2))
+		errx(1, "X509_set_version");
+	if (!ASN1_INTEGER_set(X509_get_serialNumber(x509), serial))
+		errx(1, "ASN1_INTEGER_set");
+	if (!X509_set_subject_name(x509, name))
+		errx(1, "X509_set_subject_name");
+	if (!X509_set_issuer_name(x509, ca != NULL ?
+	    X509_get_subject_name(ca) : name))
+		errx(1, "X509_set_issuer_name");
+	if (X509_gmtime_adj(X509_get_notBefore(x509), -3600) == NULL)
+		errx(1, "X509_gmtime_adj");
+	if (X509_gmtime_adj(X509_get_notAfter(x509), 86400) == NULL)
+		errx(1, "X509_gmtime_adj");
+	if (!X509_set_pubkey(x509, pkey))
+		errx(1, "X509_set_pubkey");
+
+	if (ca == NULL) {
+		if ((bc = BASIC_CONSTRAINTS_new()) == NULL)
+			errx(1, "BASIC_CONSTRAINTS_new");
+		bc->ca = 1;
+		if (!X509_add1_ext_i2d(x509, NID_basic_constraints, bc, 1, 0))
+			errx(1, "X509_add1_ext_i2d");
+		BASIC_CONSTRAINTS_free(bc);
+	}
+
+	if (!X509_sign(x509, ca_pkey, EVP_sha256()))
+		errx(1, "X509_sign");
+
+	X509_NAME_free(name);
+
+	return x509;
+}
+
+static X509_CRL *
+crl_test_crl(X509 *ca, EVP_PKEY *ca_pkey, long revoked_serial)
+{
+	X509_REVOKED *revoked;
+	ASN1_INTEGER *serial;
+	ASN1_TIME *t;
+	X509_CRL *crl;
+
+	if ((crl = X509_CRL_new()) == NULL)
+		errx(1, "X509_CRL_new");
+	if (!X509_CRL_set_version(crl, 1))
+		errx(1, "X509_CRL_set_version");
+	if (!X509_CRL_set_issuer_name(crl, X509_get_subject_name(ca)))
+		errx(1, "X509_CRL_set_issuer_name");
+	if ((t = X509_gmtime_adj(NULL, -3600)) == NULL)
+		errx(1, "X509_gmtime_adj");
+	if (!X509_CRL_set1_lastUpdate(crl, t))
+		errx(1, "X509_CRL_set1_lastUpdate");
+	if (X509_gmtime_adj(t, 86400) == NULL)
+		errx(1, "X509_gmtime_adj");
+	if (!X509_CRL_set1_nextUpdate(crl, t))
+		errx(1, "X509_CRL_set1_nextUpdate");
+
+	if ((revoked = X509_REVOKED_new()) == NULL)
+		errx(1, "X509_REVOKED_new");
+	if ((serial = ASN1_INTEGER_new()) == NULL)
+		errx(1, "ASN1_INTEGER_new");
+	if (!ASN1_INTEGER_set(serial, revoked_serial))
+		errx(1, "ASN1_INTEGER_set");
+	if (!X509_REVOKED_set_serialNumber(revoked, serial))
+		errx(1, "X509_REVOKED_set_serialNumber");
+	if (!X509_REVOKED_set_revocationDate(revoked, t))
+		errx(1, "X509_REVOKED_set_revocationDate");
+	if (!X509_CRL_add0_revoked(crl, revoked))
+		errx(1, "X509_CRL_add0_revoked");
+
+	if (!X509_CRL_sort(crl))
+		errx(1, "X509_CRL_sort");
+	if (!X509_CRL_sign(crl, ca_pkey, EVP_sha256()))
+		errx(1, "X509_CRL_sign");
+
+	ASN1_INTEGER_free(serial);
+	ASN1_TIME_free(t);
+
+	return crl;
+}
+
+static int
+crl_test_verify(X509_STORE *store, X509 *leaf, X509_CRL *crl, int *error)
+{
+	STACK_OF(X509_CRL) *crls;
+	X509_STORE_CTX *xsc;
+	int ret;
+
+	if ((crls = sk_X509_CRL_new_null()) == NULL)
+		errx(1, "sk_X509_CRL_new_null");
+	if (!sk_X509_CRL_push(crls, crl))
+		errx(1, "sk_X509_CRL_push");
+
+	if ((xsc = X509_STORE_CTX_new()) == NULL)
+		errx(1, "X509_STORE_CTX_new");
+	if (!X509_STORE_CTX_init(xsc, store, leaf, NULL))
+		errx(1, "X509_STORE_CTX_init");
+	X509_STORE_CTX_set0_crls(xsc, crls);
+	X509_STORE_CTX_set_flags(xsc, X509_V_FLAG_CRL_CHECK);
+
+	ret = X509_verify_cert(xsc);
+	*error = X509_STORE_CTX_get_error(xsc);
+
+	X509_STORE_CTX_free(xsc);
+	sk_X509_CRL_free(crls);
+
+	return ret;
+}
+
+/*
+ * CRLs built in memory, rather than decoded, must still give different
+ * verification cache keys when their contents differ.
+ */
+static int
+verify_cache_crl_test(void)
+{
+	EVP_PKEY *ca_pkey, *leaf_pkey;
+	X509_CRL *crl_other, *crl_leaf;
+	X509_STORE *store;
+	X509 *ca, *leaf;
+	int error, ret;
+	int failed = 1;
+
+	ca_pkey = crl_test_key();
+	leaf_pkey = crl_test_key();
+	ca = crl_test_cert("verify cache CA", 1, ca_pkey, NULL, ca_pkey);
+	leaf = crl_test_cert("verify cache leaf", 2, leaf_pkey, ca, ca_pkey);
+	crl_other = crl_test_crl(ca, ca_pkey, 3);
+	crl_leaf = crl_test_crl(ca, ca_pkey, 2);
+
+	if ((store = X509_STORE_new()) == NULL)
+		errx(1, "X509_STORE_new");
+	if (!X509_STORE_set_verify_cache(store, 16))
+		errx(1, "failed to enable verify cache");
+	if (!X509_STORE_add_cert(store, ca))
+		errx(1, "X509_STORE_add_cert");
+
+	if ((ret = crl_test_verify(store, leaf, crl_other, &error)) != 1) {
+		fprintf(stderr, "FAIL: CRL without the leaf: got %d, error "
+		    "%d, want 1\n", ret, error);
+		goto fail;
+	}
+	if ((ret = crl_test_verify(store, leaf, crl_leaf, &error)) != 0 ||
+	    error != X509_V_ERR_CERT_REVOKED) {
+		fprintf(stderr, "FAIL: CRL revoking the leaf: got %d, error "
+		    "%d, want 0 and %d\n", ret, error,
+		    X509_V_ERR_CERT_REVOKED);
+		goto fail;
+	}
+
+	failed = 0;
+
+ fail:
+	X509_STORE_free(store);
+	X509_CRL_free(crl_other);
+	X509_CRL_free(crl_leaf);
+	X509_free(ca);
+	X509_free(leaf);
+	EVP_PKEY_free(ca_pkey);
+	EVP_PKEY_free(leaf_pkey);
+
+	return failed;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -561,8 +935,16 @@ main(int argc, char **argv)
 	failed |= verify_cert_test(argv[1], MODE_MODERN_VFY);
 	fprintf(stderr, "\n\nTesting modern x509_vfy by_dir\n");
 	failed |= verify_cert_test(argv[1], MODE_MODERN_VFY_DIR);
+	fprintf(stderr, "\n\nTesting modern x509_vfy with verify cache\n");
+	failed |= verify_cert_test(argv[1], MODE_MODERN_VFY_CACHED);
+	fprintf(stderr, "\n\nTesting verify cache with CRLs\n");
+	failed |= verify_cache_crl_test();
 	fprintf(stderr, "\n\nTesting x509_verify\n");
 	failed |= verify_cert_test(argv[1], MODE_VERIFY);
+	fprintf(stderr, "\n\nTesting x509_verify with indexed certs\n");
+	load_padding(argv[1]);
+	failed |= verify_cert_test(argv[1], MODE_VERIFY_INDEXED);
+	sk_X509_pop_free(padding, X509_free);
 
 	return (failed);
 }
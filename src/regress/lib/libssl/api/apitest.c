@@ -352,6 +352,266 @@ ssl_get_peer_cert_chain_tests(void)
 	return failed;
 }
 
+static int
+ssl_chain_certs_change_test(uint16_t tls_version)
+{
+	STACK_OF(X509) *chain, *peer_chain;
+	BIO *client_wbio = NULL, *server_wbio = NULL;
+	SSL *client = NULL, *server = NULL;
+	X509 *ca = NULL;
+	int failed = 1;
+
+	if ((client_wbio = BIO_new(BIO_s_mem())) == NULL)
+		goto failure;
+	if (BIO_set_mem_eof_return(client_wbio, -1) <= 0)
+		goto failure;
+
+	if ((server_wbio = BIO_new(BIO_s_mem())) == NULL)
+		goto failure;
+	if (BIO_set_mem_eof_return(server_wbio, -1) <= 0)
+		goto failure;
+
+	if ((client = tls_client(server_wbio, client_wbio)) == NULL)
+		goto failure;
+	if (!SSL_set_min_proto_version(client, tls_version))
+		goto failure;
+	if (!SSL_set_max_proto_version(client, tls_version))
+		goto failure;
+
+	if ((server = tls_server(client_wbio, server_wbio)) == NULL)
+		goto failure;
+	if (!SSL_set_min_proto_version(server, tls_version))
+		goto failure;
+	if (!SSL_set_max_proto_version(server, tls_version))
+		goto failure;
+
+	/*
+	 * Replace the chain loaded with the keypair with one that has the
+	 * intermediate twice - the server must send the chain as changed.
+	 */
+	if (!SSL_get0_chain_certs(server, &chain))
+		goto failure;
+	if (sk_X509_num(chain) != 1) {
+		fprintf(stderr, "FAIL: server has chain with %d certificates, "
+		    "want 1\n", sk_X509_num(chain));
+		goto failure;
+	}
+	ca = sk_X509_value(chain, 0);
+	X509_up_ref(ca);
+
+	if (!SSL_clear_chain_certs(server))
+		goto failure;
+	if (!SSL_add1_chain_cert(server, ca))
+		goto failure;
+	if (!SSL_add1_chain_cert(server, ca))
+		goto failure;
+
+	if (!do_client_server_loop(client, do_connect, server, do_accept)) {
+		fprintf(stderr, "FAIL: client and server handshake failed\n");
+		goto failure;
+	}
+
+	peer_chain = SSL_get_peer_cert_chain(client);
+	if (sk_X509_num(peer_chain) != 3) {
+		fprintf(stderr, "FAIL: client got peer cert chain with %d "
+		    "certificates, want 3\n", sk_X509_num(peer_chain));
+		goto failure;
+	}
+	if (X509_cmp(ca, sk_X509_value(peer_chain, 2)) != 0) {
+		fprintf(stderr, "FAIL: client got peer cert chain without "
+		    "intermediate\n");
+		goto failure;
+	}
+
+	fprintf(stderr, "INFO: Done!\n");
+
+	failed = 0;
+
+ failure:
+	BIO_free(client_wbio);
+	BIO_free(server_wbio);
+
+	SSL_free(client);
+	SSL_free(server);
+
+	X509_free(ca);
+
+	return failed;
+}
+
+static int
+ssl_chain_certs_change_tests(void)
+{
+	int failed = 0;
+
+	fprintf(stderr, "\n== Testing chain certificate changes... ==\n");
+
+	failed |= ssl_chain_certs_change_test(TLS1_3_VERSION);
+	failed |= ssl_chain_certs_change_test(TLS1_2_VERSION);
+
+	return failed;
+}
+
+static int
+ssl_session_resumption_handshake(SSL *client, SSL *server, int want_reused)
+{
+	uint8_t buf[1] = { 0x5a };
+	int ret;
+
+	if (!do_client_server_loop(client, do_connect, server, do_accept)) {
+		fprintf(stderr, "FAIL: client and server handshake failed\n");
+		return 0;
+	}
+
+	if (SSL_session_reused(client) != want_reused) {
+		fprintf(stderr, "FAIL: client session reused = %ld, want %d\n",
+		    SSL_session_reused(client), want_reused);
+		return 0;
+	}
+	if (SSL_session_reused(server) != want_reused) {
+		fprintf(stderr, "FAIL: server session reused = %ld, want %d\n",
+		    SSL_session_reused(server), want_reused);
+		return 0;
+	}
+
+	/*
+	 * Exchange application data, so that the client processes any
+	 * session ticket that the server sent following the handshake.
+	 */
+	if ((ret = SSL_write(server, buf, sizeof(buf))) != sizeof(buf)) {
+		fprintf(stderr, "FAIL: server write returned %d\n", ret);
+		return 0;
+	}
+	if ((ret = SSL_read(client, buf, sizeof(buf))) != sizeof(buf)) {
+		fprintf(stderr, "FAIL: client read returned %d\n", ret);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int
+ssl_session_resumption_test(uint16_t tls_version, const char *server_groups)
+{
+	const unsigned char sid_ctx[] = "apitest";
+	BIO *client_wbio = NULL, *server_wbio = NULL;
+	SSL *client = NULL, *server = NULL;
+	SSL_SESSION *session = NULL;
+	X509 *peer_cert = NULL;
+	int i;
+	int failed = 1;
+
+	fprintf(stderr, "INFO: Testing session resumption with TLS version "
+	    "%x, server groups %s\n", tls_version,
+	    server_groups != NULL ? server_groups : "default");
+
+	for (i = 0; i < 3; i++) {
+		BIO_free(client_wbio);
+		BIO_free(server_wbio);
+		client_wbio = server_wbio = NULL;
+
+		if ((client_wbio = BIO_new(BIO_s_mem())) == NULL)
+			goto failure;
+		if (BIO_set_mem_eof_return(client_wbio, -1) <= 0)
+			goto failure;
+		if ((server_wbio = BIO_new(BIO_s_mem())) == NULL)
+			goto failure;
+		if (BIO_set_mem_eof_return(server_wbio, -1) <= 0)
+			goto failure;
+
+		SSL_free(client);
+		if ((client = tls_client(server_wbio, client_wbio)) == NULL)
+			goto failure;
+		if (!SSL_set_min_proto_version(client, tls_version))
+			goto failure;
+		if (!SSL_set_max_proto_version(client, tls_version))
+			goto failure;
+		if (session != NULL && !SSL_set_session(client, session))
+			goto failure;
+
+		/* Use the same server context, so that tickets can be decrypted. */
+		if (server == NULL) {
+			if ((server = tls_server(client_wbio, server_wbio)) == NULL)
+				goto failure;
+			if (!SSL_CTX_set_session_id_context(SSL_get_SSL_CTX(server),
+			    sid_ctx, sizeof(sid_ctx)))
+				goto failure;
+			if (!SSL_set_session_id_context(server, sid_ctx,
+			    sizeof(sid_ctx)))
+				goto failure;
+		} else {
+			SSL *ssl;
+
+			if ((ssl = SSL_new(SSL_get_SSL_CTX(server))) == NULL)
+				goto failure;
+			SSL_free(server);
+			server = ssl;
+
+			BIO_up_ref(client_wbio);
+			BIO_up_ref(server_wbio);
+			SSL_set_bio(server, client_wbio, server_wbio);
+		}
+		if (!SSL_set_min_proto_version(server, tls_version))
+			goto failure;
+		if (!SSL_set_max_proto_version(server, tls_version))
+			goto failure;
+		if (server_groups != NULL &&
+		    !SSL_set1_groups_list(server, server_groups))
+			goto failure;
+
+		if (!ssl_session_resumption_handshake(client, server, i > 0))
+			goto failure;
+
+		if (SSL_version(client) != tls_version) {
+			fprintf(stderr, "FAIL: client got TLS version %x, "
+			    "want %x\n", SSL_version(client), tls_version);
+			goto failure;
+		}
+
+		/* The client certificate must be retained on resumption. */
+		if ((peer_cert = SSL_get_peer_certificate(server)) == NULL) {
+			fprintf(stderr, "FAIL: server got no peer cert\n");
+			goto failure;
+		}
+		X509_free(peer_cert);
+
+		SSL_SESSION_free(session);
+		if ((session = SSL_get1_session(client)) == NULL) {
+			fprintf(stderr, "FAIL: client has no session\n");
+			goto failure;
+		}
+	}
+
+	fprintf(stderr, "INFO: Done!\n");
+
+	failed = 0;
+
+ failure:
+	BIO_free(client_wbio);
+	BIO_free(server_wbio);
+
+	SSL_SESSION_free(session);
+	SSL_free(client);
+	SSL_free(server);
+
+	return failed;
+}
+
+static int
+ssl_session_resumption_tests(void)
+{
+	int failed = 0;
+
+	fprintf(stderr, "\n== Testing session resumption... ==\n");
+
+	failed |= ssl_session_resumption_test(TLS1_3_VERSION, NULL);
+	/* Force a HelloRetryRequest, since the client sends an X25519 share. */
+	failed |= ssl_session_resumption_test(TLS1_3_VERSION, "P-256");
+	failed |= ssl_session_resumption_test(TLS1_2_VERSION, NULL);
+
+	return failed;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -364,6 +624,8 @@ main(int argc, char **argv)
 	certs_path = argv[1];
 
 	failed |= ssl_get_peer_cert_chain_tests();
+	failed |= ssl_chain_certs_change_tests();
+	failed |= ssl_session_resumption_tests();
 
 	return failed;
 }
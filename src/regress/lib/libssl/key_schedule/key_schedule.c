@@ -98,6 +98,19 @@ const struct tls13_secret csfhello_hash = {
 	.len = 32,
 };
 
+/* Transcript hash through the client finished message. */
+uint8_t cfin[] = {
+	0x20, 0x91, 0x45, 0xa9, 0x6e, 0xe8, 0xe2, 0xa1,
+	0x22, 0xff, 0x81, 0x00, 0x47, 0xcc, 0x95, 0x26,
+	0x84, 0x65, 0x8d, 0x60, 0x49, 0xe8, 0x64, 0x29,
+	0x42, 0x6d, 0xb8, 0x7c, 0x54, 0xad, 0x14, 0x3d
+};
+
+const struct tls13_secret cfin_hash = {
+	.data = cfin,
+	.len = 32,
+};
+
 
 /* Expected Values */
 
@@ -175,6 +188,13 @@ uint8_t expected_client_application_traffic_updated[] = {
 	0xe2, 0x24, 0x5c, 0xa6, 0xea, 0x16, 0x72, 0x07,
 };
 
+uint8_t expected_resumption_master[] = {
+	0x7d, 0xf2, 0x35, 0xf2, 0x03, 0x1d, 0x2a, 0x05,
+	0x12, 0x87, 0xd0, 0x2b, 0x02, 0x41, 0xb0, 0xbf,
+	0xda, 0xf8, 0x6c, 0xc8, 0x56, 0x23, 0x1f, 0x2d,
+	0x5a, 0xba, 0x46, 0xc4, 0x34, 0xec, 0x19, 0x6c
+};
+
 uint8_t expected_exporter_master[] = {
 	0xfe, 0x22, 0xf8, 0x81, 0x17, 0x6e, 0xda, 0x18,
 	0xeb, 0x8f, 0x44, 0x52, 0x9e, 0x67, 0x92, 0xc5,
@@ -182,6 +202,77 @@ uint8_t expected_exporter_master[] = {
 	0xae, 0x31, 0x1b, 0x43, 0x09, 0xd3, 0xcf, 0x50
 };
 
+/*
+ * RFC 8448 section 4 - the resumed handshake uses the ticket issued with
+ * the nonce 0x0000 and offers a binder over the truncated ClientHello.
+ */
+uint8_t psk_ticket_nonce[] = { 0x00, 0x00 };
+
+uint8_t expected_psk[] = {
+	0x4e, 0xcd, 0x0e, 0xb6, 0xec, 0x3b, 0x4d, 0x87,
+	0xf5, 0xd6, 0x02, 0x8f, 0x92, 0x2c, 0xa4, 0xc5,
+	0x85, 0x1a, 0x27, 0x7f, 0xd4, 0x13, 0x11, 0xc9,
+	0xe6, 0x2d, 0x2c, 0x94, 0x92, 0xe1, 0xc4, 0xf3
+};
+
+uint8_t psk_binder_hash[] = {
+	0x63, 0x22, 0x4b, 0x2e, 0x45, 0x73, 0xf2, 0xd3,
+	0x45, 0x4c, 0xa8, 0x4b, 0x9d, 0x00, 0x9a, 0x04,
+	0xf6, 0xbe, 0x9e, 0x05, 0x71, 0x1a, 0x83, 0x96,
+	0x47, 0x3a, 0xef, 0xa0, 0x1e, 0x92, 0x4a, 0x14
+};
+
+uint8_t expected_psk_binder[] = {
+	0x3a, 0xdd, 0x4f, 0xb2, 0xd8, 0xfd, 0xf8, 0x22,
+	0xa0, 0xca, 0x3c, 0xf7, 0x67, 0x8e, 0xf5, 0xe8,
+	0x8d, 0xae, 0x99, 0x01, 0x41, 0xc5, 0x92, 0x4d,
+	0x57, 0xbb, 0x6f, 0xa3, 0x1b, 0x9e, 0x5f, 0x9d
+};
+
+static void
+psk_binder_test(void)
+{
+	struct tls13_secret resumption_master = {
+		.data = expected_resumption_master,
+		.len = sizeof(expected_resumption_master),
+	};
+	struct tls13_secret nonce = {
+		.data = psk_ticket_nonce,
+		.len = sizeof(psk_ticket_nonce),
+	};
+	struct tls13_secret binder_hash = {
+		.data = psk_binder_hash,
+		.len = sizeof(psk_binder_hash),
+	};
+	uint8_t psk_data[32], binder_data[32];
+	struct tls13_secret psk = {
+		.data = psk_data,
+		.len = sizeof(psk_data),
+	};
+	struct tls13_secret binder = {
+		.data = binder_data,
+		.len = sizeof(binder_data),
+	};
+
+	if (!tls13_derive_secret(&psk, EVP_sha256(), &resumption_master,
+	    "resumption", &nonce))
+		FAIL("derive resumption psk failed\n");
+
+	fprintf(stderr, "psk:\n");
+	compare_data(psk.data, 32, expected_psk, 32);
+	if (memcmp(psk.data, expected_psk, 32) != 0)
+		FAIL("psk does not match\n");
+
+	if (!tls13_derive_psk_binder(&binder, EVP_sha256(), &psk, 1,
+	    &binder_hash))
+		FAIL("derive_psk_binder failed\n");
+
+	fprintf(stderr, "psk_binder:\n");
+	compare_data(binder.data, 32, expected_psk_binder, 32);
+	if (memcmp(binder.data, expected_psk_binder, 32) != 0)
+		FAIL("psk_binder does not match\n");
+}
+
 int
 main (int argc, char **argv)
 {
@@ -197,6 +288,9 @@ main (int argc, char **argv)
 	if (tls13_derive_application_secrets(secrets,
 	    &chello_hash))
 		FAIL("derive_application_secrets worked when it shouldn't\n");
+	if (tls13_derive_resumption_master_secret(secrets, &chello_hash))
+		FAIL("derive_resumption_master_secret worked when it "
+		    "shouldn't\n");
 
 	if (!tls13_derive_early_secrets(secrets,
 	    secrets->zeros.data, secrets->zeros.len, &chello_hash))
@@ -217,6 +311,12 @@ main (int argc, char **argv)
 		FAIL("derive_application_secrets worked when it "
 		    "shouldn't(2)\n");
 
+	if (!tls13_derive_resumption_master_secret(secrets, &cfin_hash))
+		FAIL("derive_resumption_master_secret failed\n");
+	if (tls13_derive_resumption_master_secret(secrets, &cfin_hash))
+		FAIL("derive_resumption_master_secret worked when it "
+		    "shouldn't\n");
+
 	fprintf(stderr, "extracted_early:\n");
 	compare_data(secrets->extracted_early.data, 32,
 	    expected_extracted_early, 32);
@@ -294,6 +394,13 @@ main (int argc, char **argv)
 	    expected_exporter_master, 32) != 0)
 		FAIL("exporter_master does not match\n");
 
+	fprintf(stderr, "resumption_master:\n");
+	compare_data(secrets->resumption_master.data, 32,
+	    expected_resumption_master, 32);
+	if (memcmp(secrets->resumption_master.data,
+	    expected_resumption_master, 32) != 0)
+		FAIL("resumption_master does not match\n");
+
 	tls13_update_server_traffic_secret(secrets);
 	fprintf(stderr, "server_application_traffic after update:\n");
 	compare_data(secrets->server_application_traffic.data, 32,
@@ -313,5 +420,7 @@ main (int argc, char **argv)
 
 	tls13_secrets_destroy(secrets);
 
+	psk_binder_test();
+
 	return failures;
 }
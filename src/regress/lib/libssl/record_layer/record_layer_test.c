@@ -294,6 +294,202 @@ test_seq_num_tls13(void)
 	return failed;
 }
 
+struct wire_buf {
+	uint8_t *data;
+	size_t len;
+	size_t size;
+	size_t offset;
+	size_t max_write;
+	int block;
+	int writes;
+};
+
+static ssize_t
+wire_buf_read(void *buf, size_t n, void *arg)
+{
+	struct wire_buf *wb = arg;
+
+	if (wb->offset == wb->len)
+		return TLS13_IO_EOF;
+	if (n > wb->len - wb->offset)
+		n = wb->len - wb->offset;
+
+	memcpy(buf, &wb->data[wb->offset], n);
+	wb->offset += n;
+
+	return n;
+}
+
+static ssize_t
+wire_buf_write(const void *buf, size_t n, void *arg)
+{
+	struct wire_buf *wb = arg;
+
+	/* Alternate between blocking and accepting a partial write. */
+	if (wb->max_write > 0) {
+		if ((wb->block = !wb->block))
+			return TLS13_IO_WANT_POLLOUT;
+		if (n > wb->max_write)
+			n = wb->max_write;
+	}
+
+	if (n > wb->size - wb->len)
+		return TLS13_IO_FAILURE;
+
+	memcpy(&wb->data[wb->len], buf, n);
+	wb->len += n;
+	wb->writes++;
+
+	return n;
+}
+
+static ssize_t
+wire_buf_flush(void *arg)
+{
+	return TLS13_IO_SUCCESS;
+}
+
+static const struct tls13_record_layer_callbacks wire_buf_cb = {
+	.wire_read = wire_buf_read,
+	.wire_write = wire_buf_write,
+	.wire_flush = wire_buf_flush,
+};
+
+static struct tls13_record_layer *
+tls13_record_layer_setup(struct wire_buf *wb, struct tls13_secret *secret)
+{
+	struct tls13_record_layer *rl;
+
+	if ((rl = tls13_record_layer_new(&wire_buf_cb, wb)) == NULL)
+		errx(1, "failed to create record layer");
+
+	tls13_record_layer_set_aead(rl, EVP_aead_aes_128_gcm());
+	tls13_record_layer_set_hash(rl, EVP_sha256());
+
+	if (!tls13_record_layer_set_read_traffic_key(rl, secret,
+	    ssl_encryption_application))
+		errx(1, "failed to set read traffic key");
+	if (!tls13_record_layer_set_write_traffic_key(rl, secret,
+	    ssl_encryption_application))
+		errx(1, "failed to set write traffic key");
+
+	tls13_record_layer_handshake_completed(rl);
+
+	return rl;
+}
+
+#define COALESCE_TEST_LEN	(1024 * 1024 + 1234)
+
+static int
+do_coalesced_write_test(int coalesce, size_t max_write)
+{
+	struct tls13_record_layer *rrl = NULL, *wrl = NULL;
+	uint8_t key[32], *data = NULL, *rdata = NULL;
+	struct tls13_secret secret;
+	struct wire_buf wb;
+	size_t i, records, sent, recv;
+	ssize_t ret;
+	int failed = 1;
+
+	memset(&wb, 0, sizeof(wb));
+	wb.size = 2 * COALESCE_TEST_LEN;
+	wb.max_write = max_write;
+
+	for (i = 0; i < sizeof(key); i++)
+		key[i] = i;
+	secret.data = key;
+	secret.len = sizeof(key);
+
+	if ((data = malloc(COALESCE_TEST_LEN)) == NULL)
+		err(1, NULL);
+	if ((rdata = calloc(1, COALESCE_TEST_LEN)) == NULL)
+		err(1, NULL);
+	if ((wb.data = malloc(wb.size)) == NULL)
+		err(1, NULL);
+	arc4random_buf(data, COALESCE_TEST_LEN);
+
+	wrl = tls13_record_layer_setup(&wb, &secret);
+	rrl = tls13_record_layer_setup(&wb, &secret);
+
+	tls13_record_layer_set_coalesce_writes(wrl, coalesce);
+
+	/*
+	 * Retry with the same data on blocking writes, as would be done for
+	 * SSL_write().
+	 */
+	sent = 0;
+	while (sent < COALESCE_TEST_LEN) {
+		ret = tls13_write_application_data(wrl, &data[sent],
+		    COALESCE_TEST_LEN - sent);
+		if (ret == TLS13_IO_WANT_POLLOUT)
+			continue;
+		if (ret <= 0) {
+			fprintf(stderr, "FAIL: write returned %zd\n", ret);
+			goto failure;
+		}
+		sent += ret;
+	}
+
+	records = (COALESCE_TEST_LEN + TLS13_RECORD_MAX_PLAINTEXT_LEN - 1) /
+	    TLS13_RECORD_MAX_PLAINTEXT_LEN;
+	if (wb.len != COALESCE_TEST_LEN + records * (TLS13_RECORD_HEADER_LEN +
+	    1 + EVP_AEAD_max_tag_len(EVP_aead_aes_128_gcm()))) {
+		fprintf(stderr, "FAIL: wrote %zu bytes for %zu records\n",
+		    wb.len, records);
+		goto failure;
+	}
+	if (coalesce && max_write == 0 && wb.writes > (records + 15) / 16) {
+		fprintf(stderr, "FAIL: %d wire writes for %zu records\n",
+		    wb.writes, records);
+		goto failure;
+	}
+	if (!coalesce && max_write == 0 && wb.writes != records) {
+		fprintf(stderr, "FAIL: %d wire writes for %zu records without "
+		    "coalescing\n", wb.writes, records);
+		goto failure;
+	}
+
+	recv = 0;
+	while (recv < COALESCE_TEST_LEN) {
+		if ((ret = tls13_read_application_data(rrl, &rdata[recv],
+		    COALESCE_TEST_LEN - recv)) <= 0) {
+			fprintf(stderr, "FAIL: read returned %zd\n", ret);
+			goto failure;
+		}
+		recv += ret;
+	}
+	if (memcmp(data, rdata, COALESCE_TEST_LEN) != 0) {
+		fprintf(stderr, "FAIL: read data differs from written data\n");
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	tls13_record_layer_free(rrl);
+	tls13_record_layer_free(wrl);
+	free(data);
+	free(rdata);
+	free(wb.data);
+
+	return failed;
+}
+
+static int
+test_coalesced_write_tls13(void)
+{
+	int failed = 0;
+
+	fprintf(stderr, "Running TLSv1.3 coalesced write tests...\n");
+
+	failed |= do_coalesced_write_test(0, 0);
+	failed |= do_coalesced_write_test(0, 1000);
+	failed |= do_coalesced_write_test(1, 0);
+	failed |= do_coalesced_write_test(1, 1000);
+
+	return failed;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -301,6 +497,7 @@ main(int argc, char **argv)
 
 	failed |= test_seq_num_tls12();
 	failed |= test_seq_num_tls13();
+	failed |= test_coalesced_write_tls13();
 
 	return failed;
 }
@@ -4093,11 +4093,10 @@ test_tlsext_psk_modes_client(void)
 	}
 
 	/*
-	 * Prerequisites: use_psk_dhe_ke flag is set and
-	 * our_max_tls_version >= TLSv1.3.
+	 * Prerequisites: our_max_tls_version >= TLSv1.3 and tickets are
+	 * not disabled. No PSK needs to be offered.
 	 */
 
-	ssl->s3->hs.tls13.use_psk_dhe_ke = 1;
 	ssl->s3->hs.our_max_tls_version = TLS1_2_VERSION;
 
 	if (client_funcs->needs(ssl, SSL_TLSEXT_MSG_CH)) {
@@ -4105,16 +4104,17 @@ test_tlsext_psk_modes_client(void)
 		goto err;
 	}
 
-	ssl->s3->hs.tls13.use_psk_dhe_ke = 0;
+	SSL_set_options(ssl, SSL_OP_NO_TICKET);
 	ssl->s3->hs.our_max_tls_version = TLS1_3_VERSION;
 
 	if (client_funcs->needs(ssl, SSL_TLSEXT_MSG_CH)) {
-		FAIL("client should not need psk kex modes without "
-		    "use_psk_dhe_ke\n");
+		FAIL("client should not need psk kex modes with "
+		    "SSL_OP_NO_TICKET\n");
 		goto err;
 	}
 
-	ssl->s3->hs.tls13.use_psk_dhe_ke = 1;
+	SSL_clear_options(ssl, SSL_OP_NO_TICKET);
+	ssl->s3->hs.tls13.psk_offered = 0;
 	ssl->s3->hs.our_max_tls_version = TLS1_3_VERSION;
 
 	if (!client_funcs->needs(ssl, SSL_TLSEXT_MSG_CH)) {
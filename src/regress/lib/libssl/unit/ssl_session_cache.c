@@ -0,0 +1,514 @@
+/*	$OpenBSD$ */
+/*
+ * Copyright (c) 2026 The LibreSSL Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <err.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <openssl/ssl.h>
+
+#include "ssl_local.h"
+
+#define CACHE_TEST_THREADS	8
+#define CACHE_TEST_SESSIONS	1000
+
+static pthread_mutex_t removed_lock = PTHREAD_MUTEX_INITIALIZER;
+static int removed;
+static int removed_relookup;
+
+static void
+remove_session_cb(SSL_CTX *ssl_ctx, SSL_SESSION *sess)
+{
+	/*
+	 * Removing a session that is no longer cached still takes the lock
+	 * for its shard, which would deadlock if it were held here.
+	 */
+	if (removed_relookup && SSL_CTX_remove_session(ssl_ctx, sess) != 0)
+		errx(1, "removed session is still cached");
+
+	pthread_mutex_lock(&removed_lock);
+	removed++;
+	pthread_mutex_unlock(&removed_lock);
+}
+
+static int
+removed_count(void)
+{
+	int count;
+
+	pthread_mutex_lock(&removed_lock);
+	count = removed;
+	removed = 0;
+	pthread_mutex_unlock(&removed_lock);
+
+	return count;
+}
+
+static SSL_CTX *
+cache_test_ctx(void)
+{
+	SSL_CTX *ssl_ctx;
+
+	if ((ssl_ctx = SSL_CTX_new(TLS_method())) == NULL)
+		errx(1, "SSL_CTX_new");
+	SSL_CTX_sess_set_remove_cb(ssl_ctx, remove_session_cb);
+	SSL_CTX_sess_set_cache_size(ssl_ctx, 0);
+
+	removed_count();
+
+	return ssl_ctx;
+}
+
+static SSL_SESSION *
+cache_test_session(SSL *ssl, unsigned char id[SSL3_SSL_SESSION_ID_LENGTH])
+{
+	SSL_SESSION *sess;
+
+	if ((sess = SSL_SESSION_new()) == NULL)
+		errx(1, "SSL_SESSION_new");
+
+	arc4random_buf(id, SSL3_SSL_SESSION_ID_LENGTH);
+	if (!SSL_SESSION_set1_id(sess, id, SSL3_SSL_SESSION_ID_LENGTH))
+		errx(1, "SSL_SESSION_set1_id");
+	sess->ssl_version = SSL_version(ssl);
+
+	return sess;
+}
+
+static int
+test_session_cache_add_remove(void)
+{
+	unsigned char ids[CACHE_TEST_SESSIONS][SSL3_SSL_SESSION_ID_LENGTH];
+	SSL_SESSION *sessions[CACHE_TEST_SESSIONS] = { 0 };
+	SSL_CTX *ssl_ctx;
+	SSL *ssl;
+	int i, n;
+	int failed = 1;
+
+	ssl_ctx = cache_test_ctx();
+	if ((ssl = SSL_new(ssl_ctx)) == NULL)
+		errx(1, "SSL_new");
+
+	for (i = 0; i < CACHE_TEST_SESSIONS; i++) {
+		sessions[i] = cache_test_session(ssl, ids[i]);
+		if (SSL_CTX_add_session(ssl_ctx, sessions[i]) != 1) {
+			fprintf(stderr, "FAIL: failed to add session %d\n", i);
+			goto failure;
+		}
+	}
+	for (i = 0; i < CACHE_TEST_SESSIONS; i++) {
+		if (SSL_CTX_add_session(ssl_ctx, sessions[i]) != 0) {
+			fprintf(stderr, "FAIL: session %d added twice\n", i);
+			goto failure;
+		}
+	}
+	if ((n = SSL_CTX_sess_number(ssl_ctx)) != CACHE_TEST_SESSIONS) {
+		fprintf(stderr, "FAIL: got %d cached sessions, want %d\n",
+		    n, CACHE_TEST_SESSIONS);
+		goto failure;
+	}
+
+	for (i = 0; i < CACHE_TEST_SESSIONS; i++) {
+		if (!SSL_has_matching_session_id(ssl, ids[i], sizeof(ids[i]))) {
+			fprintf(stderr, "FAIL: session %d not found\n", i);
+			goto failure;
+		}
+	}
+
+	for (i = 0; i < CACHE_TEST_SESSIONS; i += 2) {
+		if (SSL_CTX_remove_session(ssl_ctx, sessions[i]) != 1) {
+			fprintf(stderr, "FAIL: failed to remove session %d\n",
+			    i);
+			goto failure;
+		}
+		if (SSL_CTX_remove_session(ssl_ctx, sessions[i]) != 0) {
+			fprintf(stderr, "FAIL: session %d removed twice\n", i);
+			goto failure;
+		}
+	}
+	for (i = 0; i < CACHE_TEST_SESSIONS; i++) {
+		if (SSL_has_matching_session_id(ssl, ids[i],
+		    sizeof(ids[i])) != (i % 2)) {
+			fprintf(stderr, "FAIL: session %d lookup mismatch\n", i);
+			goto failure;
+		}
+	}
+	if ((n = removed_count()) != CACHE_TEST_SESSIONS / 2) {
+		fprintf(stderr, "FAIL: got %d remove callbacks, want %d\n",
+		    n, CACHE_TEST_SESSIONS / 2);
+		goto failure;
+	}
+
+	removed_relookup = 1;
+	SSL_CTX_flush_sessions(ssl_ctx, 0);
+	removed_relookup = 0;
+
+	if ((n = SSL_CTX_sess_number(ssl_ctx)) != 0) {
+		fprintf(stderr, "FAIL: got %d sessions after flush\n", n);
+		goto failure;
+	}
+	if ((n = removed_count()) != CACHE_TEST_SESSIONS / 2) {
+		fprintf(stderr, "FAIL: got %d flush callbacks, want %d\n",
+		    n, CACHE_TEST_SESSIONS / 2);
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	for (i = 0; i < CACHE_TEST_SESSIONS; i++)
+		SSL_SESSION_free(sessions[i]);
+	SSL_free(ssl);
+	SSL_CTX_free(ssl_ctx);
+
+	return failed;
+}
+
+static int
+test_session_cache_size(void)
+{
+	unsigned char id[SSL3_SSL_SESSION_ID_LENGTH];
+	SSL_CTX *ssl_ctx;
+	SSL_SESSION *sess;
+	SSL *ssl;
+	int i, n;
+	int failed = 1;
+
+	ssl_ctx = cache_test_ctx();
+	SSL_CTX_sess_set_cache_size(ssl_ctx, 10);
+	if ((ssl = SSL_new(ssl_ctx)) == NULL)
+		errx(1, "SSL_new");
+
+	for (i = 0; i < 100; i++) {
+		sess = cache_test_session(ssl, id);
+		if (SSL_CTX_add_session(ssl_ctx, sess) != 1) {
+			fprintf(stderr, "FAIL: failed to add session %d\n", i);
+			SSL_SESSION_free(sess);
+			goto failure;
+		}
+		SSL_SESSION_free(sess);
+
+		if (!SSL_has_matching_session_id(ssl, id, sizeof(id))) {
+			fprintf(stderr, "FAIL: session %d not found\n", i);
+			goto failure;
+		}
+		if ((n = SSL_CTX_sess_number(ssl_ctx)) > 10) {
+			fprintf(stderr, "FAIL: got %d sessions with cache "
+			    "size 10\n", n);
+			goto failure;
+		}
+	}
+
+	if ((n = SSL_CTX_sess_cache_full(ssl_ctx)) != 90) {
+		fprintf(stderr, "FAIL: got %d cache full, want 90\n", n);
+		goto failure;
+	}
+	if ((n = removed_count()) != 90) {
+		fprintf(stderr, "FAIL: got %d remove callbacks, want 90\n", n);
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	SSL_free(ssl);
+	SSL_CTX_free(ssl_ctx);
+
+	return failed;
+}
+
+static int
+test_session_cache_expire(void)
+{
+	unsigned char id[SSL3_SSL_SESSION_ID_LENGTH];
+	SSL_CTX *ssl_ctx;
+	SSL_SESSION *sess;
+	SSL *ssl;
+	int i, n;
+	int failed = 1;
+
+	ssl_ctx = cache_test_ctx();
+	if ((ssl = SSL_new(ssl_ctx)) == NULL)
+		errx(1, "SSL_new");
+
+	/*
+	 * Expired sessions should be removed as new sessions are added,
+	 * without needing to flush the cache.
+	 */
+	for (i = 0; i < 100; i++) {
+		sess = cache_test_session(ssl, id);
+		SSL_SESSION_set_time(sess, time(NULL) - 100);
+		SSL_SESSION_set_timeout(sess, 10);
+		if (SSL_CTX_add_session(ssl_ctx, sess) != 1) {
+			fprintf(stderr, "FAIL: failed to add session %d\n", i);
+			SSL_SESSION_free(sess);
+			goto failure;
+		}
+		SSL_SESSION_free(sess);
+	}
+	for (i = 0; i < 1000; i++) {
+		sess = cache_test_session(ssl, id);
+		if (SSL_CTX_add_session(ssl_ctx, sess) != 1) {
+			fprintf(stderr, "FAIL: failed to add session %d\n", i);
+			SSL_SESSION_free(sess);
+			goto failure;
+		}
+		SSL_SESSION_free(sess);
+	}
+	if ((n = SSL_CTX_sess_number(ssl_ctx)) != 1000) {
+		fprintf(stderr, "FAIL: got %d sessions, want 1000\n", n);
+		goto failure;
+	}
+	if ((n = removed_count()) != 100) {
+		fprintf(stderr, "FAIL: got %d remove callbacks, want 100\n", n);
+		goto failure;
+	}
+
+	/* Without auto clear, expired sessions are only removed by flush. */
+	SSL_CTX_set_session_cache_mode(ssl_ctx,
+	    SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_AUTO_CLEAR);
+
+	for (i = 0; i < 100; i++) {
+		sess = cache_test_session(ssl, id);
+		SSL_SESSION_set_time(sess, time(NULL) - 100);
+		SSL_SESSION_set_timeout(sess, 10);
+		if (SSL_CTX_add_session(ssl_ctx, sess) != 1) {
+			fprintf(stderr, "FAIL: failed to add session %d\n", i);
+			SSL_SESSION_free(sess);
+			goto failure;
+		}
+		SSL_SESSION_free(sess);
+	}
+	if ((n = SSL_CTX_sess_number(ssl_ctx)) != 1100) {
+		fprintf(stderr, "FAIL: got %d sessions, want 1100\n", n);
+		goto failure;
+	}
+
+	SSL_CTX_flush_sessions(ssl_ctx, time(NULL));
+
+	if ((n = SSL_CTX_sess_number(ssl_ctx)) != 1000) {
+		fprintf(stderr, "FAIL: got %d sessions after flush, want "
+		    "1000\n", n);
+		goto failure;
+	}
+	if ((n = removed_count()) != 100) {
+		fprintf(stderr, "FAIL: got %d remove callbacks, want 100\n", n);
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	SSL_free(ssl);
+	SSL_CTX_free(ssl_ctx);
+
+	return failed;
+}
+
+static int
+check_view(SSL_CTX *ssl_ctx, unsigned long want)
+{
+	unsigned long n;
+
+	if ((n = lh_SSL_SESSION_num_items(SSL_CTX_sessions(ssl_ctx))) != want) {
+		fprintf(stderr, "FAIL: got %lu sessions in view, want %lu\n",
+		    n, want);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int
+test_session_cache_view(void)
+{
+	unsigned char ids[CACHE_TEST_SESSIONS][SSL3_SSL_SESSION_ID_LENGTH];
+	SSL_SESSION *sessions[CACHE_TEST_SESSIONS] = { 0 };
+	SSL_CTX *ssl_ctx;
+	SSL *ssl;
+	int i;
+	int failed = 1;
+
+	ssl_ctx = cache_test_ctx();
+	if ((ssl = SSL_new(ssl_ctx)) == NULL)
+		errx(1, "SSL_new");
+
+	/* Add sessions both before and after the view is created. */
+	for (i = 0; i < CACHE_TEST_SESSIONS / 2; i++) {
+		sessions[i] = cache_test_session(ssl, ids[i]);
+		if (SSL_CTX_add_session(ssl_ctx, sessions[i]) != 1) {
+			fprintf(stderr, "FAIL: failed to add session %d\n", i);
+			goto failure;
+		}
+	}
+	if (!check_view(ssl_ctx, CACHE_TEST_SESSIONS / 2))
+		goto failure;
+
+	for (; i < CACHE_TEST_SESSIONS; i++) {
+		sessions[i] = cache_test_session(ssl, ids[i]);
+		if (SSL_CTX_add_session(ssl_ctx, sessions[i]) != 1) {
+			fprintf(stderr, "FAIL: failed to add session %d\n", i);
+			goto failure;
+		}
+	}
+	if (!check_view(ssl_ctx, CACHE_TEST_SESSIONS))
+		goto failure;
+
+	for (i = 0; i < CACHE_TEST_SESSIONS; i++) {
+		if (lh_SSL_SESSION_retrieve(SSL_CTX_sessions(ssl_ctx),
+		    sessions[i]) != sessions[i]) {
+			fprintf(stderr, "FAIL: session %d not in view\n", i);
+			goto failure;
+		}
+	}
+
+	for (i = 0; i < CACHE_TEST_SESSIONS; i += 2) {
+		if (SSL_CTX_remove_session(ssl_ctx, sessions[i]) != 1) {
+			fprintf(stderr, "FAIL: failed to remove session %d\n",
+			    i);
+			goto failure;
+		}
+	}
+	if (!check_view(ssl_ctx, CACHE_TEST_SESSIONS / 2))
+		goto failure;
+
+	SSL_CTX_flush_sessions(ssl_ctx, 0);
+
+	if (!check_view(ssl_ctx, 0))
+		goto failure;
+
+	failed = 0;
+
+ failure:
+	for (i = 0; i < CACHE_TEST_SESSIONS; i++)
+		SSL_SESSION_free(sessions[i]);
+	SSL_free(ssl);
+	SSL_CTX_free(ssl_ctx);
+
+	return failed;
+}
+
+struct cache_thread_ctx {
+	SSL_CTX *ssl_ctx;
+	int failed;
+};
+
+static void *
+session_cache_thread(void *arg)
+{
+	struct cache_thread_ctx *ctx = arg;
+	unsigned char ids[CACHE_TEST_SESSIONS][SSL3_SSL_SESSION_ID_LENGTH];
+	SSL_SESSION *sessions[CACHE_TEST_SESSIONS];
+	SSL *ssl;
+	int i;
+
+	if ((ssl = SSL_new(ctx->ssl_ctx)) == NULL)
+		errx(1, "SSL_new");
+
+	for (i = 0; i < CACHE_TEST_SESSIONS; i++) {
+		sessions[i] = cache_test_session(ssl, ids[i]);
+		if (SSL_CTX_add_session(ctx->ssl_ctx, sessions[i]) != 1)
+			ctx->failed = 1;
+	}
+	for (i = 0; i < CACHE_TEST_SESSIONS; i++) {
+		if (!SSL_has_matching_session_id(ssl, ids[i], sizeof(ids[i])))
+			ctx->failed = 1;
+		if (SSL_CTX_remove_session(ctx->ssl_ctx, sessions[i]) != 1)
+			ctx->failed = 1;
+		if (SSL_has_matching_session_id(ssl, ids[i], sizeof(ids[i])))
+			ctx->failed = 1;
+		SSL_SESSION_free(sessions[i]);
+	}
+
+	SSL_free(ssl);
+
+	return NULL;
+}
+
+static int
+test_session_cache_threads(void)
+{
+	struct cache_thread_ctx ctx[CACHE_TEST_THREADS];
+	pthread_t threads[CACHE_TEST_THREADS];
+	SSL_CTX *ssl_ctx;
+	int i, n;
+	int failed = 1;
+
+	ssl_ctx = cache_test_ctx();
+
+	/* Have the threads keep the combined view up to date as well. */
+	if (SSL_CTX_sessions(ssl_ctx) == NULL)
+		errx(1, "SSL_CTX_sessions");
+
+	for (i = 0; i < CACHE_TEST_THREADS; i++) {
+		ctx[i].ssl_ctx = ssl_ctx;
+		ctx[i].failed = 0;
+		if (pthread_create(&threads[i], NULL, session_cache_thread,
+		    &ctx[i]) != 0)
+			errx(1, "pthread_create");
+	}
+	for (i = 0; i < CACHE_TEST_THREADS; i++) {
+		if (pthread_join(threads[i], NULL) != 0)
+			errx(1, "pthread_join");
+	}
+
+	for (i = 0; i < CACHE_TEST_THREADS; i++) {
+		if (ctx[i].failed) {
+			fprintf(stderr, "FAIL: thread %d failed\n", i);
+			goto failure;
+		}
+	}
+	if ((n = SSL_CTX_sess_number(ssl_ctx)) != 0) {
+		fprintf(stderr, "FAIL: got %d sessions, want 0\n", n);
+		goto failure;
+	}
+	if (!check_view(ssl_ctx, 0))
+		goto failure;
+	if ((n = removed_count()) != CACHE_TEST_THREADS * CACHE_TEST_SESSIONS) {
+		fprintf(stderr, "FAIL: got %d remove callbacks, want %d\n",
+		    n, CACHE_TEST_THREADS * CACHE_TEST_SESSIONS);
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	SSL_CTX_free(ssl_ctx);
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	int failed = 0;
+
+	SSL_library_init();
+
+	failed |= test_session_cache_add_remove();
+	failed |= test_session_cache_size();
+	failed |= test_session_cache_expire();
+	failed |= test_session_cache_view();
+	failed |= test_session_cache_threads();
+
+	if (failed == 0)
+		printf("PASS %s\n", __FILE__);
+
+	return (failed);
+}